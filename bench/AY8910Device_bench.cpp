@@ -0,0 +1,79 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/sound/src/AY8910Device.hpp"
+
+#include <array>
+#include <utility>
+
+namespace epoch::sound
+{
+    namespace
+    {
+        constexpr int ClocksPerIteration = 1 << 16;
+
+        // Tone on A, noise on B, envelope on C: every generator is running
+        void setup(AY8910Device& device)
+        {
+            constexpr std::array<std::pair<uint8_t, uint8_t>, 14> registers{{
+                {0, 0x00}, {1, 0x01}, {2, 0x55}, {3, 0x01}, {4, 0xaa}, {5, 0x02}, {6, 0x10},
+                {7, 0b00101110}, {8, 0x0f}, {9, 0x0a}, {10, 0x10}, {11, 0x00}, {12, 0x02}, {13, 0x0e},
+            }};
+            device.reset();
+            for (const auto& [address, value] : registers)
+            {
+                device.address(address);
+                device.data(value);
+            }
+        }
+    }  // namespace
+
+    void BM_AY8910Device_Clock(benchmark::State& state)
+    {
+        AY8910Device device;
+        setup(device);
+        for (auto _ : state)
+        {
+            for (auto i = 0; i < ClocksPerIteration; i++)
+            {
+                device.clock();
+            }
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * ClocksPerIteration);
+    }
+    BENCHMARK(BM_AY8910Device_Clock);
+
+    void BM_AY8910Device_Output(benchmark::State& state)
+    {
+        AY8910Device device;
+        setup(device);
+        for (auto _ : state)
+        {
+            SoundSample sum{};
+            for (auto i = 0; i < ClocksPerIteration; i++)
+            {
+                device.clock();
+                sum += device.output();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * ClocksPerIteration);
+    }
+    BENCHMARK(BM_AY8910Device_Output);
+}  // namespace epoch::sound
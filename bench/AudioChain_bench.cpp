@@ -0,0 +1,70 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/sound/src/AudioChain.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace epoch::sound
+{
+    namespace
+    {
+        // One chunk of the emulation thread
+        constexpr std::size_t BlockSamples = 512;
+
+        std::vector<SoundSample> makeBlock()
+        {
+            // Square wave like the beeper, with a DC offset
+            std::vector<SoundSample> block(BlockSamples);
+            for (std::size_t i = 0; i < block.size(); ++i) block[i] = SoundSample{(i / 37) % 2 ? 0.8f : 0.f};
+            return block;
+        }
+    }  // namespace
+
+    void BM_AudioChain_Filter(benchmark::State& state)
+    {
+        AudioChain chain{48000., 48000.};
+        chain.emplace<DcBlocker>(48000.f);
+        chain.emplace<LowPassFilter>(48000.f, 8000.f);
+        chain.emplace<StereoWidener>(1.5f);
+        auto block = makeBlock();
+        for (auto _ : state)
+        {
+            chain.filter(block);
+            benchmark::DoNotOptimize(block.data());
+        }
+        state.SetItemsProcessed(state.iterations() * BlockSamples);
+    }
+    BENCHMARK(BM_AudioChain_Filter);
+
+    void BM_AudioChain_Resample(benchmark::State& state)
+    {
+        Resampler resampler{48000., static_cast<double>(state.range(0))};
+        const auto block = makeBlock();
+        std::vector<SoundSample> output;
+        for (auto _ : state)
+        {
+            output.clear();
+            resampler.process(block, output);
+            benchmark::DoNotOptimize(output.data());
+        }
+        state.SetItemsProcessed(state.iterations() * BlockSamples);
+    }
+    BENCHMARK(BM_AudioChain_Resample)->Arg(44100)->Arg(96000);
+}  // namespace epoch::sound
@@ -0,0 +1,48 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+
+#include <epoch/video.hpp>
+
+namespace epoch::video
+{
+    // A booted 48K screen through the software CRT at 2x, the size of a default window; items are frames
+    void BM_CrtFilter_Render(benchmark::State& state)
+    {
+        const auto emulator = zxspectrum::ZXSpectrumEmulator::create48K();
+        emulator->reset();
+        for (int i = 0; i < 100; i++) emulator->frame();
+        const auto& info = emulator->info();
+
+        CrtFilter filter{info.width, info.height, info.width * 2, info.height * 2};
+        CrtParameters parameters{};
+        parameters.curvature = static_cast<float>(state.range(0));
+        parameters.bloom = static_cast<float>(state.range(0)) * 0.3f;
+        filter.setParameters(parameters);
+        std::vector<uint32_t> output(static_cast<std::size_t>(filter.outputWidth()) * filter.outputHeight());
+        for (auto _ : state)
+        {
+            filter.render(emulator->indexedScreenBuffer(), emulator->palette(), output);
+            benchmark::DoNotOptimize(output.data());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    // 0: crt-easymode alone, 1: with curvature and bloom
+    BENCHMARK(BM_CrtFilter_Render)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+}  // namespace epoch::video
@@ -0,0 +1,203 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/zxspectrum/src/Io.hpp"
+#include "../src/zxspectrum/src/PulsesTape.hpp"
+#include "../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        using Bytes = std::vector<uint8_t>;
+
+        void put(Bytes& bytes, std::initializer_list<uint8_t> values) { bytes.insert(bytes.end(), values); }
+        void putWord(Bytes& bytes, const uint16_t value)
+        {
+            put(bytes, {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)});
+        }
+
+        // Deterministic content with both runs and noise, without $ED bytes so that .z80 compression stays simple
+        Bytes memory(const std::size_t size, const int seed)
+        {
+            Bytes bytes(size);
+            for (std::size_t i = 0; i < size; i++)
+            {
+                const auto value = (i / 256) % 3 == 1 ? 0 : static_cast<uint8_t>(i * 7 + seed);
+                bytes[i] = value == 0xed ? 0xec : value;
+            }
+            return bytes;
+        }
+
+        // Standard ROM loader block: flag, payload and checksum
+        Bytes tapeBlock(const uint8_t flag, const Bytes& payload)
+        {
+            Bytes block(payload.size() + 1);
+            block[0] = flag;
+            std::copy(payload.begin(), payload.end(), block.begin() + 1);
+            block.push_back(std::accumulate(block.begin(), block.end(), uint8_t{}, std::bit_xor<>{}));
+            return block;
+        }
+
+        // SCREEN$ header and data blocks
+        std::vector<Bytes> tapeBlocks()
+        {
+            Bytes header{3, 'e', 'p', 'o', 'c', 'h', ' ', 'b', 'e', 'n', 'c'};
+            putWord(header, 6912);
+            putWord(header, 0x4000);
+            putWord(header, 0x8000);
+            return {tapeBlock(0x00, header), tapeBlock(0xff, memory(6912, 1))};
+        }
+
+        Bytes tap()
+        {
+            Bytes bytes;
+            for (const auto& block : tapeBlocks())
+            {
+                putWord(bytes, static_cast<uint16_t>(block.size()));
+                bytes.insert(bytes.end(), block.begin(), block.end());
+            }
+            return bytes;
+        }
+
+        Bytes tzx()
+        {
+            Bytes bytes{'Z', 'X', 'T', 'a', 'p', 'e', '!', 0x1a, 1, 20};
+            for (const auto& block : tapeBlocks())
+            {
+                bytes.push_back(0x10);  // Standard speed data block
+                putWord(bytes, 1000);
+                putWord(bytes, static_cast<uint16_t>(block.size()));
+                bytes.insert(bytes.end(), block.begin(), block.end());
+            }
+            return bytes;
+        }
+
+        // Version 2 header (48K) with the three RAM pages compressed
+        Bytes z80()
+        {
+            Bytes bytes{0x12, 0x34};                                   // A, F
+            putWord(bytes, 0x1234);                                    // BC
+            putWord(bytes, 0x5678);                                    // HL
+            putWord(bytes, 0x0000);                                    // PC: version 2 or later
+            putWord(bytes, 0xff40);                                    // SP
+            put(bytes, {0x3f, 0x00, 0x02});                            // I, R, flags
+            for (auto i = 0; i < 7; i++) putWord(bytes, 0x0000);       // DE, BC', DE', HL', AF', IY, IX
+            put(bytes, {0x01, 0x01, 0x01});                            // IFF1, IFF2, IM
+            putWord(bytes, 23);                                        // Additional header length
+            putWord(bytes, 0x8000);                                    // PC
+            bytes.push_back(0x00);                                     // Hardware mode: 48K
+            bytes.insert(bytes.end(), 20, 0x00);
+            for (const uint8_t page : {8, 4, 5})
+            {
+                const auto data = memory(0x4000, page);
+                Bytes compressed;
+                for (std::size_t i = 0; i < data.size();)
+                {
+                    std::size_t run = 1;
+                    while (i + run < data.size() && run < 255 && data[i + run] == data[i]) run++;
+                    if (run >= 5)
+                        put(compressed, {0xed, 0xed, static_cast<uint8_t>(run), data[i]});
+                    else
+                        compressed.insert(compressed.end(), data.begin() + i, data.begin() + i + run);
+                    i += run;
+                }
+                putWord(bytes, static_cast<uint16_t>(compressed.size()));
+                bytes.push_back(page);
+                bytes.insert(bytes.end(), compressed.begin(), compressed.end());
+            }
+            return bytes;
+        }
+
+        std::filesystem::path write(const std::string& name, const Bytes& bytes)
+        {
+            const auto directory = std::filesystem::temp_directory_path() / "epoch_bench";
+            std::filesystem::create_directories(directory);
+            const auto path = directory / name;
+            std::ofstream os{path, std::ios::binary};
+            os.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            return path;
+        }
+
+        std::filesystem::path sna()
+        {
+            const auto emulator = ZXSpectrumEmulator::create48K();
+            emulator->reset();
+            for (auto i = 0; i < 100; i++) emulator->frame();
+            const auto path = std::filesystem::temp_directory_path() / "epoch_bench" / "bench.sna";
+            std::filesystem::create_directories(path.parent_path());
+            save(path.string(), emulator.get());
+            return path;
+        }
+
+        void runLoad(benchmark::State& state, const std::filesystem::path& path)
+        {
+            const auto emulator = ZXSpectrumEmulator::create48K();
+            for (auto _ : state)
+            {
+                auto tape = load(path.string(), emulator.get());
+                benchmark::DoNotOptimize(tape);
+            }
+            state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+        }
+    }  // namespace
+
+    void BM_Io_LoadTap(benchmark::State& state) { runLoad(state, write("bench.tap", tap())); }
+    BENCHMARK(BM_Io_LoadTap);
+
+    void BM_Io_LoadTzx(benchmark::State& state) { runLoad(state, write("bench.tzx", tzx())); }
+    BENCHMARK(BM_Io_LoadTzx);
+
+    void BM_Io_LoadSna(benchmark::State& state) { runLoad(state, sna()); }
+    BENCHMARK(BM_Io_LoadSna);
+
+    void BM_Io_LoadZ80(benchmark::State& state) { runLoad(state, write("bench.z80", z80())); }
+    BENCHMARK(BM_Io_LoadZ80);
+
+    void BM_PulsesTape_Clock(benchmark::State& state)
+    {
+        constexpr int ClocksPerIteration = 1 << 20;
+        const auto emulator = ZXSpectrumEmulator::create48K();
+        const auto path = write("bench.tap", tap());
+        auto tape = load(path.string(), emulator.get());
+        for (auto _ : state)
+        {
+            if (tape->completed())
+            {
+                state.PauseTiming();
+                tape = load(path.string(), emulator.get());
+                state.ResumeTiming();
+            }
+            auto level = false;
+            for (auto i = 0; i < ClocksPerIteration; i++)
+            {
+                level ^= tape->clock();
+            }
+            benchmark::DoNotOptimize(level);
+        }
+        state.SetItemsProcessed(state.iterations() * ClocksPerIteration);
+    }
+    BENCHMARK(BM_PulsesTape_Clock);
+}  // namespace epoch::zxspectrum
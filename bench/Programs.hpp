@@ -0,0 +1,58 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCH_PROGRAMS_HPP_
+#define BENCH_PROGRAMS_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace epoch::bench
+{
+    // Endless loop mixing loads, ALU, stack, indexed, call/ret, DJNZ and LDIR. It only writes between $9000 and
+    // $C020 and needs a stack below $F000.
+    constexpr uint16_t SyntheticMixOrigin = 0x8000;
+    constexpr uint16_t SyntheticMixStack = 0xf000;
+    constexpr std::array<uint8_t, 0x33> SyntheticMix{
+        0x21, 0x00, 0x90,        // 8000 ld hl,$9000
+        0x11, 0x00, 0xa0,        // 8003 ld de,$A000
+        0xdd, 0x21, 0x00, 0xb0,  // 8006 ld ix,$B000
+        0x06, 0x40,              // 800A ld b,$40
+        0x7e,                    // 800C ld a,(hl)
+        0x81,                    // 800D add a,c
+        0x12,                    // 800E ld (de),a
+        0x23,                    // 800F inc hl
+        0x13,                    // 8010 inc de
+        0xc5,                    // 8011 push bc
+        0xdd, 0x4e, 0x05,        // 8012 ld c,(ix+$05)
+        0xdd, 0x77, 0x06,        // 8015 ld (ix+$06),a
+        0xc1,                    // 8018 pop bc
+        0xcd, 0x30, 0x80,        // 8019 call $8030
+        0xcb, 0x27,              // 801C sla a
+        0x10, 0xec,              // 801E djnz $800C
+        0x21, 0x00, 0x90,        // 8020 ld hl,$9000
+        0x11, 0x00, 0xc0,        // 8023 ld de,$C000
+        0x01, 0x20, 0x00,        // 8026 ld bc,$0020
+        0xed, 0xb0,              // 8029 ldir
+        0xc3, 0x00, 0x80,        // 802B jp $8000
+        0x00, 0x00,              // 802E
+        0xae,                    // 8030 xor (hl)
+        0x17,                    // 8031 rla
+        0xc9,                    // 8032 ret
+    };
+}  // namespace epoch::bench
+
+#endif
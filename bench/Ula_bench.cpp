@@ -0,0 +1,70 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/zxspectrum/src/Roms.hpp"
+#include "../src/zxspectrum/src/Ula.hpp"
+#include "../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+
+#include <random>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        void fillScreen(std::span<uint8_t> vram)
+        {
+            std::mt19937 random{1};
+            for (auto& value : vram) value = static_cast<uint8_t>(random());
+        }
+    }  // namespace
+
+    // One whole frame of beam rendering and contention bookkeeping, without the CPU (the ROM is never executed)
+    template <typename Model>
+    void BM_Ula_Frame(benchmark::State& state)
+    {
+        ModelUla<Model> ula{roms::Rom48K};
+        ula.reset();
+        fillScreen(ula.ram()[5]);
+        for (auto _ : state)
+        {
+            do
+            {
+                ula.clock();
+            } while (!ula.frameReady());
+            benchmark::DoNotOptimize(ula.screenBuffer().data());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK_TEMPLATE(BM_Ula_Frame, Model48K);
+    BENCHMARK_TEMPLATE(BM_Ula_Frame, Model128K);
+
+    void BM_ZXSpectrumEmulator_UpdateScreenBuffer(benchmark::State& state)
+    {
+        const auto emulator = ZXSpectrumEmulator::create48K();
+        fillScreen(emulator->ram()[5]);
+        emulator->frame();
+        for (auto _ : state)
+        {
+            emulator->updateScreenBuffer();
+            benchmark::DoNotOptimize(emulator->screenBuffer().data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_ZXSpectrumEmulator_UpdateScreenBuffer);
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,112 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/zxspectrum/src/Z80Cpu.hpp"
+#include "../src/zxspectrum/tools/utils.hpp"
+#include "../src/zxspectrum/tools/zexroms.hpp"
+#include "Programs.hpp"
+
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        constexpr int InstructionsPerIteration = 100000;
+
+        void runInstructions(benchmark::State& state, std::unique_ptr<RamZ80Interface> interface, const uint16_t pc,
+                             const uint16_t sp)
+        {
+            Z80Cpu cpu{*interface};
+            cpu.reset();
+            cpu.registers().pc = pc;
+            cpu.registers().sp = sp;
+            for (auto _ : state)
+            {
+                for (auto i = 0; i < InstructionsPerIteration; i++)
+                {
+                    cpu.step();
+                }
+            }
+            const auto instructions = static_cast<double>(state.iterations()) * InstructionsPerIteration;
+            state.counters["Minstructions"] = benchmark::Counter(instructions * 1e-6, benchmark::Counter::kIsRate);
+            state.counters["Mcycles"] =
+                benchmark::Counter(static_cast<double>(cpu.clockCounter()) * 1e-6, benchmark::Counter::kIsRate);
+        }
+
+        // RAM with a contention block, either with the program page contended by a 6,5,4,3,2,1,0,0 pattern on every
+        // T-state (no ULA advances the frame) or with no contended page, which only costs the page tests
+        class ContendedRamZ80Interface final : public RamZ80Interface
+        {
+        public:
+            ContendedRamZ80Interface(const std::span<uint8_t> ram, const bool contended) : RamZ80Interface{ram}
+            {
+                static constexpr uint8_t Pattern[] = {6, 5, 4, 3, 2, 1, 0, 0};
+                for (std::size_t t = 0; t < m_delays.size(); t++)
+                {
+                    m_delays[t] = Pattern[t & 0x07];
+                }
+                m_contention.pages = {false, false, contended, false};
+                m_contention.io = contended;
+                m_contention.delays = m_delays.data();
+                m_contention.activeEnd = m_contention.frameLength = m_delays.size();
+            }
+
+            [[nodiscard]] const Z80Contention* contention() const override { return &m_contention; }
+
+        private:
+            std::array<uint8_t, 256> m_delays{};
+            Z80Contention m_contention{};
+        };
+    }  // namespace
+
+    void BM_Z80Cpu_Zexdoc(benchmark::State& state)
+    {
+        // Same CP/M environment as epoch_zxspectrum_zexdoc, BDOS calls return immediately
+        std::array<uint8_t, 0x10000> ram{};
+        ram[0x0005] = 0xc3;  // JP $E400
+        ram[0x0006] = 0x00;
+        ram[0x0007] = 0xe4;
+        ram[0xe400] = 0xc9;  // RET
+        std::memcpy(ram.data() + 0x0100, zexdoc, sizeof(zexdoc));
+        runInstructions(state, std::make_unique<RamZ80Interface>(ram), 0x0100, 0xe400);
+    }
+    BENCHMARK(BM_Z80Cpu_Zexdoc);
+
+    void BM_Z80Cpu_SyntheticMix(benchmark::State& state)
+    {
+        std::array<uint8_t, 0x10000> ram{};
+        std::memcpy(ram.data() + bench::SyntheticMixOrigin, bench::SyntheticMix.data(), bench::SyntheticMix.size());
+        runInstructions(state, std::make_unique<RamZ80Interface>(ram), bench::SyntheticMixOrigin,
+                        bench::SyntheticMixStack);
+    }
+    BENCHMARK(BM_Z80Cpu_SyntheticMix);
+
+    void BM_Z80Cpu_SyntheticMixContention(benchmark::State& state)
+    {
+        // Arg 0: contention block with no contended page, to compare with BM_Z80Cpu_SyntheticMix (no block at all).
+        // Arg 1: the program and the data it reads ($8000-$BFFF) in a contended page.
+        std::array<uint8_t, 0x10000> ram{};
+        std::memcpy(ram.data() + bench::SyntheticMixOrigin, bench::SyntheticMix.data(), bench::SyntheticMix.size());
+        runInstructions(state, std::make_unique<ContendedRamZ80Interface>(ram, state.range(0) != 0),
+                        bench::SyntheticMixOrigin, bench::SyntheticMixStack);
+    }
+    BENCHMARK(BM_Z80Cpu_SyntheticMixContention)->Arg(0)->Arg(1);
+}  // namespace epoch::zxspectrum
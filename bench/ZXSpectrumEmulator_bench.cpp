@@ -0,0 +1,78 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/zxspectrum/src/Ula.hpp"
+#include "../src/zxspectrum/src/Z80Cpu.hpp"
+#include "../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+#include "Programs.hpp"
+
+#include <functional>
+#include <memory>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        using Factory = std::function<std::unique_ptr<ZXSpectrumEmulator>()>;
+
+        // Boots to the BASIC prompt, the emulator is then mostly waiting for keys in the ROM idle loop
+        std::unique_ptr<ZXSpectrumEmulator> boot(const Factory& factory)
+        {
+            auto emulator = factory();
+            emulator->reset();
+            for (auto i = 0; i < 200; i++) emulator->frame();
+            return emulator;
+        }
+
+        void runFrames(benchmark::State& state, ZXSpectrumEmulator& emulator)
+        {
+            for (auto _ : state)
+            {
+                emulator.frame();
+                benchmark::DoNotOptimize(emulator.screenBuffer().data());
+            }
+            state.SetItemsProcessed(state.iterations());
+            state.counters["emulated_s"] =
+                benchmark::Counter(static_cast<double>(state.iterations()) / emulator.info().framesPerSecond,
+                                   benchmark::Counter::kIsRate);
+        }
+    }  // namespace
+
+    void BM_ZXSpectrumEmulator_FrameIdle(benchmark::State& state, const Factory& factory)
+    {
+        const auto emulator = boot(factory);
+        runFrames(state, *emulator);
+    }
+    BENCHMARK_CAPTURE(BM_ZXSpectrumEmulator_FrameIdle, zx48k, &ZXSpectrumEmulator::create48K);
+    BENCHMARK_CAPTURE(BM_ZXSpectrumEmulator_FrameIdle, zx128k, &ZXSpectrumEmulator::create128K);
+
+    // The CPU never idles: the synthetic mix runs with the ROM interrupt handler
+    void BM_ZXSpectrumEmulator_FrameBusy(benchmark::State& state, const Factory& factory)
+    {
+        const auto emulator = boot(factory);
+        for (std::size_t i = 0; i < bench::SyntheticMix.size(); i++)
+        {
+            emulator->ula()->write(static_cast<uint16_t>(bench::SyntheticMixOrigin + i), bench::SyntheticMix[i]);
+        }
+        emulator->cpu()->registers().pc = bench::SyntheticMixOrigin;
+        emulator->cpu()->registers().sp = bench::SyntheticMixStack;
+        runFrames(state, *emulator);
+    }
+    BENCHMARK_CAPTURE(BM_ZXSpectrumEmulator_FrameBusy, zx48k, &ZXSpectrumEmulator::create48K);
+    BENCHMARK_CAPTURE(BM_ZXSpectrumEmulator_FrameBusy, zx128k, &ZXSpectrumEmulator::create128K);
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+#
+# Epoch is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Epoch is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Compares two epoch_bench JSON outputs and fails when a benchmark got slower than the threshold.
+
+    epoch_bench --benchmark_repetitions=5 --benchmark_out=base.json --benchmark_out_format=json
+    python3 bench/compare.py base.json new.json --threshold 5
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path, encoding="utf-8") as f:
+        benchmarks = json.load(f)["benchmarks"]
+    # With repetitions the median is the most stable figure, otherwise use the single iteration run
+    medians = {b["run_name"]: b for b in benchmarks if b.get("aggregate_name") == "median"}
+    runs = {}
+    for b in benchmarks:
+        name = b.get("run_name", b["name"])
+        if b.get("run_type", "iteration") == "iteration" and name not in medians:
+            runs.setdefault(name, b)
+    runs.update(medians)
+    return {name: b[metric] for name, b in runs.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base", help="reference epoch_bench JSON output")
+    parser.add_argument("new", help="epoch_bench JSON output to check")
+    parser.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown in percent (default 5)")
+    parser.add_argument("--metric", choices=["cpu_time", "real_time"], default="cpu_time")
+    args = parser.parse_args()
+
+    base = load(args.base, args.metric)
+    new = load(args.new, args.metric)
+    regressions = 0
+    width = max(len(name) for name in base | new)
+    print(f"{'Benchmark':<{width}}  {'Base':>14}  {'New':>14}  {'Change':>8}")
+    for name in sorted(base | new):
+        if name not in base or name not in new:
+            print(f"{name:<{width}}  {'only in ' + ('new' if name in new else 'base'):>40}")
+            continue
+        change = (new[name] - base[name]) / base[name] * 100.0
+        regression = change > args.threshold
+        regressions += regression
+        flag = "  REGRESSION" if regression else ""
+        print(f"{name:<{width}}  {base[name]:>14.1f}  {new[name]:>14.1f}  {change:>+7.1f}%{flag}")
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower than {args.threshold}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
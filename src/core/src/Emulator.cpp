@@ -33,7 +33,10 @@ namespace epoch
 
     void Emulator::clock()
     {
-        doClock();
+        if (!m_paused) [[likely]]
+        {
+            doClock();
+        }
         m_elapsed += m_clockDuration;
     }
 
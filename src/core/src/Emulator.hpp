@@ -20,6 +20,8 @@
 #include "Keyboard.hpp"
 #include "SoundSample.hpp"
 
+#include <cstdint>
+#include <functional>
 #include <span>
 #include <string>
 #include <vector>
@@ -36,6 +38,44 @@ namespace epoch
         bool save;
     };
 
+    // Execution counters of a single CPU instruction, see Emulator::cpuStatistics
+    struct EmulatorCpuStatistic
+    {
+        std::string instruction;
+        uint64_t executions;
+        uint64_t cycles;
+    };
+
+    // Guest code profile, times are average T-states per frame
+    struct EmulatorProfileEntry
+    {
+        std::string name;
+        double selfTStates;
+        double inclusiveTStates;
+    };
+    struct EmulatorProfile
+    {
+        uint64_t frames;
+        double busyTStates;
+        double idleTStates;
+        std::vector<float> frameLoad;  // busy fraction of the last frames
+        std::vector<EmulatorProfileEntry> routines;
+    };
+
+    // Debugger views of the machine state
+    struct EmulatorRegister
+    {
+        std::string name;
+        uint16_t value;
+        int bits;
+    };
+    struct EmulatorDisassemblyLine
+    {
+        uint16_t address;
+        uint8_t length;
+        std::string text;
+    };
+
     struct EmulatorInfo
     {
         unsigned width;
@@ -70,6 +110,14 @@ namespace epoch
         SoundSample generateNextAudioSample();
 
         [[nodiscard]] virtual std::span<const uint32_t> screenBuffer() = 0;
+        // Same screen as indices in palette(), a quarter of the size of screenBuffer() and cheaper to produce. Empty
+        // when the emulator has no indexed screen.
+        [[nodiscard]] virtual std::span<const uint8_t> indexedScreenBuffer() { return {}; }
+        // RGBA colors, same layout as screenBuffer()
+        [[nodiscard]] virtual std::span<const uint32_t> palette() const { return {}; }
+        // Frames completed since the last reset, tells the frontend when the screen changed. Always 0 when the
+        // emulator does not count them.
+        [[nodiscard]] virtual uint64_t frameCounter() const { return 0; }
 
         [[nodiscard]] virtual SoundSample audioOut() const = 0;
         void audioIn(const float sample) { m_audioIn = sample; }
@@ -78,6 +126,40 @@ namespace epoch
 
         virtual Tape* tape() { return nullptr; }
 
+        // Per-instruction counters collected since the last reset, empty when the emulator was built without them
+        [[nodiscard]] virtual std::vector<EmulatorCpuStatistic> cpuStatistics() const { return {}; }
+        virtual void resetCpuStatistics() {}
+
+        // Guest profiler, not available on every emulator (guestProfile() stays empty)
+        virtual void setGuestProfiling(bool enabled) {}
+        [[nodiscard]] virtual bool guestProfiling() const { return false; }
+        [[nodiscard]] virtual EmulatorProfile guestProfile() const { return {}; }
+        virtual void resetGuestProfile() {}
+        virtual void loadSymbols(const std::string& path) {}
+
+        // Debugger: a paused emulator keeps its time running but does not execute anything. Emulators with
+        // breakpoints pause themselves when one is hit.
+        void pause() { m_paused = true; }
+        virtual void resume() { m_paused = false; }
+        [[nodiscard]] bool paused() const { return m_paused; }
+        // Executes a single instruction while paused
+        virtual void step() {}
+        // Like step() but runs subroutine calls, repeated instructions and HALT to completion
+        virtual void stepOver() { step(); }
+        // Gives an attached remote debugger the chance to run, called by the frontend between frames. Never blocks:
+        // while the debugger holds the machine it stays paused, and wake is called from another thread when the
+        // debugger has new requests, so that the frontend calls serviceDebugger() again without waiting.
+        virtual void serviceDebugger() {}
+        virtual void setDebuggerWake(std::function<void()> wake) {}
+
+        // Debugger views, empty when not supported. peek() reads memory without side effects on the machine.
+        [[nodiscard]] virtual uint8_t peek(uint16_t address) { return 0; }
+        [[nodiscard]] virtual std::vector<EmulatorRegister> debugRegisters() const { return {}; }
+        [[nodiscard]] virtual uint16_t programCounter() const { return 0; }
+        [[nodiscard]] virtual uint16_t stackPointer() const { return 0; }
+        // Listing of the whole address space, updated on each call
+        [[nodiscard]] virtual std::span<const EmulatorDisassemblyLine> disassembly() { return {}; }
+
     public:
         [[nodiscard]] const EmulatorInfo& info() const;
 
@@ -90,6 +172,7 @@ namespace epoch
     private:
         double m_clockDuration;
         double m_elapsed{};
+        bool m_paused{};
     };
 }  // namespace epoch
 
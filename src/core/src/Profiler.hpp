@@ -19,9 +19,9 @@
 
 #include <chrono>
 
+#ifdef EPOCH_PROFILER
 namespace epoch
 {
-#ifdef EPOCH_PROFILER
     class BlockProfiler final
     {
     public:
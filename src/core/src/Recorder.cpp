@@ -0,0 +1,391 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Recorder.hpp"
+
+#include "Emulator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace epoch
+{
+    namespace
+    {
+        constexpr uint32_t VideoMagic = 0x31565045;  // "EPV1"
+        constexpr uint16_t VideoVersion = 1;
+
+        struct VideoHeader
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint8_t littleEndian;
+            uint8_t reserved;
+            uint32_t width;
+            uint32_t height;
+            uint32_t paletteSize;
+            uint32_t reserved2;
+            double framesPerSecond;
+        };
+        static_assert(sizeof(VideoHeader) == 32);
+
+        enum FrameType : uint8_t
+        {
+            KeyFrame = 0,
+            DeltaFrame = 1,
+            RepeatFrame = 2,
+        };
+
+        // 16 bit PCM, the fields are little endian like every host the emulator runs on
+        struct WavHeader
+        {
+            char riff[4];
+            uint32_t riffSize;
+            char wave[4];
+            char fmt[4];
+            uint32_t fmtSize;
+            uint16_t format;
+            uint16_t channels;
+            uint32_t sampleRate;
+            uint32_t byteRate;
+            uint16_t blockAlign;
+            uint16_t bitsPerSample;
+            char data[4];
+            uint32_t dataSize;
+        };
+        static_assert(sizeof(WavHeader) == 44);
+
+        // PackBits-like: a control byte below 0x80 is followed by control + 1 literal bytes, otherwise the next byte
+        // is repeated (control & 0x7f) + 3 times. XOR deltas of mostly static screens are long runs of zeros.
+        void packBits(const std::span<const uint8_t> in, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            std::size_t i = 0;
+            while (i < in.size())
+            {
+                std::size_t run = 1;
+                while (i + run < in.size() && run < 130 && in[i + run] == in[i]) ++run;
+                if (run >= 3)
+                {
+                    out.push_back(static_cast<uint8_t>(0x80 | (run - 3)));
+                    out.push_back(in[i]);
+                    i += run;
+                    continue;
+                }
+                // Literals up to the next run worth encoding
+                std::size_t literal = 0;
+                while (i + literal < in.size() && literal < 128)
+                {
+                    const auto j = i + literal;
+                    if (j + 2 < in.size() && in[j] == in[j + 1] && in[j] == in[j + 2]) break;
+                    ++literal;
+                }
+                out.push_back(static_cast<uint8_t>(literal - 1));
+                out.insert(out.end(), in.begin() + static_cast<std::ptrdiff_t>(i),
+                           in.begin() + static_cast<std::ptrdiff_t>(i + literal));
+                i += literal;
+            }
+        }
+
+        // False when in does not decode to exactly out.size() bytes
+        bool unpackBits(const std::span<const uint8_t> in, const std::span<uint8_t> out)
+        {
+            std::size_t i = 0, o = 0;
+            while (i < in.size())
+            {
+                const auto control = in[i++];
+                if (control & 0x80)
+                {
+                    const std::size_t run = (control & 0x7f) + 3;
+                    if (i >= in.size() || o + run > out.size()) return false;
+                    std::memset(&out[o], in[i++], run);
+                    o += run;
+                }
+                else
+                {
+                    const std::size_t literal = control + 1;
+                    if (i + literal > in.size() || o + literal > out.size()) return false;
+                    std::memcpy(&out[o], &in[i], literal);
+                    i += literal;
+                    o += literal;
+                }
+            }
+            return o == out.size();
+        }
+    }  // namespace
+
+    Recorder::Recorder(const std::filesystem::path& path, const EmulatorInfo& info,
+                       const std::span<const uint32_t> palette, const unsigned sampleRate)
+        : m_screenSize{static_cast<std::size_t>(info.width) * info.height}
+    {
+        if (palette.empty() || palette.size() > 256) throw std::runtime_error("Recording needs an indexed screen");
+
+        auto videoPath = path;
+        videoPath += ".epv";
+        m_video.open(videoPath, std::ios::binary);
+        if (!m_video) throw std::runtime_error("Cannot open " + videoPath.string() + " for writing");
+        auto wavPath = path;
+        wavPath += ".wav";
+        m_wav.open(wavPath, std::ios::binary);
+        if (!m_wav) throw std::runtime_error("Cannot open " + wavPath.string() + " for writing");
+
+        const VideoHeader videoHeader{VideoMagic,
+                                      VideoVersion,
+                                      std::endian::native == std::endian::little,
+                                      0,
+                                      info.width,
+                                      info.height,
+                                      static_cast<uint32_t>(palette.size()),
+                                      0,
+                                      info.framesPerSecond};
+        m_video.write(reinterpret_cast<const char*>(&videoHeader), sizeof(videoHeader));
+        m_video.write(reinterpret_cast<const char*>(palette.data()),
+                      static_cast<std::streamsize>(palette.size_bytes()));
+        // Sizes are filled in by finalize()
+        const WavHeader wavHeader{{'R', 'I', 'F', 'F'}, 0, {'W', 'A', 'V', 'E'}, {'f', 'm', 't', ' '}, 16, 1, 2,
+                                  sampleRate, sampleRate * 4, 4, 16, {'d', 'a', 't', 'a'}, 0};
+        m_wav.write(reinterpret_cast<const char*>(&wavHeader), sizeof(wavHeader));
+        if (!m_video || !m_wav) throw std::runtime_error("Cannot write recording headers");
+        m_bytes = sizeof(videoHeader) + palette.size_bytes() + sizeof(wavHeader);
+
+        // A few frames worth of audio, so audio() does not allocate unless the encoder falls far behind
+        const auto audioReserve = static_cast<std::size_t>(sampleRate / info.framesPerSecond) * 2 * 4;
+        for (auto& slot : m_slots)
+        {
+            slot.screen.resize(m_screenSize);
+            slot.audio.reserve(audioReserve);
+        }
+        for (std::size_t i = PoolSize - 1; i > 0; --i) m_free.push_back(i);
+        m_current = 0;
+        m_previous.resize(m_screenSize);
+        m_delta.resize(m_screenSize);
+
+        m_thread = std::thread{[this] { run(); }};
+    }
+
+    Recorder::~Recorder()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+
+        // The slot being filled has the audio after the last frame, and that frame too when it was dropped
+        auto& tail = m_slots[m_current];
+        const auto frame = tail.repeats > 0;
+        if (frame) tail.repeats--;
+        encode(tail, frame);
+        finalize();
+    }
+
+    void Recorder::audio(const std::span<const float> samples)
+    {
+        auto& audio = m_slots[m_current].audio;
+        audio.insert(audio.end(), samples.begin(), samples.end());
+    }
+
+    void Recorder::frame(const std::span<const uint8_t> indices)
+    {
+        assert(indices.size() == m_screenSize);
+        auto& slot = m_slots[m_current];
+        std::memcpy(slot.screen.data(), indices.data(), m_screenSize);
+        {
+            std::lock_guard lock{m_mutex};
+            if (m_free.empty())
+            {
+                // The next frame overwrites this one in the same slot and is written twice
+                slot.repeats++;
+                m_dropped++;
+                return;
+            }
+            m_queue.push_back(m_current);
+            m_current = m_free.back();
+            m_free.pop_back();
+            if (m_queue.size() > m_maxQueueDepth) m_maxQueueDepth = m_queue.size();
+        }
+        m_condition.notify_one();
+
+        auto& next = m_slots[m_current];
+        next.audio.clear();
+        next.repeats = 0;
+    }
+
+    void Recorder::flush()
+    {
+        std::unique_lock lock{m_mutex};
+        m_paused = false;
+        m_condition.notify_one();
+        m_freed.wait(lock, [this] { return m_free.size() == PoolSize - 1; });
+    }
+
+    void Recorder::setEncoderPaused(const bool paused)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_paused = paused;
+        }
+        m_condition.notify_one();
+    }
+
+    RecorderStatistics Recorder::statistics() const
+    {
+        std::size_t queueDepth;
+        {
+            std::lock_guard lock{m_mutex};
+            queueDepth = m_queue.size();
+        }
+        return {m_frames, m_dropped, queueDepth, m_maxQueueDepth, m_bytes};
+    }
+
+    void Recorder::run()
+    {
+        while (true)
+        {
+            std::size_t index;
+            {
+                std::unique_lock lock{m_mutex};
+                m_condition.wait(lock, [this] { return m_stop || (!m_paused && !m_queue.empty()); });
+                // Stopping still drains the queue, paused or not
+                if (m_queue.empty()) break;
+                index = m_queue.front();
+                m_queue.pop_front();
+            }
+            encode(m_slots[index], true);
+            {
+                std::lock_guard lock{m_mutex};
+                m_free.push_back(index);
+            }
+            m_freed.notify_all();
+        }
+    }
+
+    void Recorder::encode(const Slot& slot, const bool frame)
+    {
+        if (m_failed) return;
+        writeAudio(slot.audio);
+        if (frame)
+        {
+            if (m_sinceKeyFrame == 0)
+            {
+                packBits(slot.screen, m_payload);
+                writeFrame(KeyFrame, m_payload);
+            }
+            else
+            {
+                for (std::size_t i = 0; i < m_screenSize; ++i) m_delta[i] = slot.screen[i] ^ m_previous[i];
+                packBits(m_delta, m_payload);
+                writeFrame(DeltaFrame, m_payload);
+            }
+            m_sinceKeyFrame = (m_sinceKeyFrame + 1) % KeyFrameInterval;
+            std::memcpy(m_previous.data(), slot.screen.data(), m_screenSize);
+            for (uint32_t i = 0; i < slot.repeats; ++i) writeFrame(RepeatFrame, {});
+        }
+        if (!m_video || !m_wav) m_failed = true;
+    }
+
+    void Recorder::writeFrame(const uint8_t type, const std::span<const uint8_t> payload)
+    {
+        const auto size = static_cast<uint32_t>(payload.size());
+        m_video.put(static_cast<char>(type));
+        m_video.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_video.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        m_frames++;
+        m_bytes += 1 + sizeof(size) + payload.size();
+    }
+
+    void Recorder::writeAudio(const std::span<const float> samples)
+    {
+        m_pcm.resize(samples.size());
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            m_pcm[i] = static_cast<int16_t>(std::lround(std::clamp(samples[i], -1.f, 1.f) * 32767.f));
+        }
+        const auto bytes = m_pcm.size() * sizeof(int16_t);
+        m_wav.write(reinterpret_cast<const char*>(m_pcm.data()), static_cast<std::streamsize>(bytes));
+        m_audioBytes += bytes;
+        m_bytes += bytes;
+    }
+
+    void Recorder::finalize()
+    {
+        // Past 4GB (about 6 hours at 48kHz) the sizes saturate, most players then read up to the end of the file
+        const auto dataSize = static_cast<uint32_t>(
+            std::min<uint64_t>(m_audioBytes, std::numeric_limits<uint32_t>::max() - sizeof(WavHeader)));
+        const uint32_t riffSize = dataSize + sizeof(WavHeader) - 8;
+        m_wav.seekp(offsetof(WavHeader, riffSize));
+        m_wav.write(reinterpret_cast<const char*>(&riffSize), sizeof(riffSize));
+        m_wav.seekp(offsetof(WavHeader, dataSize));
+        m_wav.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+        m_wav.close();
+        m_video.close();
+    }
+
+    RecordingReader::RecordingReader(const std::filesystem::path& path) : m_is{path, std::ios::binary}
+    {
+        if (!m_is) throw std::runtime_error("Cannot open recording file");
+        VideoHeader header{};
+        m_is.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!m_is || header.magic != VideoMagic) throw std::runtime_error("Invalid recording file");
+        if (header.version != VideoVersion ||
+            static_cast<bool>(header.littleEndian) != (std::endian::native == std::endian::little) ||
+            header.paletteSize == 0 || header.paletteSize > 256)
+            throw std::runtime_error("Unsupported recording file format");
+        m_width = header.width;
+        m_height = header.height;
+        m_framesPerSecond = header.framesPerSecond;
+        m_palette.resize(header.paletteSize);
+        m_is.read(reinterpret_cast<char*>(m_palette.data()),
+                  static_cast<std::streamsize>(m_palette.size() * sizeof(uint32_t)));
+        if (!m_is) throw std::runtime_error("Truncated recording file");
+        m_current.resize(static_cast<std::size_t>(m_width) * m_height);
+        m_delta.resize(m_current.size());
+    }
+
+    bool RecordingReader::next(std::vector<uint8_t>& indices)
+    {
+        const auto type = m_is.get();
+        if (type == std::ifstream::traits_type::eof()) return false;
+        uint32_t size{};
+        m_is.read(reinterpret_cast<char*>(&size), sizeof(size));
+        m_payload.resize(size);
+        m_is.read(reinterpret_cast<char*>(m_payload.data()), size);
+        if (!m_is) throw std::runtime_error("Truncated recording file");
+        switch (type)
+        {
+            case KeyFrame:
+                if (!unpackBits(m_payload, m_current)) throw std::runtime_error("Corrupted recording frame");
+                break;
+            case DeltaFrame:
+                if (!unpackBits(m_payload, m_delta)) throw std::runtime_error("Corrupted recording frame");
+                for (std::size_t i = 0; i < m_current.size(); ++i) m_current[i] ^= m_delta[i];
+                break;
+            case RepeatFrame:
+                break;
+            default:
+                throw std::runtime_error("Invalid recording frame type");
+        }
+        indices.assign(m_current.begin(), m_current.end());
+        return true;
+    }
+}  // namespace epoch
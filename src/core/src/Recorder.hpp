@@ -0,0 +1,158 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_EPOCH_CORE_RECORDER_HPP_
+#define SRC_EPOCH_CORE_RECORDER_HPP_
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace epoch
+{
+    struct EmulatorInfo;
+
+    struct RecorderStatistics
+    {
+        uint64_t frames;  // written to the video, repeated ones included
+        uint64_t dropped;  // replaced by a repeat of a later frame because the encoder was behind
+        std::size_t queueDepth;
+        std::size_t maxQueueDepth;
+        uint64_t bytes;  // written to both files
+    };
+
+    // Records the palette indexed screen to <path>.epv and the stereo audio to <path>.wav. The caller only copies
+    // into pooled buffers, the encoder thread compresses and writes them. A frame arriving with the pool exhausted is
+    // dropped, and so is every following one until a buffer is free again: they are all recorded as repeats of the
+    // frame that finally gets the buffer, so the video never loses time against the audio.
+    //
+    // The .epv stream is a header (see RecordingReader) followed by frames, each either a key frame or the delta
+    // from the previous one: run-length encoded palette indices, or their XOR with the previous frame.
+    class Recorder final
+    {
+    public:
+        Recorder(const std::filesystem::path& path, const EmulatorInfo& info, std::span<const uint32_t> palette,
+                 unsigned sampleRate);
+        // Writes whatever is still queued and completes both files
+        ~Recorder();
+
+    public:
+        Recorder(const Recorder& other) = delete;
+        Recorder(Recorder&& other) noexcept = delete;
+        Recorder& operator=(const Recorder& other) = delete;
+        Recorder& operator=(Recorder&& other) noexcept = delete;
+
+    public:
+        // Interleaved stereo samples generated since the previous call; frame() and audio() from the same thread
+        void audio(std::span<const float> samples);
+        // One memcpy of the screen, and a short lock to hand the buffer over to the encoder
+        void frame(std::span<const uint8_t> indices);
+
+        // Waits until the encoder has written every queued frame, resuming it if paused. Offline recordings call it
+        // often enough not to drop frames.
+        void flush();
+        // A paused encoder leaves the frames queued, so that tests can exhaust the pool
+        void setEncoderPaused(bool paused);
+
+        [[nodiscard]] RecorderStatistics statistics() const;
+        // Set by the encoder on a write error, the following frames are discarded
+        [[nodiscard]] bool failed() const { return m_failed; }
+
+        static constexpr std::size_t PoolSize = 16;
+        static constexpr uint32_t KeyFrameInterval = 250;
+
+    private:
+        struct Slot
+        {
+            std::vector<uint8_t> screen{};
+            std::vector<float> audio{};
+            uint32_t repeats{};
+        };
+
+        void run();
+        void encode(const Slot& slot, bool frame);
+        void writeFrame(uint8_t type, std::span<const uint8_t> payload);
+        void writeAudio(std::span<const float> samples);
+        void finalize();
+
+    private:
+        std::ofstream m_video;
+        std::ofstream m_wav;
+        std::size_t m_screenSize;
+
+        std::array<Slot, PoolSize> m_slots{};
+        std::size_t m_current{};
+
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        std::condition_variable m_freed{};
+        std::vector<std::size_t> m_free{};
+        std::deque<std::size_t> m_queue{};
+        bool m_stop{};
+        bool m_paused{};
+
+        // Encoder thread only
+        std::vector<uint8_t> m_previous{};
+        std::vector<uint8_t> m_delta{};
+        std::vector<uint8_t> m_payload{};
+        std::vector<int16_t> m_pcm{};
+        uint32_t m_sinceKeyFrame{};
+        uint64_t m_audioBytes{};
+
+        std::atomic<uint64_t> m_frames{};
+        std::atomic<uint64_t> m_dropped{};
+        std::atomic<std::size_t> m_maxQueueDepth{};
+        std::atomic<uint64_t> m_bytes{};
+        std::atomic<bool> m_failed{};
+        std::thread m_thread{};
+    };
+
+    // Decodes a .epv stream written by Recorder
+    class RecordingReader final
+    {
+    public:
+        explicit RecordingReader(const std::filesystem::path& path);
+
+    public:
+        [[nodiscard]] unsigned width() const { return m_width; }
+        [[nodiscard]] unsigned height() const { return m_height; }
+        [[nodiscard]] double framesPerSecond() const { return m_framesPerSecond; }
+        [[nodiscard]] const std::vector<uint32_t>& palette() const { return m_palette; }
+
+        // Decodes the next frame into indices, false at the end of the stream
+        bool next(std::vector<uint8_t>& indices);
+
+    private:
+        std::ifstream m_is;
+        unsigned m_width{};
+        unsigned m_height{};
+        double m_framesPerSecond{};
+        std::vector<uint32_t> m_palette{};
+        std::vector<uint8_t> m_current{};
+        std::vector<uint8_t> m_delta{};
+        std::vector<uint8_t> m_payload{};
+    };
+}  // namespace epoch
+
+#endif
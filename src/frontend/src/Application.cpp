@@ -17,6 +17,8 @@
 #include "Application.hpp"
 
 #include "AudioPlayer.hpp"
+#include "EmulationThread.hpp"
+#include "FramePacer.hpp"
 #include "GraphicContext.hpp"
 #include "Gui.hpp"
 #include "SettingsManager.hpp"
@@ -28,11 +30,65 @@
 #include <imgui.h>
 #include <ImGuiFileDialog.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
 #include <numeric>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
 
 namespace epoch::frontend
 {
+    namespace
+    {
+        void togglePause(Emulator& emulator)
+        {
+            if (emulator.paused())
+                emulator.resume();
+            else
+                emulator.pause();
+        }
+
+        // Per user cache directory of the platform, next to the settings file when the environment doesn't tell
+        std::filesystem::path shaderCacheDirectory(const std::filesystem::path& settings)
+        {
+            const auto env = [](const char* name)
+            {
+                const auto value = std::getenv(name);
+                return value ? std::filesystem::path{value} : std::filesystem::path{};
+            };
+#if defined(_WIN32)
+            auto base = env("LOCALAPPDATA");
+#elif defined(__APPLE__)
+            auto base = env("HOME");
+            if (!base.empty()) base /= "Library/Caches";
+#else
+            // Relative XDG paths are invalid and must be ignored
+            auto base = env("XDG_CACHE_HOME");
+            if (!base.is_absolute())
+            {
+                base = env("HOME");
+                if (!base.empty()) base /= ".cache";
+            }
+#endif
+            if (!base.is_absolute()) return settings.parent_path() / "shadercache";
+            return base / "epoch" / "shadercache";
+        }
+
+        // epoch-YYYYMMDD-HHMMSS in the working directory, the recorder adds the extensions
+        std::filesystem::path recordingPath()
+        {
+            const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            char name[32];
+            std::strftime(name, sizeof(name), "epoch-%Y%m%d-%H%M%S", std::localtime(&now));
+            return std::filesystem::current_path() / name;
+        }
+    }  // namespace
+
     Application::Application(ApplicationConfiguration configuration)
         : m_settings{std::make_unique<SettingsManager>()}, m_configuration{std::move(configuration)}
     {
@@ -52,13 +108,20 @@ namespace epoch::frontend
             m_currentEntry = &entry;
             m_settings->current().emulator.key = m_currentEntry->key;
         }
-        m_emulator = m_currentEntry->factory();
-
         m_shaders.emplace_back("default", "<none>", shaders::DEFAULT);
         m_shaders.emplace_back("crt-easymode", "crt-easymode", shaders::CRT_EASYMODE);
         m_shaders.emplace_back("crt-geom", "crt-geom", shaders::CRT_GEOM);
-
-        init();
+        const auto builtinShader = [](const std::string& name) -> std::string
+        {
+            if (name == "pal-blur") return std::string{shaders::PAL_BLUR};
+            if (name == "crt-easymode") return std::string{shaders::CRT_EASYMODE};
+            if (name == "crt-geom") return std::string{shaders::CRT_GEOM};
+            throw std::runtime_error("Unknown shader: " + name);
+        };
+        m_shaders.emplace_back("crt-easymode-pal", "crt-easymode + PAL blur",
+                               parseShaderPreset(shaders::CRT_EASYMODE_PAL, builtinShader));
+
+        init(m_currentEntry->factory());
     }
 
     Application::~Application() = default;
@@ -68,28 +131,10 @@ namespace epoch::frontend
         m_time = m_window->time();
         while (m_window->nextFrame())
         {
-            {
-                PROFILE_BLOCK(&m_profiling.emulation[m_profiling.index]);
-                if (const auto samples = m_audio->neededSamples(); samples > 0)
-                {
-                    m_audioBuffer.resize(samples * 2);
-                    if (m_running)
-                    {
-                        unsigned long i = 0;
-                        for (unsigned long x = 0; x < samples; ++x)
-                        {
-                            const auto sample = m_emulator->generateNextAudioSample();
-                            m_audioBuffer[i++] = sample.left;
-                            m_audioBuffer[i++] = sample.right;
-                        }
-                    }
-                    else
-                    {
-                        std::memset(m_audioBuffer.data(), 0, sizeof(m_audioBuffer[0]) * m_audioBuffer.size());
-                    }
-                    m_audio->push(m_audioBuffer);
-                }
-            }
+            m_pacer->presented();
+#ifdef EPOCH_PROFILER
+            m_profiling.emulation[m_profiling.index] = m_emulation->chunkTime();
+#endif
 
             auto currentTime = m_window->time();
             if (currentTime <= m_time) currentTime = m_time + 0.00001;
@@ -98,7 +143,23 @@ namespace epoch::frontend
 
             {
                 PROFILE_BLOCK(&m_profiling.render[m_profiling.index]);
-                m_context->updateScreen(m_emulator->screenBuffer());
+                // A new frame is held until the refresh it belongs to, newer ones wait in the emulation thread
+                if (!m_framePending && m_emulation->updateFrame())
+                {
+                    m_framePending = true;
+                    m_pacer->arrived(m_emulation->frame().number);
+                }
+                if (m_framePending && m_pacer->due(m_emulation->frame().number))
+                {
+                    const auto& frame = m_emulation->frame();
+                    if (!frame.indices.empty())
+                        m_context->updateScreen(frame.indices);
+                    else if (!frame.pixels.empty())
+                        m_context->updateScreen(frame.pixels);
+                    m_pacer->shown(frame.number);
+                    m_framePending = false;
+                }
+                m_context->setFrameBlend(m_pacer->blend());
                 render();
             }
 
@@ -116,30 +177,33 @@ namespace epoch::frontend
         return 0;
     }
 
-    void Application::init()
+    void Application::init(std::shared_ptr<Emulator> emulator)
     {
         assert(!m_window);
-        const auto& emulatorInfo = m_emulator->info();
+        const auto& emulatorInfo = emulator->info();
         m_window = std::make_unique<Window>(WindowInfo{
             .title = "Epoch emulator: " + m_currentEntry->name,
             .width = emulatorInfo.width * 2,
             .height = emulatorInfo.height * 2,
         });
-        m_context = std::make_unique<GraphicContext>();
+        m_context = std::make_unique<GraphicContext>(shaderCacheDirectory(m_settings->path()));
         m_gui = std::make_unique<Gui>(m_settings->current().ui.imgui.c_str());
-        m_audio = std::make_unique<AudioPlayer>(AudioSampleRate);
+        // Native rate of the device, the emulation thread resamples from AudioSampleRate
+        m_audio = std::make_unique<AudioPlayer>(0);
+        m_audio->setLowLatency(m_settings->current().emulator.lowLatencyAudio);
 
         m_window->setCharCallback([&](const unsigned int c) { m_gui->charEvent(c); });
         m_window->setContentScaleCallback([&](const float xscale, const float yscale)
                                           { m_gui->contentScaleEvent(std::max(xscale, yscale)); });
         m_window->setCursorEnterCallback([&](const bool entered) { m_gui->cursorEnterEvent(entered); });
         m_window->setCursorPosCallback([&](const float x, const float y) { m_gui->cursorPosEvent(x, y); });
-        m_window->setFileDropCallback([&](const char* path) { m_emulator->load(path); });
+        m_window->setFileDropCallback(
+            [&](const char* path) { m_emulation->post([path = std::string{path}](Emulator& e) { e.load(path); }); });
         m_window->setFocusCallback([&](const bool focused) { m_gui->focusEvent(focused); });
         m_window->setKeyboardCallback(
             [&](const Key key, const KeyAction action)
             {
-                if (!m_gui->wantKeyboardEvents()) m_emulator->keyEvent(key, action);
+                if (!m_gui->wantKeyboardEvents()) m_emulation->keyEvent(key, action);
                 m_gui->keyEvent(key, action);
             });
         m_window->setMouseButtonCallback([&](const int button, const int action)
@@ -148,7 +212,15 @@ namespace epoch::frontend
 
         m_gui->contentScaleEvent(std::max(m_window->scaleX(), m_window->scaleY()));
 
-        m_context->init(m_emulator->info().width, m_emulator->info().height);
+        // The palette is looked up by the shaders when the emulator provides the screen as indices
+        m_context->init(emulatorInfo.width, emulatorInfo.height, !emulator->indexedScreenBuffer().empty());
+        m_context->updatePalette(emulator->palette());
+        m_aspectRatio = emulatorInfo.aspectRatio();
+        m_pacer = std::make_unique<FramePacer>(emulatorInfo.framesPerSecond, m_window->refreshRate());
+        m_frameBlending = m_settings->current().ui.frameBlending;
+        m_context->setFrameBlending(m_frameBlending);
+        m_adaptiveSync = m_settings->current().ui.adaptiveSync && m_window->adaptiveSyncSupported();
+        m_window->setAdaptiveSync(m_adaptiveSync);
 
         std::size_t shader = 0;
         for (std::size_t i = 0; i < m_shaders.size(); ++i)
@@ -161,14 +233,16 @@ namespace epoch::frontend
         }
         setShader(shader);
 
-        m_emulator->reset();
+        emulator->reset();
+        m_emulation = std::make_unique<EmulationThread>(std::move(emulator), *m_audio, AudioSampleRate);
+        m_emulation->setSpeakerFilter(m_settings->current().emulator.speakerFilter);
     }
 
     void Application::render()
     {
         if (m_keepAspectRatio)
         {
-            const auto emulatorAspectRatio = m_emulator->info().aspectRatio();
+            const auto emulatorAspectRatio = m_aspectRatio;
             const auto windowAspectRatio =
                 static_cast<float>(m_window->framebufferWidth()) / static_cast<float>(m_window->framebufferHeight());
             auto x = 0u, y = 0u;
@@ -230,6 +304,19 @@ namespace epoch::frontend
                     ImGuiFileDialog::Instance()->OpenDialog("SaveDialogKey", "Save", filters.c_str(), config);
                 }
                 ImGui::Separator();
+                if (!m_emulation->recording())
+                {
+                    if (ImGui::MenuItem("Start recording"))
+                        m_emulation->startRecording(recordingPath(), AudioSampleRate);
+                }
+                else
+                {
+                    const auto statistics = m_emulation->recordingStatistics();
+                    const auto label = "Stop recording (" + std::to_string(statistics.frames) + " frames, " +
+                                       std::to_string(statistics.dropped) + " dropped)";
+                    if (ImGui::MenuItem(label.c_str())) m_emulation->stopRecording();
+                }
+                ImGui::Separator();
                 if (ImGui::MenuItem("Exit"))
                 {
                     m_window->close();
@@ -238,10 +325,37 @@ namespace epoch::frontend
             }
             if (ImGui::BeginMenu("Emulator"))
             {
-                ImGui::MenuItem("Run", nullptr, &m_running);
+                if (ImGui::MenuItem("Run", nullptr, &m_running))
+                {
+                    m_emulation->setRunning(m_running);
+                }
+                if (ImGui::MenuItem("Low latency audio", nullptr, m_audio->lowLatency()))
+                {
+                    m_audio->setLowLatency(!m_audio->lowLatency());
+                    m_settings->current().emulator.lowLatencyAudio = m_audio->lowLatency();
+                }
+                if (ImGui::MenuItem("Speaker filter", nullptr, m_emulation->speakerFilter()))
+                {
+                    m_emulation->setSpeakerFilter(!m_emulation->speakerFilter());
+                    m_settings->current().emulator.speakerFilter = m_emulation->speakerFilter();
+                }
                 if (ImGui::MenuItem("Reset"))
                 {
-                    m_emulator->reset();
+                    m_emulation->post([](Emulator& e) { e.reset(); });
+                }
+                ImGui::Separator();
+                const auto paused = m_emulation->paused();
+                if (ImGui::MenuItem("Pause", nullptr, paused))
+                {
+                    m_emulation->post(togglePause);
+                }
+                if (ImGui::MenuItem("Step", nullptr, false, paused))
+                {
+                    m_emulation->post([](Emulator& e) { e.step(); });
+                }
+                if (ImGui::MenuItem("Step over", nullptr, false, paused))
+                {
+                    m_emulation->post([](Emulator& e) { e.stepOver(); });
                 }
                 if (!m_configuration.emulators.empty())
                 {
@@ -260,25 +374,39 @@ namespace epoch::frontend
             {
                 ImGui::MenuItem("Keep aspect ratio", nullptr, &m_keepAspectRatio);
                 ImGui::Separator();
-                if (ImGui::MenuItem("1X size"))
+                const auto resize = [&](const unsigned scale)
                 {
-                    m_window->resize(m_emulator->info().width, m_emulator->info().height);
-                }
-                if (ImGui::MenuItem("2X size"))
+                    const auto [width, height] = m_emulation->access(
+                        [](const Emulator& e) { return std::pair{e.info().width, e.info().height}; });
+                    m_window->resize(width * scale, height * scale);
+                };
+                if (ImGui::MenuItem("1X size")) resize(1);
+                if (ImGui::MenuItem("2X size")) resize(2);
+                if (ImGui::MenuItem("3X size")) resize(3);
+                ImGui::Separator();
+                if (ImGui::MenuItem("Fullscreen", nullptr, &m_fullscreen))
                 {
-                    m_window->resize(m_emulator->info().width * 2, m_emulator->info().height * 2);
+                    m_window->mode(m_fullscreen ? WindowMode::borderless : WindowMode::windowed);
                 }
-                if (ImGui::MenuItem("3X size"))
+                if (ImGui::MenuItem("Frame blending", nullptr, &m_frameBlending))
                 {
-                    m_window->resize(m_emulator->info().width * 3, m_emulator->info().height * 3);
+                    m_context->setFrameBlending(m_frameBlending);
+                    setShader(m_shader);
+                    m_settings->current().ui.frameBlending = m_frameBlending;
                 }
-                ImGui::Separator();
-                if (ImGui::MenuItem("Fullscreen", nullptr, &m_fullscreen))
+                if (ImGui::MenuItem("Adaptive sync", nullptr, &m_adaptiveSync, m_window->adaptiveSyncSupported()))
                 {
-                    m_window->mode(m_fullscreen ? WindowMode::borderless : WindowMode::windowed);
+                    m_window->setAdaptiveSync(m_adaptiveSync);
+                    m_settings->current().ui.adaptiveSync = m_adaptiveSync;
                 }
                 ImGui::Separator();
                 ImGui::MenuItem("Shader settings", nullptr, &m_showShaderSettings);
+                ImGui::MenuItem("Guest profiler", nullptr, &m_showGuestProfiler);
+                ImGui::Separator();
+                ImGui::MenuItem("Disassembly", nullptr, &m_showDisassembly);
+                ImGui::MenuItem("Memory", nullptr, &m_showMemory);
+                ImGui::MenuItem("Registers", nullptr, &m_showRegisters);
+                ImGui::MenuItem("Stack", nullptr, &m_showStack);
                 ImGui::EndMenu();
             }
             ImGui::EndMainMenuBar();
@@ -334,8 +462,18 @@ namespace epoch::frontend
             ImGui::End();
         }
 
-        if (auto tape = m_emulator->tape())
+        if (m_showGuestProfiler)
         {
+            renderGuestProfiler();
+        }
+
+        renderDebugger();
+
+        // The tape is owned by the emulator and can go away when it ends: the buttons are posted as commands, which
+        // look it up again on the emulation thread
+        if (m_emulation->tapeLoaded())
+        {
+            const auto playing = m_emulation->tapePlaying();
             ImGui::SetNextWindowSize(
                 {
                     ImGui::GetFontSize() * 20,
@@ -344,12 +482,26 @@ namespace epoch::frontend
                 ImGuiCond_Once);
             if (ImGui::Begin("Tape controls"))
             {
-                ImGui::BeginDisabled(tape->playing());
-                if (ImGui::Button("Play")) tape->play();
+                ImGui::BeginDisabled(playing);
+                if (ImGui::Button("Play"))
+                {
+                    m_emulation->post(
+                        [](Emulator& e)
+                        {
+                            if (const auto tape = e.tape()) tape->play();
+                        });
+                }
                 ImGui::EndDisabled();
                 ImGui::SameLine();
-                ImGui::BeginDisabled(!tape->playing());
-                if (ImGui::Button("Stop")) tape->stop();
+                ImGui::BeginDisabled(!playing);
+                if (ImGui::Button("Stop"))
+                {
+                    m_emulation->post(
+                        [](Emulator& e)
+                        {
+                            if (const auto tape = e.tape()) tape->stop();
+                        });
+                }
                 ImGui::EndDisabled();
             }
             ImGui::End();
@@ -368,6 +520,30 @@ namespace epoch::frontend
                              nullptr, 0.f, 25.f, {0, 60});
             ImGui::PlotLines("Rendering", m_profiling.render, IM_ARRAYSIZE(m_profiling.render), m_profiling.index,
                              nullptr, 0.f, 20.f, {0, 60});
+            ImGui::Text("Debugger: %.3f ms",
+                        std::accumulate(std::begin(m_profiling.debugger), std::end(m_profiling.debugger), 0.f) /
+                            static_cast<float>(IM_ARRAYSIZE(m_profiling.debugger)));
+            ImGui::PlotLines("Debugger", m_profiling.debugger, IM_ARRAYSIZE(m_profiling.debugger), m_profiling.index,
+                             nullptr, 0.f, 5.f, {0, 60});
+            ImGui::Text("Display: %.2f Hz, jitter %.3f ms", m_pacer->refreshRate(), m_pacer->jitter());
+            ImGui::PlotLines("Frame time", m_pacer->intervals(), m_pacer->intervalsCount(), m_pacer->intervalsOffset(),
+                             nullptr, 0.f, 40.f, {0, 60});
+            ImGui::Text("Audio: %d Hz", m_audio->sampleRate());
+            const auto& stages = m_emulation->audioStageNames();
+            for (std::size_t i = 0; i < stages.size(); ++i)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%s %.3f ms", stages[i].c_str(), m_emulation->audioStageTime(i));
+            }
+            if (m_emulation->recording())
+            {
+                const auto statistics = m_emulation->recordingStatistics();
+                ImGui::Text("Recording: %llu frames, %llu dropped, queue %zu (max %zu), %.1f MB",
+                            static_cast<unsigned long long>(statistics.frames),
+                            static_cast<unsigned long long>(statistics.dropped), statistics.queueDepth,
+                            statistics.maxQueueDepth, static_cast<double>(statistics.bytes) / (1024. * 1024.));
+            }
+            renderCpuStatistics();
         }
         ImGui::End();
 #endif
@@ -382,8 +558,20 @@ namespace epoch::frontend
             m_settings->current().ui.lastLoadPath = ImGuiFileDialog::Instance()->GetCurrentPath();
             if (ImGuiFileDialog::Instance()->IsOk())
             {
-                const std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
-                m_emulator->load(filePathName);
+                m_emulation->post([path = ImGuiFileDialog::Instance()->GetFilePathName()](Emulator& e)
+                                  { e.load(path); });
+            }
+            ImGuiFileDialog::Instance()->Close();
+        }
+
+        if (ImGuiFileDialog::Instance()->Display(
+                "SymbolsDialogKey", ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize,
+                screenSize, screenSize))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+            {
+                m_emulation->post([path = ImGuiFileDialog::Instance()->GetFilePathName()](Emulator& e)
+                                  { e.loadSymbols(path); });
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -395,16 +583,371 @@ namespace epoch::frontend
             m_settings->current().ui.lastSavePath = ImGuiFileDialog::Instance()->GetCurrentPath();
             if (ImGuiFileDialog::Instance()->IsOk())
             {
-                const std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
-                m_emulator->save(filePathName);
+                m_emulation->post([path = ImGuiFileDialog::Instance()->GetFilePathName()](Emulator& e)
+                                  { e.save(path); });
             }
             ImGuiFileDialog::Instance()->Close();
         }
     }
 
+    void Application::renderCpuStatistics()
+    {
+        if (m_profiling.index == 0)
+        {
+            // Refresh once per plot period, collecting the counters is not free
+            m_profiling.cpuStatistics = m_emulation->access([](const Emulator& e) { return e.cpuStatistics(); });
+            m_profiling.cpuStatisticsSorted = false;
+        }
+        auto& statistics = m_profiling.cpuStatistics;
+        if (statistics.empty() || !ImGui::CollapsingHeader("CPU instructions")) return;
+
+        if (ImGui::Button("Reset"))
+        {
+            m_emulation->post([](Emulator& e) { e.resetCpuStatistics(); });
+            statistics.clear();
+        }
+        constexpr auto flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                               ImGuiTableFlags_BordersOuter | ImGuiTableFlags_Resizable;
+        if (ImGui::BeginTable("CpuStatistics", 4, flags, {0, ImGui::GetFontSize() * 20}))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Instruction");
+            ImGui::TableSetupColumn("Executions",
+                                    ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("T-states", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableSetupColumn("Average", ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableHeadersRow();
+
+            auto sortSpecs = ImGui::TableGetSortSpecs();
+            if (sortSpecs && sortSpecs->SpecsCount > 0 && (sortSpecs->SpecsDirty || !m_profiling.cpuStatisticsSorted))
+            {
+                const auto& spec = sortSpecs->Specs[0];
+                const auto ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+                const auto column = spec.ColumnIndex;
+                std::ranges::stable_sort(
+                    statistics,
+                    [&](const EmulatorCpuStatistic& a, const EmulatorCpuStatistic& b)
+                    {
+                        const auto less = [&](const EmulatorCpuStatistic& l, const EmulatorCpuStatistic& r)
+                        {
+                            switch (column)
+                            {
+                                case 0:
+                                    return l.instruction < r.instruction;
+                                case 1:
+                                    return l.executions < r.executions;
+                                case 2:
+                                    return l.cycles < r.cycles;
+                                default:
+                                    return l.cycles * r.executions < r.cycles * l.executions;
+                            }
+                        };
+                        return ascending ? less(a, b) : less(b, a);
+                    });
+                sortSpecs->SpecsDirty = false;
+                m_profiling.cpuStatisticsSorted = true;
+            }
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(statistics.size()));
+            while (clipper.Step())
+            {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    const auto& entry = statistics[static_cast<std::size_t>(row)];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(entry.instruction.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(entry.executions));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(entry.cycles));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", static_cast<double>(entry.cycles) / static_cast<double>(entry.executions));
+                }
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    void Application::renderGuestProfiler()
+    {
+        ImGui::SetNextWindowSize(
+            {
+                ImGui::GetFontSize() * 30,
+                ImGui::GetFontSize() * 30,
+            },
+            ImGuiCond_Once);
+        if (ImGui::Begin("Guest profiler", &m_showGuestProfiler))
+        {
+            auto enabled = m_emulation->access([](const Emulator& e) { return e.guestProfiling(); });
+            if (ImGui::Checkbox("Enabled", &enabled))
+                m_emulation->post([enabled](Emulator& e) { e.setGuestProfiling(enabled); });
+            ImGui::SameLine();
+            if (ImGui::Button("Reset")) m_emulation->post([](Emulator& e) { e.resetGuestProfile(); });
+            ImGui::SameLine();
+            if (ImGui::Button("Load symbols"))
+            {
+                const IGFD::FileDialogConfig config{
+                    .path = m_settings->current().ui.lastLoadPath,
+                    .flags = ImGuiFileDialogFlags_ReadOnlyFileNameField | ImGuiFileDialogFlags_Modal |
+                             ImGuiFileDialogFlags_DisableCreateDirectoryButton,
+                };
+                ImGuiFileDialog::Instance()->OpenDialog("SymbolsDialogKey", "Load symbols", ".*,.sym,.map", config);
+            }
+
+            // Building the report walks all the routines, a few refreshes per second are enough
+            if (!m_guestProfile || --m_guestProfileAge <= 0)
+            {
+                m_guestProfile = std::make_unique<EmulatorProfile>(
+                    m_emulation->access([](const Emulator& e) { return e.guestProfile(); }));
+                m_guestProfileAge = 15;
+            }
+            const auto& profile = *m_guestProfile;
+            const auto frameTStates = profile.busyTStates + profile.idleTStates;
+            ImGui::Text("Frames: %llu", static_cast<unsigned long long>(profile.frames));
+            ImGui::Text("Busy: %.0f T-states/frame (%.1f%%)", profile.busyTStates,
+                        frameTStates > 0 ? 100.0 * profile.busyTStates / frameTStates : 0.0);
+            ImGui::PlotHistogram("Frame load", profile.frameLoad.data(), static_cast<int>(profile.frameLoad.size()),
+                                 0, nullptr, 0.f, 1.f, {0, 60});
+
+            constexpr auto flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                   ImGuiTableFlags_Resizable;
+            if (ImGui::BeginTable("GuestRoutines", 3, flags))
+            {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Routine");
+                ImGui::TableSetupColumn("Self T/frame");
+                ImGui::TableSetupColumn("Incl. T/frame");
+                ImGui::TableHeadersRow();
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(profile.routines.size()));
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const auto& routine = profile.routines[static_cast<std::size_t>(row)];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(routine.name.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.1f", routine.selfTStates);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.1f", routine.inclusiveTStates);
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    void Application::renderDebugger()
+    {
+        m_profiling.debugger[m_profiling.index] = 0.f;
+        if (!m_showDisassembly && !m_showMemory && !m_showRegisters && !m_showStack) return;
+        PROFILE_BLOCK(&m_profiling.debugger[m_profiling.index]);
+
+        // Collecting the snapshot costs more than drawing it: throttle it while running, always fresh when paused
+        const auto paused = m_emulation->paused() || !m_running;
+        if (paused || m_time - m_debugger.lastRefresh >= 1.0 / m_debugger.refreshRate)
+        {
+            m_debugger.lastRefresh = m_time;
+            // A single access so that registers, memory and disassembly all describe the same instant
+            m_emulation->access(
+                [&](Emulator& emulator)
+                {
+                    m_debugger.registers = emulator.debugRegisters();
+                    const auto pc = emulator.programCounter();
+                    if (pc != m_debugger.pc) m_debugger.scrollToPc = m_debugger.followPc;
+                    m_debugger.pc = pc;
+                    m_debugger.sp = emulator.stackPointer();
+                    if (m_showMemory || m_showStack)
+                    {
+                        m_debugger.memory.resize(0x10000);
+                        for (std::size_t address = 0; address < m_debugger.memory.size(); ++address)
+                        {
+                            m_debugger.memory[address] = emulator.peek(static_cast<uint16_t>(address));
+                        }
+                    }
+                    if (m_showDisassembly) m_debugger.disassembly = emulator.disassembly();
+                });
+        }
+
+        if (m_showRegisters) renderRegisters();
+        if (m_showDisassembly) renderDisassembly();
+        if (m_showMemory) renderMemory();
+        if (m_showStack) renderStack();
+    }
+
+    void Application::renderDisassembly()
+    {
+        ImGui::SetNextWindowSize({ImGui::GetFontSize() * 20, ImGui::GetFontSize() * 30}, ImGuiCond_Once);
+        if (ImGui::Begin("Disassembly", &m_showDisassembly))
+        {
+            if (ImGui::Checkbox("Follow PC", &m_debugger.followPc)) m_debugger.scrollToPc = m_debugger.followPc;
+            const auto& lines = m_debugger.disassembly;
+            const auto pcLine = std::ranges::lower_bound(lines, m_debugger.pc, {}, &EmulatorDisassemblyLine::address);
+            const auto pcRow = static_cast<int>(pcLine - lines.begin());
+            constexpr auto flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter;
+            if (ImGui::BeginTable("DisassemblyTable", 2, flags))
+            {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthFixed);
+                ImGui::TableSetupColumn("Instruction");
+                ImGui::TableHeadersRow();
+                const auto rowHeight = ImGui::GetTextLineHeightWithSpacing();
+                if (m_debugger.scrollToPc)
+                {
+                    ImGui::SetScrollY(std::max(0.f, (static_cast<float>(pcRow) - 5.f) * rowHeight));
+                    m_debugger.scrollToPc = false;
+                }
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(lines.size()), rowHeight);
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const auto& line = lines[static_cast<std::size_t>(row)];
+                        ImGui::TableNextRow();
+                        if (row == pcRow) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, IM_COL32(90, 70, 20, 255));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%04X", line.address);
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(line.text.c_str());
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    void Application::renderMemory()
+    {
+        constexpr int BytesPerRow = 16;
+        ImGui::SetNextWindowSize({ImGui::GetFontSize() * 32, ImGui::GetFontSize() * 30}, ImGuiCond_Once);
+        if (ImGui::Begin("Memory", &m_showMemory))
+        {
+            auto& address = m_debugger.memoryAddress;
+            ImGui::SetNextItemWidth(ImGui::GetFontSize() * 4);
+            if (ImGui::InputText("Go to", address, sizeof(address),
+                                 ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue))
+            {
+                m_debugger.memoryScrollRow = static_cast<int>(std::strtoul(address, nullptr, 16)) / BytesPerRow;
+            }
+            const auto& memory = m_debugger.memory;
+            if (ImGui::BeginChild("MemoryRows"))
+            {
+                const auto rowHeight = ImGui::GetTextLineHeightWithSpacing();
+                if (m_debugger.memoryScrollRow >= 0)
+                {
+                    ImGui::SetScrollY(static_cast<float>(m_debugger.memoryScrollRow) * rowHeight);
+                    m_debugger.memoryScrollRow = -1;
+                }
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(memory.size()) / BytesPerRow, rowHeight);
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const auto base = static_cast<std::size_t>(row * BytesPerRow);
+                        char text[8 + BytesPerRow * 4];
+                        auto length = std::snprintf(text, sizeof(text), "%04X ", static_cast<unsigned>(base));
+                        for (std::size_t i = 0; i < BytesPerRow; ++i)
+                        {
+                            length += std::snprintf(text + length, sizeof(text) - static_cast<std::size_t>(length),
+                                                    " %02X", memory[base + i]);
+                        }
+                        text[length++] = ' ';
+                        text[length++] = ' ';
+                        for (std::size_t i = 0; i < BytesPerRow; ++i)
+                        {
+                            const auto c = memory[base + i];
+                            text[length++] = c >= 0x20 && c < 0x7f ? static_cast<char>(c) : '.';
+                        }
+                        ImGui::TextUnformatted(text, text + length);
+                    }
+                }
+            }
+            ImGui::EndChild();
+        }
+        ImGui::End();
+    }
+
+    void Application::renderRegisters()
+    {
+        ImGui::SetNextWindowSize({ImGui::GetFontSize() * 16, ImGui::GetFontSize() * 26}, ImGuiCond_Once);
+        if (ImGui::Begin("Registers", &m_showRegisters))
+        {
+            const auto paused = m_emulation->paused();
+            if (ImGui::Button(paused ? "Resume" : "Pause"))
+            {
+                m_emulation->post(togglePause);
+            }
+            ImGui::BeginDisabled(!paused);
+            ImGui::SameLine();
+            if (ImGui::Button("Step")) m_emulation->post([](Emulator& e) { e.step(); });
+            ImGui::SameLine();
+            if (ImGui::Button("Step over")) m_emulation->post([](Emulator& e) { e.stepOver(); });
+            ImGui::EndDisabled();
+            ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+            ImGui::SliderFloat("Refresh (Hz)", &m_debugger.refreshRate, 1.f, 60.f, "%.0f");
+
+            if (ImGui::BeginTable("RegistersTable", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter))
+            {
+                for (const auto& reg : m_debugger.registers)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(reg.name.c_str());
+                    ImGui::TableNextColumn();
+                    if (reg.bits == 16)
+                        ImGui::Text("%04X", reg.value);
+                    else if (reg.bits == 8)
+                        ImGui::Text("%02X", reg.value);
+                    else
+                        ImGui::Text("%u", reg.value);
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+    }
+
+    void Application::renderStack()
+    {
+        constexpr int Entries = 32;
+        ImGui::SetNextWindowSize({ImGui::GetFontSize() * 12, ImGui::GetFontSize() * 20}, ImGuiCond_Once);
+        if (ImGui::Begin("Stack", &m_showStack))
+        {
+            const auto& memory = m_debugger.memory;
+            ImGuiListClipper clipper;
+            clipper.Begin(memory.empty() ? 0 : Entries);
+            while (clipper.Step())
+            {
+                for (int entry = clipper.DisplayStart; entry < clipper.DisplayEnd; ++entry)
+                {
+                    const auto address = static_cast<uint16_t>(m_debugger.sp + entry * 2);
+                    const auto value = static_cast<unsigned>(memory[address] | memory[(address + 1) & 0xffff] << 8);
+                    ImGui::Text("%04X  %04X", address, value);
+                }
+            }
+        }
+        ImGui::End();
+    }
+
     void Application::setEmulatorEntry(const EmulatorEntry& entry)
     {
-        m_emulator = entry.factory();
+        m_debugger.disassembly = {};
+        m_emulation->replace(entry.factory);
+        m_emulation->access(
+            [&](const Emulator& emulator)
+            {
+                m_context->updatePalette(emulator.palette());
+                m_aspectRatio = emulator.info().aspectRatio();
+                m_pacer->setFramesPerSecond(emulator.info().framesPerSecond);
+            });
         m_currentEntry = &entry;
         m_settings->current().emulator.key = m_currentEntry->key;
         m_window->setTitle("Epoch emulator: " + m_currentEntry->name);
@@ -419,10 +962,11 @@ namespace epoch::frontend
 
     std::string Application::generateFileDialogFilters(const bool save) const
     {
+        const auto fileFormats = m_emulation->access([](const Emulator& e) { return e.info().fileFormats; });
         std::ostringstream ss;
         ss << "Supported files{";
         bool empty{true};
-        for (const auto& format : m_emulator->info().fileFormats)
+        for (const auto& format : fileFormats)
         {
             if (save ? format.save : format.load)
             {
@@ -432,7 +976,7 @@ namespace epoch::frontend
             }
         }
         ss << "},";
-        for (const auto& format : m_emulator->info().fileFormats)
+        for (const auto& format : fileFormats)
         {
             if (save ? format.save : format.load)
             {
@@ -21,16 +21,23 @@
 
 #include <functional>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace epoch
 {
     class Emulator;
+    struct EmulatorCpuStatistic;
+    struct EmulatorDisassemblyLine;
+    struct EmulatorProfile;
+    struct EmulatorRegister;
 }
 
 namespace epoch::frontend
 {
     class AudioPlayer;
+    class EmulationThread;
+    class FramePacer;
     class GraphicContext;
     class Gui;
     class SettingsManager;
@@ -62,13 +69,21 @@ namespace epoch::frontend
     public:
         int run();
 
+        // Rate the emulators generate audio at, see Emulator::generateNextAudioSample
         static constexpr auto AudioSampleRate = 48000;
 
     private:
-        void init();
+        void init(std::shared_ptr<Emulator> emulator);
 
         void render();
         void renderGui();
+        void renderCpuStatistics();
+        void renderGuestProfiler();
+        void renderDebugger();
+        void renderDisassembly();
+        void renderMemory();
+        void renderRegisters();
+        void renderStack();
 
         void setEmulatorEntry(const EmulatorEntry& entry);
         void setShader(std::size_t index);
@@ -78,8 +93,8 @@ namespace epoch::frontend
     private:
         std::unique_ptr<SettingsManager> m_settings{};
         const ApplicationConfiguration m_configuration{};
-        std::shared_ptr<Emulator> m_emulator{};
         const EmulatorEntry* m_currentEntry{};
+        float m_aspectRatio{};
 
         double m_time{};
         double m_deltaTime{};
@@ -88,12 +103,42 @@ namespace epoch::frontend
         std::unique_ptr<GraphicContext> m_context{};
         std::unique_ptr<Gui> m_gui{};
         std::unique_ptr<AudioPlayer> m_audio{};
-        std::vector<float> m_audioBuffer{};
+        // Declared after the audio player: the emulation thread feeds it until destroyed
+        std::unique_ptr<EmulationThread> m_emulation{};
+        std::unique_ptr<FramePacer> m_pacer{};
+        // A frame picked up from the emulation thread and held by the pacer for a later refresh
+        bool m_framePending{};
 
         bool m_running{true};
         bool m_keepAspectRatio{true};
         bool m_fullscreen{false};
+        bool m_frameBlending{false};
+        bool m_adaptiveSync{false};
         bool m_showShaderSettings{false};
+        bool m_showGuestProfiler{false};
+        bool m_showDisassembly{false};
+        bool m_showMemory{false};
+        bool m_showRegisters{false};
+        bool m_showStack{false};
+
+        std::unique_ptr<EmulatorProfile> m_guestProfile{};
+        int m_guestProfileAge{};
+
+        // Snapshot of the machine shown by the debugger windows, refreshed at refreshRate while running
+        struct debugger_t
+        {
+            float refreshRate{10.f};
+            double lastRefresh{};
+            std::span<const EmulatorDisassemblyLine> disassembly{};
+            std::vector<EmulatorRegister> registers{};
+            std::vector<uint8_t> memory{};
+            uint16_t pc{};
+            uint16_t sp{};
+            bool followPc{true};
+            bool scrollToPc{};
+            int memoryScrollRow{-1};
+            char memoryAddress[5]{};
+        } m_debugger{};
 
         std::vector<ConfigurableShader> m_shaders{};
         std::size_t m_shader{};
@@ -104,6 +149,9 @@ namespace epoch::frontend
             int index{};
             float emulation[COUNT];
             float render[COUNT];
+            float debugger[COUNT];
+            std::vector<EmulatorCpuStatistic> cpuStatistics;
+            bool cpuStatisticsSorted{};
         } m_profiling{};
     };
 }  // namespace epoch::frontend
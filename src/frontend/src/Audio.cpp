@@ -51,8 +51,10 @@ namespace epoch::frontend
             .suggestedLatency = info->defaultLowOutputLatency,
         };
         const auto hostApi = Pa_GetHostApiInfo(info->hostApi);
-        std::cout << "Audio output: " << info->name << " (" << hostApi->name << ")" << std::endl;
-        PA_CHECK(Pa_OpenStream(&m_handle, nullptr, &outputParameters, sampleRate, paFramesPerBufferUnspecified,
+        m_sampleRate = sampleRate > 0 ? sampleRate : static_cast<int>(info->defaultSampleRate);
+        std::cout << "Audio output: " << info->name << " (" << hostApi->name << "), " << m_sampleRate << "Hz"
+                  << std::endl;
+        PA_CHECK(Pa_OpenStream(&m_handle, nullptr, &outputParameters, m_sampleRate, paFramesPerBufferUnspecified,
                                paClipOff, &s_callback, this));
     }
 
@@ -68,10 +70,20 @@ namespace epoch::frontend
 
     void AudioStream::stop() const { PA_CHECK(Pa_StopStream(m_handle)); }
 
+    void AudioStream::wake()
+    {
+        ++m_consumption;
+        m_consumption.notify_all();
+    }
+
     int AudioStream::callback(float* outputBuffer, const unsigned long framesPerBuffer,
                               const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags)
     {
         m_buffer.read(outputBuffer, framesPerBuffer * 2);
+        m_hostFrames.store(framesPerBuffer, std::memory_order_relaxed);
+        // Futex based on the common platforms: no lock is taken on the audio thread
+        m_consumption.fetch_add(1, std::memory_order_release);
+        m_consumption.notify_one();
         return paContinue;
     }
 
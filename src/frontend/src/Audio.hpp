@@ -19,6 +19,9 @@
 
 #include "CircularBuffer.hpp"
 
+#include <atomic>
+#include <cstdint>
+
 #ifndef PaStream
 typedef void PaStream;
 #endif
@@ -32,6 +35,7 @@ namespace epoch::frontend
     class AudioStream final
     {
     public:
+        // A sampleRate of 0 opens the default device at its native rate, sparing the host a second resampling
         explicit AudioStream(int sampleRate);
         ~AudioStream();
 
@@ -49,12 +53,24 @@ namespace epoch::frontend
         void push(const std::span<float> samples) { m_buffer.write(samples); }
         [[nodiscard]] unsigned long ahead() const { return m_buffer.available(); }
 
+        // Number of callbacks served so far, waitConsumption() blocks until it moves past the given value
+        [[nodiscard]] uint32_t consumption() const { return m_consumption; }
+        void waitConsumption(const uint32_t seen) const { m_consumption.wait(seen); }
+        // Releases the threads blocked in waitConsumption() without a callback
+        void wake();
+        // Frames requested by the last callback, 0 before the first one
+        [[nodiscard]] unsigned long hostFrames() const { return m_hostFrames; }
+        [[nodiscard]] int sampleRate() const { return m_sampleRate; }
+
         static constexpr unsigned long BufferSize = 1 << 14;
 
     private:
         PaStream* m_handle{};
+        int m_sampleRate{};
 
         CircularBuffer<float, BufferSize> m_buffer{};
+        std::atomic<uint32_t> m_consumption{};
+        std::atomic<unsigned long> m_hostFrames{};
 
         int callback(float* outputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
                      PaStreamCallbackFlags statusFlags);
@@ -18,6 +18,8 @@
 
 #include "Audio.hpp"
 
+#include <algorithm>
+
 namespace epoch::frontend
 {
     AudioPlayer::AudioPlayer(int sampleRate) : m_audioContext{std::make_unique<AudioContext>()}
@@ -32,6 +34,21 @@ namespace epoch::frontend
 
     unsigned long AudioPlayer::neededSamples() const
     {
-        return std::max(0L, 4096L - static_cast<long>(m_stream->ahead()));
+        auto target = QueuedSamples;
+        if (const auto hostFrames = m_stream->hostFrames(); m_lowLatency && hostFrames > 0)
+        {
+            target = std::min(QueuedSamples, hostFrames * 2 + LowLatencyMargin);
+        }
+        // ahead() counts the values of both channels
+        const auto queued = static_cast<long>(m_stream->ahead() / 2);
+        return static_cast<unsigned long>(std::max(0L, static_cast<long>(target) - queued));
     }
+
+    int AudioPlayer::sampleRate() const { return m_stream->sampleRate(); }
+
+    uint32_t AudioPlayer::consumption() const { return m_stream->consumption(); }
+
+    void AudioPlayer::waitConsumption(const uint32_t seen) const { m_stream->waitConsumption(seen); }
+
+    void AudioPlayer::wake() const { m_stream->wake(); }
 }  // namespace epoch::frontend
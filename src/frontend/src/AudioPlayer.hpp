@@ -17,6 +17,8 @@
 #ifndef SRC_FRONTEND_AUDIOPLAYER_HPP_
 #define SRC_FRONTEND_AUDIOPLAYER_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <span>
 
@@ -28,6 +30,7 @@ namespace epoch::frontend
     class AudioPlayer final
     {
     public:
+        // 0 plays at the native rate of the default device, see sampleRate()
         explicit AudioPlayer(int sampleRate);
         ~AudioPlayer();
 
@@ -40,10 +43,27 @@ namespace epoch::frontend
     public:
         void push(std::span<float> sample) const;
         [[nodiscard]] unsigned long neededSamples() const;
+        [[nodiscard]] int sampleRate() const;
+
+        // Blocks until the audio callback consumes more samples than seen in consumption(), or wake() is called
+        [[nodiscard]] uint32_t consumption() const;
+        void waitConsumption(uint32_t seen) const;
+        void wake() const;
+
+        // Low latency queues just enough samples for the next couple of host buffers instead of a fixed cushion:
+        // less delay between emulation and speakers, at the cost of clicks if the producer is ever late
+        void setLowLatency(const bool lowLatency) { m_lowLatency = lowLatency; }
+        [[nodiscard]] bool lowLatency() const { return m_lowLatency; }
+
+        // Stereo samples kept queued in the default mode, about 43ms at 48kHz
+        static constexpr unsigned long QueuedSamples = 2048;
+        // Extra stereo samples on top of two host buffers in low latency mode
+        static constexpr unsigned long LowLatencyMargin = 128;
 
     private:
         std::unique_ptr<AudioContext> m_audioContext{};
         std::unique_ptr<AudioStream> m_stream{};
+        std::atomic<bool> m_lowLatency{};
     };
 }  // namespace epoch::frontend
 
@@ -16,8 +16,12 @@
 
 #include "ConfigurableShader.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <map>
 #include <sstream>
+#include <stdexcept>
 
 namespace epoch::frontend
 {
@@ -34,25 +38,130 @@ namespace epoch::frontend
     {
     }
 
-    ConfigurableShader::ConfigurableShader(std::string key, std::string name, const std::string_view source)
-        : m_key{std::move(key)}, m_name{std::move(name)}, m_source{source}
+    namespace
     {
-        std::istringstream f{m_source};
+        // The whole value must be a number: std::stoi and std::stof alone accept "2x" and throw other exceptions
+        int parseCount(const std::string& text, const std::string& name)
+        {
+            std::size_t end{};
+            int result{};
+            try
+            {
+                result = std::stoi(text, &end);
+            }
+            catch (const std::exception&)
+            {
+                end = 0;
+            }
+            if (end == 0 || end != text.size() || result <= 0)
+                throw std::runtime_error("Invalid " + name + ": " + text);
+            return result;
+        }
+
+        float parseScale(const std::string& text, const std::string& name)
+        {
+            std::size_t end{};
+            float result{};
+            try
+            {
+                result = std::stof(text, &end);
+            }
+            catch (const std::exception&)
+            {
+                end = 0;
+            }
+            if (end == 0 || end != text.size() || !std::isfinite(result) || result <= 0)
+                throw std::runtime_error("Invalid " + name + ": " + text);
+            return result;
+        }
+    }  // namespace
+
+    std::vector<ShaderPass> parseShaderPreset(const std::string_view preset,
+                                              const std::function<std::string(const std::string&)>& resolve)
+    {
+        std::map<std::string, std::string> values;
+        std::istringstream f{std::string{preset}};
         std::string line;
         while (std::getline(f, line))
         {
-            if (line.starts_with("#pragma parameter "))
+            if (const auto comment = line.find('#'); comment != std::string::npos) line.erase(comment);
+            const auto equal = line.find('=');
+            if (equal == std::string::npos) continue;
+            const auto trim = [](std::string s)
+            {
+                const auto first = s.find_first_not_of(" \t\r\"");
+                const auto last = s.find_last_not_of(" \t\r\"");
+                return first == std::string::npos ? std::string{} : s.substr(first, last - first + 1);
+            };
+            values[trim(line.substr(0, equal))] = trim(line.substr(equal + 1));
+        }
+
+        const auto value = [&](const std::string& name) -> const std::string*
+        {
+            const auto i = values.find(name);
+            return i != values.end() ? &i->second : nullptr;
+        };
+        const auto count = value("shaders");
+        if (!count) throw std::runtime_error("Shader preset without shaders");
+
+        std::vector<ShaderPass> passes(static_cast<std::size_t>(parseCount(*count, "shaders")));
+        for (std::size_t i = 0; i < passes.size(); ++i)
+        {
+            const auto index = std::to_string(i);
+            auto& pass = passes[i];
+            const auto shader = value("shader" + index);
+            if (!shader) throw std::runtime_error("Shader preset without shader" + index);
+            pass.source = resolve(*shader);
+            // Intermediate passes default to the size of their input, the last one always fills the viewport
+            pass.scaleType = i + 1 < passes.size() ? ShaderPassScale::source : ShaderPassScale::viewport;
+            if (const auto scaleType = value("scale_type" + index))
+            {
+                if (*scaleType == "source")
+                    pass.scaleType = ShaderPassScale::source;
+                else if (*scaleType == "viewport")
+                    pass.scaleType = ShaderPassScale::viewport;
+                else if (*scaleType == "absolute")
+                    pass.scaleType = ShaderPassScale::absolute;
+                else
+                    throw std::runtime_error("Invalid scale_type" + index + ": " + *scaleType);
+            }
+            if (const auto scale = value("scale" + index)) pass.scale = parseScale(*scale, "scale" + index);
+            if (const auto filterLinear = value("filter_linear" + index)) pass.filterLinear = *filterLinear == "true";
+        }
+        return passes;
+    }
+
+    ConfigurableShader::ConfigurableShader(std::string key, std::string name, const std::string_view source)
+        : ConfigurableShader{std::move(key), std::move(name), {ShaderPass{.source = std::string{source}}}}
+    {
+    }
+
+    ConfigurableShader::ConfigurableShader(std::string key, std::string name, std::vector<ShaderPass> passes)
+        : m_key{std::move(key)}, m_name{std::move(name)}, m_passes{std::move(passes)}
+    {
+        for (const auto& pass : m_passes)
+        {
+            std::istringstream f{pass.source};
+            std::string line;
+            while (std::getline(f, line))
             {
-                std::istringstream ls{line.substr(sizeof("#pragma parameter ") - 1)};
-                std::string variableName, description;
-                float defaultValue, min, max, step;
-                ls >> variableName;
-                ls >> std::quoted(description);
-                ls >> defaultValue;
-                ls >> min;
-                ls >> max;
-                ls >> step;
-                m_parameters.emplace_back(variableName, description, defaultValue, min, max, step, defaultValue);
+                if (line.starts_with("#pragma parameter "))
+                {
+                    std::istringstream ls{line.substr(sizeof("#pragma parameter ") - 1)};
+                    std::string variableName, description;
+                    float defaultValue, min, max, step;
+                    ls >> variableName;
+                    ls >> std::quoted(description);
+                    ls >> defaultValue;
+                    ls >> min;
+                    ls >> max;
+                    ls >> step;
+                    // Passes of the same chain can share a parameter
+                    if (std::ranges::find(m_parameters, variableName, &ConfigurableShaderParameter::variableName) !=
+                        m_parameters.end())
+                        continue;
+                    m_parameters.emplace_back(variableName, description, defaultValue, min, max, step, defaultValue);
+                }
             }
         }
     }
@@ -61,7 +170,7 @@ namespace epoch::frontend
 
     const std::string& ConfigurableShader::name() const { return m_name; }
 
-    const std::string& ConfigurableShader::source() const { return m_source; }
+    const std::vector<ShaderPass>& ConfigurableShader::passes() const { return m_passes; }
 
     std::vector<ConfigurableShaderParameter>& ConfigurableShader::parameters() { return m_parameters; }
 }  // namespace epoch::frontend
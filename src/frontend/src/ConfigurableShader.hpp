@@ -17,7 +17,9 @@
 #ifndef SRC_EPOCH_FRONTEND_CONFIGURABLESHADER_HPP_
 #define SRC_EPOCH_FRONTEND_CONFIGURABLESHADER_HPP_
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace epoch::frontend
@@ -36,20 +38,44 @@ namespace epoch::frontend
         float value;
     };
 
+    // Size of the output of a pass: relative to its input, relative to the viewport or in pixels
+    enum class ShaderPassScale
+    {
+        source,
+        viewport,
+        absolute,
+    };
+
+    struct ShaderPass
+    {
+        std::string source;
+        ShaderPassScale scaleType{ShaderPassScale::viewport};
+        float scale{1.f};
+        // Linear filtering when sampling the output of the previous pass, the emulator screen is always nearest
+        bool filterLinear{false};
+    };
+
+    // Parses a libretro style preset: "shaders = N" then shaderI, scale_typeI, scaleI and filter_linearI for each
+    // pass. resolve() maps the shaderI values to sources. Throws std::runtime_error on malformed presets.
+    std::vector<ShaderPass> parseShaderPreset(std::string_view preset,
+                                              const std::function<std::string(const std::string&)>& resolve);
+
+    // A chain of passes, the last one draws into the viewport; the parameters of all the passes are merged
     class ConfigurableShader final
     {
     public:
         ConfigurableShader(std::string key, std::string name, std::string_view source);
+        ConfigurableShader(std::string key, std::string name, std::vector<ShaderPass> passes);
 
         [[nodiscard]] const std::string& key() const;
         [[nodiscard]] const std::string& name() const;
-        [[nodiscard]] const std::string& source() const;
+        [[nodiscard]] const std::vector<ShaderPass>& passes() const;
         [[nodiscard]] std::vector<ConfigurableShaderParameter>& parameters();
 
     private:
         std::string m_key;
         std::string m_name;
-        std::string m_source;
+        std::vector<ShaderPass> m_passes;
         std::vector<ConfigurableShaderParameter> m_parameters;
     };
 }  // namespace epoch::frontend
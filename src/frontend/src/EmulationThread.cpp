@@ -0,0 +1,227 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EmulationThread.hpp"
+
+#include "AudioPlayer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace epoch::frontend
+{
+    EmulationThread::EmulationThread(std::shared_ptr<Emulator> emulator, AudioPlayer& audio, const int sampleRate)
+        : m_emulator{std::move(emulator)}, m_audio{audio}, m_audioChain{static_cast<double>(sampleRate),
+                                                                        static_cast<double>(audio.sampleRate())}
+    {
+        m_audioChain.emplace<sound::DcBlocker>(static_cast<float>(sampleRate));
+        m_speakerStage = &m_audioChain.emplace<sound::LowPassFilter>(static_cast<float>(sampleRate), SpeakerCutoff);
+#ifdef EPOCH_PROFILER
+        m_audioStageNames = m_audioChain.stageNames();
+        assert(m_audioStageNames.size() <= MaxAudioStages);
+#endif
+        // A request from gdb interrupts the wait for the audio callback, see Emulator::serviceDebugger
+        m_emulator->setDebuggerWake([&audio = m_audio] { audio.wake(); });
+        m_thread = std::thread{[this] { run(); }};
+    }
+
+    EmulationThread::~EmulationThread()
+    {
+        m_stop = true;
+        m_audio.wake();
+        m_thread.join();
+        m_emulator->setDebuggerWake({});
+    }
+
+    void EmulationThread::keyEvent(const Key key, const KeyAction action)
+    {
+        // A full queue means the emulation thread is stuck, dropping the key is the lesser evil
+        m_keys.push({key, action});
+    }
+
+    void EmulationThread::post(Command command)
+    {
+        std::lock_guard lock{m_commandsMutex};
+        m_commands.push_back(std::move(command));
+    }
+
+    void EmulationThread::replace(const Factory& factory)
+    {
+        std::lock_guard lock{m_emulatorMutex};
+        // Release the previous emulator first, it can hold resources the new one needs (e.g. the debugger port)
+        m_emulator = {};
+        m_emulator = factory();
+        m_emulator->setDebuggerWake([&audio = m_audio] { audio.wake(); });
+        m_paused = m_emulator->paused();
+        m_publishedFrame = 0;
+        // The new machine can have a different screen, it would need a new recording anyway
+        m_recorder = {};
+        m_recording = false;
+    }
+
+    void EmulationThread::startRecording(std::filesystem::path path, const unsigned sampleRate)
+    {
+        post(
+            [this, path = std::move(path), sampleRate](Emulator& emulator)
+            {
+                m_recorder = {};
+                m_recording = false;
+                if (emulator.indexedScreenBuffer().empty())
+                    throw std::runtime_error("Recording needs an emulator with an indexed screen");
+                m_recorder = std::make_unique<Recorder>(path, emulator.info(), emulator.palette(), sampleRate);
+                {
+                    std::lock_guard lock{m_recordingMutex};
+                    m_recordingStatistics = {};
+                }
+                m_recording = true;
+            });
+    }
+
+    void EmulationThread::stopRecording()
+    {
+        post(
+            [this](Emulator&)
+            {
+                // Waits for the encoder to write what is still queued
+                m_recorder = {};
+                m_recording = false;
+            });
+    }
+
+    RecorderStatistics EmulationThread::recordingStatistics() const
+    {
+        std::lock_guard lock{m_recordingMutex};
+        return m_recordingStatistics;
+    }
+
+    void EmulationThread::run()
+    {
+        while (!m_stop)
+        {
+            // Read before the fill level, a callback in between must not be missed by the wait below
+            const auto consumption = m_audio.consumption();
+            // Samples for the audio player, the emulator generates them at its own rate
+            const auto samples = std::min(m_audio.neededSamples(), MaxChunkSamples);
+            const auto input = m_audioChain.inputFor(samples);
+            [[maybe_unused]] float chunkTime{};
+            {
+                PROFILE_BLOCK(&chunkTime);
+                std::lock_guard lock{m_emulatorMutex};
+                runCommands();
+                KeyEvent event{};
+                while (m_keys.pop(event)) m_emulator->keyEvent(event.key, event.action);
+                m_emulator->serviceDebugger();
+
+                if (samples > 0)
+                {
+                    // Only the time the machine actually runs is recorded
+                    const auto record = m_recorder && m_running && !m_emulator->paused();
+                    m_audioBlock.resize(input);
+                    if (m_running)
+                    {
+                        for (auto& sample : m_audioBlock) sample = m_emulator->generateNextAudioSample();
+                    }
+                    else
+                    {
+                        std::ranges::fill(m_audioBlock, SoundSample{});
+                    }
+                    // Silence still goes through the chain, the filters settle instead of jumping when resumed
+                    m_speakerStage->setEnabled(m_speakerFilter);
+                    m_audioChain.filter(m_audioBlock);
+                    if (record)
+                    {
+                        const auto* interleaved = reinterpret_cast<const float*>(m_audioBlock.data());
+                        m_recorder->audio({interleaved, m_audioBlock.size() * 2});
+                    }
+                    publishFrame(record);
+                }
+                m_paused = m_emulator->paused();
+                const auto tape = m_emulator->tape();
+                m_tapeLoaded = tape != nullptr;
+                m_tapePlaying = tape && tape->playing();
+            }
+
+            if (samples > 0)
+            {
+                m_audioOutput.clear();
+                m_audioChain.resample(m_audioBlock, m_audioOutput);
+#ifdef EPOCH_PROFILER
+                m_chunkTime = chunkTime;
+                const auto times = m_audioChain.stageTimes();
+                for (std::size_t i = 0; i < times.size(); ++i) m_audioStageTimes[i] = times[i];
+#endif
+                m_audio.push({reinterpret_cast<float*>(m_audioOutput.data()), m_audioOutput.size() * 2});
+            }
+            else
+            {
+                // The audio queue is full: sleep until the callback drains some of it
+                m_audio.waitConsumption(consumption);
+            }
+        }
+    }
+
+    void EmulationThread::runCommands()
+    {
+        {
+            std::lock_guard lock{m_commandsMutex};
+            std::swap(m_commands, m_pendingCommands);
+        }
+        for (const auto& command : m_pendingCommands)
+        {
+            try
+            {
+                command(*m_emulator);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Emulator command failed: " << e.what() << std::endl;
+            }
+        }
+        m_pendingCommands.clear();
+    }
+
+    void EmulationThread::publishFrame(const bool record)
+    {
+        const auto number = m_emulator->frameCounter();
+        if (number != 0 && number == m_publishedFrame) return;
+        m_publishedFrame = number;
+
+        auto& frame = m_frames.back();
+        frame.number = number;
+        if (const auto indices = m_emulator->indexedScreenBuffer(); !indices.empty())
+        {
+            frame.indices.assign(indices.begin(), indices.end());
+            frame.pixels.clear();
+            // Without a frame counter every chunk would count as a frame
+            if (record && number != 0)
+            {
+                m_recorder->frame(indices);
+                std::lock_guard lock{m_recordingMutex};
+                m_recordingStatistics = m_recorder->statistics();
+            }
+        }
+        else
+        {
+            const auto pixels = m_emulator->screenBuffer();
+            frame.pixels.assign(pixels.begin(), pixels.end());
+            frame.indices.clear();
+        }
+        m_frames.publish();
+    }
+}  // namespace epoch::frontend
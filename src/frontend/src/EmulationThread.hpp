@@ -0,0 +1,167 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRONTEND_EMULATIONTHREAD_HPP_
+#define SRC_FRONTEND_EMULATIONTHREAD_HPP_
+
+#include "SpscQueue.hpp"
+#include "TripleBuffer.hpp"
+
+#include <epoch/core.hpp>
+#include <epoch/sound.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace epoch::frontend
+{
+    class AudioPlayer;
+
+    // Runs the emulator on its own thread, woken by the audio callback. The render thread only sees the latest
+    // published frame; everything else reaches the emulator as a command or through access()
+    class EmulationThread final
+    {
+    public:
+        // Screen of the emulator, either palette indices or RGBA pixels depending on what the emulator provides
+        struct Frame
+        {
+            std::vector<uint8_t> indices{};
+            std::vector<uint32_t> pixels{};
+            // Emulator::frameCounter() of the screen
+            uint64_t number{};
+        };
+        using Command = std::function<void(Emulator&)>;
+        using Factory = std::function<std::shared_ptr<Emulator>()>;
+
+        // The emulator produces sampleRate samples per second, resampled to the rate of the audio player
+        EmulationThread(std::shared_ptr<Emulator> emulator, AudioPlayer& audio, int sampleRate);
+        ~EmulationThread();
+
+    public:
+        EmulationThread(const EmulationThread& other) = delete;
+        EmulationThread(EmulationThread&& other) noexcept = delete;
+        EmulationThread& operator=(const EmulationThread& other) = delete;
+        EmulationThread& operator=(EmulationThread&& other) noexcept = delete;
+
+    public:
+        // Must always be called from the same thread
+        void keyEvent(Key key, KeyAction action);
+        // Queues a command executed by the emulation thread before the next chunk of emulation
+        void post(Command command);
+        // Replaces the emulator, waiting for the emulation thread to stop touching the previous one
+        void replace(const Factory& factory);
+
+        // Runs f on the calling thread while the emulation thread is held, for reads that need a consistent machine
+        template<typename F>
+        decltype(auto) access(F&& f)
+        {
+            std::lock_guard lock{m_emulatorMutex};
+            return std::forward<F>(f)(*m_emulator);
+        }
+
+        // Records the screen and the audio of the running machine to path.epv/.wav until stopRecording() or replace()
+        void startRecording(std::filesystem::path path, unsigned sampleRate);
+        void stopRecording();
+        [[nodiscard]] bool recording() const { return m_recording; }
+        [[nodiscard]] RecorderStatistics recordingStatistics() const;
+
+        // Low-pass modelling the speaker, on top of the DC blocker always applied to the emulator output
+        void setSpeakerFilter(const bool speakerFilter) { m_speakerFilter = speakerFilter; }
+        [[nodiscard]] bool speakerFilter() const { return m_speakerFilter; }
+
+        void setRunning(const bool running) { m_running = running; }
+        [[nodiscard]] bool paused() const { return m_paused; }
+        // State of Emulator::tape() after the last chunk
+        [[nodiscard]] bool tapeLoaded() const { return m_tapeLoaded; }
+        [[nodiscard]] bool tapePlaying() const { return m_tapePlaying; }
+
+        // Picks up the most recent frame, returns false when no new one has been published since the last call. A
+        // frame is published when the emulator completes it, or after every chunk if it does not count frames.
+        bool updateFrame() { return m_frames.update(); }
+        [[nodiscard]] const Frame& frame() const { return m_frames.front(); }
+
+#ifdef EPOCH_PROFILER
+        // Duration in milliseconds of the last chunk of emulation
+        [[nodiscard]] float chunkTime() const { return m_chunkTime; }
+        // Stages of the audio chain and the milliseconds each spent on the last chunk
+        [[nodiscard]] const std::vector<std::string>& audioStageNames() const { return m_audioStageNames; }
+        [[nodiscard]] float audioStageTime(const std::size_t index) const { return m_audioStageTimes[index]; }
+#endif
+
+    private:
+        struct KeyEvent
+        {
+            Key key;
+            KeyAction action;
+        };
+
+        void run();
+        void runCommands();
+        void publishFrame(bool record);
+
+    private:
+        // Samples generated at most between two looks at the command queue, about 10ms of emulation
+        static constexpr unsigned long MaxChunkSamples = 512;
+        static constexpr float SpeakerCutoff = 8000.f;
+        static constexpr std::size_t MaxAudioStages = 4;
+
+        std::shared_ptr<Emulator> m_emulator;
+        AudioPlayer& m_audio;
+        std::mutex m_emulatorMutex{};
+
+        SpscQueue<KeyEvent, 256> m_keys{};
+        std::mutex m_commandsMutex{};
+        std::vector<Command> m_commands{};
+        std::vector<Command> m_pendingCommands{};
+
+        TripleBuffer<Frame> m_frames{};
+        uint64_t m_publishedFrame{};
+        // Emulator samples, then the same chunk resampled for the audio player
+        std::vector<SoundSample> m_audioBlock{};
+        std::vector<SoundSample> m_audioOutput{};
+        sound::AudioChain m_audioChain;
+        sound::LowPassFilter* m_speakerStage{};
+        std::atomic<bool> m_speakerFilter{true};
+
+        // Emulation thread only, like the emulator
+        std::unique_ptr<Recorder> m_recorder{};
+        std::atomic<bool> m_recording{};
+        mutable std::mutex m_recordingMutex{};
+        RecorderStatistics m_recordingStatistics{};
+
+        std::atomic<bool> m_running{true};
+        std::atomic<bool> m_paused{};
+        std::atomic<bool> m_tapeLoaded{};
+        std::atomic<bool> m_tapePlaying{};
+        std::atomic<bool> m_stop{};
+#ifdef EPOCH_PROFILER
+        std::atomic<float> m_chunkTime{};
+        std::vector<std::string> m_audioStageNames{};
+        std::array<std::atomic<float>, MaxAudioStages> m_audioStageTimes{};
+#endif
+        std::thread m_thread{};
+    };
+}  // namespace epoch::frontend
+
+#endif
@@ -0,0 +1,88 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace epoch::frontend
+{
+    // Share of the arrival error folded into the frame clock at each frame: slow enough to smooth the chunked
+    // production, fast enough to follow the audio clock drifting from the display one
+    static constexpr double FrameClockGain = 0.02;
+    // Larger errors mean a reset, a pause or a model switch: start the clock again
+    static constexpr double FrameClockResync = 0.25;
+
+    FramePacer::FramePacer(const double framesPerSecond, const double displayRate)
+        : m_framePeriod{1.0 / framesPerSecond}, m_refreshPeriod{1.0 / displayRate}
+    {
+        m_lastPresent = now();
+    }
+
+    double FramePacer::now()
+    {
+        const auto time = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>(time).count();
+    }
+
+    void FramePacer::presented()
+    {
+        const auto time = now();
+        const auto interval = time - m_lastPresent;
+        m_lastPresent = time;
+
+        m_intervals[m_interval] = static_cast<float>(interval * 1000.0);
+        m_interval = (m_interval + 1) % m_intervals.size();
+        m_measured = std::min(m_measured + 1, m_intervals.size());
+        if (m_measured < m_intervals.size()) return;
+
+        // Until the history is full the nominal rate of the monitor is used
+        const auto count = static_cast<float>(m_intervals.size());
+        const auto mean = std::accumulate(m_intervals.begin(), m_intervals.end(), 0.f) / count;
+        auto variance = 0.f;
+        for (const auto value : m_intervals) variance += (value - mean) * (value - mean);
+        m_jitter = std::sqrt(variance / count);
+        m_refreshPeriod = static_cast<double>(mean) * 0.001;
+    }
+
+    void FramePacer::arrived(const uint64_t frame)
+    {
+        const auto time = now();
+        const auto error = time - frameTime(frame);
+        if (!m_locked || std::abs(error) > FrameClockResync)
+        {
+            m_frameBase = time - static_cast<double>(frame) * m_framePeriod;
+            m_locked = true;
+        }
+        else
+        {
+            m_frameBase += error * FrameClockGain;
+        }
+    }
+
+    bool FramePacer::due(const uint64_t frame) const { return frameTime(frame) <= nextRefresh(); }
+
+    float FramePacer::blend() const
+    {
+        const auto ratio = m_framePeriod / m_refreshPeriod;
+        if (std::abs(ratio - std::round(ratio)) < 0.01) return 1.f;
+        const auto covered = (nextRefresh() - frameTime(m_shownFrame)) / m_refreshPeriod;
+        return static_cast<float>(std::clamp(covered, 0.0, 1.0));
+    }
+}  // namespace epoch::frontend
@@ -0,0 +1,82 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRONTEND_FRAMEPACER_HPP_
+#define SRC_FRONTEND_FRAMEPACER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace epoch::frontend
+{
+    // Decides which emulated frame is shown at each display refresh. Frames reach the render thread in bursts (one
+    // per chunk of audio), the pacer puts them back on a regular clock at the emulated rate and holds each one until
+    // the refresh it belongs to; it also measures the display refresh and its jitter.
+    class FramePacer final
+    {
+    public:
+        FramePacer(double framesPerSecond, double displayRate);
+
+    public:
+        void setFramesPerSecond(double framesPerSecond) { m_framePeriod = 1.0 / framesPerSecond; }
+
+        // Called right after every buffer swap
+        void presented();
+        // Called when a new frame has been published by the emulation thread
+        void arrived(uint64_t frame);
+        // Whether the frame should be uploaded for the coming refresh, or held for a later one
+        [[nodiscard]] bool due(uint64_t frame) const;
+        // Called when the frame is uploaded
+        void shown(uint64_t frame) { m_shownFrame = frame; }
+        // Weight of the shown frame against the previous one for the coming refresh: the part of the refresh interval
+        // covered by the shown frame. Always 1 when the display refresh is a multiple of the emulated rate.
+        [[nodiscard]] float blend() const;
+
+        [[nodiscard]] double refreshRate() const { return 1.0 / m_refreshPeriod; }
+        // Standard deviation of the intervals between presents, in milliseconds
+        [[nodiscard]] float jitter() const { return m_jitter; }
+        // Last intervals between presents in milliseconds, oldest at intervalsOffset()
+        [[nodiscard]] const float* intervals() const { return m_intervals.data(); }
+        [[nodiscard]] int intervalsCount() const { return static_cast<int>(m_intervals.size()); }
+        [[nodiscard]] int intervalsOffset() const { return static_cast<int>(m_interval); }
+
+        [[nodiscard]] static double now();
+
+    private:
+        [[nodiscard]] double frameTime(uint64_t frame) const
+        {
+            return m_frameBase + static_cast<double>(frame) * m_framePeriod;
+        }
+        [[nodiscard]] double nextRefresh() const { return m_lastPresent + m_refreshPeriod; }
+
+    private:
+        double m_framePeriod;
+        // Ideal time of frame 0, frame n is due at m_frameBase + n * m_framePeriod
+        double m_frameBase{};
+        bool m_locked{};
+        uint64_t m_shownFrame{};
+
+        double m_refreshPeriod;
+        double m_lastPresent{};
+        std::array<float, 128> m_intervals{};
+        std::size_t m_interval{};
+        std::size_t m_measured{};
+        float m_jitter{};
+    };
+}  // namespace epoch::frontend
+
+#endif
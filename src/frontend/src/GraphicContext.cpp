@@ -18,10 +18,16 @@
 
 #include "ConfigurableShader.hpp"
 #include "Shader.hpp"
+#include "ShaderCache.hpp"
+#include "Shaders.hpp"
 
 #include <bit>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
 
 namespace epoch::frontend
 {
@@ -32,94 +38,213 @@ namespace epoch::frontend
         float uv[2];
     };
 
-    GraphicContext::GraphicContext()
+    static void setupQuad(const GLuint vao, const GLuint vertexBuffer, const GLuint indexBuffer, const float uMax,
+                          const float vTop, const float vBottom)
+    {
+        glBindVertexArray(vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        const Vertex quadVertices[] = {
+            {{-1, -1, 0, 1}, {1, 1, 1, 1}, {0, vBottom}},
+            {{1, -1, 0, 1}, {1, 1, 1, 1}, {uMax, vBottom}},
+            {{1, 1, 0, 1}, {1, 1, 1, 1}, {uMax, vTop}},
+            {{-1, 1, 0, 1}, {1, 1, 1, 1}, {0, vTop}},
+        };
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        const uint8_t quadIndices[] = {
+            0, 1, 3, 1, 2, 3,
+        };
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), &quadIndices, GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float),
+                              reinterpret_cast<void *>(4 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 10 * sizeof(float),
+                              reinterpret_cast<void *>(8 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    GraphicContext::GraphicContext(std::filesystem::path shaderCacheDirectory)
     {
         glClearColor(0.f, 0.f, 0.f, 0.f);
 
         glGenVertexArrays(1, &m_vao);
         assert(m_vao);
+        glGenVertexArrays(1, &m_passVao);
+        assert(m_passVao);
         glGenBuffers(1, &m_vertexBuffer);
         assert(m_vertexBuffer);
+        glGenBuffers(1, &m_passVertexBuffer);
+        assert(m_passVertexBuffer);
         glGenBuffers(1, &m_indexBuffer);
         assert(m_indexBuffer);
-        glGenTextures(1, &m_screenTexture);
-        assert(m_screenTexture);
-
-        glBindTexture(GL_TEXTURE_2D, m_screenTexture);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glGenTextures(static_cast<GLsizei>(m_screenTextures.size()), m_screenTextures.data());
+        for (const auto screenTexture : m_screenTextures)
+        {
+            assert(screenTexture);
+            glBindTexture(GL_TEXTURE_2D, screenTexture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
         glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenTextures(1, &m_paletteTexture);
+        assert(m_paletteTexture);
+        glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAX_LEVEL, 0);
+        glBindTexture(GL_TEXTURE_1D, 0);
+
+        for (auto& pixelBuffer : m_pixelBuffers)
+        {
+            glGenBuffers(1, &pixelBuffer.buffer);
+            assert(pixelBuffer.buffer);
+        }
+
+        m_shaderCache = std::make_unique<ShaderCache>(std::move(shaderCacheDirectory));
     }
 
     GraphicContext::~GraphicContext()
     {
+        deletePasses();
         if (m_vao) glDeleteVertexArrays(1, &m_vao);
+        if (m_passVao) glDeleteVertexArrays(1, &m_passVao);
         if (m_vertexBuffer) glDeleteBuffers(1, &m_vertexBuffer);
+        if (m_passVertexBuffer) glDeleteBuffers(1, &m_passVertexBuffer);
         if (m_indexBuffer) glDeleteBuffers(1, &m_indexBuffer);
-        if (m_screenTexture) glDeleteTextures(1, &m_screenTexture);
-        m_shader = nullptr;
+        if (m_screenTextures[0])
+            glDeleteTextures(static_cast<GLsizei>(m_screenTextures.size()), m_screenTextures.data());
+        if (m_paletteTexture) glDeleteTextures(1, &m_paletteTexture);
+        for (const auto& pixelBuffer : m_pixelBuffers)
+        {
+            if (pixelBuffer.fence) glDeleteSync(pixelBuffer.fence);
+            if (pixelBuffer.buffer) glDeleteBuffers(1, &pixelBuffer.buffer);
+        }
     }
 
-    void GraphicContext::init(const unsigned screenWidth, const unsigned screenHeight)
+    void GraphicContext::init(const unsigned screenWidth, const unsigned screenHeight, const bool indexed)
     {
         assert(screenWidth > 0);
         assert(screenHeight > 0);
         m_screenWidth = screenWidth;
         m_screenHeight = screenHeight;
+        m_indexed = indexed;
 
         m_screenTextureWidth = std::bit_ceil(m_screenWidth);
         m_screenTextureHeight = std::bit_ceil(m_screenHeight);
 
-        glBindTexture(GL_TEXTURE_2D, m_screenTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLint>(m_screenTextureWidth),
-                     static_cast<GLint>(m_screenTextureHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        for (const auto screenTexture : m_screenTextures)
+        {
+            glBindTexture(GL_TEXTURE_2D, screenTexture);
+            if (m_indexed)
+            {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, static_cast<GLint>(m_screenTextureWidth),
+                             static_cast<GLint>(m_screenTextureHeight), 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLint>(m_screenTextureWidth),
+                             static_cast<GLint>(m_screenTextureHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
         glBindTexture(GL_TEXTURE_2D, 0);
 
-        glBindVertexArray(m_vao);
-
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-        constexpr auto uMin = .0f;
-        constexpr auto vMin = .0f;
-        const auto uMax = static_cast<float>(screenWidth) / static_cast<float>(m_screenTextureWidth);
-        const auto vMax = static_cast<float>(screenHeight) / static_cast<float>(m_screenTextureHeight);
-        const Vertex quadVertices[] = {
-            {{-1, -1, 0, 1}, {1, 1, 1, 1}, {uMin, vMax}},
-            {{1, -1, 0, 1}, {1, 1, 1, 1}, {uMax, vMax}},
-            {{1, 1, 0, 1}, {1, 1, 1, 1}, {uMax, vMin}},
-            {{-1, 1, 0, 1}, {1, 1, 1, 1}, {uMin, vMin}},
-        };
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-        const uint8_t quadIndices[] = {
-            0, 1, 3, 1, 2, 3,
-        };
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), &quadIndices, GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float), nullptr);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float),
-                              reinterpret_cast<void *>(4 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 10 * sizeof(float),
-                              reinterpret_cast<void *>(8 * sizeof(float)));
-        glEnableVertexAttribArray(2);
+        m_pixelBufferSize = static_cast<std::size_t>(m_screenWidth) * m_screenHeight * (m_indexed ? 1 : 4);
+        for (auto& pixelBuffer : m_pixelBuffers)
+        {
+            if (pixelBuffer.fence) glDeleteSync(pixelBuffer.fence);
+            pixelBuffer.fence = {};
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(m_pixelBufferSize), nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        // The emulator screen fills the top left corner of its texture, rows top to bottom
+        setupQuad(m_vao, m_vertexBuffer, m_indexBuffer,
+                  static_cast<float>(screenWidth) / static_cast<float>(m_screenTextureWidth), 0.f,
+                  static_cast<float>(screenHeight) / static_cast<float>(m_screenTextureHeight));
+        // Intermediate passes render bottom to top, like any OpenGL framebuffer
+        setupQuad(m_passVao, m_passVertexBuffer, m_indexBuffer, 1.f, 1.f, 0.f);
     }
 
     void GraphicContext::updateScreen(const std::span<const uint32_t> buffer)
     {
+        assert(!m_indexed);
         assert(buffer.size() == static_cast<std::size_t>(m_screenWidth) * m_screenHeight);
+        uploadScreen(buffer.data(), buffer.size_bytes(), GL_RGBA);
+    }
+
+    void GraphicContext::updateScreen(const std::span<const uint8_t> indices)
+    {
+        assert(m_indexed);
+        assert(indices.size() == static_cast<std::size_t>(m_screenWidth) * m_screenHeight);
+        uploadScreen(indices.data(), indices.size_bytes(), GL_RED_INTEGER);
+    }
+
+    void GraphicContext::uploadScreen(const void* data, const std::size_t size, const GLenum format)
+    {
+        assert(size == m_pixelBufferSize);
+        auto& pixelBuffer = m_pixelBuffers[m_pixelBuffer];
+        m_pixelBuffer = (m_pixelBuffer + 1) % m_pixelBuffers.size();
+        if (pixelBuffer.fence)
+        {
+            // Only waits when the driver is more than PixelBuffersCount frames behind
+            glClientWaitSync(pixelBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(pixelBuffer.fence);
+            pixelBuffer.fence = {};
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+        // Unsynchronized: the fence above already guarantees the previous upload from this buffer has completed
+        auto* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                                        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (mapped)
+        {
+            std::memcpy(mapped, data, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+        {
+            // Fall back to a plain upload from client memory
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        // The current screen becomes the previous one
+        m_screenTexture ^= 1;
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_screenTexture);
+        glBindTexture(GL_TEXTURE_2D, m_screenTextures[m_screenTexture]);
+        // Rows of single bytes are not 4 bytes aligned in general
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(m_screenWidth),
-                        static_cast<GLsizei>(m_screenHeight), GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+                        static_cast<GLsizei>(m_screenHeight), format, GL_UNSIGNED_BYTE, mapped ? nullptr : data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glBindTexture(GL_TEXTURE_2D, 0);
+        if (mapped)
+        {
+            pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+
+    void GraphicContext::updatePalette(const std::span<const uint32_t> palette)
+    {
+        assert(palette.size() <= 256);
+        glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, static_cast<GLsizei>(palette.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     palette.data());
+        glBindTexture(GL_TEXTURE_1D, 0);
     }
 
     void GraphicContext::renderScreen()
@@ -127,18 +252,50 @@ namespace epoch::frontend
         glDisable(GL_BLEND);
         glDisable(GL_SCISSOR_TEST);
 
-        glClear(GL_COLOR_BUFFER_BIT);
+        resizePasses();
 
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, m_paletteTexture);
+        if (m_frameBlending)
+        {
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, m_screenTextures[m_screenTexture ^ 1]);
+        }
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_screenTexture);
-
-        glBindVertexArray(m_vao);
-        m_shader->bind();
-        m_shader->setUniformInt("FrameCount", m_frameCount);
-        // glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-        // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+        glBindTexture(GL_TEXTURE_2D, m_screenTextures[m_screenTexture]);
+
+        for (std::size_t i = 0; i < m_passes.size(); ++i)
+        {
+            const auto& pass = m_passes[i];
+            if (pass.framebuffer)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+                glViewport(0, 0, pass.width, pass.height);
+            }
+            else
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+            if (i > 0) glBindTexture(GL_TEXTURE_2D, m_passes[i - 1].texture);
+
+            glBindVertexArray(i == 0 ? m_vao : m_passVao);
+            pass.shader->bind();
+            pass.shader->setUniformInt("FrameCount", m_frameCount);
+            if (i == 0 && m_frameBlending) pass.shader->setUniformFloat("FrameBlend", m_frameBlend);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+        }
+
         glBindTexture(GL_TEXTURE_2D, 0);
+        if (m_frameBlending)
+        {
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, 0);
+        glActiveTexture(GL_TEXTURE0);
         glUseProgram(0);
         glBindVertexArray(0);
 
@@ -147,53 +304,138 @@ namespace epoch::frontend
 
     void GraphicContext::viewport(const int x, const int y, const int width, const int height)
     {
+        m_viewportX = x;
+        m_viewportY = y;
         m_viewportWidth = width;
         m_viewportHeight = height;
         glViewport(x, y, width, height);
-
-        m_shader->bind();
-        float vec2[2];
-        vec2[0] = static_cast<float>(m_viewportWidth);
-        vec2[1] = static_cast<float>(m_viewportHeight);
-        m_shader->setUniformVec2("OutputSize", vec2);
     }
 
     void GraphicContext::updateShader(ConfigurableShader &configurableShader)
     {
-        m_shader = nullptr;
-
-        std::string vertexSource =
-            "#version 330 core\n#define VERTEX\n#define PARAMETER_UNIFORM\n\n" + configurableShader.source();
-        std::string fragmentSource =
-            "#version 330 core\n#define FRAGMENT\n#define PARAMETER_UNIFORM\n\n" + configurableShader.source();
-
-        m_shader = std::make_unique<Shader>(vertexSource, fragmentSource);
-        m_shader->bind();
-        m_shader->setUniformTexture("MainTexture", 0);
-        float vec2[2];
-        vec2[0] = static_cast<float>(m_screenWidth);
-        vec2[1] = static_cast<float>(m_screenHeight);
-        m_shader->setUniformVec2("InputSize", vec2);
-        vec2[0] = static_cast<float>(m_screenTextureWidth);
-        vec2[1] = static_cast<float>(m_screenTextureHeight);
-        m_shader->setUniformVec2("TextureSize", vec2);
-        vec2[0] = static_cast<float>(m_viewportWidth);
-        vec2[1] = static_cast<float>(m_viewportHeight);
-        m_shader->setUniformVec2("OutputSize", vec2);
-        float mat4x4[16] = {
-            1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1,
-        };
-        m_shader->setUniformMat4("MVPMatrix", mat4x4);
+        deletePasses();
+
+        const auto& passes = configurableShader.passes();
+        assert(!passes.empty());
+        for (std::size_t i = 0; i < passes.size(); ++i)
+        {
+            // Only the first pass samples the emulator screen, the others the RGBA output of the previous pass
+            std::string defines = "#define PARAMETER_UNIFORM\n";
+            if (i == 0 && m_indexed) defines += "#define INDEXED_SCREEN\n";
+            if (i == 0 && m_frameBlending) defines += "#define FRAME_BLENDING\n";
+            const auto& source = passes[i].source;
+            const std::string vertexSource = "#version 330 core\n#define VERTEX\n" + defines + "\n" + source;
+            const std::string fragmentSource = "#version 330 core\n#define FRAGMENT\n" + defines +
+                                               std::string{shaders::SCREEN_SAMPLING} + "\n" + source;
+
+            auto& pass = m_passes.emplace_back();
+            pass.shader = std::make_unique<Shader>(vertexSource, fragmentSource, m_shaderCache.get());
+            pass.scaleType = i + 1 < passes.size() ? passes[i].scaleType : ShaderPassScale::viewport;
+            pass.scale = i + 1 < passes.size() ? passes[i].scale : 1.f;
+            if (i + 1 < passes.size())
+            {
+                glGenFramebuffers(1, &pass.framebuffer);
+                glGenTextures(1, &pass.texture);
+                const GLint filter = passes[i + 1].filterLinear ? GL_LINEAR : GL_NEAREST;
+                glBindTexture(GL_TEXTURE_2D, pass.texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+
+            pass.shader->bind();
+            pass.shader->setUniformTexture("ScreenTexture", 0);
+            pass.shader->setUniformTexture("ScreenPalette", 1);
+            pass.shader->setUniformTexture("ScreenPreviousTexture", 2);
+            float mat4x4[16] = {
+                1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1,
+            };
+            pass.shader->setUniformMat4("MVPMatrix", mat4x4);
+        }
 
         updateShaderParameters(configurableShader);
     }
 
     void GraphicContext::updateShaderParameters(ConfigurableShader &configurableShader)
     {
-        m_shader->bind();
-        for (const auto &parameter : configurableShader.parameters())
+        for (const auto& pass : m_passes)
+        {
+            pass.shader->bind();
+            for (const auto &parameter : configurableShader.parameters())
+            {
+                pass.shader->setUniformFloat(parameter.variableName, parameter.value);
+            }
+        }
+    }
+
+    void GraphicContext::resizePasses()
+    {
+        // Sizes are recomputed every frame, the framebuffers are only reallocated when they change
+        int inputWidth = static_cast<int>(m_screenWidth), inputHeight = static_cast<int>(m_screenHeight);
+        int textureWidth = static_cast<int>(m_screenTextureWidth);
+        int textureHeight = static_cast<int>(m_screenTextureHeight);
+        bool inputChanged = false;
+        for (auto& pass : m_passes)
+        {
+            int width = m_viewportWidth, height = m_viewportHeight;
+            switch (pass.scaleType)
+            {
+                case ShaderPassScale::source:
+                    width = static_cast<int>(static_cast<float>(inputWidth) * pass.scale);
+                    height = static_cast<int>(static_cast<float>(inputHeight) * pass.scale);
+                    break;
+                case ShaderPassScale::viewport:
+                    width = static_cast<int>(static_cast<float>(m_viewportWidth) * pass.scale);
+                    height = static_cast<int>(static_cast<float>(m_viewportHeight) * pass.scale);
+                    break;
+                case ShaderPassScale::absolute:
+                    width = height = static_cast<int>(pass.scale);
+                    break;
+            }
+            width = std::max(width, 1);
+            height = std::max(height, 1);
+
+            const auto outputChanged = width != pass.width || height != pass.height;
+            if (outputChanged && pass.framebuffer)
+            {
+                glBindTexture(GL_TEXTURE_2D, pass.texture);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pass.texture, 0);
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            }
+            if (outputChanged || inputChanged)
+            {
+                pass.width = width;
+                pass.height = height;
+                pass.shader->bind();
+                float vec2[2];
+                vec2[0] = static_cast<float>(inputWidth);
+                vec2[1] = static_cast<float>(inputHeight);
+                pass.shader->setUniformVec2("InputSize", vec2);
+                vec2[0] = static_cast<float>(textureWidth);
+                vec2[1] = static_cast<float>(textureHeight);
+                pass.shader->setUniformVec2("TextureSize", vec2);
+                vec2[0] = static_cast<float>(width);
+                vec2[1] = static_cast<float>(height);
+                pass.shader->setUniformVec2("OutputSize", vec2);
+            }
+            inputChanged = outputChanged;
+            inputWidth = textureWidth = width;
+            inputHeight = textureHeight = height;
+        }
+    }
+
+    void GraphicContext::deletePasses()
+    {
+        for (const auto& pass : m_passes)
         {
-            m_shader->setUniformFloat(parameter.variableName, parameter.value);
+            if (pass.framebuffer) glDeleteFramebuffers(1, &pass.framebuffer);
+            if (pass.texture) glDeleteTextures(1, &pass.texture);
         }
+        m_passes.clear();
     }
 }  // namespace epoch::frontend
@@ -17,21 +17,28 @@
 #ifndef SRC_FRONTEND_GRAPHICCONTEXT_HPP_
 #define SRC_FRONTEND_GRAPHICCONTEXT_HPP_
 
+#include "ConfigurableShader.hpp"
+
 #include <glad/glad.h>
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <span>
+#include <vector>
 
 namespace epoch::frontend
 {
-    class ConfigurableShader;
     class Shader;
+    class ShaderCache;
 
     class GraphicContext final
     {
     public:
-        GraphicContext();
+        // Linked shader programs are cached in shaderCacheDirectory, created on the first store
+        explicit GraphicContext(std::filesystem::path shaderCacheDirectory);
         ~GraphicContext();
 
     public:
@@ -41,24 +48,68 @@ namespace epoch::frontend
         GraphicContext& operator=(GraphicContext&& other) noexcept = delete;
 
     public:
-        void init(unsigned screenWidth, unsigned screenHeight);
+        // An indexed screen is uploaded as 8 bit palette indices, the shaders look the colors up in the palette
+        void init(unsigned screenWidth, unsigned screenHeight, bool indexed);
         void updateScreen(std::span<const uint32_t> buffer);
+        void updateScreen(std::span<const uint8_t> indices);
+        void updatePalette(std::span<const uint32_t> palette);
         void renderScreen();
         void viewport(int x, int y, int width, int height);
 
         void updateShader(ConfigurableShader& configurableShader);
         void updateShaderParameters(ConfigurableShader& configurableShader);
 
+        // Mixes the previous screen into the current one in the shaders, takes effect at the next updateShader()
+        void setFrameBlending(const bool enabled) { m_frameBlending = enabled; }
+        // Weight of the current screen against the previous one, see FramePacer::blend
+        void setFrameBlend(const float blend) { m_frameBlend = blend; }
+
     private:
         unsigned m_screenWidth{}, m_screenHeight{};
         unsigned m_screenTextureWidth{}, m_screenTextureHeight{};
-        int m_viewportWidth{}, m_viewportHeight{};
+        int m_viewportX{}, m_viewportY{}, m_viewportWidth{}, m_viewportHeight{};
         int m_frameCount{};
+        bool m_indexed{};
+        bool m_frameBlending{};
+        float m_frameBlend{1.f};
+
+        // The quad sampling the emulator screen, and the one sampling the output of an intermediate pass
+        GLuint m_vao{}, m_passVao{};
+        GLuint m_vertexBuffer{}, m_passVertexBuffer{}, m_indexBuffer{};
+        // The current screen and the previous one, uploads alternate between the two
+        std::array<GLuint, 2> m_screenTextures{};
+        std::size_t m_screenTexture{};
+        GLuint m_paletteTexture{};
+        std::unique_ptr<ShaderCache> m_shaderCache{};
+
+        // Each pass but the last draws into its own framebuffer, kept across frames until its size changes
+        struct Pass
+        {
+            std::unique_ptr<Shader> shader{};
+            ShaderPassScale scaleType{};
+            float scale{};
+            GLuint framebuffer{};
+            GLuint texture{};
+            int width{}, height{};
+        };
+        std::vector<Pass> m_passes{};
+
+        void resizePasses();
+        void deletePasses();
+
+        // Screen uploads go through a ring of pixel buffers: the copy to the texture runs asynchronously while the
+        // next frame is emulated, the fence of each buffer tells when the driver is done reading it
+        struct PixelBuffer
+        {
+            GLuint buffer{};
+            GLsync fence{};
+        };
+        static constexpr std::size_t PixelBuffersCount = 3;
+        std::array<PixelBuffer, PixelBuffersCount> m_pixelBuffers{};
+        std::size_t m_pixelBuffer{};
+        std::size_t m_pixelBufferSize{};
 
-        GLuint m_vao{};
-        GLuint m_vertexBuffer{}, m_indexBuffer{};
-        GLuint m_screenTexture{};
-        std::unique_ptr<Shader> m_shader{};
+        void uploadScreen(const void* data, std::size_t size, GLenum format);
     };
 }  // namespace epoch::frontend
 
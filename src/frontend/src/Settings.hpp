@@ -24,6 +24,10 @@ namespace epoch::frontend
     struct SettingsEmulator final
     {
         std::string key;
+        // Keep only a couple of host audio buffers queued, see AudioPlayer::setLowLatency
+        bool lowLatencyAudio{false};
+        // Low-pass the audio like a small speaker, see EmulationThread::setSpeakerFilter
+        bool speakerFilter{true};
 
         bool operator==(const SettingsEmulator&) const = default;
     };
@@ -34,6 +38,8 @@ namespace epoch::frontend
         std::string lastLoadPath{"."};
         std::string lastSavePath{"."};
         std::string shader;
+        bool frameBlending{false};
+        bool adaptiveSync{false};
 
         bool operator==(const SettingsUI&) const = default;
     };
@@ -27,6 +27,8 @@ struct YAML::convert<epoch::frontend::SettingsEmulator>
     {
         Node node;
         node["key"] = rhs.key;
+        node["lowLatencyAudio"] = rhs.lowLatencyAudio;
+        node["speakerFilter"] = rhs.speakerFilter;
         return node;
     }
 
@@ -37,6 +39,8 @@ struct YAML::convert<epoch::frontend::SettingsEmulator>
             return false;
         }
         rhs.key = node["key"].as<std::string>("");
+        rhs.lowLatencyAudio = node["lowLatencyAudio"].as<bool>(false);
+        rhs.speakerFilter = node["speakerFilter"].as<bool>(true);
         return true;
     }
 };
@@ -51,6 +55,8 @@ struct YAML::convert<epoch::frontend::SettingsUI>
         node["lastLoadPath"] = rhs.lastLoadPath;
         node["lastSavePath"] = rhs.lastSavePath;
         node["shader"] = rhs.shader;
+        node["frameBlending"] = rhs.frameBlending;
+        node["adaptiveSync"] = rhs.adaptiveSync;
         return node;
     }
 
@@ -64,6 +70,8 @@ struct YAML::convert<epoch::frontend::SettingsUI>
         rhs.lastLoadPath = node["lastLoadPath"].as<std::string>(".");
         rhs.lastSavePath = node["lastSavePath"].as<std::string>(".");
         rhs.shader = node["shader"].as<std::string>("");
+        rhs.frameBlending = node["frameBlending"].as<bool>(false);
+        rhs.adaptiveSync = node["adaptiveSync"].as<bool>(false);
         return true;
     }
 };
@@ -41,6 +41,7 @@ namespace epoch::frontend
         void reset();
 
         [[nodiscard]] bool dirty() const;
+        [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
 
         [[nodiscard]] const Settings& current() const { return m_currentSettings; }
         [[nodiscard]] Settings& current() { return m_currentSettings; }
@@ -16,6 +16,8 @@
 
 #include "Shader.hpp"
 
+#include "ShaderCache.hpp"
+
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
@@ -69,13 +71,17 @@ namespace epoch::frontend
         }
     }
 
-    Shader::Shader(const std::string_view vertex, const std::string_view fragment)
+    Shader::Shader(const std::string_view vertex, const std::string_view fragment, const ShaderCache* cache)
     {
         m_handle = glCreateProgram();
         assert(m_handle);
+        if (cache && cache->load(m_handle, vertex, fragment)) return;
+
         const ShaderModule vertexModule{GL_VERTEX_SHADER, vertex};
         const ShaderModule fragmentModule{GL_FRAGMENT_SHADER, fragment};
+        if (cache) glProgramParameteri(m_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         link(vertexModule, fragmentModule);
+        if (cache) cache->store(m_handle, vertex, fragment);
     }
 
     Shader::~Shader()
@@ -46,10 +46,13 @@ namespace epoch::frontend
         void compile(std::string_view source) const;
     };
 
+    class ShaderCache;
+
     class Shader final
     {
     public:
-        Shader(std::string_view vertex, std::string_view fragment);
+        // With a cache the linked program is loaded from it when present, and saved to it otherwise
+        Shader(std::string_view vertex, std::string_view fragment, const ShaderCache* cache = nullptr);
         ~Shader();
 
     public:
@@ -0,0 +1,121 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ShaderCache.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace epoch::frontend
+{
+    static constexpr std::array<char, 4> Magic{'E', 'P', 'S', 'C'};
+
+    static void hash(uint64_t& h, const std::string_view data)
+    {
+        // FNV-1a, the cache only needs to tell sources apart
+        for (const auto c : data)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+    }
+
+    static std::string glString(const GLenum name)
+    {
+        const auto value = reinterpret_cast<const char*>(glGetString(name));
+        return value ? value : "";
+    }
+
+    ShaderCache::ShaderCache(std::filesystem::path directory) : m_directory{std::move(directory)}
+    {
+        GLint formats{};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        m_enabled = formats > 0;
+        // Binaries are only valid for the driver that produced them
+        m_driver = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+    }
+
+    bool ShaderCache::load(const GLuint program, const std::string_view vertex, const std::string_view fragment) const
+    {
+        if (!m_enabled) return false;
+        std::ifstream file{path(vertex, fragment), std::ios::binary};
+        if (!file.good()) return false;
+
+        std::array<char, 4> magic{};
+        GLenum format{};
+        file.read(magic.data(), magic.size());
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        const std::vector<char> binary{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        if (magic != Magic || binary.empty()) return false;
+
+        glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint success{};
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        return success;
+    }
+
+    void ShaderCache::store(const GLuint program, const std::string_view vertex, const std::string_view fragment) const
+    {
+        if (!m_enabled) return;
+        GLint length{};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> binary(static_cast<std::size_t>(length));
+        GLenum format{};
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+        // Written aside and renamed, so that a crash or another instance never leaves a truncated binary behind
+        const auto target = path(vertex, fragment);
+        auto temp = target;
+        temp += '.' + std::to_string(std::random_device{}()) + ".tmp";
+        {
+            std::ofstream file{temp, std::ios::binary};
+            if (!file.good()) return;
+            file.write(Magic.data(), Magic.size());
+            file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+            file.close();
+            if (!file.good())
+            {
+                std::filesystem::remove(temp, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temp, target, error);
+        if (error) std::filesystem::remove(temp, error);
+    }
+
+    std::filesystem::path ShaderCache::path(const std::string_view vertex, const std::string_view fragment) const
+    {
+        uint64_t h = 0xcbf29ce484222325ull;
+        hash(h, m_driver);
+        hash(h, {"\0", 1});
+        hash(h, vertex);
+        hash(h, {"\0", 1});
+        hash(h, fragment);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(h));
+        return m_directory / name;
+    }
+}  // namespace epoch::frontend
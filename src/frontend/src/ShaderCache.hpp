@@ -0,0 +1,54 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRONTEND_SHADERCACHE_HPP_
+#define SRC_FRONTEND_SHADERCACHE_HPP_
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace epoch::frontend
+{
+    // Linked program binaries saved on disk, keyed by the hash of the sources and of the driver: skips compiling and
+    // linking the same program again at the next start. Any I/O problem just turns into a cache miss.
+    class ShaderCache final
+    {
+    public:
+        explicit ShaderCache(std::filesystem::path directory);
+
+    public:
+        // False when the driver supports no binary format
+        [[nodiscard]] bool enabled() const { return m_enabled; }
+
+        // Loads the binary into program, false on a miss or when the driver rejects the binary
+        bool load(GLuint program, std::string_view vertex, std::string_view fragment) const;
+        // program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        void store(GLuint program, std::string_view vertex, std::string_view fragment) const;
+
+    private:
+        [[nodiscard]] std::filesystem::path path(std::string_view vertex, std::string_view fragment) const;
+
+    private:
+        std::filesystem::path m_directory;
+        std::string m_driver{};
+        bool m_enabled{};
+    };
+}  // namespace epoch::frontend
+
+#endif
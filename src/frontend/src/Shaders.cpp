@@ -18,6 +18,48 @@
 
 namespace epoch::frontend::shaders
 {
+    // Prepended to every program: screenTexture() samples the emulator screen, either RGBA or palette indices
+    // (INDEXED_SCREEN, looked up in the ScreenPalette 1D texture). Indices are integers and are not filtered, the
+    // screen texture is sampled with nearest filtering in both cases. With FRAME_BLENDING the previous screen is
+    // mixed in, FrameBlend being the weight of the current one.
+    std::string_view SCREEN_SAMPLING = R"GLSL(
+#if defined(FRAGMENT)
+#if defined(INDEXED_SCREEN)
+#define SCREEN_SAMPLER usampler2D
+uniform sampler1D ScreenPalette;
+
+vec4 screenTexel(usampler2D screen, vec2 uv)
+{
+    ivec2 size = textureSize(screen, 0);
+    ivec2 texel = clamp(ivec2(floor(uv * vec2(size))), ivec2(0), size - 1);
+    return texelFetch(ScreenPalette, int(texelFetch(screen, texel, 0).r), 0);
+}
+#else
+#define SCREEN_SAMPLER sampler2D
+
+vec4 screenTexel(sampler2D screen, vec2 uv)
+{
+    return texture(screen, uv);
+}
+#endif
+
+uniform SCREEN_SAMPLER ScreenTexture;
+#if defined(FRAME_BLENDING)
+uniform SCREEN_SAMPLER ScreenPreviousTexture;
+uniform float FrameBlend;
+#endif
+
+vec4 screenTexture(vec2 uv)
+{
+#if defined(FRAME_BLENDING)
+    return mix(screenTexel(ScreenPreviousTexture, uv), screenTexel(ScreenTexture, uv), FrameBlend);
+#else
+    return screenTexel(ScreenTexture, uv);
+#endif
+}
+#endif
+)GLSL";
+
     std::string_view DEFAULT = R"GLSL(
 #if defined(VERTEX)
 layout (location = 0) in vec4 inPos;
@@ -33,15 +75,13 @@ void main()
 #endif
 
 #if defined(FRAGMENT)
-uniform sampler2D MainTexture;
-
 in vec2 passTexCoords;
 
 out vec4 outFragColor;
 
 void main()
 {
-    outFragColor = texture(MainTexture, passTexCoords);
+    outFragColor = screenTexture(passTexCoords);
 }
 #endif
 )GLSL";
@@ -164,16 +204,15 @@ uniform COMPAT_PRECISION int FrameCount;
 uniform COMPAT_PRECISION vec2 OutputSize;
 uniform COMPAT_PRECISION vec2 TextureSize;
 uniform COMPAT_PRECISION vec2 InputSize;
-uniform sampler2D Texture;
 COMPAT_VARYING vec4 TEX0;
 
 #define FIX(c) max(abs(c), 1e-5)
 #define PI 3.141592653589
 
-#define TEX2D(c) dilate(COMPAT_TEXTURE(Texture, c))
+#define TEX2D(c) dilate(screenTexture(c))
 
 // compatibility #defines
-#define Source Texture
+#define Source ScreenTexture
 #define vTexCoord TEX0.xy
 
 #define SourceSize vec4(TextureSize, 1.0 / TextureSize) //either TextureSize or InputSize
@@ -578,7 +617,6 @@ uniform COMPAT_PRECISION int FrameCount;
 uniform COMPAT_PRECISION vec2 OutputSize;
 uniform COMPAT_PRECISION vec2 TextureSize;
 uniform COMPAT_PRECISION vec2 InputSize;
-uniform sampler2D Texture;
 COMPAT_VARYING vec4 TEX0;
 
 // Comment the next line to disable interpolation in linear gamma (and
@@ -599,9 +637,9 @@ COMPAT_VARYING vec4 TEX0;
 #define PI 3.141592653589
 
 #ifdef LINEAR_PROCESSING
-#       define TEX2D(c) pow(COMPAT_TEXTURE(Texture, (c)), vec4(CRTgamma))
+#       define TEX2D(c) pow(screenTexture(c), vec4(CRTgamma))
 #else
-#       define TEX2D(c) COMPAT_TEXTURE(Texture, (c))
+#       define TEX2D(c) screenTexture(c)
 #endif
 
 COMPAT_VARYING vec2 one;
@@ -848,4 +886,58 @@ if (INV == 1.0){ mul_res = inv_gamma(mul_res,pwr);}
 } 
 #endif
     )GLSL";
+
+    // Cheap horizontal blur approximating the limited chroma bandwidth of a PAL signal, meant as a first pass
+    std::string_view PAL_BLUR = R"GLSL(
+#pragma parameter PAL_BLUR "PAL Blur" 0.5 0.0 1.0 0.05
+
+#if defined(VERTEX)
+layout (location = 0) in vec4 inPos;
+layout (location = 2) in vec2 inTexCoords;
+
+out vec2 passTexCoords;
+
+void main()
+{
+    gl_Position = inPos;
+    passTexCoords = inTexCoords;
+}
+#endif
+
+#if defined(FRAGMENT)
+#ifdef PARAMETER_UNIFORM
+uniform float PAL_BLUR;
+#else
+#define PAL_BLUR 0.5
+#endif
+
+uniform vec2 TextureSize;
+
+in vec2 passTexCoords;
+
+out vec4 outFragColor;
+
+void main()
+{
+    vec2 dx = vec2(1.0 / TextureSize.x, 0.0);
+    vec4 left = screenTexture(passTexCoords - dx);
+    vec4 center = screenTexture(passTexCoords);
+    vec4 right = screenTexture(passTexCoords + dx);
+    outFragColor = mix(center, (left + 2.0 * center + right) * 0.25, PAL_BLUR);
+}
+#endif
+)GLSL";
+
+    // Presets chain the built-in shaders above, referring to them by key
+    std::string_view CRT_EASYMODE_PAL = R"(
+shaders = 2
+
+shader0 = pal-blur
+scale_type0 = source
+scale0 = 1.0
+filter_linear0 = false
+
+shader1 = crt-easymode
+filter_linear1 = false
+)";
 }  // namespace epoch::frontend::shaders
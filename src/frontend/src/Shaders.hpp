@@ -21,9 +21,14 @@
 
 namespace epoch::frontend::shaders
 {
+    extern std::string_view SCREEN_SAMPLING;
+
     extern std::string_view DEFAULT;
     extern std::string_view CRT_EASYMODE;
     extern std::string_view CRT_GEOM;
+    extern std::string_view PAL_BLUR;
+
+    extern std::string_view CRT_EASYMODE_PAL;
 }  // namespace epoch::frontend::shaders
 
 #endif
@@ -0,0 +1,62 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRONTEND_SPSCQUEUE_HPP_
+#define SRC_FRONTEND_SPSCQUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+
+namespace epoch::frontend
+{
+    // Bounded lock-free queue with exactly one producer thread and one consumer thread
+    template<typename T, std::size_t N>
+    class SpscQueue final
+    {
+        static_assert(std::has_single_bit(N), "SpscQueue size must be a power of two");
+
+    public:
+        // Producer side, returns false when the queue is full
+        bool push(const T& value)
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == N) return false;
+            m_buffer[tail & (N - 1)] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, returns false when the queue is empty
+        bool pop(T& value)
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) return false;
+            value = m_buffer[head & (N - 1)];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        // Each index on its own cache line so the two threads do not bounce it
+        alignas(64) std::atomic<std::size_t> m_head{};
+        alignas(64) std::atomic<std::size_t> m_tail{};
+        std::array<T, N> m_buffer{};
+    };
+}  // namespace epoch::frontend
+
+#endif
@@ -0,0 +1,59 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRONTEND_TRIPLEBUFFER_HPP_
+#define SRC_FRONTEND_TRIPLEBUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace epoch::frontend
+{
+    // Lock-free handoff of the latest value from one producer thread to one consumer thread: neither side ever
+    // waits, the producer overwrites values the consumer did not pick up in time
+    template<typename T>
+    class TripleBuffer final
+    {
+    public:
+        // Producer side: fill back() then publish() it
+        [[nodiscard]] T& back() { return m_buffers[m_back]; }
+        void publish()
+        {
+            m_back = m_middle.exchange(static_cast<uint8_t>(m_back | NewFlag), std::memory_order_acq_rel) & IndexMask;
+        }
+
+        // Consumer side: update() makes the last published value current, returns false when there is none newer
+        bool update()
+        {
+            if ((m_middle.load(std::memory_order_relaxed) & NewFlag) == 0) return false;
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+        [[nodiscard]] const T& front() const { return m_buffers[m_front]; }
+
+    private:
+        static constexpr uint8_t IndexMask = 0x03;
+        static constexpr uint8_t NewFlag = 0x04;
+
+        std::array<T, 3> m_buffers{};
+        uint8_t m_back{0};
+        std::atomic<uint8_t> m_middle{1};
+        uint8_t m_front{2};
+    };
+}  // namespace epoch::frontend
+
+#endif
@@ -153,6 +153,25 @@ namespace epoch::frontend
         }
     }
 
+    double Window::refreshRate() const
+    {
+        auto monitor = glfwGetWindowMonitor(m_window);
+        if (!monitor) monitor = glfwGetPrimaryMonitor();
+        const auto vidmode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+        return vidmode && vidmode->refreshRate > 0 ? vidmode->refreshRate : 60.0;
+    }
+
+    bool Window::adaptiveSyncSupported() const
+    {
+        return glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+               glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    }
+
+    void Window::setAdaptiveSync(const bool enabled) const
+    {
+        glfwSwapInterval(enabled && adaptiveSyncSupported() ? -1 : 1);
+    }
+
     void Window::setTitle(const std::string& title) const { glfwSetWindowTitle(m_window, title.c_str()); }
 
     void Window::setCharCallback(CharCallback callback) { m_charCallback = std::move(callback); }
@@ -70,6 +70,12 @@ namespace epoch::frontend
         void resize(unsigned width, unsigned height) const;
         void mode(WindowMode mode);
 
+        // Nominal refresh rate of the monitor showing the window (the primary one when windowed)
+        [[nodiscard]] double refreshRate() const;
+        // Adaptive vsync: a late frame is presented immediately instead of waiting for the next refresh
+        [[nodiscard]] bool adaptiveSyncSupported() const;
+        void setAdaptiveSync(bool enabled) const;
+
         void setTitle(const std::string& title) const;
 
         using CharCallback = std::function<void(unsigned int)>;
@@ -17,30 +17,48 @@
 #include <epoch/frontend.hpp>
 #include <epoch/zxspectrum.hpp>
 
-int main()
+#include <memory>
+#include <string>
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
 {
+#ifdef EPOCH_GDB_SERVER
+    // --gdb <port|localhost:port|unix:path> waits for gdb connections on that endpoint
+    std::string gdbEndpoint;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string{argv[i]} == "--gdb") gdbEndpoint = argv[i + 1];
+    }
+    const auto create = [gdbEndpoint](std::unique_ptr<epoch::zxspectrum::ZXSpectrumEmulator> emulator)
+    {
+        if (!gdbEndpoint.empty()) emulator->startGdbServer(gdbEndpoint);
+        return emulator;
+    };
+#else
+    const auto create = [](std::unique_ptr<epoch::zxspectrum::ZXSpectrumEmulator> emulator) { return emulator; };
+#endif
     const epoch::frontend::ApplicationConfiguration configuration{
         .emulators =
             {
                 {
                     .key = "ZXSpectrum48K",
                     .name = "ZX Spectrum 48K",
-                    .factory = []() { return epoch::zxspectrum::ZXSpectrumEmulator::create48K(); },
+                    .factory = [create]() { return create(epoch::zxspectrum::ZXSpectrumEmulator::create48K()); },
                 },
                 {
                     .key = "ZXSpectrum128K",
                     .name = "ZX Spectrum 128K",
-                    .factory = []() { return epoch::zxspectrum::ZXSpectrumEmulator::create128K(); },
+                    .factory = [create]() { return create(epoch::zxspectrum::ZXSpectrumEmulator::create128K()); },
                 },
                 {
                     .key = "ZXSpectrum128K+2",
                     .name = "ZX Spectrum 128K+2",
-                    .factory = []() { return epoch::zxspectrum::ZXSpectrumEmulator::create128KPlus2(); },
+                    .factory = [create]() { return create(epoch::zxspectrum::ZXSpectrumEmulator::create128KPlus2()); },
                 },
                 {
                     .key = "ZXSpectrum128K+3",
                     .name = "ZX Spectrum 128K+2A/+3",
-                    .factory = []() { return epoch::zxspectrum::ZXSpectrumEmulator::create128KPlus3(); },
+                    .factory = [create]() { return create(epoch::zxspectrum::ZXSpectrumEmulator::create128KPlus3()); },
                 },
             },
     };
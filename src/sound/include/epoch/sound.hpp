@@ -18,5 +18,6 @@
 #define INCLUDE_EPOCH_SOUND_HPP_
 
 #include "../../src/AY8910Device.hpp"
+#include "../../src/AudioChain.hpp"
 
 #endif
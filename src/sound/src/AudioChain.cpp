@@ -0,0 +1,277 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "AudioChain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EPOCH_SOUND_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace epoch::sound
+{
+    static_assert(sizeof(SoundSample) == 2 * sizeof(float), "SoundSample blocks are processed as interleaved floats");
+
+    namespace
+    {
+        // Modified Bessel function of the first kind, order 0, for the Kaiser window
+        double besselI0(const double x)
+        {
+            double sum = 1, term = 1;
+            for (int k = 1; k < 32; ++k)
+            {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+    }  // namespace
+
+    void AudioStage::setEnabled(const bool enabled)
+    {
+        if (enabled && !m_enabled) reset();
+        m_enabled = enabled;
+    }
+
+    DcBlocker::DcBlocker(const float sampleRate, const float cutoff)
+        : m_pole{std::exp(-2.f * std::numbers::pi_v<float> * cutoff / sampleRate)}
+    {
+    }
+
+    void DcBlocker::process(const std::span<SoundSample> block)
+    {
+        auto input = m_input, output = m_output;
+        for (auto& sample : block)
+        {
+            const auto x = sample;
+            output = x - input + output * m_pole;
+            input = x;
+            sample = output;
+        }
+        m_input = input;
+        m_output = output;
+    }
+
+    void DcBlocker::reset()
+    {
+        m_input = {};
+        m_output = {};
+    }
+
+    LowPassFilter::LowPassFilter(const float sampleRate, const float cutoff, const float q)
+    {
+        // RBJ cookbook low-pass, normalized by a0
+        const auto w0 = 2.f * std::numbers::pi_v<float> * std::min(cutoff, sampleRate * 0.49f) / sampleRate;
+        const auto alpha = std::sin(w0) / (2.f * q);
+        const auto cosW0 = std::cos(w0);
+        const auto a0 = 1.f + alpha;
+        m_b0 = (1.f - cosW0) * 0.5f / a0;
+        m_b1 = (1.f - cosW0) / a0;
+        m_b2 = m_b0;
+        m_a1 = -2.f * cosW0 / a0;
+        m_a2 = (1.f - alpha) / a0;
+    }
+
+    void LowPassFilter::process(const std::span<SoundSample> block)
+    {
+        // Transposed direct form II, both channels at once
+        auto z1 = m_z1, z2 = m_z2;
+        for (auto& sample : block)
+        {
+            const auto x = sample;
+            const auto y = x * m_b0 + z1;
+            z1 = x * m_b1 - y * m_a1 + z2;
+            z2 = x * m_b2 - y * m_a2;
+            sample = y;
+        }
+        m_z1 = z1;
+        m_z2 = z2;
+    }
+
+    void LowPassFilter::reset()
+    {
+        m_z1 = {};
+        m_z2 = {};
+    }
+
+    void StereoWidener::process(const std::span<SoundSample> block)
+    {
+        if (m_width == 1.f) return;
+        // left' = mid + side * width, right' = mid - side * width
+        const auto same = (1.f + m_width) * 0.5f, cross = (1.f - m_width) * 0.5f;
+        auto* data = reinterpret_cast<float*>(block.data());
+        std::size_t i = 0;
+#ifdef EPOCH_SOUND_SSE2
+        const auto sameVector = _mm_set1_ps(same), crossVector = _mm_set1_ps(cross);
+        for (; i + 4 <= block.size() * 2; i += 4)
+        {
+            const auto samples = _mm_loadu_ps(data + i);
+            const auto swapped = _mm_shuffle_ps(samples, samples, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(samples, sameVector), _mm_mul_ps(swapped, crossVector)));
+        }
+#endif
+        for (; i < block.size() * 2; i += 2)
+        {
+            const auto left = data[i], right = data[i + 1];
+            data[i] = left * same + right * cross;
+            data[i + 1] = right * same + left * cross;
+        }
+    }
+
+    Resampler::Resampler(const double inputRate, const double outputRate)
+        : m_bypass{inputRate == outputRate}, m_step{inputRate / outputRate}
+    {
+        assert(inputRate > 0 && outputRate > 0);
+        // Cutoff as a fraction of the input rate, with some room for the transition band
+        const auto cutoff = 0.45 * std::min(1., outputRate / inputRate);
+        constexpr auto beta = 8.;
+        m_coefficients.resize(static_cast<std::size_t>(Phases + 1) * Taps * 2);
+        for (int phase = 0; phase <= Phases; ++phase)
+        {
+            double sum = 0;
+            std::vector<double> kernel(Taps);
+            for (int k = 0; k < Taps; ++k)
+            {
+                // Distance from the output sample of input tap k
+                const auto t = static_cast<double>(k - (Taps / 2 - 1)) - static_cast<double>(phase) / Phases;
+                const auto x = 2. * cutoff * t;
+                const auto sinc = x == 0. ? 1. : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+                const auto r = t / (Taps / 2.);
+                const auto window = std::abs(r) >= 1. ? 0. : besselI0(beta * std::sqrt(1. - r * r)) / besselI0(beta);
+                kernel[k] = sinc * window;
+                sum += kernel[k];
+            }
+            for (int k = 0; k < Taps; ++k)
+            {
+                const auto coefficient = static_cast<float>(kernel[k] / sum);
+                m_coefficients[(static_cast<std::size_t>(phase) * Taps + k) * 2] = coefficient;
+                m_coefficients[(static_cast<std::size_t>(phase) * Taps + k) * 2 + 1] = coefficient;
+            }
+        }
+        reset();
+    }
+
+    void Resampler::reset()
+    {
+        // Half the taps of silence, so the first input sample reaches the center of the filter right away
+        m_history.assign(Taps / 2 - 1, SoundSample{});
+        m_position = 0;
+    }
+
+    std::size_t Resampler::inputFor(const std::size_t count) const
+    {
+        if (m_bypass) return count;
+        if (count == 0) return 0;
+        // Same additions as process(), a multiplication could round the other way
+        auto position = m_position;
+        for (std::size_t i = 1; i < count; ++i) position += m_step;
+        const auto last = static_cast<std::size_t>(position);
+        return std::max<std::ptrdiff_t>(0, static_cast<std::ptrdiff_t>(last + Taps) -
+                                               static_cast<std::ptrdiff_t>(m_history.size()));
+    }
+
+    void Resampler::process(const std::span<const SoundSample> input, std::vector<SoundSample>& output)
+    {
+        if (m_bypass)
+        {
+            output.insert(output.end(), input.begin(), input.end());
+            return;
+        }
+
+        m_history.insert(m_history.end(), input.begin(), input.end());
+        while (static_cast<std::size_t>(m_position) + Taps <= m_history.size())
+        {
+            const auto first = static_cast<std::size_t>(m_position);
+            const auto phase = (m_position - static_cast<double>(first)) * Phases;
+            const auto phaseIndex = static_cast<std::size_t>(phase);
+            const auto blend = static_cast<float>(phase - static_cast<double>(phaseIndex));
+            const auto* samples = reinterpret_cast<const float*>(&m_history[first]);
+            const auto* c0 = &m_coefficients[phaseIndex * Taps * 2];
+            const auto* c1 = c0 + Taps * 2;
+#ifdef EPOCH_SOUND_SSE2
+            // Two stereo samples per vector, the coefficients interpolated between the two nearest phases
+            const auto blendVector = _mm_set1_ps(blend);
+            auto sum = _mm_setzero_ps();
+            for (int k = 0; k < Taps * 2; k += 4)
+            {
+                const auto a = _mm_loadu_ps(c0 + k), b = _mm_loadu_ps(c1 + k);
+                const auto coefficients = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), blendVector));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + k), coefficients));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, sum);
+            output.emplace_back(lanes[0] + lanes[2], lanes[1] + lanes[3]);
+#else
+            float left = 0, right = 0;
+            for (int k = 0; k < Taps * 2; k += 2)
+            {
+                const auto coefficient = c0[k] + (c1[k] - c0[k]) * blend;
+                left += samples[k] * coefficient;
+                right += samples[k + 1] * coefficient;
+            }
+            output.emplace_back(left, right);
+#endif
+            m_position += m_step;
+        }
+
+        const auto consumed = std::min(static_cast<std::size_t>(m_position), m_history.size());
+        m_history.erase(m_history.begin(), m_history.begin() + static_cast<std::ptrdiff_t>(consumed));
+        m_position -= static_cast<double>(consumed);
+    }
+
+    AudioChain::AudioChain(const double inputRate, const double outputRate) : m_resampler{inputRate, outputRate} {}
+
+    void AudioChain::filter(const std::span<SoundSample> block)
+    {
+        for (std::size_t i = 0; i < m_stages.size(); ++i)
+        {
+            [[maybe_unused]] auto& time = m_times[i];
+            if (!m_stages[i]->enabled())
+            {
+                time = 0;
+                continue;
+            }
+            PROFILE_BLOCK(&time);
+            m_stages[i]->process(block);
+        }
+    }
+
+    void AudioChain::resample(const std::span<const SoundSample> block, std::vector<SoundSample>& output)
+    {
+        [[maybe_unused]] auto& time = m_times.back();
+        PROFILE_BLOCK(&time);
+        m_resampler.process(block, output);
+    }
+
+    void AudioChain::reset()
+    {
+        for (const auto& stage : m_stages) stage->reset();
+        m_resampler.reset();
+    }
+
+    std::vector<std::string> AudioChain::stageNames() const
+    {
+        std::vector<std::string> names;
+        for (const auto& stage : m_stages) names.push_back(stage->name());
+        names.emplace_back("Resampler");
+        return names;
+    }
+}  // namespace epoch::sound
@@ -0,0 +1,165 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SOUND_AUDIOCHAIN_HPP_
+#define SRC_SOUND_AUDIOCHAIN_HPP_
+
+#include <epoch/core.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace epoch::sound
+{
+    // Processes blocks of samples in place, keeping its state from one block to the next
+    class AudioStage
+    {
+    public:
+        virtual ~AudioStage() = default;
+
+    public:
+        virtual void process(std::span<SoundSample> block) = 0;
+        virtual void reset() {}
+        [[nodiscard]] virtual std::string name() const = 0;
+
+        // A disabled stage is skipped by the chain, its state reset so that it starts clean when enabled again
+        void setEnabled(bool enabled);
+        [[nodiscard]] bool enabled() const { return m_enabled; }
+
+    private:
+        bool m_enabled{true};
+    };
+
+    // One pole high-pass removing the DC offset of the beeper, which sits at either rail when silent
+    class DcBlocker final : public AudioStage
+    {
+    public:
+        explicit DcBlocker(float sampleRate, float cutoff = 20.f);
+
+    public:
+        void process(std::span<SoundSample> block) override;
+        void reset() override;
+        [[nodiscard]] std::string name() const override { return "DC blocker"; }
+
+    private:
+        float m_pole;
+        SoundSample m_input{};
+        SoundSample m_output{};
+    };
+
+    // Second order low-pass, models the limited bandwidth of a small speaker or of the TV audio path
+    class LowPassFilter final : public AudioStage
+    {
+    public:
+        LowPassFilter(float sampleRate, float cutoff, float q = 0.7071f);
+
+    public:
+        void process(std::span<SoundSample> block) override;
+        void reset() override;
+        [[nodiscard]] std::string name() const override { return "Low-pass"; }
+
+    private:
+        float m_b0, m_b1, m_b2, m_a1, m_a2;
+        SoundSample m_z1{};
+        SoundSample m_z2{};
+    };
+
+    // Scales the side (left - right) signal: 1 leaves the input untouched, 0 is mono, above 1 widens the AY
+    // StereoABC/StereoACB mixes whose channels otherwise overlap a lot
+    class StereoWidener final : public AudioStage
+    {
+    public:
+        explicit StereoWidener(float width = 1.f) : m_width{width} {}
+
+    public:
+        void process(std::span<SoundSample> block) override;
+        [[nodiscard]] std::string name() const override { return "Stereo widener"; }
+
+        void setWidth(const float width) { m_width = width; }
+        [[nodiscard]] float width() const { return m_width; }
+
+    private:
+        float m_width;
+    };
+
+    // Windowed sinc (Kaiser) polyphase resampler between any two rates. The cutoff follows the lower of the two, so
+    // downsampling does not alias. Each output sample waits for Taps / 2 input samples past it, that is the latency.
+    class Resampler final
+    {
+    public:
+        Resampler(double inputRate, double outputRate);
+
+    public:
+        // Appends to output every sample the input received so far allows, possibly none
+        void process(std::span<const SoundSample> input, std::vector<SoundSample>& output);
+        // Input samples needed for process() to produce count more output samples. When upsampling it can produce a
+        // few more, the ones already possible with that input.
+        [[nodiscard]] std::size_t inputFor(std::size_t count) const;
+        void reset();
+
+        [[nodiscard]] bool bypass() const { return m_bypass; }
+
+        static constexpr int Taps = 32;
+        static constexpr int Phases = 128;
+
+    private:
+        bool m_bypass;
+        double m_step;
+        double m_position{};
+        // Taps per phase, Phases + 1 of them to interpolate the last one, each coefficient repeated for the two
+        // channels so that it lines up with interleaved stereo samples
+        std::vector<float> m_coefficients{};
+        std::vector<SoundSample> m_history{};
+    };
+
+    // Stages run in order over each block, then the resampler converts to the output rate. With EPOCH_PROFILER
+    // the time spent by each stage on the last block is kept, the resampler last.
+    class AudioChain final
+    {
+    public:
+        AudioChain(double inputRate, double outputRate);
+
+    public:
+        template<typename T, typename... Args>
+        T& emplace(Args&&... args)
+        {
+            auto stage = std::make_unique<T>(std::forward<Args>(args)...);
+            auto& result = *stage;
+            m_stages.push_back(std::move(stage));
+            m_times.push_back(0.f);
+            return result;
+        }
+
+        void filter(std::span<SoundSample> block);
+        void resample(std::span<const SoundSample> block, std::vector<SoundSample>& output);
+        [[nodiscard]] std::size_t inputFor(const std::size_t count) const { return m_resampler.inputFor(count); }
+        void reset();
+
+        [[nodiscard]] std::vector<std::string> stageNames() const;
+        // Milliseconds, in the order of stageNames(); always 0 without EPOCH_PROFILER
+        [[nodiscard]] std::span<const float> stageTimes() const { return m_times; }
+
+    private:
+        std::vector<std::unique_ptr<AudioStage>> m_stages{};
+        Resampler m_resampler;
+        std::vector<float> m_times{0.f};
+    };
+}  // namespace epoch::sound
+
+#endif
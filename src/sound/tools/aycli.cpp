@@ -16,99 +16,456 @@
 
 #include <epoch/sound.hpp>
 
+#ifdef AYCLI_PLAY
 #include "../../frontend/src/AudioPlayer.hpp"
+#endif
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
-struct TestConfiguration final
+namespace
 {
-    uint16_t pitchA;
-    uint16_t pitchB;
-    uint16_t pitchC;
-    uint8_t pitchNoise;
-    uint8_t mixer;
-    uint8_t volA;
-    uint8_t volB;
-    uint8_t volC;
-    uint16_t envDuration;
-    uint8_t envShape;
-};
-
-#define SET_REG(idx, value) \
-    device.address(idx);    \
-    device.data(static_cast<uint8_t>(value))
-
-void executeTest(const TestConfiguration configuration, const unsigned long duration)
-{
-    epoch::sound::AY8910Device device{};
+    constexpr uint64_t AyClock = 1764000;
+    constexpr uint64_t SampleRate = 48000;
+
+    // Register script, one command per line and '#' starting a comment. Numbers can be written in hex (0x...).
+    //   reg <register> <value>   writes an AY register
+    //   wait <milliseconds>      renders that long with the registers as they are
+    //   stereo mono|abc|acb      selects how the channels are mixed
+    struct Command
+    {
+        enum class Type
+        {
+            Register,
+            Wait,
+            Stereo,
+        };
+        Type type;
+        uint32_t first;
+        uint32_t second;
+    };
+    using Script = std::vector<Command>;
 
-    SET_REG(0, configuration.pitchA & 0xff);
-    SET_REG(1, configuration.pitchA >> 8);
-    SET_REG(2, configuration.pitchB & 0xff);
-    SET_REG(3, configuration.pitchB >> 8);
-    SET_REG(4, configuration.pitchC & 0xff);
-    SET_REG(5, configuration.pitchC >> 8);
-    SET_REG(6, configuration.pitchNoise);
-    SET_REG(7, configuration.mixer);
-    SET_REG(8, configuration.volA);
-    SET_REG(9, configuration.volB);
-    SET_REG(10, configuration.volC);
-    SET_REG(11, configuration.envDuration & 0xff);
-    SET_REG(12, configuration.envDuration >> 8);
-    SET_REG(13, configuration.envShape);
+    const epoch::sound::AY8910Device::StereoMix* StereoMixes[] = {
+        &epoch::sound::AY8910Device::Mono,
+        &epoch::sound::AY8910Device::StereoABC,
+        &epoch::sound::AY8910Device::StereoACB,
+    };
 
-    unsigned long ticks = 0;
-    double sampleCount = 0.;
+    uint32_t parseNumber(const std::string& token, const int line)
+    {
+        std::size_t end{};
+        unsigned long value{};
+        try
+        {
+            value = std::stoul(token, &end, 0);
+        }
+        catch (const std::exception&)
+        {
+            end = 0;
+        }
+        if (end == 0 || end != token.size())
+            throw std::runtime_error("Line " + std::to_string(line) + ": invalid number " + token);
+        return static_cast<uint32_t>(value);
+    }
+
+    Script parseScript(std::istream& is)
+    {
+        Script script;
+        std::string text;
+        for (int line = 1; std::getline(is, text); ++line)
+        {
+            if (const auto comment = text.find('#'); comment != std::string::npos) text.resize(comment);
+            std::istringstream tokens{text};
+            std::string command, first, second, extra;
+            if (!(tokens >> command)) continue;
+            tokens >> first >> second >> extra;
+            if (command == "reg" && !second.empty() && extra.empty())
+            {
+                const auto reg = parseNumber(first, line), value = parseNumber(second, line);
+                if (reg > 15 || value > 0xff)
+                    throw std::runtime_error("Line " + std::to_string(line) + ": register or value out of range");
+                script.push_back({Command::Type::Register, reg, value});
+            }
+            else if (command == "wait" && !first.empty() && second.empty())
+            {
+                script.push_back({Command::Type::Wait, parseNumber(first, line), 0});
+            }
+            else if (command == "stereo" && !first.empty() && second.empty())
+            {
+                const auto mix = first == "mono" ? 0u : first == "abc" ? 1u : first == "acb" ? 2u : 3u;
+                if (mix > 2) throw std::runtime_error("Line " + std::to_string(line) + ": unknown stereo mix " + first);
+                script.push_back({Command::Type::Stereo, mix, 0});
+            }
+            else
+            {
+                throw std::runtime_error("Line " + std::to_string(line) + ": invalid command " + text);
+            }
+        }
+        return script;
+    }
+
+    Script loadScript(const std::filesystem::path& path)
+    {
+        std::ifstream is{path};
+        if (!is) throw std::runtime_error("Cannot open " + path.string());
+        try
+        {
+            return parseScript(is);
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error(path.string() + ": " + e.what());
+        }
+    }
 
+    // Three tones with the envelope on B, played when no script is given
+    Script demoScript()
     {
-        const epoch::frontend::AudioPlayer player{48000};
+        std::istringstream is{"reg 0 251\nreg 2 199\nreg 4 167\nreg 7 0xf8\nreg 8 0x0f\nreg 9 0x10\nreg 10 0x0f\n"
+                              "reg 11 0xe8\nreg 12 0x03\nreg 13 0x0e\nwait 2000\n"};
+        return parseScript(is);
+    }
 
-        const auto startTime = std::chrono::system_clock::now();
-        std::vector<float> samples{};
+    struct RenderStatistics
+    {
+        uint64_t clocks{};
+        uint64_t samples{};
+        double seconds{};
+    };
 
-        do
+    // Renders the script at SampleRate as fast as the device goes, appending to samples
+    RenderStatistics render(const Script& script, std::vector<epoch::SoundSample>& samples)
+    {
+        epoch::sound::AY8910Device device{};
+        device.reset();
+        RenderStatistics statistics;
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& command : script)
         {
-            if (const unsigned long count = player.neededSamples(); count > 0)
+            switch (command.type)
+            {
+            case Command::Type::Register:
+                device.address(static_cast<uint8_t>(command.first));
+                device.data(static_cast<uint8_t>(command.second));
+                break;
+            case Command::Type::Stereo:
+                device.stereoMix(*StereoMixes[command.first]);
+                break;
+            case Command::Type::Wait:
             {
-                samples.resize(count * 2);
-                auto i = 0;
-                for (unsigned long x = 0; x < count; ++x)
+                const auto end = statistics.samples + command.first * SampleRate / 1000;
+                for (; statistics.samples < end; ++statistics.samples)
                 {
-                    while (ticks < (sampleCount * 1764000. / 48000.))
+                    // The device is sampled once every AyClock / SampleRate clocks, like the emulators do
+                    for (const auto target = statistics.samples * AyClock / SampleRate; statistics.clocks < target;
+                         ++statistics.clocks)
                     {
                         device.clock();
-                        ticks++;
                     }
-                    samples[i++] = device.output().left;
-                    samples[i++] = device.output().right;
-                    sampleCount++;
+                    samples.push_back(device.output());
                 }
-                player.push(samples);
+                break;
             }
-        } while (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime)
-                     .count() < duration);
+            }
+        }
+        statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return statistics;
     }
 
-    std::cout << "Generated samples: " << sampleCount << "\n";
-    std::cout << "Ticks:             " << ticks << "\n";
-}
+    // 16 bit PCM as written to the WAV files, the golden hashes are computed on it so that they do not depend on
+    // the last bits of the float math
+    std::vector<int16_t> toPcm(const std::vector<epoch::SoundSample>& samples)
+    {
+        std::vector<int16_t> pcm;
+        pcm.reserve(samples.size() * 2);
+        for (const auto& sample : samples)
+        {
+            pcm.push_back(static_cast<int16_t>(std::lround(std::clamp(sample.left, -1.f, 1.f) * 32767.f)));
+            pcm.push_back(static_cast<int16_t>(std::lround(std::clamp(sample.right, -1.f, 1.f) * 32767.f)));
+        }
+        return pcm;
+    }
+
+    void writeWav(const std::filesystem::path& path, const std::vector<int16_t>& pcm, const uint32_t sampleRate)
+    {
+        static_assert(std::endian::native == std::endian::little, "WAV files are little endian");
+        std::ofstream os{path, std::ios::binary};
+        if (!os) throw std::runtime_error("Cannot open " + path.string() + " for writing");
+        const auto write = [&os](const auto value) { os.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+        const auto dataSize = static_cast<uint32_t>(pcm.size() * sizeof(int16_t));
+        os.write("RIFF", 4);
+        write(static_cast<uint32_t>(36 + dataSize));
+        os.write("WAVEfmt ", 8);
+        write(uint32_t{16});
+        write(uint16_t{1});
+        write(uint16_t{2});
+        write(sampleRate);
+        write(static_cast<uint32_t>(sampleRate * 2 * sizeof(int16_t)));
+        write(static_cast<uint16_t>(2 * sizeof(int16_t)));
+        write(uint16_t{16});
+        os.write("data", 4);
+        write(dataSize);
+        os.write(reinterpret_cast<const char*>(pcm.data()), static_cast<std::streamsize>(dataSize));
+        if (!os) throw std::runtime_error("Cannot write " + path.string());
+    }
+
+    // FNV-1a over the PCM bytes
+    uint64_t hash(const std::vector<int16_t>& pcm)
+    {
+        uint64_t result = 0xcbf29ce484222325;
+        for (const auto value : pcm)
+        {
+            const auto bits = static_cast<uint16_t>(value);
+            for (const auto byte : {bits & 0xff, bits >> 8})
+            {
+                result ^= static_cast<uint64_t>(byte);
+                result *= 0x100000001b3;
+            }
+        }
+        return result;
+    }
+
+    std::string hexHash(const uint64_t value)
+    {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+    void printStatistics(const RenderStatistics& statistics)
+    {
+        const auto seconds = std::max(statistics.seconds, 1e-9);
+        const auto audioSeconds = static_cast<double>(statistics.samples) / SampleRate;
+        std::cout << "Samples:   " << statistics.samples << " (" << audioSeconds << " s)\n";
+        std::cout << "Clocks:    " << statistics.clocks << "\n";
+        std::cout << "Time:      " << statistics.seconds * 1000. << " ms\n";
+        std::cout << "Clocks/s:  " << static_cast<double>(statistics.clocks) / seconds << "\n";
+        std::cout << "Samples/s: " << static_cast<double>(statistics.samples) / seconds << " ("
+                  << audioSeconds / seconds << "x real time)\n";
+    }
+
+#ifdef AYCLI_PLAY
+    void play(const Script& script)
+    {
+        std::vector<epoch::SoundSample> samples;
+        render(script, samples);
+
+        const epoch::frontend::AudioPlayer player{0};
+        epoch::sound::Resampler resampler{static_cast<double>(SampleRate), static_cast<double>(player.sampleRate())};
+        std::vector<epoch::SoundSample> output;
+        std::size_t position = 0;
+        while (position < samples.size())
+        {
+            const auto consumption = player.consumption();
+            if (const auto count = player.neededSamples(); count > 0)
+            {
+                const auto input = std::min(resampler.inputFor(count), samples.size() - position);
+                output.clear();
+                resampler.process(std::span{samples}.subspan(position, input), output);
+                position += input;
+                player.push({reinterpret_cast<float*>(output.data()), output.size() * 2});
+            }
+            else
+            {
+                player.waitConsumption(consumption);
+            }
+        }
+        // Let the queued samples play out
+        for (auto seen = player.consumption(); player.neededSamples() < epoch::frontend::AudioPlayer::QueuedSamples;
+             seen = player.consumption())
+        {
+            player.waitConsumption(seen);
+        }
+    }
+#endif
+
+    int renderWav(const Script& script, const std::filesystem::path& output, const uint32_t rate)
+    {
+        std::vector<epoch::SoundSample> samples;
+        printStatistics(render(script, samples));
+        if (rate != SampleRate)
+        {
+            epoch::sound::Resampler resampler{static_cast<double>(SampleRate), static_cast<double>(rate)};
+            std::vector<epoch::SoundSample> resampled;
+            resampler.process(samples, resampled);
+            // Flush the samples still in the filter
+            resampler.process(std::vector<epoch::SoundSample>(epoch::sound::Resampler::Taps), resampled);
+            samples = std::move(resampled);
+        }
+        writeWav(output, toPcm(samples), rate);
+        return EXIT_SUCCESS;
+    }
+
+    int bench(const Script& script, const unsigned long repeat)
+    {
+        RenderStatistics total;
+        std::vector<epoch::SoundSample> samples;
+        for (unsigned long i = 0; i < repeat; ++i)
+        {
+            samples.clear();
+            const auto statistics = render(script, samples);
+            total.clocks += statistics.clocks;
+            total.samples += statistics.samples;
+            total.seconds += statistics.seconds;
+        }
+        printStatistics(total);
+        return EXIT_SUCCESS;
+    }
+
+    // Renders every script of the directory and compares the hashes with hashes.txt, or rewrites it with update
+    int golden(const std::filesystem::path& directory, const bool update)
+    {
+        const auto hashesPath = directory / "hashes.txt";
+        std::map<std::string, std::string> expected;
+        if (!update)
+        {
+            std::ifstream is{hashesPath};
+            if (!is) throw std::runtime_error("Cannot open " + hashesPath.string());
+            std::string value, name;
+            while (is >> value >> name) expected[name] = value;
+        }
+
+        std::vector<std::filesystem::path> scripts;
+        for (const auto& entry : std::filesystem::directory_iterator{directory})
+        {
+            if (entry.path().extension() == ".ay") scripts.push_back(entry.path());
+        }
+        std::ranges::sort(scripts);
+
+        std::map<std::string, std::string> actual;
+        auto failures = 0;
+        for (const auto& path : scripts)
+        {
+            std::vector<epoch::SoundSample> samples;
+            const auto statistics = render(loadScript(path), samples);
+            const auto name = path.filename().string();
+            const auto value = hexHash(hash(toPcm(samples)));
+            actual[name] = value;
+            if (update) continue;
+
+            const auto it = expected.find(name);
+            const auto ok = it != expected.end() && it->second == value;
+            std::cout << (ok ? "OK   " : "FAIL ") << name << " " << value << " ("
+                      << static_cast<double>(statistics.clocks) / std::max(statistics.seconds, 1e-9) / 1e6
+                      << " Mclocks/s)\n";
+            if (!ok)
+            {
+                std::cout << "     expected " << (it != expected.end() ? it->second : "nothing") << "\n";
+                ++failures;
+            }
+        }
+        if (!update)
+        {
+            for (const auto& [name, value] : expected)
+            {
+                if (!actual.contains(name))
+                {
+                    std::cout << "FAIL " << name << " missing\n";
+                    ++failures;
+                }
+            }
+            return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
 
-int main()
+        std::ofstream os{hashesPath};
+        for (const auto& [name, value] : actual) os << value << " " << name << "\n";
+        if (!os) throw std::runtime_error("Cannot write " + hashesPath.string());
+        std::cout << "Updated " << actual.size() << " hashes in " << hashesPath.string() << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    void usage(const char* program)
+    {
+        // Without AYCLI_PLAY the tool does not link the frontend, and cannot play live
+#ifdef AYCLI_PLAY
+        std::cerr << "Usage: " << program << " [play] [SCRIPT]\n"
+                  << "       " << program << " render SCRIPT OUTPUT.wav [--rate N]\n"
+#else
+        std::cerr << "Usage: " << program << " render SCRIPT OUTPUT.wav [--rate N]\n"
+#endif
+                  << "       " << program << " bench [SCRIPT] [--repeat N]\n"
+                  << "       " << program << " golden DIRECTORY [--update]\n";
+    }
+}  // namespace
+
+int main(int argc, char* argv[])
 {
-    std::cout << "AY8910 CLI utility\n";
-    executeTest({.pitchA = 251,
-                 .pitchB = 199,
-                 .pitchC = 167,
-                 .pitchNoise = 0,
-                 .mixer = 0b11111000,
-                 .volA = 0x0f,
-                 .volB = 0x10,
-                 .volC = 0x0f,
-                 .envDuration = 1000,
-                 .envShape = 0b1110},
-                2000);
+    std::string_view mode{"play"};
+    // Script, or directory of scripts in golden mode
+    const char* path{};
+    const char* output{};
+    unsigned long rate = SampleRate;
+    unsigned long repeat = 10;
+    auto update = false;
+    auto first = 1;
+    if (argc > 1 && !std::string_view{argv[1]}.starts_with("--"))
+    {
+        const std::string_view arg{argv[1]};
+        if (arg == "play" || arg == "render" || arg == "bench" || arg == "golden")
+        {
+            mode = arg;
+            first = 2;
+        }
+    }
+    for (int i = first; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "--rate" && i + 1 < argc && mode == "render")
+            rate = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--repeat" && i + 1 < argc && mode == "bench")
+            repeat = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--update" && mode == "golden")
+            update = true;
+        else if (!path && !arg.starts_with("--"))
+            path = argv[i];
+        else if (!output && !arg.starts_with("--") && mode == "render")
+            output = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((mode == "render" && (!path || !output || rate == 0)) || (mode == "golden" && !path) || repeat == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        if (mode == "golden") return golden(path, update);
+        const auto script = path ? loadScript(path) : demoScript();
+        if (mode == "render") return renderWav(script, output, static_cast<uint32_t>(rate));
+        if (mode == "bench") return bench(script, repeat);
+#ifdef AYCLI_PLAY
+        std::cout << "AY8910 CLI utility\n";
+        play(script);
+#else
+        usage(argv[0]);
+        return EXIT_FAILURE;
+#endif
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
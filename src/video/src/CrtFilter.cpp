@@ -0,0 +1,493 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CrtFilter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numbers>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EPOCH_VIDEO_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace epoch::video
+{
+    namespace
+    {
+        // Pixels of padding around the source, enough for the filter taps of any sampling point on the screen
+        constexpr int Padding = 3;
+
+        // One RGBA pixel, SSE2 when available and plain floats otherwise
+#ifdef EPOCH_VIDEO_SSE2
+        struct Vec4
+        {
+            __m128 v;
+
+            static Vec4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+            static Vec4 broadcast(const float f) { return {_mm_set1_ps(f)}; }
+            static Vec4 make(const float r, const float g, const float b) { return {_mm_setr_ps(r, g, b, 0.f)}; }
+            void store(float* p) const { _mm_storeu_ps(p, v); }
+            // Table indices of the channels clamped to [0, 1], for tables of steps + 1 entries
+            void indices(const float steps, int32_t* out) const
+            {
+                const auto clamped = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+                const auto scaled = _mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(steps)), _mm_set1_ps(0.5f));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvttps_epi32(scaled));
+            }
+        };
+        inline Vec4 operator+(const Vec4 a, const Vec4 b) { return {_mm_add_ps(a.v, b.v)}; }
+        inline Vec4 operator-(const Vec4 a, const Vec4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+        inline Vec4 operator*(const Vec4 a, const Vec4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+        inline Vec4 min(const Vec4 a, const Vec4 b) { return {_mm_min_ps(a.v, b.v)}; }
+        inline Vec4 max(const Vec4 a, const Vec4 b) { return {_mm_max_ps(a.v, b.v)}; }
+#else
+        struct Vec4
+        {
+            float v[4];
+
+            static Vec4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+            static Vec4 broadcast(const float f) { return {{f, f, f, f}}; }
+            static Vec4 make(const float r, const float g, const float b) { return {{r, g, b, 0.f}}; }
+            void store(float* p) const { std::memcpy(p, v, sizeof(v)); }
+            void indices(const float steps, int32_t* out) const
+            {
+                for (int i = 0; i < 4; ++i) out[i] = static_cast<int32_t>(std::clamp(v[i], 0.f, 1.f) * steps + 0.5f);
+            }
+        };
+        template<typename F>
+        inline Vec4 apply(const Vec4 a, const Vec4 b, F f)
+        {
+            return {{f(a.v[0], b.v[0]), f(a.v[1], b.v[1]), f(a.v[2], b.v[2]), f(a.v[3], b.v[3])}};
+        }
+        inline Vec4 operator+(const Vec4 a, const Vec4 b) { return apply(a, b, std::plus{}); }
+        inline Vec4 operator-(const Vec4 a, const Vec4 b) { return apply(a, b, std::minus{}); }
+        inline Vec4 operator*(const Vec4 a, const Vec4 b) { return apply(a, b, std::multiplies{}); }
+        inline Vec4 min(const Vec4 a, const Vec4 b)
+        {
+            return apply(a, b, [](const float x, const float y) { return std::min(x, y); });
+        }
+        inline Vec4 max(const Vec4 a, const Vec4 b)
+        {
+            return apply(a, b, [](const float x, const float y) { return std::max(x, y); });
+        }
+#endif
+
+        // Same as the shader: half-circle s-curve for a sharper interpolation
+        float curveDistance(const float x, const float sharp)
+        {
+            const auto step = x >= 0.5f ? 1.f : 0.f;
+            const auto sign = x < 0.5f ? 1.f : (x > 0.5f ? -1.f : 0.f);
+            const auto curve = 0.5f - std::sqrt(0.25f - (x - step) * (x - step)) * sign;
+            return x + (curve - x) * sharp;
+        }
+
+        // 4 horizontal taps, clamped to the two in the middle to avoid ringing
+        inline Vec4 filterRow(const float* taps, const std::array<float, 4>& coeffs)
+        {
+            const auto t0 = Vec4::load(taps), t1 = Vec4::load(taps + 4), t2 = Vec4::load(taps + 8),
+                       t3 = Vec4::load(taps + 12);
+            const auto col = t0 * Vec4::broadcast(coeffs[0]) + t1 * Vec4::broadcast(coeffs[1]) +
+                             t2 * Vec4::broadcast(coeffs[2]) + t3 * Vec4::broadcast(coeffs[3]);
+            return max(min(col, max(t1, t2)), min(t1, t2));
+        }
+    }  // namespace
+
+    bool CrtParameters::set(const std::string_view name, const float value)
+    {
+        const std::pair<std::string_view, float CrtParameters::*> names[] = {
+            {"SHARPNESS_H", &CrtParameters::sharpnessH},
+            {"SHARPNESS_V", &CrtParameters::sharpnessV},
+            {"MASK_STRENGTH", &CrtParameters::maskStrength},
+            {"MASK_DOT_WIDTH", &CrtParameters::maskDotWidth},
+            {"MASK_DOT_HEIGHT", &CrtParameters::maskDotHeight},
+            {"MASK_STAGGER", &CrtParameters::maskStagger},
+            {"MASK_SIZE", &CrtParameters::maskSize},
+            {"SCANLINE_STRENGTH", &CrtParameters::scanlineStrength},
+            {"SCANLINE_BEAM_WIDTH_MIN", &CrtParameters::scanlineBeamWidthMin},
+            {"SCANLINE_BEAM_WIDTH_MAX", &CrtParameters::scanlineBeamWidthMax},
+            {"SCANLINE_BRIGHT_MIN", &CrtParameters::scanlineBrightMin},
+            {"SCANLINE_BRIGHT_MAX", &CrtParameters::scanlineBrightMax},
+            {"SCANLINE_CUTOFF", &CrtParameters::scanlineCutoff},
+            {"GAMMA_INPUT", &CrtParameters::gammaInput},
+            {"GAMMA_OUTPUT", &CrtParameters::gammaOutput},
+            {"BRIGHT_BOOST", &CrtParameters::brightBoost},
+            {"DILATION", &CrtParameters::dilation},
+            {"CURVATURE", &CrtParameters::curvature},
+            {"R", &CrtParameters::radius},
+            {"cornersize", &CrtParameters::cornerSize},
+            {"cornersmooth", &CrtParameters::cornerSmooth},
+            {"BLOOM", &CrtParameters::bloom},
+        };
+        for (const auto& [parameterName, member] : names)
+        {
+            if (parameterName == name)
+            {
+                this->*member = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    CrtFilter::CrtFilter(const unsigned sourceWidth, const unsigned sourceHeight, const unsigned outputWidth,
+                         const unsigned outputHeight)
+        : m_sourceWidth{sourceWidth},
+          m_sourceHeight{sourceHeight},
+          m_outputWidth{outputWidth},
+          m_outputHeight{outputHeight},
+          m_stride{sourceWidth + 2 * Padding}
+    {
+        assert(sourceWidth > 0 && sourceHeight > 0 && outputWidth > 0 && outputHeight > 0);
+        const auto sourceSize = static_cast<std::size_t>(m_stride) * (m_sourceHeight + 2 * Padding) * 4;
+        m_source.resize(sourceSize);
+        m_bloom.resize(sourceSize);
+        m_blurTemp.resize(sourceSize);
+        rebuild();
+    }
+
+    void CrtFilter::setParameters(const CrtParameters& parameters)
+    {
+        m_parameters = parameters;
+        rebuild();
+    }
+
+    void CrtFilter::rebuild()
+    {
+        const auto& p = m_parameters;
+        constexpr auto pi = std::numbers::pi_v<float>;
+
+        m_lanczos.resize(Phases);
+        for (int i = 0; i < Phases; ++i)
+        {
+            const auto curveX = curveDistance(static_cast<float>(i) / Phases, p.sharpnessH * p.sharpnessH);
+            std::array<float, 4> coeffs{1.f + curveX, curveX, 1.f - curveX, 2.f - curveX};
+            float sum = 0;
+            for (auto& c : coeffs)
+            {
+                c = std::max(std::abs(c * pi), 1e-5f);
+                c = 2.f * std::sin(c) * std::sin(c * 0.5f) / (c * c);
+                sum += c;
+            }
+            for (auto& c : coeffs) c /= sum;
+            m_lanczos[i] = coeffs;
+
+            m_curveY[i] = curveDistance(static_cast<float>(i) / Phases, p.sharpnessV);
+
+            const auto scan = std::cos(2.f * pi * static_cast<float>(i) / Phases) * 0.5f + 0.5f;
+            m_scanLog[i] = std::log2(std::max(scan, 1e-20f));
+            m_scanPow[i] = std::pow(scan, p.scanlineBeamWidthMax);
+        }
+        // clamp(bright * max, min, max) cannot vary when min >= max
+        m_constantBeam = p.scanlineBeamWidthMin >= p.scanlineBeamWidthMax;
+
+        const auto mask = 1.f - p.maskStrength;
+        m_mask[0] = {1.f, mask, mask, 1.f};
+        m_mask[1] = {mask, 1.f, mask, 1.f};
+        m_mask[2] = {mask, mask, 1.f, 1.f};
+
+        m_gammaInput.resize(GammaSteps + 1);
+        for (int i = 0; i <= GammaSteps; ++i)
+        {
+            m_gammaInput[i] = std::pow(static_cast<float>(i) / GammaSteps, p.gammaInput / (p.dilation + 1.f));
+        }
+        for (int i = 0; i < GammaSteps; ++i)
+        {
+            const auto value = std::pow(static_cast<float>(i) / (GammaSteps - 1), 1.f / p.gammaOutput) * p.brightBoost;
+            m_gammaOutput[i] = static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+        }
+
+        // Geometry of every output pixel: the GL path samples at the center of each fragment
+        m_samples.resize(static_cast<std::size_t>(m_outputWidth) * m_outputHeight);
+        const auto sourceWidth = static_cast<float>(m_sourceWidth);
+        const auto sourceHeight = static_cast<float>(m_sourceHeight);
+        const auto barrel = 0.5f * p.curvature / (p.radius * p.radius);
+        for (unsigned y = 0; y < m_outputHeight; ++y)
+        {
+            for (unsigned x = 0; x < m_outputWidth; ++x)
+            {
+                auto u = (static_cast<float>(x) + 0.5f) / static_cast<float>(m_outputWidth);
+                auto v = (static_cast<float>(y) + 0.5f) / static_cast<float>(m_outputHeight);
+                float weight = 1.f;
+                if (p.curvature > 0.f)
+                {
+                    const auto cx = u * 2.f - 1.f, cy = v * 2.f - 1.f;
+                    const auto factor = 1.f + barrel * (cx * cx + cy * cy);
+                    u = cx * factor * 0.5f + 0.5f;
+                    v = cy * factor * 0.5f + 0.5f;
+                    if (u < 0.f || u > 1.f || v < 0.f || v > 1.f)
+                    {
+                        weight = 0.f;
+                    }
+                    else
+                    {
+                        // Rounded corners, as crt-geom on a 4:3 screen
+                        const auto dx = p.cornerSize - std::min(std::min(u, 1.f - u), p.cornerSize);
+                        const auto dy = p.cornerSize - std::min(std::min(v, 1.f - v) * 0.75f, p.cornerSize);
+                        weight = std::clamp((p.cornerSize - std::sqrt(dx * dx + dy * dy)) * p.cornerSmooth, 0.f, 1.f);
+                    }
+                }
+
+                const auto px = std::clamp(u * sourceWidth - 0.5f, -1.f, sourceWidth);
+                const auto py = std::clamp(v * sourceHeight - 0.5f, -1.f, sourceHeight);
+                auto ix = static_cast<int>(std::floor(px)), iy = static_cast<int>(std::floor(py));
+                auto fx = static_cast<int>(std::lround((px - static_cast<float>(ix)) * Phases));
+                auto fy = static_cast<int>(std::lround((py - static_cast<float>(iy)) * Phases));
+                if (fx == Phases)
+                {
+                    fx = 0;
+                    ++ix;
+                }
+                if (fy == Phases)
+                {
+                    fy = 0;
+                    ++iy;
+                }
+
+                const auto modX = std::floor((static_cast<float>(x) + 0.5f) / p.maskSize);
+                const auto modY = std::floor((static_cast<float>(y) + 0.5f) / (p.maskDotHeight * p.maskSize));
+                const auto dot = std::fmod((modX + std::fmod(modY, 2.f) * p.maskStagger) / p.maskDotWidth, 3.f);
+
+                auto& sample = m_samples[static_cast<std::size_t>(y) * m_outputWidth + x];
+                sample.offset = (iy + Padding) * static_cast<int>(m_stride) + ix - 1 + Padding;
+                sample.fx = static_cast<uint8_t>(fx);
+                sample.fy = static_cast<uint8_t>(fy);
+                sample.mask = static_cast<uint8_t>(std::clamp(static_cast<int>(dot), 0, 2));
+                sample.weight = weight;
+            }
+        }
+    }
+
+    void CrtFilter::render(const std::span<const uint8_t> indices, const std::span<const uint32_t> palette,
+                           const std::span<uint32_t> output, const unsigned threads)
+    {
+        assert(indices.size() == static_cast<std::size_t>(m_sourceWidth) * m_sourceHeight);
+        assert(output.size() == static_cast<std::size_t>(m_outputWidth) * m_outputHeight);
+        prepareSource(indices, palette);
+
+        const auto bands = std::clamp(threads, 1u, m_outputHeight);
+        std::vector<std::thread> workers;
+        workers.reserve(bands - 1);
+        for (unsigned band = 1; band < bands; ++band)
+        {
+            const auto first = m_outputHeight * band / bands, last = m_outputHeight * (band + 1) / bands;
+            workers.emplace_back([this, output, first, last] { renderRows(output, first, last); });
+        }
+        renderRows(output, 0, m_outputHeight / bands);
+        for (auto& worker : workers) worker.join();
+    }
+
+    void CrtFilter::prepareSource(const std::span<const uint8_t> indices, const std::span<const uint32_t> palette)
+    {
+        assert(palette.size() <= 256);
+        const auto dilation = m_parameters.dilation;
+        for (std::size_t i = 0; i < palette.size(); ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                const auto value = static_cast<float>((palette[i] >> (c * 8)) & 0xff) / 255.f;
+                m_palette[i * 4 + c] = value * (1.f + (value - 1.f) * dilation);
+            }
+        }
+
+        const auto stride = static_cast<std::size_t>(m_stride) * 4;
+        const auto width = static_cast<std::size_t>(m_sourceWidth);
+        // Edges are replicated into the padding
+        const auto padRows = [&](std::vector<float>& image)
+        {
+            for (unsigned y = 0; y < m_sourceHeight; ++y)
+            {
+                auto* row = &image[(y + Padding) * stride];
+                for (int x = 0; x < Padding; ++x)
+                {
+                    std::memcpy(row + x * 4, row + Padding * 4, 4 * sizeof(float));
+                    std::memcpy(row + (Padding + width + x) * 4, row + (Padding + width - 1) * 4, 4 * sizeof(float));
+                }
+            }
+            for (int y = 0; y < Padding; ++y)
+            {
+                std::memcpy(&image[y * stride], &image[Padding * stride], stride * sizeof(float));
+                std::memcpy(&image[(Padding + m_sourceHeight + y) * stride],
+                            &image[(Padding + m_sourceHeight - 1) * stride], stride * sizeof(float));
+            }
+        };
+
+        for (unsigned y = 0; y < m_sourceHeight; ++y)
+        {
+            auto* row = &m_source[(y + Padding) * stride + Padding * 4];
+            const auto* line = &indices[y * width];
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                std::memcpy(row + x * 4, &m_palette[line[x] * 4], 4 * sizeof(float));
+            }
+        }
+        padRows(m_source);
+
+        if (m_parameters.bloom > 0.f)
+        {
+            // Binomial 5x5 blur of the gamma corrected source
+            constexpr float kernel[] = {1.f / 16, 4.f / 16, 6.f / 16, 4.f / 16, 1.f / 16};
+            for (unsigned y = 0; y < m_sourceHeight + 2 * Padding; ++y)
+            {
+                for (std::size_t i = 0; i < stride; ++i)
+                {
+                    m_blurTemp[y * stride + i] = m_gammaInput[static_cast<std::size_t>(
+                        std::clamp(m_source[y * stride + i], 0.f, 1.f) * GammaSteps + 0.5f)];
+                }
+            }
+            for (unsigned y = 0; y < m_sourceHeight; ++y)
+            {
+                for (std::size_t x = 0; x < width; ++x)
+                {
+                    auto sum = Vec4::broadcast(0);
+                    for (int k = 0; k < 5; ++k)
+                    {
+                        const auto& tap = m_blurTemp[(y + Padding) * stride + (Padding + x + k - 2) * 4];
+                        sum = sum + Vec4::load(&tap) * Vec4::broadcast(kernel[k]);
+                    }
+                    sum.store(&m_bloom[(y + Padding) * stride + (Padding + x) * 4]);
+                }
+            }
+            padRows(m_bloom);
+            for (unsigned y = 0; y < m_sourceHeight; ++y)
+            {
+                for (std::size_t x = 0; x < width; ++x)
+                {
+                    auto sum = Vec4::broadcast(0);
+                    for (int k = 0; k < 5; ++k)
+                    {
+                        const auto& tap = m_bloom[(y + Padding + k - 2) * stride + (Padding + x) * 4];
+                        sum = sum + Vec4::load(&tap) * Vec4::broadcast(kernel[k]);
+                    }
+                    sum.store(&m_blurTemp[(y + Padding) * stride + (Padding + x) * 4]);
+                }
+            }
+            std::swap(m_bloom, m_blurTemp);
+            padRows(m_bloom);
+        }
+    }
+
+    void CrtFilter::renderRows(const std::span<uint32_t> output, const unsigned first, const unsigned last) const
+    {
+        const auto& p = m_parameters;
+        const auto stride = static_cast<std::size_t>(m_stride) * 4;
+        const auto scanlines = static_cast<float>(m_sourceHeight) < p.scanlineCutoff;
+        const auto bloom = p.bloom > 0.f;
+        const auto* gammaInput = m_gammaInput.data();
+        const auto* gammaOutput = m_gammaOutput.data();
+
+        // Without curvature every output row samples a single pair of source rows at the same columns: each source
+        // row is filtered horizontally once, and kept while the following output rows still need it
+        const auto flat = p.curvature <= 0.f;
+        const auto rowSize = static_cast<std::size_t>(m_outputWidth) * 4;
+        std::vector<float> filteredRows(flat ? 2 * rowSize : 0);
+        int cachedRows[2] = {-1, -1};
+        const auto fetchRow = [&](const Sample* samples, const int top, const int row, const int keep) -> const float*
+        {
+            for (int slot = 0; slot < 2; ++slot)
+            {
+                if (cachedRows[slot] == row) return &filteredRows[slot * rowSize];
+            }
+            const auto slot = cachedRows[0] == keep ? 1 : 0;
+            cachedRows[slot] = row;
+            auto* filtered = &filteredRows[slot * rowSize];
+            const auto shift = static_cast<std::ptrdiff_t>(row - top) * static_cast<std::ptrdiff_t>(stride);
+            for (unsigned x = 0; x < m_outputWidth; ++x)
+            {
+                const auto* taps = &m_source[static_cast<std::size_t>(samples[x].offset) * 4 + shift];
+                filterRow(taps, m_lanczos[samples[x].fx]).store(&filtered[x * 4]);
+            }
+            return filtered;
+        };
+
+        alignas(16) int32_t index[4];
+        for (auto y = first; y < last; ++y)
+        {
+            const auto* samples = &m_samples[static_cast<std::size_t>(y) * m_outputWidth];
+            auto* out = &output[static_cast<std::size_t>(y) * m_outputWidth];
+            const float* filtered0{};
+            const float* filtered1{};
+            if (flat)
+            {
+                const auto top = samples[0].offset / static_cast<int>(m_stride);
+                filtered0 = fetchRow(samples, top, top, top + 1);
+                filtered1 = fetchRow(samples, top, top + 1, top);
+            }
+            for (unsigned x = 0; x < m_outputWidth; ++x)
+            {
+                const auto& sample = samples[x];
+                if (sample.weight == 0.f)
+                {
+                    out[x] = 0xff000000;
+                    continue;
+                }
+
+                Vec4 row0, row1;
+                if (flat)
+                {
+                    row0 = Vec4::load(&filtered0[x * 4]);
+                    row1 = Vec4::load(&filtered1[x * 4]);
+                }
+                else
+                {
+                    const auto* taps = &m_source[static_cast<std::size_t>(sample.offset) * 4];
+                    row0 = filterRow(taps, m_lanczos[sample.fx]);
+                    row1 = filterRow(taps + stride, m_lanczos[sample.fx]);
+                }
+                (row0 + (row1 - row0) * Vec4::broadcast(m_curveY[sample.fy])).indices(GammaSteps, index);
+                const auto r = gammaInput[index[0]], g = gammaInput[index[1]], b = gammaInput[index[2]];
+
+                float factor = 1.f;
+                if (scanlines)
+                {
+                    const auto luma = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+                    const auto bright = (std::max(r, std::max(g, b)) + luma) * 0.5f;
+                    const auto scanBright = std::clamp(bright, p.scanlineBrightMin, p.scanlineBrightMax);
+                    // The scanline profile peaks between source rows, half a period away from the sampling point
+                    const auto phase = (sample.fy + Phases / 2) & (Phases - 1);
+                    const auto profile =
+                        m_constantBeam
+                            ? m_scanPow[phase]
+                            : std::exp2(std::clamp(bright * p.scanlineBeamWidthMax, p.scanlineBeamWidthMin,
+                                                   p.scanlineBeamWidthMax) *
+                                        m_scanLog[phase]);
+                    const auto scanWeight = 1.f - profile * p.scanlineStrength;
+                    factor = scanWeight + (1.f - scanWeight) * scanBright;
+                }
+
+                auto result = Vec4::make(r, g, b) * Vec4::load(m_mask[sample.mask].data()) *
+                              Vec4::broadcast(factor * sample.weight);
+                if (bloom)
+                {
+                    const auto* glow = &m_bloom[(static_cast<std::size_t>(sample.offset) + 1) * 4];
+                    const auto fx = Vec4::broadcast(static_cast<float>(sample.fx) / Phases);
+                    const auto fy = Vec4::broadcast(static_cast<float>(sample.fy) / Phases);
+                    const auto top = Vec4::load(glow) + (Vec4::load(glow + 4) - Vec4::load(glow)) * fx;
+                    const auto bottom =
+                        Vec4::load(glow + stride) + (Vec4::load(glow + stride + 4) - Vec4::load(glow + stride)) * fx;
+                    result = result + (top + (bottom - top) * fy) * Vec4::broadcast(p.bloom * sample.weight);
+                }
+                result.indices(GammaSteps - 1, index);
+                out[x] = gammaOutput[index[0]] | gammaOutput[index[1]] << 8 | gammaOutput[index[2]] << 16 | 0xff000000;
+            }
+        }
+    }
+}  // namespace epoch::video
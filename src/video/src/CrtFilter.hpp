@@ -0,0 +1,135 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_VIDEO_CRTFILTER_HPP_
+#define SRC_VIDEO_CRTFILTER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace epoch::video
+{
+    // Parameters of the crt-easymode shader, same names and defaults as its #pragma parameter lines, plus crt-geom
+    // curvature and a bloom pass. The defaults leave curvature and bloom off, matching crt-easymode alone.
+    struct CrtParameters
+    {
+        float sharpnessH{0.5f};
+        float sharpnessV{1.0f};
+        float maskStrength{0.3f};
+        float maskDotWidth{1.0f};
+        float maskDotHeight{1.0f};
+        float maskStagger{0.0f};
+        float maskSize{1.0f};
+        float scanlineStrength{1.0f};
+        float scanlineBeamWidthMin{1.5f};
+        float scanlineBeamWidthMax{1.5f};
+        float scanlineBrightMin{0.35f};
+        float scanlineBrightMax{0.65f};
+        float scanlineCutoff{400.0f};
+        float gammaInput{2.0f};
+        float gammaOutput{1.8f};
+        float brightBoost{1.2f};
+        float dilation{1.0f};
+        // Barrel distortion strength, 0 disables it and the rounded corners
+        float curvature{0.0f};
+        float radius{2.0f};
+        float cornerSize{0.03f};
+        float cornerSmooth{1000.0f};
+        // Blurred copy of the screen added on top, letting bright areas glow over the scanline gaps
+        float bloom{0.0f};
+
+        // Sets the parameter with that shader uniform name (e.g. SCANLINE_STRENGTH, cornersize), so the values of a
+        // ConfigurableShader can be copied over. False when the name is unknown.
+        bool set(std::string_view name, float value);
+    };
+
+    // Software rendition of the crt-easymode shader for hosts without a GPU: scanlines, aperture mask, gamma, and
+    // optionally curvature and bloom. Everything that depends on geometry only is precomputed per output pixel
+    // when the parameters change, a frame is then table lookups and 4-wide float math over RGBA.
+    class CrtFilter final
+    {
+    public:
+        CrtFilter(unsigned sourceWidth, unsigned sourceHeight, unsigned outputWidth, unsigned outputHeight);
+
+    public:
+        void setParameters(const CrtParameters& parameters);
+        [[nodiscard]] const CrtParameters& parameters() const { return m_parameters; }
+
+        [[nodiscard]] unsigned outputWidth() const { return m_outputWidth; }
+        [[nodiscard]] unsigned outputHeight() const { return m_outputHeight; }
+
+        // indices is a palette indexed screen of the source size, output gets RGBA pixels in the same layout as
+        // Emulator::screenBuffer(). Rows are split in bands over the given number of threads.
+        void render(std::span<const uint8_t> indices, std::span<const uint32_t> palette, std::span<uint32_t> output,
+                    unsigned threads = 1);
+
+        // Fractions of a source pixel are quantized to 1 / Phases
+        static constexpr int Phases = 256;
+        // Entries of the gamma tables over [0, 1]
+        static constexpr int GammaSteps = 4096;
+
+    private:
+        // Where an output pixel samples the source: top left of the 4x2 filter taps in the padded source, the
+        // quantized fractions of the sampling point, which RGB mask dot it falls on, and its weight (0 outside the
+        // curved screen)
+        struct Sample
+        {
+            int32_t offset;
+            uint8_t fx;
+            uint8_t fy;
+            uint8_t mask;
+            uint8_t reserved;
+            float weight;
+        };
+
+        void rebuild();
+        void prepareSource(std::span<const uint8_t> indices, std::span<const uint32_t> palette);
+        void renderRows(std::span<uint32_t> output, unsigned first, unsigned last) const;
+
+    private:
+        unsigned m_sourceWidth;
+        unsigned m_sourceHeight;
+        unsigned m_outputWidth;
+        unsigned m_outputHeight;
+        // The source is padded by two pixels on each side, replicating the edges like GL_CLAMP_TO_EDGE
+        unsigned m_stride;
+        CrtParameters m_parameters{};
+
+        std::vector<Sample> m_samples{};
+        // Lanczos coefficients for each horizontal phase, and the vertical interpolation curve
+        std::vector<std::array<float, 4>> m_lanczos{};
+        std::array<float, Phases> m_curveY{};
+        // Scanline profile for each phase: its log2 when the beam width varies with brightness, raised to the
+        // (constant) beam width otherwise
+        std::array<float, Phases> m_scanLog{};
+        std::array<float, Phases> m_scanPow{};
+        bool m_constantBeam{};
+        std::array<std::array<float, 4>, 3> m_mask{};
+        std::vector<float> m_gammaInput{};
+        std::array<uint8_t, GammaSteps> m_gammaOutput{};
+
+        // Dilated palette and the padded source image, RGBA floats
+        std::array<float, 256 * 4> m_palette{};
+        std::vector<float> m_source{};
+        std::vector<float> m_bloom{};
+        std::vector<float> m_blurTemp{};
+    };
+}  // namespace epoch::video
+
+#endif
@@ -22,10 +22,6 @@
 
 namespace epoch::zxspectrum
 {
-    constexpr std::size_t TStatesPerFrame = 69888;
-    constexpr std::size_t CPUClock = 3500000;
-    constexpr double FramesPerSecond = 50.08;
-
     constexpr int ScreenWidth = 256;
     constexpr int ScreenHeight = 192;
     constexpr int BorderLeft = 48;
@@ -33,15 +29,14 @@ namespace epoch::zxspectrum
     constexpr int BorderTop = 48;
     constexpr int BorderBottom = 56;
 
-    constexpr int VerticalRetrace = 16;        // 16 lines
-    constexpr int HorizontalRetrace = 48 * 2;  // Pixels (48 T-states)
     constexpr int InterruptActiveTStates = 32;
 
     constexpr auto Width = ScreenWidth + BorderLeft + BorderRight;
     constexpr auto Height = ScreenHeight + BorderTop + BorderBottom;
 
-    static_assert((VerticalRetrace + Height) * (Width + HorizontalRetrace) ==
-                  static_cast<int>(TStatesPerFrame) * 2);  // total frame length, 2 pixels per T-state
+    constexpr int ContentionTStatesPerLine = ScreenWidth / 2;
+    // Extra table entries past the end of the frame, so an instruction crossing the frame boundary needs no wrap
+    constexpr std::size_t ContentionTableSlack = 256;
 
     constexpr auto AudioInThreshold = 0.2f;
 
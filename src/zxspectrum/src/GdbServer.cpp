@@ -0,0 +1,339 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "GdbServer.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+#ifdef _WIN32
+        using Socket = SOCKET;
+        constexpr auto InvalidSocket = static_cast<std::uintptr_t>(INVALID_SOCKET);
+
+        void closeSocket(const std::uintptr_t socket) { closesocket(static_cast<Socket>(socket)); }
+        constexpr int SendFlags = 0;
+        constexpr int ShutdownBoth = SD_BOTH;
+#else
+        using Socket = int;
+        constexpr auto InvalidSocket = static_cast<std::uintptr_t>(-1);
+
+        void closeSocket(const std::uintptr_t socket) { close(static_cast<Socket>(socket)); }
+        constexpr int ShutdownBoth = SHUT_RDWR;
+#ifdef MSG_NOSIGNAL
+        constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int SendFlags = 0;
+#endif
+#endif
+
+        // Waits up to timeout for the socket to have data (or a connection) ready
+        bool waitReadable(const std::uintptr_t socket, const int timeoutMs)
+        {
+            pollfd fd{};
+            fd.fd = static_cast<Socket>(socket);
+            fd.events = POLLIN;
+#ifdef _WIN32
+            return WSAPoll(&fd, 1, timeoutMs) > 0;
+#else
+            return poll(&fd, 1, timeoutMs) > 0;
+#endif
+        }
+
+        constexpr char HexDigits[] = "0123456789abcdef";
+
+        int hexValue(const char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        void appendByte(std::string& out, const uint8_t value)
+        {
+            out += HexDigits[value >> 4];
+            out += HexDigits[value & 0xf];
+        }
+
+        constexpr std::size_t MaxPacketSize = 0x1000;
+    }  // namespace
+
+    GdbServer::GdbServer(ZXSpectrumEmulator& emulator, const std::string& endpoint)
+        : m_listener{InvalidSocket}, m_client{InvalidSocket}, m_stub{emulator}
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) throw std::runtime_error("Cannot initialize Winsock");
+#endif
+        if (endpoint.starts_with("unix:"))
+        {
+#ifdef _WIN32
+            throw std::runtime_error("Unix domain sockets are not supported on this platform");
+#else
+            m_unixPath = endpoint.substr(5);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (m_unixPath.empty() || m_unixPath.size() >= sizeof(address.sun_path))
+                throw std::runtime_error("Invalid Unix socket path " + m_unixPath);
+            std::memcpy(address.sun_path, m_unixPath.c_str(), m_unixPath.size() + 1);
+            unlink(m_unixPath.c_str());
+            const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+            m_listener = listener < 0 ? InvalidSocket : static_cast<std::uintptr_t>(listener);
+            if (m_listener == InvalidSocket ||
+                bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+                listen(listener, 1) != 0)
+            {
+                if (m_listener != InvalidSocket) closeSocket(m_listener);
+                throw std::runtime_error("Cannot listen on " + m_unixPath);
+            }
+#endif
+        }
+        else
+        {
+            const auto separator = endpoint.rfind(':');
+            const auto host = separator == std::string::npos ? std::string{"localhost"} : endpoint.substr(0, separator);
+            const auto port = separator == std::string::npos ? endpoint : endpoint.substr(separator + 1);
+            if (host != "localhost" && host != "127.0.0.1")
+                throw std::runtime_error("The debugger server only listens on localhost");
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+            const auto listener = socket(AF_INET, SOCK_STREAM, 0);
+            m_listener = static_cast<std::uintptr_t>(listener);
+            const int reuse = 1;
+            if (m_listener == InvalidSocket ||
+                setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse),
+                           sizeof(reuse)) != 0 ||
+                bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+                listen(listener, 1) != 0)
+            {
+                if (m_listener != InvalidSocket) closeSocket(m_listener);
+                throw std::runtime_error("Cannot listen on port " + port);
+            }
+        }
+        m_thread = std::thread{&GdbServer::run, this};
+    }
+
+    GdbServer::~GdbServer()
+    {
+        m_stopping = true;
+        m_thread.join();
+        closeSocket(m_listener);
+#ifndef _WIN32
+        if (!m_unixPath.empty()) unlink(m_unixPath.c_str());
+#else
+        WSACleanup();
+#endif
+    }
+
+    void GdbServer::run()
+    {
+        while (!m_stopping)
+        {
+            if (!waitReadable(m_listener, 100)) continue;
+            const auto client = static_cast<std::uintptr_t>(accept(static_cast<Socket>(m_listener), nullptr, nullptr));
+            if (client == InvalidSocket) continue;
+            if (m_unixPath.empty())
+            {
+                const int noDelay = 1;
+                setsockopt(static_cast<Socket>(client), IPPROTO_TCP, TCP_NODELAY,
+                           reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+            }
+            {
+                std::scoped_lock lock{m_mutex, m_sendMutex};
+                m_client = client;
+                m_connected = true;
+                m_newConnection = true;
+                m_requests.clear();
+                m_attention.store(true, std::memory_order_release);
+                wake();
+            }
+            m_packetState = 0;
+
+            char buffer[1024];
+            while (!m_stopping)
+            {
+                if (!waitReadable(client, 100)) continue;
+                const auto received = recv(static_cast<Socket>(client), buffer, sizeof(buffer), 0);
+                if (received <= 0) break;
+                receive(buffer, static_cast<std::size_t>(received));
+            }
+
+            {
+                std::scoped_lock lock{m_mutex, m_sendMutex};
+                m_connected = false;
+                m_client = InvalidSocket;
+                wake();
+            }
+            closeSocket(client);
+        }
+    }
+
+    void GdbServer::receive(const char* data, const std::size_t size)
+    {
+        // States: 0 outside a packet, 1 payload, 2 and 3 checksum digits
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const auto c = data[i];
+            switch (m_packetState)
+            {
+                case 0:
+                    if (c == '$')
+                    {
+                        m_packet.clear();
+                        m_packetState = 1;
+                    }
+                    else if (c == '\x03')
+                    {
+                        std::scoped_lock lock{m_mutex};
+                        m_interruptRequested = true;
+                        wake();
+                    }
+                    break;
+                case 1:
+                    if (c == '#')
+                        m_packetState = 2;
+                    else if (m_packet.size() < MaxPacketSize)
+                        m_packet += c;
+                    break;
+                case 2:
+                    m_packetState = 3;
+                    m_packet += c;
+                    break;
+                default:
+                {
+                    m_packetState = 0;
+                    m_packet += c;
+                    const auto checksum =
+                        static_cast<uint8_t>(hexValue(m_packet[m_packet.size() - 2]) * 16 + hexValue(m_packet.back()));
+                    m_packet.resize(m_packet.size() - 2);
+                    uint8_t sum = 0;
+                    for (const auto p : m_packet) sum = static_cast<uint8_t>(sum + p);
+                    if (sum != checksum)
+                    {
+                        sendRaw("-");
+                        break;
+                    }
+                    sendRaw("+");
+                    {
+                        std::scoped_lock lock{m_mutex};
+                        m_requests.push_back(std::move(m_packet));
+                        wake();
+                    }
+                    m_packet = {};
+                    break;
+                }
+            }
+        }
+    }
+
+    void GdbServer::send(const std::string& payload)
+    {
+        uint8_t sum = 0;
+        for (const auto c : payload) sum = static_cast<uint8_t>(sum + c);
+        std::string packet;
+        packet.reserve(payload.size() + 4);
+        packet += '$';
+        packet += payload;
+        packet += '#';
+        appendByte(packet, sum);
+        sendRaw(packet);
+    }
+
+    void GdbServer::sendRaw(const std::string& data)
+    {
+        std::scoped_lock lock{m_sendMutex};
+        if (m_client == InvalidSocket) return;
+        ::send(static_cast<Socket>(m_client), data.data(), static_cast<int>(data.size()), SendFlags);
+    }
+
+    void GdbServer::disconnect()
+    {
+        std::scoped_lock lock{m_sendMutex};
+        if (m_client != InvalidSocket) shutdown(static_cast<Socket>(m_client), ShutdownBoth);
+    }
+
+    void GdbServer::setWake(std::function<void()> wake)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_wake = std::move(wake);
+    }
+
+    void GdbServer::serviceAttached()
+    {
+        std::unique_lock lock{m_mutex};
+        if (!m_connected || m_stopping)
+        {
+            m_attention.store(false, std::memory_order_relaxed);
+            lock.unlock();
+            m_stub.detach();
+            return;
+        }
+        if (m_newConnection)
+        {
+            m_newConnection = false;
+            m_interruptRequested = false;
+            m_stub.attach();
+        }
+        if (m_interruptRequested)
+        {
+            m_interruptRequested = false;
+            if (!m_stub.halted())
+            {
+                m_stub.halt();
+                send(m_stub.stopReply());
+            }
+        }
+        else if (m_stub.stopped())
+        {
+            send(m_stub.stopReply());
+        }
+        // Requests arriving meanwhile call wake() and are served by the next call
+        while (!m_requests.empty() && !m_stub.closing())
+        {
+            const auto packet = std::move(m_requests.front());
+            m_requests.pop_front();
+            lock.unlock();
+            if (const auto reply = m_stub.handle(packet)) send(*reply);
+            lock.lock();
+        }
+        if (m_stub.closing())
+        {
+            m_requests.clear();
+            lock.unlock();
+            disconnect();
+        }
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,105 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_GDBSERVER_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_GDBSERVER_HPP_
+
+#include "GdbStub.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace epoch::zxspectrum
+{
+    class ZXSpectrumEmulator;
+
+    // GDB remote serial protocol server ("target remote localhost:1234" from a Z80 aware gdb).
+    // Packets are received by a dedicated thread; the emulation thread runs them through GdbStub in service(), which
+    // never blocks: while the debugger holds the machine stopped it stays paused, and the wake callback tells the
+    // emulation thread that new requests are waiting. Without a debugger attached service() is a single atomic load.
+    class GdbServer final
+    {
+    public:
+        // endpoint is "port" or "localhost:port" for TCP on the loopback interface, "unix:path" for a Unix domain
+        // socket. Throws std::runtime_error if the socket cannot be opened.
+        GdbServer(ZXSpectrumEmulator& emulator, const std::string& endpoint);
+        ~GdbServer();
+
+    public:
+        GdbServer(const GdbServer& other) = delete;
+        GdbServer(GdbServer&& other) noexcept = delete;
+        GdbServer& operator=(const GdbServer& other) = delete;
+        GdbServer& operator=(GdbServer&& other) noexcept = delete;
+
+    public:
+        // To be called by the emulation thread between frames
+        void service()
+        {
+            if (m_attention.load(std::memory_order_acquire)) [[unlikely]]
+                serviceAttached();
+        }
+        [[nodiscard]] bool attached() const { return m_attention.load(std::memory_order_relaxed); }
+        // Called by the server thread when requests arrive or the connection changes, may be empty
+        void setWake(std::function<void()> wake);
+
+    private:
+        std::string m_unixPath{};
+        std::uintptr_t m_listener;
+        std::uintptr_t m_client;
+        std::thread m_thread{};
+
+        // Shared between the server and the emulation threads
+        std::atomic<bool> m_attention{};
+        std::atomic<bool> m_stopping{};
+        std::mutex m_mutex{};
+        std::function<void()> m_wake{};
+        std::deque<std::string> m_requests{};
+        bool m_connected{};
+        bool m_newConnection{};
+        bool m_interruptRequested{};
+        std::mutex m_sendMutex{};
+
+        // Emulation thread only
+        GdbStub m_stub;
+
+        // Server thread only
+        std::string m_packet{};
+        int m_packetState{};
+
+        void run();
+        // Under m_mutex
+        void wake() const
+        {
+            if (m_wake) m_wake();
+        }
+        void receive(const char* data, std::size_t size);
+        void send(const std::string& payload);
+        void sendRaw(const std::string& data);
+
+        // Ends the connection from the emulation thread, the server thread then sees it closed
+        void disconnect();
+
+        void serviceAttached();
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
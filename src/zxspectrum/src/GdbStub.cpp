@@ -0,0 +1,376 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "GdbStub.hpp"
+
+#include "Ula.hpp"
+#include "Z80Breakpoints.hpp"
+#include "Z80Cpu.hpp"
+#include "ZXSpectrumEmulator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        constexpr char HexDigits[] = "0123456789abcdef";
+
+        int hexValue(const char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Parses the hex digits up to the first non hex character, advancing position. False without any digit.
+        bool parseHex(const std::string& text, std::size_t& position, uint32_t& value)
+        {
+            const auto start = position;
+            value = 0;
+            while (position < text.size() && hexValue(text[position]) >= 0)
+            {
+                value = (value << 4) | static_cast<uint32_t>(hexValue(text[position++]));
+            }
+            return position > start;
+        }
+
+        // Parses "number<separator>" (or "number" at the end of text when separator is 0), advancing position
+        bool parseField(const std::string& text, std::size_t& position, uint32_t& value, const char separator)
+        {
+            if (!parseHex(text, position, value)) return false;
+            if (separator == 0) return position == text.size();
+            return position < text.size() && text[position++] == separator;
+        }
+
+        // Pairs of hex digits from position to the end of text
+        bool parseBytes(const std::string& text, const std::size_t position, std::vector<uint8_t>& bytes)
+        {
+            if ((text.size() - position) % 2 != 0) return false;
+            bytes.clear();
+            for (auto i = position; i < text.size(); i += 2)
+            {
+                const auto high = hexValue(text[i]);
+                const auto low = hexValue(text[i + 1]);
+                if (high < 0 || low < 0) return false;
+                bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+            }
+            return true;
+        }
+
+        void appendByte(std::string& out, const uint8_t value)
+        {
+            out += HexDigits[value >> 4];
+            out += HexDigits[value & 0xf];
+        }
+
+        constexpr std::size_t RegistersCount = 13;
+        constexpr std::size_t ProgramCounter = 5;
+        constexpr std::size_t MaxMemoryRead = 0x800;  // bytes in a reply within the advertised PacketSize
+    }  // namespace
+
+    GdbStub::GdbStub(ZXSpectrumEmulator& emulator) : m_emulator{emulator} {}
+
+    std::optional<std::string> GdbStub::handle(const std::string& packet)
+    {
+        if (packet.empty()) return std::string{};
+        std::size_t position = 1;
+        uint32_t value;
+        switch (packet[0])
+        {
+            case '?':
+                return stopReply();
+            case 'g':
+                return readRegisters();
+            case 'G':
+            {
+                std::vector<uint8_t> bytes;
+                if (!parseBytes(packet, position, bytes) || bytes.size() % 2 != 0 ||
+                    bytes.size() > RegistersCount * 2)
+                    return "E00";
+                for (std::size_t i = 0; i < bytes.size(); i += 2)
+                {
+                    writeRegister(i / 2, static_cast<uint16_t>(bytes[i + 1] << 8 | bytes[i]));
+                }
+                return "OK";
+            }
+            case 'p':
+                if (!parseField(packet, position, value, 0) || value >= RegistersCount) return "E00";
+                return readRegisters().substr(value * 4, 4);
+            case 'P':
+            {
+                uint32_t index;
+                std::vector<uint8_t> bytes;
+                if (!parseField(packet, position, index, '=') || index >= RegistersCount ||
+                    !parseBytes(packet, position, bytes) || bytes.empty() || bytes.size() > 2)
+                    return "E00";
+                // Little endian, as in the 'g' packet
+                writeRegister(index, static_cast<uint16_t>(bytes.size() == 2 ? bytes[1] << 8 | bytes[0] : bytes[0]));
+                return "OK";
+            }
+            case 'm':
+            {
+                uint32_t address;
+                if (!parseField(packet, position, address, ',') || !parseField(packet, position, value, 0))
+                    return "E00";
+                return readMemory(static_cast<uint16_t>(address), std::min<std::size_t>(value, MaxMemoryRead));
+            }
+            case 'M':
+            {
+                uint32_t address;
+                std::vector<uint8_t> bytes;
+                if (!parseField(packet, position, address, ',') || !parseField(packet, position, value, ':') ||
+                    !parseBytes(packet, position, bytes) || bytes.size() != value)
+                    return "E00";
+                return writeMemory(static_cast<uint16_t>(address), bytes) ? "OK" : "E01";
+            }
+            case 'c':
+                if (position < packet.size())
+                {
+                    if (!parseField(packet, position, value, 0)) return "E00";
+                    writeRegister(ProgramCounter, static_cast<uint16_t>(value));
+                }
+                m_halted = false;
+                m_emulator.resume();
+                return std::nullopt;
+            case 's':
+                if (position < packet.size())
+                {
+                    if (!parseField(packet, position, value, 0)) return "E00";
+                    writeRegister(ProgramCounter, static_cast<uint16_t>(value));
+                }
+                m_emulator.step();
+                return "S05";
+            case 'Z':
+            case 'z':
+            {
+                // [Zz]type,address,kind
+                uint32_t address;
+                if (packet.size() < 4 || packet[2] != ',') return "E00";
+                position = 3;
+                if (!parseField(packet, position, address, ',') || !parseField(packet, position, value, 0))
+                    return "E00";
+                const auto type = packet[1];
+                const auto done = packet[0] == 'Z' ? setBreakpoint(type, static_cast<uint16_t>(address))
+                                                   : removeBreakpoint(type, static_cast<uint16_t>(address));
+                return done ? "OK" : "";
+            }
+            case 'H':
+            case 'T':
+                return "OK";
+            case 'D':
+                detach();
+                return "OK";
+            case 'k':
+                detach();
+                m_closing = true;
+                return std::nullopt;
+            case 'q':
+                if (packet.starts_with("qSupported")) return "PacketSize=1000";
+                if (packet == "qAttached") return "1";
+                if (packet == "qC") return "QC1";
+                if (packet == "qfThreadInfo") return "m1";
+                if (packet == "qsThreadInfo") return "l";
+                return std::string{};
+            default:
+                return std::string{};
+        }
+    }
+
+    void GdbStub::attach()
+    {
+        m_closing = false;
+        halt();
+    }
+
+    void GdbStub::detach()
+    {
+        for (const auto& [key, ids] : m_breakpoints)
+        {
+            for (const auto id : ids) m_emulator.breakpoints()->remove(id);
+        }
+        m_breakpoints.clear();
+        if (m_halted)
+        {
+            m_halted = false;
+            m_emulator.resume();
+        }
+    }
+
+    void GdbStub::halt()
+    {
+        m_halted = true;
+        if (m_emulator.paused()) return;
+        m_emulator.breakpoints()->requestBreak();
+        while (!m_emulator.paused()) m_emulator.clock();
+    }
+
+    bool GdbStub::stopped()
+    {
+        if (m_halted || !m_emulator.paused()) return false;
+        m_halted = true;
+        return true;
+    }
+
+    std::string GdbStub::stopReply() const
+    {
+        const auto& hit = m_emulator.breakpoints()->lastHit();
+        if (hit.reason == Z80Breakpoints::Reason::request) return "S02";
+        if (hit.reason == Z80Breakpoints::Reason::breakpoint)
+        {
+            for (const auto& [key, ids] : m_breakpoints)
+            {
+                if (key.first < '2' || std::find(ids.begin(), ids.end(), hit.id) == ids.end()) continue;
+                static constexpr const char* WatchKinds[] = {"watch", "rwatch", "awatch"};
+                char reply[32];
+                std::snprintf(reply, sizeof(reply), "T05%s:%04x;", WatchKinds[key.first - '2'], hit.address);
+                return reply;
+            }
+        }
+        return "S05";
+    }
+
+    std::string GdbStub::readRegisters() const
+    {
+        const auto& r = m_emulator.cpu()->registers();
+        const uint16_t values[RegistersCount] = {r.af, r.bc, r.de, r.hl, r.sp, r.pc, r.ix, r.iy, r.af2, r.bc2, r.de2,
+                                                 r.hl2, r.ir};
+        std::string result;
+        for (const auto value : values)
+        {
+            appendByte(result, value & 0xff);
+            appendByte(result, value >> 8);
+        }
+        return result;
+    }
+
+    void GdbStub::writeRegister(const std::size_t index, const uint16_t value)
+    {
+        auto& r = m_emulator.cpu()->registers();
+        switch (index)
+        {
+            case 0:
+                r.af = value;
+                break;
+            case 1:
+                r.bc = value;
+                break;
+            case 2:
+                r.de = value;
+                break;
+            case 3:
+                r.hl = value;
+                break;
+            case 4:
+                r.sp = value;
+                break;
+            case 5:
+                r.pc = value;
+                break;
+            case 6:
+                r.ix = value;
+                break;
+            case 7:
+                r.iy = value;
+                break;
+            case 8:
+                r.af2 = value;
+                break;
+            case 9:
+                r.bc2 = value;
+                break;
+            case 10:
+                r.de2 = value;
+                break;
+            case 11:
+                r.hl2 = value;
+                break;
+            case 12:
+                r.ir = value;
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::string GdbStub::readMemory(const uint16_t address, const std::size_t length) const
+    {
+        // peek() does not disturb the floating bus like a CPU read would
+        auto& ula = *m_emulator.ula();
+        std::string result;
+        result.reserve(length * 2);
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            appendByte(result, ula.peek(static_cast<uint16_t>(address + i)));
+        }
+        return result;
+    }
+
+    bool GdbStub::writeMemory(const uint16_t address, const std::vector<uint8_t>& data)
+    {
+        // ROM is not writable: the whole write fails without changing anything
+        auto& ula = *m_emulator.ula();
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            if (ula.writePage(static_cast<uint16_t>(address + i) >> 14) == nullptr) return false;
+        }
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            const auto target = static_cast<uint16_t>(address + i);
+            ula.writePage(target >> 14)[target & 0x3fff] = data[i];
+        }
+        return true;
+    }
+
+    bool GdbStub::setBreakpoint(const char type, const uint16_t address)
+    {
+        auto& breakpoints = *m_emulator.breakpoints();
+        auto& ids = m_breakpoints[{type, address}];
+        switch (type)
+        {
+            case '0':  // software
+            case '1':  // hardware
+                ids.push_back(breakpoints.add(Z80BreakpointType::execution, address));
+                return true;
+            case '2':  // write watchpoint
+                ids.push_back(breakpoints.add(Z80BreakpointType::write, address));
+                return true;
+            case '3':  // read watchpoint
+                ids.push_back(breakpoints.add(Z80BreakpointType::read, address));
+                return true;
+            case '4':  // access watchpoint
+                ids.push_back(breakpoints.add(Z80BreakpointType::read, address));
+                ids.push_back(breakpoints.add(Z80BreakpointType::write, address));
+                return true;
+            default:
+                m_breakpoints.erase({type, address});
+                return false;
+        }
+    }
+
+    bool GdbStub::removeBreakpoint(const char type, const uint16_t address)
+    {
+        const auto it = m_breakpoints.find({type, address});
+        if (it == m_breakpoints.end()) return type >= '0' && type <= '4';
+        for (const auto id : it->second) m_emulator.breakpoints()->remove(id);
+        m_breakpoints.erase(it);
+        return true;
+    }
+
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,79 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_GDBSTUB_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_GDBSTUB_HPP_
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    class ZXSpectrumEmulator;
+
+    // GDB remote serial protocol commands, without any transport: GdbServer feeds it the packets received on its
+    // socket (payload only, framing and checksum already removed) from the emulation thread.
+    // Registers are exposed in gdb's z80 order: AF BC DE HL SP PC IX IY AF' BC' DE' HL' IR, 16 bit little endian.
+    class GdbStub final
+    {
+    public:
+        explicit GdbStub(ZXSpectrumEmulator& emulator);
+
+    public:
+        GdbStub(const GdbStub& other) = delete;
+        GdbStub(GdbStub&& other) noexcept = delete;
+        GdbStub& operator=(const GdbStub& other) = delete;
+        GdbStub& operator=(GdbStub&& other) noexcept = delete;
+
+    public:
+        // Returns the reply payload, nothing when the packet has none: 'c' is answered by a stop reply once the
+        // machine stops again (see stopped()), 'k' asks to close the connection (see closing())
+        [[nodiscard]] std::optional<std::string> handle(const std::string& packet);
+
+        // A new debugger connected: gdb expects the target to be stopped
+        void attach();
+        // Removes the debugger breakpoints and resumes the machine if the debugger had stopped it
+        void detach();
+        // Stops the machine at the next instruction boundary, so that registers and memory are consistent
+        void halt();
+        // True once each time the machine stops by itself (breakpoint, watchpoint) while the debugger let it run
+        [[nodiscard]] bool stopped();
+        [[nodiscard]] bool halted() const { return m_halted; }
+        [[nodiscard]] std::string stopReply() const;
+        // Set by 'k' until the next attach(): the connection must be closed
+        [[nodiscard]] bool closing() const { return m_closing; }
+
+    private:
+        ZXSpectrumEmulator& m_emulator;
+        bool m_halted{};
+        bool m_closing{};
+        std::map<std::pair<char, uint16_t>, std::vector<int>> m_breakpoints{};  // gdb (type, address) to engine ids
+
+        [[nodiscard]] std::string readRegisters() const;
+        void writeRegister(std::size_t index, uint16_t value);
+        [[nodiscard]] std::string readMemory(uint16_t address, std::size_t length) const;
+        bool writeMemory(uint16_t address, const std::vector<uint8_t>& data);
+        bool setBreakpoint(char type, uint16_t address);
+        bool removeBreakpoint(char type, uint16_t address);
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
@@ -0,0 +1,331 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "GuestProfiler.hpp"
+
+#include "Ula.hpp"
+#include "Z80Cpu.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        constexpr std::size_t BanksCount = 12;  // 8 RAM + 4 ROM
+        constexpr std::size_t BankSize = 0x4000;
+
+        std::size_t bankSlot(const uint8_t bank) { return bank & Ula::RomBank ? 8 + (bank & 0x03) : bank; }
+        uint8_t slotBank(const std::size_t slot)
+        {
+            return static_cast<uint8_t>(slot >= 8 ? Ula::RomBank + (slot - 8) : slot);
+        }
+        uint16_t bankBase(const uint8_t bank)
+        {
+            if (bank & Ula::RomBank) return 0x0000;
+            if (bank == 5) return 0x4000;
+            if (bank == 2) return 0x8000;
+            return 0xc000;
+        }
+
+        bool parseNumber(std::string_view text, const bool hexDefault, uint32_t& value)
+        {
+            int base = hexDefault ? 16 : 10;
+            if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+            {
+                text.remove_prefix(2);
+                base = 16;
+            }
+            else if (!text.empty() && (text[0] == '$' || text[0] == '#' || text[0] == '&'))
+            {
+                text.remove_prefix(1);
+                base = 16;
+            }
+            else if (!text.empty() && (text.back() == 'h' || text.back() == 'H'))
+            {
+                text.remove_suffix(1);
+                base = 16;
+            }
+            if (text.empty()) return false;
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+            return error == std::errc{} && end == text.data() + text.size();
+        }
+
+        bool isIdentifier(const std::string_view text)
+        {
+            return !text.empty() && (std::isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_' ||
+                                     text[0] == '.' || text[0] == '@');
+        }
+    }  // namespace
+
+    GuestSymbols parseSymbols(std::istream& is)
+    {
+        GuestSymbols symbols;
+        std::string line;
+        while (std::getline(is, line))
+        {
+            if (const auto comment = line.find(';'); comment != std::string::npos) line.resize(comment);
+            std::replace(line.begin(), line.end(), ':', ' ');
+            std::istringstream tokenizer{line};
+            std::vector<std::string> tokens;
+            for (std::string token; tokenizer >> token;)
+            {
+                if (token.size() > 1 && token.front() == '=')
+                {
+                    tokens.emplace_back("=");
+                    token.erase(0, 1);
+                }
+                tokens.push_back(std::move(token));
+            }
+
+            std::string lower = tokens.size() >= 3 ? tokens[1] : std::string{};
+            std::transform(lower.begin(), lower.end(), lower.begin(),
+                           [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            uint32_t value{};
+            if (tokens.size() >= 3 && (lower == "equ" || lower == "=") && isIdentifier(tokens[0]) &&
+                parseNumber(tokens[2], false, value))
+            {
+                // label EQU value / label = value
+                symbols.emplace(static_cast<uint16_t>(value), tokens[0]);
+            }
+            else if (tokens.size() == 2 && isIdentifier(tokens[1]) && parseNumber(tokens[0], true, value))
+            {
+                // address label
+                symbols.emplace(static_cast<uint16_t>(value), tokens[1]);
+            }
+            else if (tokens.size() == 2 && isIdentifier(tokens[0]) && parseNumber(tokens[1], true, value))
+            {
+                // label address
+                symbols.emplace(static_cast<uint16_t>(value), tokens[0]);
+            }
+        }
+        return symbols;
+    }
+
+    GuestSymbols loadSymbols(const std::filesystem::path& path)
+    {
+        std::ifstream is{path};
+        if (!is) throw std::runtime_error("Cannot open symbols file");
+        return parseSymbols(is);
+    }
+
+    GuestProfiler::GuestProfiler(const uint32_t samplePeriod)
+        : m_samplePeriod{std::max<uint32_t>(samplePeriod, 1)}, m_countdown{m_samplePeriod},
+          m_locations(BanksCount * BankSize)
+    {
+    }
+
+    void GuestProfiler::frame()
+    {
+        m_frameLoad[m_frames % FrameHistory] =
+            m_frameSamples ? 1.f - static_cast<float>(m_frameIdleSamples) / static_cast<float>(m_frameSamples) : 0.f;
+        m_frames++;
+        m_frameSamples = m_frameIdleSamples = 0;
+    }
+
+    void GuestProfiler::setSamplePeriod(const uint32_t samplePeriod)
+    {
+        m_samplePeriod = std::max<uint32_t>(samplePeriod, 1);
+        reset();
+    }
+
+    void GuestProfiler::reset()
+    {
+        m_countdown = m_samplePeriod;
+        m_callTargets.clear();
+        m_routines.clear();
+        std::fill(m_locations.begin(), m_locations.end(), 0);
+        m_frames = m_samples = m_idleSamples = 0;
+        m_frameSamples = m_frameIdleSamples = 0;
+        m_frameLoad = {};
+    }
+
+    void GuestProfiler::sample(const Z80Cpu& cpu, Ula& ula)
+    {
+        const auto pc = cpu.instructionPc();
+        m_locations[bankSlot(ula.pageBank(pc >> 14)) * BankSize + (pc & (BankSize - 1))]++;
+        m_samples++;
+        m_frameSamples++;
+        if (ula.peek(pc) == 0x76)
+        {
+            // HALT
+            m_idleSamples++;
+            m_frameIdleSamples++;
+        }
+
+        // Words on the stack right after a CALL/RST are (most likely) return addresses: their callee is running
+        std::array<uint16_t, MaxStackDepth + 1> active{};
+        std::size_t activeCount = 0;
+        auto sp = cpu.registers().sp;
+        for (std::size_t i = 0; i < MaxStackDepth && sp < 0xffff; ++i, sp += 2)
+        {
+            const auto ret = static_cast<uint16_t>(ula.peek(sp) | ula.peek(static_cast<uint16_t>(sp + 1)) << 8);
+            const auto call = ula.peek(static_cast<uint16_t>(ret - 3));
+            const auto rst = ula.peek(static_cast<uint16_t>(ret - 1));
+            uint16_t target;
+            if (call == 0xcd || (call & 0xc7) == 0xc4)
+            {
+                // CALL nn / CALL cc,nn
+                target = static_cast<uint16_t>(ula.peek(static_cast<uint16_t>(ret - 2)) | rst << 8);
+            }
+            else if ((rst & 0xc7) == 0xc7 && rst != 0xff)
+            {
+                // RST n, except RST 38h: 0xff is the most common filler byte and IM 1 interrupts do not use it
+                target = rst & 0x38;
+            }
+            else
+            {
+                continue;
+            }
+            m_callTargets.insert(target);
+            if (std::find(active.begin(), active.begin() + activeCount, target) == active.begin() + activeCount)
+            {
+                active[activeCount++] = target;
+            }
+        }
+
+        const auto self = routineAt(pc);
+        m_routines[self].self++;
+        if (std::find(active.begin(), active.begin() + activeCount, self) == active.begin() + activeCount)
+        {
+            active[activeCount++] = self;
+        }
+        for (std::size_t i = 0; i < activeCount; ++i)
+        {
+            m_routines[active[i]].inclusive++;
+        }
+    }
+
+    uint16_t GuestProfiler::routineAt(const uint16_t address) const
+    {
+        uint16_t result = 0;
+        if (const auto it = m_symbols.upper_bound(address); it != m_symbols.begin())
+        {
+            result = std::prev(it)->first;
+        }
+        if (const auto it = m_callTargets.upper_bound(address); it != m_callTargets.begin())
+        {
+            result = std::max(result, *std::prev(it));
+        }
+        return result;
+    }
+
+    std::string GuestProfiler::routineName(const uint16_t address) const
+    {
+        if (const auto it = m_symbols.find(address); it != m_symbols.end()) return it->second;
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "sub_%04X", address);
+        return buffer;
+    }
+
+    std::vector<float> GuestProfiler::frameLoad() const
+    {
+        const auto count = std::min<uint64_t>(m_frames, FrameHistory);
+        std::vector<float> result;
+        result.reserve(count);
+        for (auto i = m_frames - count; i < m_frames; ++i)
+        {
+            result.push_back(m_frameLoad[i % FrameHistory]);
+        }
+        return result;
+    }
+
+    std::vector<GuestProfiler::Routine> GuestProfiler::routines() const
+    {
+        std::vector<Routine> result;
+        result.reserve(m_routines.size());
+        for (const auto& [address, counters] : m_routines)
+        {
+            result.push_back({address, routineName(address), counters.self, counters.inclusive});
+        }
+        std::ranges::sort(result,
+                          [](const Routine& a, const Routine& b)
+                          {
+                              if (a.selfSamples != b.selfSamples) return a.selfSamples > b.selfSamples;
+                              if (a.inclusiveSamples != b.inclusiveSamples)
+                                  return a.inclusiveSamples > b.inclusiveSamples;
+                              return a.address < b.address;
+                          });
+        return result;
+    }
+
+    std::vector<GuestProfiler::Location> GuestProfiler::hotLocations(const std::size_t count) const
+    {
+        std::vector<Location> result;
+        for (std::size_t i = 0; i < m_locations.size(); ++i)
+        {
+            if (m_locations[i] == 0) continue;
+            const auto bank = slotBank(i / BankSize);
+            result.push_back({bank, static_cast<uint16_t>(bankBase(bank) + i % BankSize), m_locations[i]});
+        }
+        const auto size = std::min(count, result.size());
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(size), result.end(),
+                          [](const Location& a, const Location& b) { return a.samples > b.samples; });
+        result.resize(size);
+        return result;
+    }
+
+    void GuestProfiler::writeReport(std::ostream& os, const std::size_t maxRoutines) const
+    {
+        char line[160];
+        const auto frames = static_cast<double>(std::max<uint64_t>(m_frames, 1));
+        const auto samples = static_cast<double>(std::max<uint64_t>(m_samples, 1));
+        const auto tStatesPerFrame = static_cast<double>(m_samples) * m_samplePeriod / frames;
+        const auto idlePerFrame = static_cast<double>(m_idleSamples) * m_samplePeriod / frames;
+
+        std::snprintf(line, sizeof(line), "Guest profile: %llu frames, %llu samples every %u T-states\n",
+                      static_cast<unsigned long long>(m_frames), static_cast<unsigned long long>(m_samples),
+                      m_samplePeriod);
+        os << line;
+        std::snprintf(line, sizeof(line), "Frame budget: %.0f T-states, busy %.0f (%.1f%%), halted %.0f (%.1f%%)\n\n",
+                      tStatesPerFrame, tStatesPerFrame - idlePerFrame,
+                      100.0 * (1.0 - static_cast<double>(m_idleSamples) / samples), idlePerFrame,
+                      100.0 * static_cast<double>(m_idleSamples) / samples);
+        os << line;
+
+        os << "  Self T/frame   Self%   Incl T/frame   Incl%  Address  Routine\n";
+        const auto routinesList = routines();
+        for (std::size_t i = 0; i < std::min(maxRoutines, routinesList.size()); ++i)
+        {
+            const auto& routine = routinesList[i];
+            std::snprintf(line, sizeof(line), "%14.1f  %5.1f%%  %13.1f  %5.1f%%  %04X     %s\n",
+                          static_cast<double>(routine.selfSamples) * m_samplePeriod / frames,
+                          100.0 * static_cast<double>(routine.selfSamples) / samples,
+                          static_cast<double>(routine.inclusiveSamples) * m_samplePeriod / frames,
+                          100.0 * static_cast<double>(routine.inclusiveSamples) / samples, routine.address,
+                          routine.name.c_str());
+            os << line;
+        }
+
+        os << "\n       Samples   Share  Location\n";
+        for (const auto& location : hotLocations(20))
+        {
+            const auto rom = (location.bank & Ula::RomBank) != 0;
+            std::snprintf(line, sizeof(line), "%14llu  %5.1f%%  %s%d:%04X  %s\n",
+                          static_cast<unsigned long long>(location.samples),
+                          100.0 * static_cast<double>(location.samples) / samples, rom ? "ROM" : "RAM",
+                          location.bank & 0x07, location.address, routineName(routineAt(location.address)).c_str());
+            os << line;
+        }
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,133 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_GUESTPROFILER_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_GUESTPROFILER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    class Ula;
+    class Z80Cpu;
+
+    // Address -> name, as exported by pasmo (--public), sjasmplus (--sym) and most map files
+    using GuestSymbols = std::map<uint16_t, std::string>;
+    GuestSymbols parseSymbols(std::istream& is);
+    GuestSymbols loadSymbols(const std::filesystem::path& path);
+
+    // Statistical profiler of the emulated program: samples the Z80 PC and memory bank every samplePeriod T-states.
+    // Routines are the known symbols plus the targets of the CALL/RST found walking the guest stack, which also gives
+    // an approximated inclusive (self + callees) time.
+    class GuestProfiler final
+    {
+    public:
+        struct Routine
+        {
+            uint16_t address;
+            std::string name;
+            uint64_t selfSamples;
+            uint64_t inclusiveSamples;
+        };
+        struct Location
+        {
+            uint8_t bank;  // see Ula::pageBank
+            uint16_t address;
+            uint64_t samples;
+        };
+
+        static constexpr std::size_t MaxStackDepth = 16;
+        static constexpr std::size_t FrameHistory = 256;
+
+    public:
+        explicit GuestProfiler(uint32_t samplePeriod = 64);
+
+    public:
+        GuestProfiler(const GuestProfiler& other) = delete;
+        GuestProfiler(GuestProfiler&& other) noexcept = delete;
+        GuestProfiler& operator=(const GuestProfiler& other) = delete;
+        GuestProfiler& operator=(GuestProfiler&& other) noexcept = delete;
+
+    public:
+        // Called once per emulated T-state, after the CPU
+        void clock(const Z80Cpu& cpu, Ula& ula)
+        {
+            if (--m_countdown == 0) [[unlikely]]
+            {
+                m_countdown = m_samplePeriod;
+                sample(cpu, ula);
+            }
+        }
+        void frame();
+        // Also resets the collected data
+        void setSamplePeriod(uint32_t samplePeriod);
+        void reset();
+
+        void setSymbols(GuestSymbols symbols) { m_symbols = std::move(symbols); }
+        [[nodiscard]] const GuestSymbols& symbols() const { return m_symbols; }
+
+        [[nodiscard]] uint32_t samplePeriod() const { return m_samplePeriod; }
+        [[nodiscard]] uint64_t frames() const { return m_frames; }
+        [[nodiscard]] uint64_t samples() const { return m_samples; }
+        // Samples taken while the CPU was halted
+        [[nodiscard]] uint64_t idleSamples() const { return m_idleSamples; }
+        // Busy fraction (0-1) of the last FrameHistory frames, oldest first
+        [[nodiscard]] std::vector<float> frameLoad() const;
+
+        // Sorted by self time, hottest first
+        [[nodiscard]] std::vector<Routine> routines() const;
+        [[nodiscard]] std::vector<Location> hotLocations(std::size_t count) const;
+        [[nodiscard]] std::string routineName(uint16_t address) const;
+
+        void writeReport(std::ostream& os, std::size_t maxRoutines = 40) const;
+
+    private:
+        struct Counters
+        {
+            uint64_t self;
+            uint64_t inclusive;
+        };
+
+        uint32_t m_samplePeriod;
+        uint32_t m_countdown;
+
+        GuestSymbols m_symbols{};
+        std::set<uint16_t> m_callTargets{};
+        std::unordered_map<uint16_t, Counters> m_routines{};
+        std::vector<uint32_t> m_locations;  // samples per (bank, offset)
+
+        uint64_t m_frames{};
+        uint64_t m_samples{};
+        uint64_t m_idleSamples{};
+        uint32_t m_frameSamples{};
+        uint32_t m_frameIdleSamples{};
+        std::array<float, FrameHistory> m_frameLoad{};
+
+        void sample(const Z80Cpu& cpu, Ula& ula);
+        [[nodiscard]] uint16_t routineAt(uint16_t address) const;
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
@@ -0,0 +1,96 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "IoBus.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace epoch::zxspectrum
+{
+    IoBus::IoBus() { build(); }
+
+    void IoBus::attach(IoDevice* device, const IoDecode read, const IoDecode write)
+    {
+        m_reads.push_back({device, read});
+        m_writes.push_back({device, write});
+        build();
+    }
+
+    void IoBus::attachRead(IoDevice* device, const IoDecode read)
+    {
+        m_reads.push_back({device, read});
+        build();
+    }
+
+    void IoBus::attachWrite(IoDevice* device, const IoDecode write)
+    {
+        m_writes.push_back({device, write});
+        build();
+    }
+
+    void IoBus::build()
+    {
+        if (m_writes.size() > 64) throw std::runtime_error("Too many I/O devices");
+
+        m_readers.fill(nullptr);
+        m_readers[0] = &m_openBus;
+        std::size_t readers = 1;
+        for (auto port = 0; port < 0x10000; port++)
+        {
+            const auto mapping = std::find_if(m_reads.begin(), m_reads.end(), [port](const Mapping& m) {
+                return m.decode.matches(static_cast<uint16_t>(port));
+            });
+            const auto device = mapping != m_reads.end() ? mapping->device : &m_openBus;
+            auto reader = std::find(m_readers.begin(), m_readers.begin() + readers, device);
+            if (reader == m_readers.begin() + readers)
+            {
+                if (readers == m_readers.size()) throw std::runtime_error("Too many I/O devices");
+                m_readers[readers++] = device;
+            }
+            m_readTable[port] = static_cast<uint8_t>(reader - m_readers.begin());
+        }
+
+        // Ports decoded by the same set of devices (bit n set when m_writes[n] matches) share a chain, chain 0 is
+        // the empty one
+        std::unordered_map<uint64_t, uint8_t> chains{{0, 0}};
+        std::size_t count = 1;
+        m_writeChains.fill({});
+        m_writeDevices.clear();
+        for (auto port = 0; port < 0x10000; port++)
+        {
+            uint64_t set = 0;
+            for (std::size_t i = 0; i < m_writes.size(); i++)
+            {
+                if (m_writes[i].decode.matches(static_cast<uint16_t>(port))) set |= uint64_t{1} << i;
+            }
+            auto chain = chains.find(set);
+            if (chain == chains.end())
+            {
+                if (count == m_writeChains.size()) throw std::runtime_error("Too many I/O devices");
+                const auto first = static_cast<uint16_t>(m_writeDevices.size());
+                for (std::size_t i = 0; i < m_writes.size(); i++)
+                {
+                    if (set & (uint64_t{1} << i)) m_writeDevices.push_back(m_writes[i].device);
+                }
+                m_writeChains[count] = {first, static_cast<uint16_t>(m_writeDevices.size())};
+                chain = chains.emplace(set, static_cast<uint8_t>(count++)).first;
+            }
+            m_writeTable[port] = chain->second;
+        }
+    }
+}  // namespace epoch::zxspectrum
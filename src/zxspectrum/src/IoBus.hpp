@@ -0,0 +1,100 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_IOBUS_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_IOBUS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    // Peripheral on the Z80 I/O bus
+    class IoDevice
+    {
+    public:
+        virtual ~IoDevice() = default;
+        virtual uint8_t ioRead(uint16_t port) { return 0xff; }
+        virtual void ioWrite(uint16_t port, uint8_t value) {}
+    };
+
+    // A device answers on the ports where (port & mask) == value
+    struct IoDecode
+    {
+        uint16_t mask;
+        uint16_t value;
+
+        [[nodiscard]] constexpr bool matches(const uint16_t port) const { return (port & mask) == value; }
+    };
+
+    // Port decoding precomputed for all the 64K ports: every access is a table lookup whatever the number of
+    // attached devices. Reads go to the first matching device in attach order (0xff when none matches), writes to
+    // every matching device.
+    class IoBus final
+    {
+    public:
+        IoBus();
+
+    public:
+        IoBus(const IoBus& other) = delete;
+        IoBus(IoBus&& other) noexcept = delete;
+        IoBus& operator=(const IoBus& other) = delete;
+        IoBus& operator=(IoBus&& other) noexcept = delete;
+
+    public:
+        // The device is not owned and must outlive the bus. Rebuilds the tables: attach while configuring the
+        // machine, not while running.
+        void attach(IoDevice* device, IoDecode read, IoDecode write);
+        void attachRead(IoDevice* device, IoDecode read);
+        void attachWrite(IoDevice* device, IoDecode write);
+
+        [[nodiscard]] uint8_t read(const uint16_t port) const { return m_readers[m_readTable[port]]->ioRead(port); }
+        void write(const uint16_t port, const uint8_t value) const
+        {
+            const auto& chain = m_writeChains[m_writeTable[port]];
+            for (auto i = chain.first; i < chain.last; i++) m_writeDevices[i]->ioWrite(port, value);
+        }
+
+    private:
+        struct Mapping
+        {
+            IoDevice* device;
+            IoDecode decode;
+        };
+        struct Chain
+        {
+            uint16_t first;
+            uint16_t last;
+        };
+
+        std::vector<Mapping> m_reads;
+        std::vector<Mapping> m_writes;
+
+        // Indexes in m_readers, 0 (m_openBus) when no device decodes the port
+        std::array<uint8_t, 0x10000> m_readTable{};
+        std::array<IoDevice*, 0x100> m_readers{};
+        IoDevice m_openBus{};
+        // Indexes in m_writeChains, each chain being the range of m_writeDevices decoding the port
+        std::array<uint8_t, 0x10000> m_writeTable{};
+        std::array<Chain, 0x100> m_writeChains{};
+        std::vector<IoDevice*> m_writeDevices;
+
+        void build();
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
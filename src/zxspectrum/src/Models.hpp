@@ -0,0 +1,95 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_MODELS_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_MODELS_HPP_
+
+#include "Constants.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace epoch::zxspectrum
+{
+    // Paging ports decoded by the machine
+    enum class UlaPaging
+    {
+        none,
+        zx128k,       // 0x7ffd
+        zx128kplus3,  // 0x7ffd and 0x1ffd
+    };
+
+    // Beam timings derived from the line length and the lines per frame, the visible area (Width x Height) is the
+    // same on every model
+    template <int LineTStates, int FrameLines>
+    struct ModelTimings
+    {
+        static constexpr int TStatesPerLine = LineTStates;
+        static constexpr std::size_t TStatesPerFrame = static_cast<std::size_t>(LineTStates * FrameLines);
+
+        static constexpr int VerticalRetrace = FrameLines - Height;         // Lines
+        static constexpr int HorizontalRetrace = LineTStates * 2 - Width;  // Pixels, 2 per T-state
+
+        // Frame T-state at which the interrupt line goes active
+        static constexpr int InterruptStartTState = (HorizontalRetrace + BorderLeft) / 2;
+        // First contended T-state of the frame, one T-state before the ULA fetches the first pixel byte
+        static constexpr int ContentionStartTState =
+            (VerticalRetrace + BorderTop) * TStatesPerLine + (HorizontalRetrace + BorderLeft) / 2 - 1;
+        static constexpr int ContentionEndTState =
+            ContentionStartTState + (ScreenHeight - 1) * TStatesPerLine + ContentionTStatesPerLine;
+
+        static_assert(VerticalRetrace > 0 && HorizontalRetrace > 0);
+    };
+
+    // Machine models: ModelUla and the emulator are instantiated per model, so these are all compile-time constants.
+    // The 128K models still run with the 48K frame timings.
+    struct Model48K : ModelTimings<224, 312>
+    {
+        static constexpr std::size_t CPUClock = 3500000;
+        static constexpr double FramesPerSecond = 50.08;
+        static constexpr std::array<uint8_t, 8> ContentionPattern{6, 5, 4, 3, 2, 1, 0, 0};
+        static constexpr bool IoContention = true;
+        static constexpr UlaPaging Paging = UlaPaging::none;
+        // Bit n set when RAM bank n is contended once paged at 0xc000
+        static constexpr uint8_t ContendedBanks = 0b00000000;
+        static constexpr std::size_t RomCount = 1;
+    };
+
+    struct Model128K : ModelTimings<224, 312>
+    {
+        static constexpr std::size_t CPUClock = 3500000;
+        static constexpr double FramesPerSecond = 50.08;
+        static constexpr std::array<uint8_t, 8> ContentionPattern{6, 5, 4, 3, 2, 1, 0, 0};
+        static constexpr bool IoContention = true;
+        static constexpr UlaPaging Paging = UlaPaging::zx128k;
+        static constexpr uint8_t ContendedBanks = 0b10101010;
+        static constexpr std::size_t RomCount = 2;
+    };
+
+    struct Model128KPlus3 : ModelTimings<224, 312>
+    {
+        static constexpr std::size_t CPUClock = 3500000;
+        static constexpr double FramesPerSecond = 50.08;
+        static constexpr std::array<uint8_t, 8> ContentionPattern{1, 0, 7, 6, 5, 4, 3, 2};
+        static constexpr bool IoContention = false;
+        static constexpr UlaPaging Paging = UlaPaging::zx128kplus3;
+        static constexpr uint8_t ContendedBanks = 0b11110000;
+        static constexpr std::size_t RomCount = 4;
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
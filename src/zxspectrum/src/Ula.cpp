@@ -21,77 +21,147 @@
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
+#include <type_traits>
 
 namespace epoch::zxspectrum
 {
-    Ula::Ula(const UlaType type, const std::span<const uint8_t> rom)
-        : m_type{type},
-          m_ay8910{std::make_unique<sound::AY8910Device>()},
+    namespace
+    {
+        template <typename Model>
+        using ContentionTable = std::array<uint8_t, Model::TStatesPerFrame + ContentionTableSlack>;
+
+        template <typename Model>
+        ContentionTable<Model> makeContentionTable()
+        {
+            ContentionTable<Model> table{};
+            for (auto line = 0; line < ScreenHeight; line++)
+            {
+                const auto lineStart = Model::ContentionStartTState + line * Model::TStatesPerLine;
+                for (auto t = 0; t < ContentionTStatesPerLine; t++)
+                {
+                    table[lineStart + t] = Model::ContentionPattern[t & 0x07];
+                }
+            }
+            return table;
+        }
+
+        template <typename Model>
+        const ContentionTable<Model> ModelContentionTable = makeContentionTable<Model>();
+    }  // namespace
+
+    Ula::Ula(const std::span<const uint8_t> rom, const UlaPaging paging, const uint8_t contendedBanks)
+        : m_ay8910{std::make_unique<sound::AY8910Device>()},
+          m_contendedBanks{contendedBanks},
           m_keyboardState{0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}
     {
         assert(rom.size() <= sizeof(m_rom));
         std::memcpy(m_rom.data(), rom.data(), rom.size());
+
+        updateContendedPages();
+        attachPorts(paging);
     }
 
     Ula::~Ula() = default;
 
-    void Ula::clock()
+    void Ula::drawPixels(const int x, const int y)
     {
-        if (m_cpuStalled > 0) m_cpuStalled--;
-
-        if (m_y >= 0 && m_x >= 0)
+        auto& screenBuffer = m_screenBuffers[m_drawBuffer];
+        if (y >= BorderTop && y < BorderTop + ScreenHeight && x >= BorderLeft && x < BorderLeft + ScreenWidth)
         {
-            if (m_y >= BorderTop && m_y < BorderTop + ScreenHeight && m_x >= BorderLeft &&
-                m_x < BorderLeft + ScreenWidth)
-            {
-                const auto xPixel = (m_x - BorderLeft);
-                const auto yPixel = (m_y - BorderTop);
-                uint16_t pixelAddress = 0;
-                pixelAddress |= (xPixel >> 3) & 0b11111;
-                pixelAddress |= (yPixel & 0b00000111) << 8;
-                pixelAddress |= (yPixel & 0b00111000) << 2;
-                pixelAddress |= (yPixel & 0b11000000) << 5;
-                const auto pixelData = m_vram[pixelAddress];
-
-                const auto attribute = m_vram[0x1800 + ((yPixel >> 3) << 5) + (xPixel >> 3)];
-
-                uint8_t paper = (attribute >> 3) & 0x07;
-                uint8_t ink = attribute & 0x07;
-                if (attribute & 0x40)
-                {
-                    // Bright colors
-                    paper += 0x08;
-                    ink += 0x08;
-                }
-                const bool flash = (attribute & 0x80) && (m_frameCounter & 0x10);  // flash every 16 frames
+            const auto xPixel = (x - BorderLeft);
+            const auto yPixel = (y - BorderTop);
+            uint16_t pixelAddress = 0;
+            pixelAddress |= (xPixel >> 3) & 0b11111;
+            pixelAddress |= (yPixel & 0b00000111) << 8;
+            pixelAddress |= (yPixel & 0b00111000) << 2;
+            pixelAddress |= (yPixel & 0b11000000) << 5;
+            const auto pixelData = m_vram[pixelAddress];
 
-                bool pixel = (pixelData >> (7 - (xPixel & 0b111))) & 0x01;
-                m_screenBuffer[m_y * Width + m_x++] = (pixel && !flash) || (!pixel && flash) ? ink : paper;
+            const auto attribute = m_vram[0x1800 + ((yPixel >> 3) << 5) + (xPixel >> 3)];
 
-                pixel = (pixelData >> (7 - ((xPixel + 1) & 0b111))) & 0x01;
-                m_screenBuffer[m_y * Width + m_x++] = (pixel && !flash) || (!pixel && flash) ? ink : paper;
-            }
-            else
+            uint8_t paper = (attribute >> 3) & 0x07;
+            uint8_t ink = attribute & 0x07;
+            if (attribute & 0x40)
             {
-                m_screenBuffer[m_y * Width + m_x++] = m_border;
-                m_screenBuffer[m_y * Width + m_x++] = m_border;
+                // Bright colors
+                paper += 0x08;
+                ink += 0x08;
             }
+            const bool flash = (attribute & 0x80) && (m_frameCounter & 0x10);  // flash every 16 frames
+
+            bool pixel = (pixelData >> (7 - (xPixel & 0b111))) & 0x01;
+            screenBuffer[y * Width + x] = (pixel && !flash) || (!pixel && flash) ? ink : paper;
+
+            pixel = (pixelData >> (7 - ((xPixel + 1) & 0b111))) & 0x01;
+            screenBuffer[y * Width + x + 1] = (pixel && !flash) || (!pixel && flash) ? ink : paper;
         }
         else
         {
-            // 2 pixels per T-state
-            m_x += 2;
+            screenBuffer[y * Width + x] = m_border;
+            screenBuffer[y * Width + x + 1] = m_border;
         }
+    }
+
+    void Ula::reset()
+    {
+        m_floatingBusValue = {};
+        m_border = {};
+        m_ear = m_mic = {};
+
+        m_ramSelect = 0;
+        m_vramSelect = 5;
+        m_vram = m_ram[m_vramSelect];
+        m_romSelect = 0;
+        m_pagingState = 0;
+        m_pagingPlus3 = 0;
+
+        m_clockCounter = 0;
+        m_frameCounter = 0;
+        m_drawBuffer = 0;
+        m_contention.frameTState = 0;
+        updateContendedPages();
+
+        m_ay8910->reset();
+    }
+
+    template <typename Model>
+    ModelUla<Model>::ModelUla(const std::span<const uint8_t> rom)
+        : Ula{rom, Model::Paging, Model::ContendedBanks}
+    {
+        assert(rom.size() <= Model::RomCount * MemoryBankSize);
+
+        m_contention.delays = ModelContentionTable<Model>.data();
+        m_contention.io = Model::IoContention;
+        m_contention.activeStart = Model::ContentionStartTState;
+        m_contention.activeEnd = Model::ContentionEndTState;
+        m_contention.frameLength = Model::TStatesPerFrame;
+    }
+
+    template <typename Model>
+    void ModelUla<Model>::clock()
+    {
+        if (m_y >= 0 && m_x >= 0)
+        {
+            drawPixels(m_x, m_y);
+        }
+        // 2 pixels per T-state
+        m_x += 2;
 
         if (m_x >= Width)
         {
-            m_x = -HorizontalRetrace;
+            m_x = -Model::HorizontalRetrace;
             m_y++;
         }
         if (m_y >= Height)
         {
-            m_y = -VerticalRetrace;
+            m_y = -Model::VerticalRetrace;
             m_frameCounter++;
+            m_drawBuffer ^= 1;
+        }
+
+        if (++m_contention.frameTState >= Model::TStatesPerFrame)
+        {
+            m_contention.frameTState = 0;
         }
 
         if ((m_clockCounter & 0x01) == 0)
@@ -102,28 +172,27 @@ namespace epoch::zxspectrum
         m_clockCounter++;
     }
 
-    void Ula::reset()
+    template <typename Model>
+    void ModelUla<Model>::reset()
     {
-        m_floatingBusValue = {};
-        m_border = {};
-        m_ear = m_mic = {};
-        m_cpuStalled = {};
-
-        m_ramSelect = 0;
-        m_vramSelect = 5;
-        m_vram = m_ram[m_vramSelect];
-        m_romSelect = 0;
-        m_pagingState = 0;
-        m_pagingPlus3 = 0;
-
-        m_clockCounter = 0;
-        m_frameCounter = 0;
-        m_x = -HorizontalRetrace;
-        m_y = -VerticalRetrace;
+        Ula::reset();
+        m_x = -Model::HorizontalRetrace;
+        m_y = -Model::VerticalRetrace;
+    }
 
-        m_ay8910->reset();
+    template <typename Model>
+    std::size_t ModelUla<Model>::cyclesToNextEvent() const
+    {
+        if (!m_lookAhead) return 0;
+        const auto t = m_contention.frameTState;
+        return t < Model::InterruptStartTState ? Model::InterruptStartTState - t
+                                               : Model::TStatesPerFrame - t + Model::InterruptStartTState;
     }
 
+    template class ModelUla<Model48K>;
+    template class ModelUla<Model128K>;
+    template class ModelUla<Model128KPlus3>;
+
     uint8_t Ula::read(const uint16_t address)
     {
         if (address <= 0x3fff)
@@ -165,128 +234,198 @@ namespace epoch::zxspectrum
         }
     }
 
-    uint8_t Ula::ioRead(const uint16_t port)
+    const uint8_t* Ula::readPage(const int page)
+    {
+        switch (page)
+        {
+            case 0:
+                return m_rom[m_romSelect].data();
+            case 1:
+                return m_ram[5].data();
+            case 2:
+                return m_ram[2].data();
+            default:
+                return m_ram[m_ramSelect].data();
+        }
+    }
+
+    uint8_t Ula::pageBank(const int page) const
     {
-        if ((port & 0b11100000) == 0)
+        switch (page)
         {
-            // Kempston joystick takes priority
-            return m_kempstonState;
+            case 0:
+                return static_cast<uint8_t>(RomBank + m_romSelect);
+            case 1:
+                return 5;
+            case 2:
+                return 2;
+            default:
+                return m_ramSelect;
         }
-        else if ((port & 0x01) == 0)
+    }
+
+    uint8_t* Ula::writePage(const int page)
+    {
+        // ROM is not writable
+        return page == 0 ? nullptr : const_cast<uint8_t*>(readPage(page));
+    }
+
+    // Handlers are template arguments so that the bus pays a single virtual call per access
+    template <auto Reader, auto Writer>
+    class Ula::Port final : public IoDevice
+    {
+    public:
+        explicit Port(Ula& ula) : m_ula{ula} {}
+
+        uint8_t ioRead(const uint16_t port) override
         {
-            const uint8_t portHigh = port >> 8;
-            uint8_t result = 0b00011111;
-            for (auto i = 0; i < 8; i++)
-            {
-                if ((portHigh & (1 << i)) == 0)
-                {
-                    result &= m_keyboardState[i];
-                }
-            }
-            if (m_ear || m_audioIn) result |= 0b01000000;
-            return result | 0b10100000;
+            if constexpr (std::is_null_pointer_v<decltype(Reader)>)
+                return 0xff;
+            else
+                return (m_ula.*Reader)(port);
         }
-        else if ((port & 0b1100000000000010) == 0b1100000000000000)
+        void ioWrite(const uint16_t port, const uint8_t value) override
         {
-            return m_ay8910->data();
+            if constexpr (!std::is_null_pointer_v<decltype(Writer)>) (m_ula.*Writer)(port, value);
         }
-        switch (m_type)
+
+    private:
+        Ula& m_ula;
+    };
+
+    template <auto Reader, auto Writer>
+    IoDevice* Ula::port()
+    {
+        return m_ports.emplace_back(std::make_unique<Port<Reader, Writer>>(*this)).get();
+    }
+
+    void Ula::attachPorts(const UlaPaging paging)
+    {
+        // Kempston joystick takes priority over the ULA, the AY answers on odd ports only
+        m_ioBus.attachRead(port<&Ula::readKempston, nullptr>(), {0b0000000011100000, 0});
+        m_ioBus.attach(port<&Ula::readUlaPort, &Ula::writeUlaPort>(), {0x0001, 0}, {0x0001, 0});
+        m_ioBus.attach(port<&Ula::readAyData, &Ula::writeAyAddress>(), {0b1100000000000011, 0b1100000000000001},
+                       {0b1100000000000011, 0b1100000000000001});
+        m_ioBus.attachWrite(port<nullptr, &Ula::writeAyData>(), {0b1100000000000011, 0b1000000000000001});
+        switch (paging)
         {
-            case UlaType::zx48k:
+            case UlaPaging::none:
                 break;
-            case UlaType::zx128k:
-                if ((port & 0b1000000000000010) == 0)
-                {
-                    return m_pagingState;
-                }
+            case UlaPaging::zx128k:
+                m_ioBus.attach(port<&Ula::readPaging, &Ula::writePaging>(), {0b1000000000000010, 0},
+                               {0b1000000000000010, 0});
                 break;
-            case UlaType::zx128kplus3:
+            case UlaPaging::zx128kplus3:
+                m_ioBus.attachWrite(port<nullptr, &Ula::writePagingPlus3>(), {0b1100000000000010, 0b0100000000000000});
+                m_ioBus.attachWrite(port<nullptr, &Ula::writePagingPlus3Extended>(),
+                                    {0b1111000000000010, 0b0001000000000000});
                 break;
         }
-        return 0xff;
     }
 
-    void Ula::ioWrite(const uint16_t port, const uint8_t value)
+    uint8_t Ula::ioRead(const uint16_t port) { return m_ioBus.read(port); }
+
+    void Ula::ioWrite(const uint16_t port, const uint8_t value) { m_ioBus.write(port, value); }
+
+    uint8_t Ula::readKempston(uint16_t) { return m_kempstonState; }
+
+    uint8_t Ula::readUlaPort(const uint16_t port)
     {
-        if ((port & 0x01) == 0)
+        const uint8_t portHigh = port >> 8;
+        uint8_t result = 0b00011111;
+        for (auto i = 0; i < 8; i++)
         {
-            const auto newEar = value & 0b00010000;
-            const auto newMic = !(value & 0b00001000);
-            /*if (m_ear != newEar || m_mic != newMic)
+            if ((portHigh & (1 << i)) == 0)
             {
-                m_audioOutput = !m_audioOutput;
-            }*/
-            m_ear = newEar;
-            m_mic = newMic;
-            m_border = value & 0x07;
+                result &= m_keyboardState[i];
+            }
         }
-        else if ((port & 0b1100000000000010) == 0b1100000000000000)
+        if (m_ear || m_audioIn) result |= 0b01000000;
+        return result | 0b10100000;
+    }
+
+    void Ula::writeUlaPort(uint16_t, const uint8_t value)
+    {
+        const auto newEar = value & 0b00010000;
+        const auto newMic = !(value & 0b00001000);
+        /*if (m_ear != newEar || m_mic != newMic)
         {
-            if (value < 16)
-            {
-                m_ay8910->address(value);
-            }
+            m_audioOutput = !m_audioOutput;
+        }*/
+        m_ear = newEar;
+        m_mic = newMic;
+        m_border = value & 0x07;
+    }
+
+    uint8_t Ula::readAyData(uint16_t) { return m_ay8910->data(); }
+
+    void Ula::writeAyAddress(uint16_t, const uint8_t value)
+    {
+        if (value < 16)
+        {
+            m_ay8910->address(value);
         }
-        else if ((port & 0b1100000000000010) == 0b1000000000000000)
+    }
+
+    void Ula::writeAyData(uint16_t, const uint8_t value) { m_ay8910->data(value); }
+
+    uint8_t Ula::readPaging(uint16_t) { return m_pagingState; }
+
+    void Ula::writePaging(uint16_t, const uint8_t value)
+    {
+        if ((m_pagingState & 0b00100000) == 0)
         {
-            m_ay8910->data(value);
+            m_pagingState = value;
+            m_ramSelect = m_pagingState & 0x07;
+            m_vramSelect = (m_pagingState & 0b00001000) ? 7 : 5;
+            m_vram = m_ram[m_vramSelect];
+            m_romSelect = (m_pagingState >> 4) & 0x01;
+            updateContendedPages();
         }
-        switch (m_type)
+    }
+
+    void Ula::writePagingPlus3(uint16_t, const uint8_t value)
+    {
+        if ((m_pagingState & 0b00100000) == 0)
         {
-            case UlaType::zx48k:
-                break;
-            case UlaType::zx128k:
-                if ((port & 0b1000000000000010) == 0)
-                {
-                    if ((m_pagingState & 0b00100000) == 0)
-                    {
-                        m_pagingState = value;
-                        m_ramSelect = m_pagingState & 0x07;
-                        m_vramSelect = (m_pagingState & 0b00001000) ? 7 : 5;
-                        m_vram = m_ram[m_vramSelect];
-                        m_romSelect = (m_pagingState >> 4) & 0x01;
-                    }
-                }
-                break;
-            case UlaType::zx128kplus3:
-            {
-                bool shouldUpdate = false;
-                if ((port & 0b1100000000000010) == 0b0100000000000000)
-                {
-                    if ((m_pagingState & 0b00100000) == 0)
-                    {
-                        m_pagingState = value;
-                        shouldUpdate = true;
-                    }
-                }
-                else if ((port & 0b1111000000000010) == 0b0001000000000000)
-                {
-                    if ((m_pagingState & 0b00100000) == 0)
-                    {
-                        m_pagingPlus3 = value;
-                        shouldUpdate = true;
-                    }
-                }
-                if (shouldUpdate)
-                {
-                    if (m_pagingPlus3 & 0x01)
-                    {
-                        // Special paging mode
-                        const auto modeSelect = (m_pagingPlus3 >> 1) & 0x03;
-                        throw std::runtime_error("Paging special mode not yet implemented");
-                    }
-                    else
-                    {
-                        // Normal paging mode
-                        m_ramSelect = m_pagingState & 0x07;
-                        m_vramSelect = (m_pagingState & 0b00001000) ? 7 : 5;
-                        m_vram = m_ram[m_vramSelect];
-                        m_romSelect = ((m_pagingPlus3 >> 1) & 0x02) | ((m_pagingState >> 4) & 0x01);
-                    }
-                }
-                break;
-            }
+            m_pagingState = value;
+            updatePagingPlus3();
+        }
+    }
+
+    void Ula::writePagingPlus3Extended(uint16_t, const uint8_t value)
+    {
+        if ((m_pagingState & 0b00100000) == 0)
+        {
+            m_pagingPlus3 = value;
+            updatePagingPlus3();
+        }
+    }
+
+    void Ula::updatePagingPlus3()
+    {
+        if (m_pagingPlus3 & 0x01)
+        {
+            // Special paging mode
+            const auto modeSelect = (m_pagingPlus3 >> 1) & 0x03;
+            throw std::runtime_error("Paging special mode not yet implemented");
         }
+        else
+        {
+            // Normal paging mode
+            m_ramSelect = m_pagingState & 0x07;
+            m_vramSelect = (m_pagingState & 0b00001000) ? 7 : 5;
+            m_vram = m_ram[m_vramSelect];
+            m_romSelect = ((m_pagingPlus3 >> 1) & 0x02) | ((m_pagingState >> 4) & 0x01);
+            updateContendedPages();
+        }
+    }
+
+    void Ula::updateContendedPages()
+    {
+        // Bank 5 is always mapped at 0x4000, the bank paged at 0xc000 is contended on odd banks (128K) or on
+        // banks 4-7 (+3)
+        m_contention.pages = {false, true, false, ((m_contendedBanks >> m_ramSelect) & 0x01) != 0};
     }
 
     SoundSample Ula::audioOutput() const
@@ -18,6 +18,8 @@
 #define SRC_EPOCH_ZXSPECTRUM_ULA_HPP_
 
 #include "Constants.hpp"
+#include "IoBus.hpp"
+#include "Models.hpp"
 #include "Z80Interface.hpp"
 
 #include <epoch/core.hpp>
@@ -26,6 +28,7 @@
 #include <cstdint>
 #include <memory>
 #include <span>
+#include <vector>
 
 namespace epoch::sound
 {
@@ -34,17 +37,13 @@ namespace epoch::sound
 
 namespace epoch::zxspectrum
 {
-    enum class UlaType
+    // State and behaviour shared by all the machine models, the beam and the frame timings are in ModelUla
+    class Ula : public Z80Interface
     {
-        zx48k,
-        zx128k,
-        zx128kplus3,
-    };
+    protected:
+        Ula(std::span<const uint8_t> rom, UlaPaging paging, uint8_t contendedBanks);
 
-    class Ula final : public Z80Interface
-    {
     public:
-        Ula(UlaType type, std::span<const uint8_t> rom);
         ~Ula() override;
 
     public:
@@ -54,26 +53,35 @@ namespace epoch::zxspectrum
         Ula& operator=(Ula&& other) noexcept = delete;
 
     public:
-        void clock();
-        void reset();
+        virtual void reset();
 
         [[nodiscard]] std::array<MemoryBank, 8>& ram() { return m_ram; }
         [[nodiscard]] const std::array<MemoryBank, 8>& ram() const { return m_ram; }
 
         uint8_t read(uint16_t address) override;
         void write(uint16_t address, uint8_t value) override;
-        uint8_t ioRead(uint16_t port) override;
-        void ioWrite(uint16_t port, uint8_t value) override;
-
-        [[nodiscard]] bool isCpuStalled() const { return m_cpuStalled > 0; }
+        uint8_t ioRead(uint16_t port) final;
+        void ioWrite(uint16_t port, uint8_t value) final;
 
-        [[nodiscard]] std::span<const uint8_t> screenBuffer() const { return m_screenBuffer; }
+        [[nodiscard]] const Z80Contention* contention() const override { return &m_contention; }
+        [[nodiscard]] const uint8_t* readPage(int page) override;
+        [[nodiscard]] uint8_t* writePage(int page) override;
+        // Bank mapped in a 16K page: RAM banks 0-7, ROM banks are RomBank + n
+        static constexpr uint8_t RomBank = 0x80;
+        [[nodiscard]] uint8_t pageBank(int page) const;
 
-        [[nodiscard]] bool interruptRequested() const
+        [[nodiscard]] uint16_t paging() const override
         {
-            return m_y == -VerticalRetrace && m_x >= BorderLeft && m_x < BorderLeft + InterruptActiveTStates * 2;
+            return static_cast<uint16_t>(m_pagingPlus3 << 8 | m_pagingState);
         }
-        [[nodiscard]] bool frameReady() const { return m_y == -VerticalRetrace && m_x == -HorizontalRetrace; }
+
+        // Last complete frame, stays valid until the end of the next one
+        [[nodiscard]] std::span<const uint8_t> screenBuffer() const { return m_screenBuffers[m_drawBuffer ^ 1]; }
+
+        // Port decoding of the machine, additional peripherals are attached here
+        [[nodiscard]] IoBus& ioBus() { return m_ioBus; }
+
+        [[nodiscard]] uint64_t frameCounter() const { return m_frameCounter; }
 
         [[nodiscard]] SoundSample audioOutput() const;
         [[nodiscard]] uint8_t border() const { return m_border; }
@@ -81,15 +89,16 @@ namespace epoch::zxspectrum
         void setKeyState(int row, int col, bool state);
         void setKempstonState(int button, bool state);
         void setAudioIn(const bool value) { m_audioIn = value; }
+        // Disable while an external source (tape) drives the inputs, they could change at any T-state
+        void setLookAhead(const bool enabled) { m_lookAhead = enabled; }
 
-    private:
-        UlaType m_type;
-
+    protected:
         std::array<MemoryBank, 4> m_rom{};
         std::array<MemoryBank, 8> m_ram{};
 
         std::unique_ptr<sound::AY8910Device> m_ay8910{};
 
+        const uint8_t m_contendedBanks;
         uint8_t m_ramSelect{0};
         uint8_t m_vramSelect{5};
         std::span<uint8_t> m_vram{m_ram[m_vramSelect]};
@@ -101,14 +110,74 @@ namespace epoch::zxspectrum
         uint8_t m_border{};
         std::array<uint8_t, 8> m_keyboardState{};  // Rows 0=Caps, A, Q, 1, 6, Y, H, 7=B
         bool m_ear{}, m_mic{}, m_audioIn{};
+        bool m_lookAhead{true};
         uint8_t m_kempstonState{};
-        int m_cpuStalled{};
+
+        Z80Contention m_contention{};
+        void updateContendedPages();
 
         uint64_t m_clockCounter{};
         uint64_t m_frameCounter{};
-        std::array<uint8_t, static_cast<std::size_t>(Width* Height)> m_screenBuffer{};
-        int m_x{-HorizontalRetrace}, m_y{-VerticalRetrace};
+        // The beam draws in one buffer while the other holds the last complete frame, swapped at the end of every
+        // frame so that the frame is never copied
+        std::array<std::array<uint8_t, static_cast<std::size_t>(Width* Height)>, 2> m_screenBuffers{};
+        uint8_t m_drawBuffer{};
+
+        // Draws the 2 pixels at the beam position x, y (visible area coordinates)
+        void drawPixels(int x, int y);
+
+    private:
+        // Built-in ports, forwarding to the member functions below
+        template <auto Reader, auto Writer>
+        class Port;
+        std::vector<std::unique_ptr<IoDevice>> m_ports{};
+        IoBus m_ioBus{};
+        template <auto Reader, auto Writer>
+        IoDevice* port();
+        void attachPorts(UlaPaging paging);
+        uint8_t readKempston(uint16_t port);
+        uint8_t readUlaPort(uint16_t port);
+        void writeUlaPort(uint16_t port, uint8_t value);
+        uint8_t readAyData(uint16_t port);
+        void writeAyAddress(uint16_t port, uint8_t value);
+        void writeAyData(uint16_t port, uint8_t value);
+        uint8_t readPaging(uint16_t port);
+        void writePaging(uint16_t port, uint8_t value);
+        void writePagingPlus3(uint16_t port, uint8_t value);
+        void writePagingPlus3Extended(uint16_t port, uint8_t value);
+        void updatePagingPlus3();
     };
+
+    // Ula of a machine model (see Models.hpp), instantiated for Model48K, Model128K and Model128KPlus3
+    template <typename Model>
+    class ModelUla final : public Ula
+    {
+    public:
+        explicit ModelUla(std::span<const uint8_t> rom);
+
+    public:
+        void clock();
+        void reset() override;
+
+        [[nodiscard]] std::size_t cyclesToNextEvent() const override;
+
+        [[nodiscard]] bool interruptRequested() const
+        {
+            return m_y == -Model::VerticalRetrace && m_x >= BorderLeft &&
+                   m_x < BorderLeft + InterruptActiveTStates * 2;
+        }
+        [[nodiscard]] bool frameReady() const
+        {
+            return m_y == -Model::VerticalRetrace && m_x == -Model::HorizontalRetrace;
+        }
+
+    private:
+        int m_x{-Model::HorizontalRetrace}, m_y{-Model::VerticalRetrace};
+    };
+
+    extern template class ModelUla<Model48K>;
+    extern template class ModelUla<Model128K>;
+    extern template class ModelUla<Model128KPlus3>;
 }  // namespace epoch::zxspectrum
 
 #endif
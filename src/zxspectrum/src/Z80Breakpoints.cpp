@@ -0,0 +1,581 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Z80Breakpoints.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        enum Operator
+        {
+            // Binary, lowest precedence first
+            logicalOr,
+            logicalAnd,
+            bitwiseOr,
+            bitwiseXor,
+            bitwiseAnd,
+            equal,
+            notEqual,
+            less,
+            lessEqual,
+            greater,
+            greaterEqual,
+            add,
+            subtract,
+            // Unary
+            logicalNot,
+            bitwiseNot,
+            negate,
+        };
+
+        struct BinaryOperator
+        {
+            std::string_view token;
+            Operator op;
+            int precedence;
+        };
+
+        // Longer tokens first, so that "<=" is not read as "<"
+        constexpr BinaryOperator BinaryOperators[] = {
+            {"||", logicalOr, 0},  {"&&", logicalAnd, 1}, {"==", equal, 5},    {"!=", notEqual, 5},
+            {"<=", lessEqual, 6},  {">=", greaterEqual, 6}, {"|", bitwiseOr, 2}, {"^", bitwiseXor, 3},
+            {"&", bitwiseAnd, 4},  {"<", less, 6},         {">", greater, 6},   {"+", add, 7},
+            {"-", subtract, 7},
+        };
+        constexpr int MaxPrecedence = 7;
+
+        enum Register
+        {
+            regA,
+            regF,
+            regB,
+            regC,
+            regD,
+            regE,
+            regH,
+            regL,
+            regI,
+            regR,
+            regAF,
+            regBC,
+            regDE,
+            regHL,
+            regIX,
+            regIY,
+            regSP,
+            regPC,
+            regIXH,
+            regIXL,
+            regIYH,
+            regIYL,
+            regAF2,
+            regBC2,
+            regDE2,
+            regHL2,
+            regWZ,
+            regIM,
+            regIFF1,
+            regIFF2,
+        };
+
+        struct RegisterName
+        {
+            std::string_view name;
+            Register reg;
+        };
+
+        constexpr RegisterName RegisterNames[] = {
+            {"a", regA},       {"f", regF},       {"b", regB},       {"c", regC},     {"d", regD},
+            {"e", regE},       {"h", regH},       {"l", regL},       {"i", regI},     {"r", regR},
+            {"af", regAF},     {"bc", regBC},     {"de", regDE},     {"hl", regHL},   {"ix", regIX},
+            {"iy", regIY},     {"sp", regSP},     {"pc", regPC},     {"ixh", regIXH}, {"ixl", regIXL},
+            {"iyh", regIYH},   {"iyl", regIYL},   {"af'", regAF2},   {"bc'", regBC2}, {"de'", regDE2},
+            {"hl'", regHL2},   {"wz", regWZ},     {"im", regIM},     {"iff1", regIFF1}, {"iff2", regIFF2},
+        };
+
+        int64_t registerValue(const Z80Registers& registers, const int reg)
+        {
+            switch (reg)
+            {
+                case regA:
+                    return registers.af.high;
+                case regF:
+                    return registers.af.low;
+                case regB:
+                    return registers.bc.high;
+                case regC:
+                    return registers.bc.low;
+                case regD:
+                    return registers.de.high;
+                case regE:
+                    return registers.de.low;
+                case regH:
+                    return registers.hl.high;
+                case regL:
+                    return registers.hl.low;
+                case regI:
+                    return registers.ir.high;
+                case regR:
+                    return registers.ir.low;
+                case regAF:
+                    return registers.af;
+                case regBC:
+                    return registers.bc;
+                case regDE:
+                    return registers.de;
+                case regHL:
+                    return registers.hl;
+                case regIX:
+                    return registers.ix;
+                case regIY:
+                    return registers.iy;
+                case regSP:
+                    return registers.sp;
+                case regPC:
+                    return registers.pc;
+                case regIXH:
+                    return registers.ix.high;
+                case regIXL:
+                    return registers.ix.low;
+                case regIYH:
+                    return registers.iy.high;
+                case regIYL:
+                    return registers.iy.low;
+                case regAF2:
+                    return registers.af2;
+                case regBC2:
+                    return registers.bc2;
+                case regDE2:
+                    return registers.de2;
+                case regHL2:
+                    return registers.hl2;
+                case regWZ:
+                    return registers.wz;
+                case regIM:
+                    return registers.interruptMode;
+                case regIFF1:
+                    return registers.iff1;
+                case regIFF2:
+                    return registers.iff2;
+                default:
+                    return 0;
+            }
+        }
+
+        int64_t applyBinary(const int op, const int64_t a, const int64_t b)
+        {
+            switch (op)
+            {
+                case logicalOr:
+                    return a || b;
+                case logicalAnd:
+                    return a && b;
+                case bitwiseOr:
+                    return a | b;
+                case bitwiseXor:
+                    return a ^ b;
+                case bitwiseAnd:
+                    return a & b;
+                case equal:
+                    return a == b;
+                case notEqual:
+                    return a != b;
+                case less:
+                    return a < b;
+                case lessEqual:
+                    return a <= b;
+                case greater:
+                    return a > b;
+                case greaterEqual:
+                    return a >= b;
+                case add:
+                    return a + b;
+                case subtract:
+                    return a - b;
+                default:
+                    return 0;
+            }
+        }
+    }  // namespace
+
+    // Recursive descent parser producing the postfix program
+    class Z80ConditionParser final
+    {
+    public:
+        Z80ConditionParser(const std::string_view text, std::vector<Z80Condition::Node>& program)
+            : m_text{text}, m_program{program}
+        {
+        }
+
+        void parse()
+        {
+            parseBinary(0);
+            skipSpaces();
+            if (m_position != m_text.size()) error("unexpected characters");
+        }
+
+    private:
+        std::string_view m_text;
+        std::size_t m_position{};
+        std::vector<Z80Condition::Node>& m_program;
+
+        [[noreturn]] void error(const std::string& message) const
+        {
+            throw std::invalid_argument("Invalid condition at " + std::to_string(m_position) + ": " + message);
+        }
+
+        void skipSpaces()
+        {
+            while (m_position < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_position])))
+                m_position++;
+        }
+
+        bool accept(const std::string_view token)
+        {
+            skipSpaces();
+            if (m_text.substr(m_position, token.size()) != token) return false;
+            m_position += token.size();
+            return true;
+        }
+
+        void parseBinary(const int precedence)
+        {
+            if (precedence > MaxPrecedence)
+            {
+                parseUnary();
+                return;
+            }
+            parseBinary(precedence + 1);
+            while (true)
+            {
+                const BinaryOperator* found{};
+                for (const auto& op : BinaryOperators)
+                {
+                    if (op.precedence != precedence) continue;
+                    skipSpaces();
+                    if (m_text.substr(m_position, op.token.size()) != op.token) continue;
+                    // "|" and "&" must not match the first character of "||" and "&&"
+                    const auto next = m_position + op.token.size();
+                    if (op.token.size() == 1 && next < m_text.size() && m_text[next] == op.token[0]) continue;
+                    found = &op;
+                    break;
+                }
+                if (!found) return;
+                m_position += found->token.size();
+                parseBinary(precedence + 1);
+                m_program.push_back({Z80Condition::Node::Type::binaryOperator, found->op, 0});
+            }
+        }
+
+        void parseUnary()
+        {
+            if (accept("!"))
+            {
+                parseUnary();
+                m_program.push_back({Z80Condition::Node::Type::unaryOperator, logicalNot, 0});
+            }
+            else if (accept("~"))
+            {
+                parseUnary();
+                m_program.push_back({Z80Condition::Node::Type::unaryOperator, bitwiseNot, 0});
+            }
+            else if (accept("-"))
+            {
+                parseUnary();
+                m_program.push_back({Z80Condition::Node::Type::unaryOperator, negate, 0});
+            }
+            else
+            {
+                parsePrimary();
+            }
+        }
+
+        void parsePrimary()
+        {
+            if (accept("("))
+            {
+                parseBinary(0);
+                if (!accept(")")) error("missing )");
+                return;
+            }
+            skipSpaces();
+            auto end = m_position;
+            while (end < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[end])) ||
+                                           m_text[end] == '$' || m_text[end] == '#' || m_text[end] == '\''))
+                end++;
+            if (end == m_position) error("operand expected");
+            std::string token{m_text.substr(m_position, end - m_position)};
+            std::transform(token.begin(), token.end(), token.begin(),
+                           [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            m_position = end;
+
+            for (const auto& reg : RegisterNames)
+            {
+                if (reg.name == token)
+                {
+                    m_program.push_back({Z80Condition::Node::Type::registerValue, reg.reg, 0});
+                    return;
+                }
+            }
+
+            std::string_view digits{token};
+            int base = 10;
+            if (digits.starts_with("0x"))
+            {
+                digits.remove_prefix(2);
+                base = 16;
+            }
+            else if (digits.starts_with("$") || digits.starts_with("#"))
+            {
+                digits.remove_prefix(1);
+                base = 16;
+            }
+            else if (digits.ends_with("h"))
+            {
+                digits.remove_suffix(1);
+                base = 16;
+            }
+            int64_t value{};
+            const auto [last, result] = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+            if (digits.empty() || result != std::errc{} || last != digits.data() + digits.size())
+                error("unknown operand " + token);
+            m_program.push_back({Z80Condition::Node::Type::number, 0, value});
+        }
+    };
+
+    Z80Condition::Z80Condition(const std::string_view expression)
+    {
+        if (expression.find_first_not_of(" \t") == std::string_view::npos) return;
+        Z80ConditionParser{expression, m_program}.parse();
+    }
+
+    int64_t Z80Condition::evaluate(const Z80Registers& registers) const
+    {
+        std::vector<int64_t> stack;
+        stack.reserve(m_program.size());
+        for (const auto& node : m_program)
+        {
+            switch (node.type)
+            {
+                case Node::Type::number:
+                    stack.push_back(node.value);
+                    break;
+                case Node::Type::registerValue:
+                    stack.push_back(registerValue(registers, node.op));
+                    break;
+                case Node::Type::unaryOperator:
+                {
+                    auto& value = stack.back();
+                    value = node.op == logicalNot ? !value : node.op == bitwiseNot ? ~value : -value;
+                    break;
+                }
+                case Node::Type::binaryOperator:
+                {
+                    const auto b = stack.back();
+                    stack.pop_back();
+                    stack.back() = applyBinary(node.op, stack.back(), b);
+                    break;
+                }
+            }
+        }
+        return stack.empty() ? 1 : stack.back();
+    }
+
+    Z80Breakpoints::Z80Breakpoints(Z80Cpu& cpu) : m_cpu{cpu} {}
+
+    Z80Breakpoints::~Z80Breakpoints() { m_cpu.setBreakpoints(nullptr); }
+
+    int Z80Breakpoints::add(const Z80BreakpointType type, const uint16_t address, const std::string_view condition,
+                            const bool temporary, const uint16_t mask)
+    {
+        Z80Condition compiled{condition};
+        const auto id = m_nextId++;
+        m_breakpoints.push_back({id, type, address, mask, std::string{condition}, temporary, 0});
+        m_conditions.push_back(std::move(compiled));
+        rebuild();
+        return id;
+    }
+
+    void Z80Breakpoints::remove(const int id)
+    {
+        for (std::size_t i = 0; i < m_breakpoints.size(); ++i)
+        {
+            if (m_breakpoints[i].id == id)
+            {
+                m_breakpoints.erase(m_breakpoints.begin() + static_cast<std::ptrdiff_t>(i));
+                m_conditions.erase(m_conditions.begin() + static_cast<std::ptrdiff_t>(i));
+                break;
+            }
+        }
+        rebuild();
+    }
+
+    void Z80Breakpoints::clear()
+    {
+        m_breakpoints.clear();
+        m_conditions.clear();
+        m_breakClock = m_breakFrame = Never;
+        m_pending = {};
+        rebuild();
+    }
+
+    void Z80Breakpoints::breakAtClock(const uint64_t clock)
+    {
+        m_breakClock = clock;
+        attach();
+    }
+
+    void Z80Breakpoints::breakAtFrame(const uint64_t frame)
+    {
+        m_breakFrame = frame;
+        attach();
+    }
+
+    void Z80Breakpoints::requestBreak()
+    {
+        m_pending = {Reason::request, -1, m_cpu.registers().pc};
+        attach();
+    }
+
+    bool Z80Breakpoints::empty() const
+    {
+        return m_breakpoints.empty() && m_breakClock == Never && m_breakFrame == Never &&
+               m_pending.reason == Reason::none;
+    }
+
+    bool Z80Breakpoints::checkInstruction(const Z80Registers& registers, const uint64_t clock)
+    {
+        if (m_skipNext)
+        {
+            m_skipNext = false;
+            m_pending = {};
+            return false;
+        }
+        auto hit = m_pending;
+        m_pending = {};
+        if (hit.reason == Reason::none && clock >= m_breakClock)
+        {
+            hit = {Reason::clock, -1, registers.pc};
+            m_breakClock = Never;
+        }
+        if (hit.reason == Reason::none && m_pages[PageExecution][registers.pc >> 8] &&
+            m_addresses[PageExecution][registers.pc])
+        {
+            for (std::size_t i = 0; i < m_breakpoints.size(); ++i)
+            {
+                const auto& breakpoint = m_breakpoints[i];
+                if (breakpoint.type == Z80BreakpointType::execution && breakpoint.address == registers.pc &&
+                    matches(i, registers))
+                {
+                    hit = {Reason::breakpoint, breakpoint.id, registers.pc};
+                    if (breakpoint.temporary) remove(breakpoint.id);
+                    break;
+                }
+            }
+        }
+        if (hit.reason == Reason::none) return false;
+        m_lastHit = hit;
+        attach();
+        return true;
+    }
+
+    void Z80Breakpoints::checkAddress(const Z80BreakpointType type, const uint16_t address,
+                                      const Z80Registers& registers)
+    {
+        const auto page = type == Z80BreakpointType::read ? PageRead : PageWrite;
+        if (!m_addresses[page][address] || m_pending.reason != Reason::none) return;
+        for (std::size_t i = 0; i < m_breakpoints.size(); ++i)
+        {
+            const auto& breakpoint = m_breakpoints[i];
+            if (breakpoint.type == type && breakpoint.address == address && matches(i, registers))
+            {
+                m_pending = {Reason::breakpoint, breakpoint.id, address};
+                if (breakpoint.temporary) remove(breakpoint.id);
+                return;
+            }
+        }
+    }
+
+    void Z80Breakpoints::checkIo(const Z80BreakpointType type, const uint16_t port, const Z80Registers& registers)
+    {
+        if (!m_hasIo || m_pending.reason != Reason::none) return;
+        for (std::size_t i = 0; i < m_breakpoints.size(); ++i)
+        {
+            const auto& breakpoint = m_breakpoints[i];
+            if (breakpoint.type == type && (port & breakpoint.mask) == (breakpoint.address & breakpoint.mask) &&
+                matches(i, registers))
+            {
+                m_pending = {Reason::breakpoint, breakpoint.id, port};
+                if (breakpoint.temporary) remove(breakpoint.id);
+                return;
+            }
+        }
+    }
+
+    void Z80Breakpoints::frame(const uint64_t frame)
+    {
+        if (frame >= m_breakFrame && m_pending.reason == Reason::none)
+        {
+            m_pending = {Reason::frame, -1, m_cpu.registers().pc};
+            m_breakFrame = Never;
+        }
+    }
+
+    bool Z80Breakpoints::matches(const std::size_t index, const Z80Registers& registers)
+    {
+        if (!m_conditions[index].empty() && m_conditions[index].evaluate(registers) == 0) return false;
+        m_breakpoints[index].hits++;
+        return true;
+    }
+
+    void Z80Breakpoints::rebuild()
+    {
+        m_pages = {};
+        for (auto& addresses : m_addresses) addresses.reset();
+        m_hasIo = false;
+        for (const auto& breakpoint : m_breakpoints)
+        {
+            std::size_t page;
+            switch (breakpoint.type)
+            {
+                case Z80BreakpointType::execution:
+                    page = PageExecution;
+                    break;
+                case Z80BreakpointType::read:
+                    page = PageRead;
+                    break;
+                case Z80BreakpointType::write:
+                    page = PageWrite;
+                    break;
+                default:
+                    m_hasIo = true;
+                    continue;
+            }
+            m_pages[page][breakpoint.address >> 8] = 1;
+            m_addresses[page][breakpoint.address] = true;
+        }
+        attach();
+    }
+
+    void Z80Breakpoints::attach() { m_cpu.setBreakpoints(empty() ? nullptr : this); }
+}  // namespace epoch::zxspectrum
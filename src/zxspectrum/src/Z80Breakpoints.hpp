@@ -0,0 +1,181 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_Z80BREAKPOINTS_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_Z80BREAKPOINTS_HPP_
+
+#include "Z80Cpu.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    // Boolean/integer expression over the CPU registers, e.g. "A == 0x10 && (HL > $8000 || iff1)".
+    // C-like operators and precedence, numbers in decimal, 0x/$/#/h-suffixed hex.
+    class Z80Condition final
+    {
+    public:
+        Z80Condition() = default;
+        // Throws std::invalid_argument on syntax errors
+        explicit Z80Condition(std::string_view expression);
+
+        [[nodiscard]] bool empty() const { return m_program.empty(); }
+        [[nodiscard]] int64_t evaluate(const Z80Registers& registers) const;
+
+    private:
+        struct Node
+        {
+            enum class Type : uint8_t
+            {
+                number,
+                registerValue,
+                unaryOperator,
+                binaryOperator,
+            };
+            Type type;
+            int op;
+            int64_t value;
+        };
+        std::vector<Node> m_program{};  // postfix
+
+        friend class Z80ConditionParser;
+    };
+
+    enum class Z80BreakpointType : uint8_t
+    {
+        execution,
+        read,
+        write,
+        ioRead,
+        ioWrite,
+    };
+
+    struct Z80Breakpoint
+    {
+        int id;
+        Z80BreakpointType type;
+        uint16_t address;  // port for IO breakpoints
+        uint16_t mask;     // IO only, the port matches when (port & mask) == address
+        std::string condition;
+        bool temporary;  // removed on the first hit
+        uint64_t hits;
+    };
+
+    // Execution, memory and IO breakpoints checked by Z80Cpu.
+    // Addresses are grouped in 256-byte pages: the per-address bitmaps are only consulted for flagged pages. The CPU
+    // only sees this object while at least one breakpoint is set, so it costs nothing otherwise.
+    class Z80Breakpoints final
+    {
+    public:
+        enum class Reason : uint8_t
+        {
+            none,
+            breakpoint,
+            clock,
+            frame,
+            request,
+        };
+        struct Hit
+        {
+            Reason reason;
+            int id;  // breakpoint, -1 for the other reasons
+            uint16_t address;
+        };
+
+        static constexpr uint64_t Never = std::numeric_limits<uint64_t>::max();
+
+    public:
+        explicit Z80Breakpoints(Z80Cpu& cpu);
+        ~Z80Breakpoints();
+
+    public:
+        Z80Breakpoints(const Z80Breakpoints& other) = delete;
+        Z80Breakpoints(Z80Breakpoints&& other) noexcept = delete;
+        Z80Breakpoints& operator=(const Z80Breakpoints& other) = delete;
+        Z80Breakpoints& operator=(Z80Breakpoints&& other) noexcept = delete;
+
+    public:
+        // Returns the new breakpoint id. Throws std::invalid_argument if the condition is not valid.
+        int add(Z80BreakpointType type, uint16_t address, std::string_view condition = {}, bool temporary = false,
+                uint16_t mask = 0xffff);
+        void remove(int id);
+        void clear();
+        [[nodiscard]] const std::vector<Z80Breakpoint>& list() const { return m_breakpoints; }
+
+        // Stop at the first instruction boundary at or after the given CPU clock counter / frame
+        void breakAtClock(uint64_t clock);
+        void breakAtFrame(uint64_t frame);
+        // Stop at the next instruction boundary
+        void requestBreak();
+
+        [[nodiscard]] bool empty() const;
+        [[nodiscard]] const Hit& lastHit() const { return m_lastHit; }
+
+        // Called by the CPU at instruction boundaries, true to stop before executing the instruction at PC
+        [[nodiscard]] bool checkInstruction(const Z80Registers& registers, uint64_t clock);
+        // Called by the CPU on bus accesses, a hit stops at the next instruction boundary
+        void checkRead(const uint16_t address, const Z80Registers& registers)
+        {
+            if (m_pages[PageRead][address >> 8]) [[unlikely]]
+                checkAddress(Z80BreakpointType::read, address, registers);
+        }
+        void checkWrite(const uint16_t address, const Z80Registers& registers)
+        {
+            if (m_pages[PageWrite][address >> 8]) [[unlikely]]
+                checkAddress(Z80BreakpointType::write, address, registers);
+        }
+        void checkIo(Z80BreakpointType type, uint16_t port, const Z80Registers& registers);
+        // Called by the machine at the end of each frame
+        void frame(uint64_t frame);
+
+        // The next instruction is executed even if it has a breakpoint (used to resume from one)
+        void skipNext() { m_skipNext = !empty(); }
+
+    private:
+        static constexpr std::size_t PageExecution = 0;
+        static constexpr std::size_t PageRead = 1;
+        static constexpr std::size_t PageWrite = 2;
+
+        Z80Cpu& m_cpu;
+        std::vector<Z80Breakpoint> m_breakpoints{};
+        std::vector<Z80Condition> m_conditions{};
+        int m_nextId{1};
+
+        std::array<std::array<uint8_t, 256>, 3> m_pages{};  // 1 for pages holding a breakpoint
+        std::array<std::bitset<0x10000>, 3> m_addresses{};
+        bool m_hasIo{};
+
+        uint64_t m_breakClock{Never};
+        uint64_t m_breakFrame{Never};
+        Hit m_pending{};
+        Hit m_lastHit{};
+        bool m_skipNext{};
+
+        void checkAddress(Z80BreakpointType type, uint16_t address, const Z80Registers& registers);
+        bool matches(std::size_t index, const Z80Registers& registers);
+        void rebuild();
+        void attach();
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
@@ -16,48 +16,37 @@
 
 #include "Z80Cpu.hpp"
 
+#include "Z80Breakpoints.hpp"
 #include "Z80Tables.hpp"
+#ifdef EPOCH_TRACER
+#include "Z80Tracer.hpp"
+#endif
 
+#include <algorithm>
 #include <bit>
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <sstream>
 
 namespace epoch::zxspectrum
 {
-    Z80Cpu::Z80Cpu(Z80Interface& bus)
-        : m_bus{bus},
-          m_registersPointers{{
-              {
-                  &m_registers.bc.high,
-                  &m_registers.bc.low,
-                  &m_registers.de.high,
-                  &m_registers.de.low,
-                  &m_registers.hl.high,
-                  &m_registers.hl.low,
-                  nullptr,  // (HL)
-                  &m_registers.af.high,
-              },
-              {
-                  &m_registers.bc.high,
-                  &m_registers.bc.low,
-                  &m_registers.de.high,
-                  &m_registers.de.low,
-                  &m_registers.ix.high,
-                  &m_registers.ix.low,
-                  nullptr,  // (IX)
-                  &m_registers.af.high,
-              },
-              {
-                  &m_registers.bc.high,
-                  &m_registers.bc.low,
-                  &m_registers.de.high,
-                  &m_registers.de.low,
-                  &m_registers.iy.high,
-                  &m_registers.iy.low,
-                  nullptr,  // (IY)
-                  &m_registers.af.high,
-              },
-          }}
+    namespace
+    {
+        constexpr Z80Contention NoContention{};
+        constexpr int PageSize = 0x4000;
+
+        // Whole CPU state except R, which is expected to advance on every iteration of a loop
+        bool sameLoopState(const Z80Registers& a, const Z80Registers& b)
+        {
+            return a.pc == b.pc && a.sp == b.sp && a.af == b.af && a.bc == b.bc && a.de == b.de && a.hl == b.hl &&
+                   a.ix == b.ix && a.iy == b.iy && a.af2 == b.af2 && a.bc2 == b.bc2 && a.de2 == b.de2 &&
+                   a.hl2 == b.hl2 && a.ir.high == b.ir.high && a.wz == b.wz && a.interruptMode == b.interruptMode &&
+                   a.iff1 == b.iff1 && a.iff2 == b.iff2 && a.interruptJustEnabled == b.interruptJustEnabled;
+        }
+    }  // namespace
+
+    Z80Cpu::Z80Cpu(Z80Interface& bus) : m_bus{bus}, m_contention{bus.contention() ? bus.contention() : &NoContention}
     {
         reset();
     }
@@ -66,13 +55,31 @@ namespace epoch::zxspectrum
     {
         if (m_remainingCycles == 0)
         {
+            m_instructionPc = m_registers.pc;
+            m_stopped = false;
             if (m_interruptRequested && m_registers.iff1 && !m_registers.interruptJustEnabled)
             {
                 handleInterrupt();
             }
             else
             {
+                if (m_breakpoints) [[unlikely]]
+                {
+                    m_stopped = m_breakpoints->checkInstruction(m_registers, m_clockCounter);
+                    if (m_stopped) return;
+                }
+#ifdef EPOCH_TRACER
+                if (m_tracer) [[unlikely]]
+                {
+                    m_tracer->record(m_registers, m_clockCounter, m_bus);
+                }
+#endif
                 executeInstruction();
+#ifdef EPOCH_CPU_STATISTICS
+                // DD/FD run the prefixed opcode in the same call: it is counted once, in the dd/fd tables, with the
+                // T-states of the prefix (and of any repeated prefix) included
+                m_statistics.count(m_statisticsTable, m_opcode, m_remainingCycles);
+#endif
             }
         }
 
@@ -95,7 +102,10 @@ namespace epoch::zxspectrum
         m_currentPrefix = Z80OpcodePrefix::none;
         m_interruptRequested = {};
         m_remainingCycles = {};
+        m_instructionPc = {};
         m_clockCounter = {};
+        m_stopped = false;
+        m_loopStableIterations = -1;
     }
 
     void Z80Cpu::interruptRequest(const bool requested) { m_interruptRequested = requested; }
@@ -103,6 +113,11 @@ namespace epoch::zxspectrum
     void Z80Cpu::executeInstruction()
     {
         m_opcode = fetchOpcode();
+#ifdef EPOCH_CPU_STATISTICS
+        static constexpr Z80StatisticsTable prefixTables[] = {
+            Z80StatisticsTable::none, Z80StatisticsTable::dd, Z80StatisticsTable::fd};
+        m_statisticsTable = prefixTables[static_cast<int>(m_currentPrefix)];
+#endif
 
         const auto quadrant = m_opcode >> 6;
 
@@ -143,6 +158,7 @@ namespace epoch::zxspectrum
         const auto r = m_registers.ir.low;
         m_registers.ir.low = (((r & 0x7f) + 1) & 0x7f) | (r & 0x80);
         m_registers.iff1 = false;
+        m_loopStableIterations = -1;
         m_remainingCycles++;  // 'use' the current cycle
         switch (m_registers.interruptMode)
         {
@@ -163,40 +179,131 @@ namespace epoch::zxspectrum
         }
     }
 
+    inline void Z80Cpu::contend(const uint16_t address)
+    {
+        // Uncontended pages only cost the flag test
+        if (m_contention->pages[address >> 14]) [[unlikely]]
+        {
+            const auto delay = m_contention->delays[m_contention->frameTState + m_remainingCycles];
+            m_remainingCycles += delay;
+            m_loopContended = true;
+            m_loopSideEffects |= delay != 0;
+        }
+    }
+
+    inline void Z80Cpu::contendInternal(const uint16_t address, const int cycles)
+    {
+        // Internal cycles with no MREQ still leave the address of the last access on the bus: each of them is
+        // delayed like a 1 T-state access
+        if (m_contention->pages[address >> 14]) [[unlikely]]
+        {
+            const auto* delays = m_contention->delays + m_contention->frameTState;
+            const auto start = m_remainingCycles;
+            for (auto i = 0; i < cycles; i++)
+            {
+                m_remainingCycles += delays[m_remainingCycles] + 1;
+            }
+            m_loopContended = true;
+            m_loopSideEffects |= m_remainingCycles - start != cycles;
+        }
+        else
+        {
+            m_remainingCycles += cycles;
+        }
+    }
+
+    void Z80Cpu::ioContend(const uint16_t port)
+    {
+        if (!m_contention->io)
+        {
+            m_remainingCycles += 4;
+            return;
+        }
+        const auto* delays = m_contention->delays + m_contention->frameTState;
+        const auto start = m_remainingCycles;
+        if (m_contention->pages[port >> 14])
+        {
+            // C:1, then C:3 for ULA ports or C:1 C:1 C:1 for the others
+            m_remainingCycles += delays[m_remainingCycles] + 1;
+            if ((port & 0x01) == 0)
+            {
+                m_remainingCycles += delays[m_remainingCycles] + 3;
+            }
+            else
+            {
+                for (auto i = 0; i < 3; i++)
+                {
+                    m_remainingCycles += delays[m_remainingCycles] + 1;
+                }
+            }
+        }
+        else if ((port & 0x01) == 0)
+        {
+            // N:1 C:3
+            m_remainingCycles += 1;
+            m_remainingCycles += delays[m_remainingCycles] + 3;
+        }
+        else
+        {
+            m_remainingCycles += 4;
+            return;
+        }
+        m_loopContended = true;
+        m_loopSideEffects |= m_remainingCycles - start != 4;
+    }
+
     uint8_t Z80Cpu::fetchOpcode()
     {
+        contend(m_registers.pc);
         m_remainingCycles += 4;
         const auto opcode = m_bus.read(m_registers.pc++);
-        if (m_currentPrefix == Z80OpcodePrefix::none || opcode != 0xcb)
-        {
-            // DDCBxxxx and FDCBxxxx increment R only by 2 instead of 3
-            const auto r = m_registers.ir.low;
-            m_registers.ir.low = (((r & 0x7f) + 1) & 0x7f) | (r & 0x80);
-        }
+        const auto r = m_registers.ir.low;
+        m_registers.ir.low = (((r & 0x7f) + 1) & 0x7f) | (r & 0x80);
         return opcode;
     }
 
     uint8_t Z80Cpu::busRead(const uint16_t address)
     {
+        contend(address);
         m_remainingCycles += 3;
+        if (m_breakpoints) [[unlikely]]
+            m_breakpoints->checkRead(address, m_registers);
         return m_bus.read(address);
     }
 
     void Z80Cpu::busWrite(const uint16_t address, const uint8_t value)
     {
+        contend(address);
         m_remainingCycles += 3;
+        m_loopSideEffects = true;
+        if (m_breakpoints) [[unlikely]]
+            m_breakpoints->checkWrite(address, m_registers);
         m_bus.write(address, value);
     }
 
     uint8_t Z80Cpu::ioRead(const uint16_t port)
     {
-        m_remainingCycles += 4;
-        return m_bus.ioRead(port);
+        ioContend(port);
+        if (m_breakpoints) [[unlikely]]
+            m_breakpoints->checkIo(Z80BreakpointType::ioRead, port, m_registers);
+        const auto value = m_bus.ioRead(port);
+        if (m_loopIoReadsCount < MaxLoopIoReads)
+        {
+            m_loopIoReads[m_loopIoReadsCount++] = static_cast<uint32_t>(port << 8) | value;
+        }
+        else
+        {
+            m_loopSideEffects = true;
+        }
+        return value;
     }
 
     void Z80Cpu::ioWrite(const uint16_t port, const uint8_t value)
     {
-        m_remainingCycles += 4;
+        ioContend(port);
+        m_loopSideEffects = true;
+        if (m_breakpoints) [[unlikely]]
+            m_breakpoints->checkIo(Z80BreakpointType::ioWrite, port, m_registers);
         m_bus.ioWrite(port, value);
     }
 
@@ -213,18 +320,17 @@ namespace epoch::zxspectrum
                     break;
                 case 0b001:
                     // EX AF, AF'
-                    std::swap(m_registers.af.low, m_registers.af2.low);
-                    std::swap(m_registers.af.high, m_registers.af2.high);
+                    std::swap(m_registers.af.word, m_registers.af2.word);
                     break;
                 case 0b010:
                     // DJNZ d
                     {
+                        contendInternal(m_registers.ir.word, 1);
                         const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
-                        m_remainingCycles++;
                         m_registers.bc.high--;
                         if (m_registers.bc.high != 0)
                         {
-                            m_remainingCycles += 5;
+                            contendInternal(m_registers.pc - 1, 5);
                             m_registers.wz = m_registers.pc += d;
                         }
                     }
@@ -261,7 +367,7 @@ namespace epoch::zxspectrum
                     break;
                 case 0b001:
                     // ADD HL, BC
-                    m_remainingCycles += 7;
+                    contendInternal(m_registers.ir.word, 7);
                     setHL(add16(getHL(), m_registers.bc));
                     break;
                 case 0b010:
@@ -270,7 +376,7 @@ namespace epoch::zxspectrum
                     break;
                 case 0b011:
                     // ADD HL, DE
-                    m_remainingCycles += 7;
+                    contendInternal(m_registers.ir.word, 7);
                     setHL(add16(getHL(), m_registers.de));
                     break;
                 case 0b100:
@@ -279,7 +385,7 @@ namespace epoch::zxspectrum
                     break;
                 case 0b101:
                     // ADD HL, HL
-                    m_remainingCycles += 7;
+                    contendInternal(m_registers.ir.word, 7);
                     setHL(add16(getHL(), getHL()));
                     break;
                 case 0b110:
@@ -288,7 +394,7 @@ namespace epoch::zxspectrum
                     break;
                 case 0b111:
                     // ADD HL, SP
-                    m_remainingCycles += 7;
+                    contendInternal(m_registers.ir.word, 7);
                     setHL(add16(getHL(), m_registers.sp));
                     break;
             }
@@ -390,7 +496,7 @@ namespace epoch::zxspectrum
                     m_registers.sp--;
                     break;
             }
-            m_remainingCycles += 2;
+            contendInternal(m_registers.ir.word, 2);
         }
         else if (z == 0b100)
         {
@@ -405,27 +511,29 @@ namespace epoch::zxspectrum
                 {
                     case Z80OpcodePrefix::none:
                         n = busRead(m_registers.hl);
-                        m_remainingCycles++;
+                        contendInternal(m_registers.hl, 1);
                         busWrite(m_registers.hl, n + 1);
                         break;
                     case Z80OpcodePrefix::ix:
                         d = static_cast<int8_t>(busRead(m_registers.pc++));
-                        m_remainingCycles += 6;
+                        contendInternal(m_registers.pc - 1, 5);
                         n = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d));
-                        busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d), n + 1);
+                        contendInternal(m_registers.wz, 1);
+                        busWrite(m_registers.wz, n + 1);
                         break;
                     case Z80OpcodePrefix::iy:
                         d = static_cast<int8_t>(busRead(m_registers.pc++));
-                        m_remainingCycles += 6;
+                        contendInternal(m_registers.pc - 1, 5);
                         n = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d));
-                        busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d), n + 1);
+                        contendInternal(m_registers.wz, 1);
+                        busWrite(m_registers.wz, n + 1);
                         break;
                 }
                 add8(n, 1);
             }
             else
             {
-                const auto n = (*m_registersPointers[static_cast<int>(m_currentPrefix)][y])++;
+                const auto n = register8(y)++;
                 add8(n, 1);
             }
             m_registers.af.c(c);  // restore carry
@@ -443,27 +551,29 @@ namespace epoch::zxspectrum
                 {
                     case Z80OpcodePrefix::none:
                         n = busRead(m_registers.hl);
-                        m_remainingCycles++;
+                        contendInternal(m_registers.hl, 1);
                         busWrite(m_registers.hl, n - 1);
                         break;
                     case Z80OpcodePrefix::ix:
                         d = static_cast<int8_t>(busRead(m_registers.pc++));
-                        m_remainingCycles += 6;
+                        contendInternal(m_registers.pc - 1, 5);
                         n = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d));
-                        busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d), n - 1);
+                        contendInternal(m_registers.wz, 1);
+                        busWrite(m_registers.wz, n - 1);
                         break;
                     case Z80OpcodePrefix::iy:
                         d = static_cast<int8_t>(busRead(m_registers.pc++));
-                        m_remainingCycles += 6;
+                        contendInternal(m_registers.pc - 1, 5);
                         n = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d));
-                        busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d), n - 1);
+                        contendInternal(m_registers.wz, 1);
+                        busWrite(m_registers.wz, n - 1);
                         break;
                 }
                 sub8(n, 1);
             }
             else
             {
-                const auto n = (*m_registersPointers[static_cast<int>(m_currentPrefix)][y])--;
+                const auto n = register8(y)--;
                 sub8(n, 1);
             }
             m_registers.af.c(c);  // restore carry
@@ -484,7 +594,7 @@ namespace epoch::zxspectrum
                     {
                         const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
                         const auto value = busRead(m_registers.pc++);
-                        m_remainingCycles += 2;
+                        contendInternal(m_registers.pc - 1, 2);
                         busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d), value);
                         break;
                     }
@@ -492,7 +602,7 @@ namespace epoch::zxspectrum
                     {
                         const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
                         const auto value = busRead(m_registers.pc++);
-                        m_remainingCycles += 2;
+                        contendInternal(m_registers.pc - 1, 2);
                         busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d), value);
                         break;
                     }
@@ -500,7 +610,7 @@ namespace epoch::zxspectrum
             }
             else
             {
-                *m_registersPointers[static_cast<int>(m_currentPrefix)][y] = busRead(m_registers.pc++);
+                register8(y) = busRead(m_registers.pc++);
             }
         }
         else  // if (z == 0b111)
@@ -597,11 +707,13 @@ namespace epoch::zxspectrum
             {
                 // HALT
                 m_registers.pc--;
+                // Every repetition is a 4 T-states opcode fetch
+                fastForward(4, 1, m_contention->pages[m_registers.pc >> 14]);
             }
             else
             {
                 // LD dst, (HL)
-                *m_registersPointers[0][dst] = busReadHL();
+                register8Unprefixed(dst) = busReadHL();
             }
         }
         else
@@ -609,14 +721,12 @@ namespace epoch::zxspectrum
             if (dst == 0b110)
             {
                 // LD (HL), src
-                busWriteHL(*m_registersPointers[0][src]);
+                busWriteHL(register8Unprefixed(src));
             }
             else
             {
-                const uint8_t* srcPtr = m_registersPointers[static_cast<int>(m_currentPrefix)][src];
-                uint8_t* dstPtr = m_registersPointers[static_cast<int>(m_currentPrefix)][dst];
                 // LD dst, src
-                *dstPtr = *srcPtr;
+                register8(dst) = register8(src);
             }
         }
     }
@@ -625,7 +735,6 @@ namespace epoch::zxspectrum
     {
         const auto operation = (m_opcode & 0b00111000) >> 3;
         const auto src = (m_opcode & 0b00000111);
-        const uint8_t* srcPtr = m_registersPointers[static_cast<int>(m_currentPrefix)][src];
         const auto a = m_registers.af.high;
         uint8_t b;
         if (src == 0b110)
@@ -634,7 +743,7 @@ namespace epoch::zxspectrum
         }
         else
         {
-            b = *srcPtr;
+            b = register8(src);
         }
         alu8(operation, a, b);
     }
@@ -646,7 +755,7 @@ namespace epoch::zxspectrum
         if (z == 0b000)
         {
             // RET [cond]
-            m_remainingCycles++;
+            contendInternal(m_registers.ir.word, 1);
             if (evaluateCondition(y))
             {
                 m_registers.wz = m_registers.pc = pop16();
@@ -670,12 +779,9 @@ namespace epoch::zxspectrum
                     break;
                 case 0b011:
                     // EXX
-                    std::swap(m_registers.bc.low, m_registers.bc2.low);
-                    std::swap(m_registers.bc.high, m_registers.bc2.high);
-                    std::swap(m_registers.de.low, m_registers.de2.low);
-                    std::swap(m_registers.de.high, m_registers.de2.high);
-                    std::swap(m_registers.hl.low, m_registers.hl2.low);
-                    std::swap(m_registers.hl.high, m_registers.hl2.high);
+                    std::swap(m_registers.bc.word, m_registers.bc2.word);
+                    std::swap(m_registers.de.word, m_registers.de2.word);
+                    std::swap(m_registers.hl.word, m_registers.hl2.word);
                     break;
                 case 0b100:
                     // POP HL
@@ -692,8 +798,7 @@ namespace epoch::zxspectrum
                 case 0b111:
                     // LD SP, HL
                     m_registers.sp = getHL();
-                    m_remainingCycles++;
-                    m_remainingCycles++;
+                    contendInternal(m_registers.ir.word, 2);
                     break;
             }
         }
@@ -701,11 +806,13 @@ namespace epoch::zxspectrum
         {
             // JP[cond] nn
             const auto nn = fetch16();
+            m_registers.wz = nn;
             if (evaluateCondition(y))
             {
+                const auto backward = nn < m_registers.pc;
                 m_registers.pc = nn;
+                if (backward) loopBranch();
             }
-            m_registers.wz = nn;
         }
         else if (z == 0b011)
         {
@@ -713,7 +820,12 @@ namespace epoch::zxspectrum
             {
                 case 0b000:
                     // JP nn
-                    m_registers.wz = m_registers.pc = fetch16();
+                    {
+                        const auto nn = fetch16();
+                        const auto backward = nn < m_registers.pc;
+                        m_registers.wz = m_registers.pc = nn;
+                        if (backward) loopBranch();
+                    }
                     break;
                 case 0b001:
                     // CB prefix
@@ -739,19 +851,18 @@ namespace epoch::zxspectrum
                     // EX (SP), HL
                     {
                         const auto low = busRead(m_registers.sp);
-                        m_remainingCycles++;
                         const auto high = busRead(m_registers.sp + 1);
+                        contendInternal(m_registers.sp + 1, 1);
                         const auto value = getHL();
-                        busWrite(m_registers.sp, value & 0xff);
                         busWrite(m_registers.sp + 1, value >> 8);
-                        m_remainingCycles += 2;
+                        busWrite(m_registers.sp, value & 0xff);
+                        contendInternal(m_registers.sp, 2);
                         setHL(m_registers.wz = static_cast<uint16_t>(high << 8) | low);
                     }
                     break;
                 case 0b101:
                     // EX DE, HL
-                    std::swap(m_registers.de.low, m_registers.hl.low);
-                    std::swap(m_registers.de.high, m_registers.hl.high);
+                    std::swap(m_registers.de.word, m_registers.hl.word);
                     break;
                 case 0b110:
                     // DI
@@ -770,7 +881,7 @@ namespace epoch::zxspectrum
             const auto nn = fetch16();
             if (evaluateCondition(y))
             {
-                m_remainingCycles++;
+                contendInternal(m_registers.pc - 1, 1);
                 push16(m_registers.pc);
                 m_registers.pc = nn;
             }
@@ -782,22 +893,22 @@ namespace epoch::zxspectrum
             {
                 case 0b000:
                     // PUSH BC
+                    contendInternal(m_registers.ir.word, 1);
                     push16(m_registers.bc);
-                    m_remainingCycles++;
                     break;
                 case 0b001:
                     // CALL nn
                     {
                         const auto nn = fetch16();
-                        m_remainingCycles++;
+                        contendInternal(m_registers.pc - 1, 1);
                         push16(m_registers.pc);
                         m_registers.wz = m_registers.pc = nn;
                     }
                     break;
                 case 0b010:
                     // PUSH DE
+                    contendInternal(m_registers.ir.word, 1);
                     push16(m_registers.de);
-                    m_remainingCycles++;
                     break;
                 case 0b011:
                     // DD prefix
@@ -805,8 +916,8 @@ namespace epoch::zxspectrum
                     break;
                 case 0b100:
                     // PUSH HL
+                    contendInternal(m_registers.ir.word, 1);
                     push16(getHL());
-                    m_remainingCycles++;
                     break;
                 case 0b101:
                     // ED prefix
@@ -814,8 +925,8 @@ namespace epoch::zxspectrum
                     break;
                 case 0b110:
                     // PUSH AF
+                    contendInternal(m_registers.ir.word, 1);
                     push16(m_registers.af);
-                    m_remainingCycles++;
                     break;
                 case 0b111:
                     // FD prefix
@@ -833,7 +944,7 @@ namespace epoch::zxspectrum
         else  // if (z == 0b111)
         {
             // RST xx
-            m_remainingCycles++;
+            contendInternal(m_registers.ir.word, 1);
             push16(m_registers.pc);
             static constexpr uint16_t targets[] = {0x00, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38};
             m_registers.wz = m_registers.pc = targets[y];
@@ -845,10 +956,20 @@ namespace epoch::zxspectrum
         int8_t d = 0;
         if (m_currentPrefix != Z80OpcodePrefix::none)
         {
-            m_remainingCycles += 4;
-            d = static_cast<int8_t>(m_bus.read(m_registers.pc++));
+            // DDCB d op: the opcode after the displacement is read by a normal memory cycle, so R is not incremented
+            d = static_cast<int8_t>(busRead(m_registers.pc++));
+            m_opcode = busRead(m_registers.pc);
+            contendInternal(m_registers.pc++, 2);
         }
-        m_opcode = fetchOpcode();
+        else
+        {
+            m_opcode = fetchOpcode();
+        }
+#ifdef EPOCH_CPU_STATISTICS
+        static constexpr Z80StatisticsTable prefixTables[] = {
+            Z80StatisticsTable::cb, Z80StatisticsTable::ddcb, Z80StatisticsTable::fdcb};
+        m_statisticsTable = prefixTables[static_cast<int>(m_currentPrefix)];
+#endif
         const uint8_t x = m_opcode >> 6;
         const uint8_t y = (m_opcode & 0b00111000) >> 3;
         const uint8_t z = m_opcode & 0b00000111;
@@ -942,6 +1063,9 @@ namespace epoch::zxspectrum
     {
         m_currentPrefix = Z80OpcodePrefix::none;
         m_opcode = fetchOpcode();
+#ifdef EPOCH_CPU_STATISTICS
+        m_statisticsTable = Z80StatisticsTable::ed;
+#endif
         const auto x = m_opcode >> 6;
         const auto y = (m_opcode & 0b00111000) >> 3;
         const auto z = (m_opcode & 0b00000111);
@@ -1035,42 +1159,42 @@ namespace epoch::zxspectrum
                     case 0b000:
                         // SBC HL, BC
                         m_registers.hl = sub16(m_registers.hl, m_registers.bc, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b001:
                         // ADC HL, BC
                         m_registers.hl = add16(m_registers.hl, m_registers.bc, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b010:
                         // SBC HL, DE
                         m_registers.hl = sub16(m_registers.hl, m_registers.de, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b011:
                         // ADC HL, DE
                         m_registers.hl = add16(m_registers.hl, m_registers.de, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b100:
                         // SBC HL, HL
                         m_registers.hl = sub16(m_registers.hl, m_registers.hl, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b101:
                         // ADC HL, HL
                         m_registers.hl = add16(m_registers.hl, m_registers.hl, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b110:
                         // SBC HL, SP
                         m_registers.hl = sub16(m_registers.hl, m_registers.sp, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                     case 0b111:
                         // ADC HL, SP
                         m_registers.hl = add16(m_registers.hl, m_registers.sp, m_registers.af.c());
-                        m_remainingCycles += 7;
+                        contendInternal(m_registers.ir.word, 7);
                         break;
                 }
             }
@@ -1152,12 +1276,12 @@ namespace epoch::zxspectrum
                     case 0b000:
                         // LD I, A
                         m_registers.ir.high = m_registers.af.high;
-                        m_remainingCycles++;
+                        contendInternal(m_registers.ir.word, 1);
                         break;
                     case 0b001:
                         // LD R, A
                         m_registers.ir.low = m_registers.af.high;
-                        m_remainingCycles++;
+                        contendInternal(m_registers.ir.word, 1);
                         break;
                     case 0b010:
                         // LD A, I
@@ -1171,7 +1295,7 @@ namespace epoch::zxspectrum
                             m_registers.af.x(value & Z80Flags::x);
                             m_registers.af.p(m_registers.iff2);
                             m_registers.af.n(false);
-                            m_remainingCycles++;
+                            contendInternal(m_registers.ir.word, 1);
                         }
                         break;
                     case 0b011:
@@ -1186,15 +1310,15 @@ namespace epoch::zxspectrum
                             m_registers.af.x(value & Z80Flags::x);
                             m_registers.af.p(m_registers.iff2);
                             m_registers.af.n(false);
-                            m_remainingCycles++;
+                            contendInternal(m_registers.ir.word, 1);
                         }
                         break;
                     case 0b100:
                         // RRD
-                        m_remainingCycles += 4;
                         {
                             const auto a = m_registers.af.high;
                             const auto n = busRead(m_registers.hl);
+                            contendInternal(m_registers.hl, 4);
                             const auto res = static_cast<uint8_t>((a & 0xf0) | (n & 0x0f));
                             m_registers.af.high = res;
                             busWrite(m_registers.hl, static_cast<uint8_t>(a << 4 | n >> 4));
@@ -1204,10 +1328,10 @@ namespace epoch::zxspectrum
                         break;
                     case 0b101:
                         // RLD
-                        m_remainingCycles += 4;
                         {
                             const auto a = m_registers.af.high;
                             const auto n = busRead(m_registers.hl);
+                            contendInternal(m_registers.hl, 4);
                             const auto res = static_cast<uint8_t>((a & 0xf0) | n >> 4);
                             m_registers.af.high = res;
                             busWrite(m_registers.hl, static_cast<uint8_t>(n << 4 | (a & 0x0f)));
@@ -1239,24 +1363,32 @@ namespace epoch::zxspectrum
                         break;
                     case 0b110:
                         // LDIR
-                        ldi();
-                        if (m_registers.af.p())
                         {
-                            m_registers.wz = (m_registers.pc -= 2) + 1;
-                            m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
-                            m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
-                            m_remainingCycles += 5;
+                            const auto repeated = blockLoad(1);
+                            ldi();
+                            if (m_registers.af.p())
+                            {
+                                m_registers.wz = (m_registers.pc -= 2) + 1;
+                                m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
+                                m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
+                                contendInternal(static_cast<uint16_t>(m_registers.de - 1), 5);
+                            }
+                            m_remainingCycles += repeated * 21;
                         }
                         break;
                     case 0b111:
                         // LDDR
-                        ldd();
-                        if (m_registers.af.p())
                         {
-                            m_registers.wz = (m_registers.pc -= 2) + 1;
-                            m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
-                            m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
-                            m_remainingCycles += 5;
+                            const auto repeated = blockLoad(-1);
+                            ldd();
+                            if (m_registers.af.p())
+                            {
+                                m_registers.wz = (m_registers.pc -= 2) + 1;
+                                m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
+                                m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
+                                contendInternal(static_cast<uint16_t>(m_registers.de + 1), 5);
+                            }
+                            m_remainingCycles += repeated * 21;
                         }
                         break;
                         // Rest is NOP
@@ -1278,26 +1410,34 @@ namespace epoch::zxspectrum
                         break;
                     case 0b110:
                         // CPIR
-                        cpi();
-                        m_registers.wz++;
-                        if (m_registers.af.p() && !m_registers.af.z())
                         {
-                            m_registers.wz = (m_registers.pc -= 2) + 1;
-                            m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
-                            m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
-                            m_remainingCycles += 5;
+                            const auto repeated = blockCompare(1);
+                            cpi();
+                            m_registers.wz++;
+                            if (m_registers.af.p() && !m_registers.af.z())
+                            {
+                                m_registers.wz = (m_registers.pc -= 2) + 1;
+                                m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
+                                m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
+                                contendInternal(static_cast<uint16_t>(m_registers.hl - 1), 5);
+                            }
+                            m_remainingCycles += repeated * 21;
                         }
                         break;
                     case 0b111:
                         // CPDR
-                        cpd();
-                        m_registers.wz--;
-                        if (m_registers.af.p() && !m_registers.af.z())
                         {
-                            m_registers.wz = (m_registers.pc -= 2) + 1;
-                            m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
-                            m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
-                            m_remainingCycles += 5;
+                            const auto repeated = blockCompare(-1);
+                            cpd();
+                            m_registers.wz--;
+                            if (m_registers.af.p() && !m_registers.af.z())
+                            {
+                                m_registers.wz = (m_registers.pc -= 2) + 1;
+                                m_registers.af.x(m_registers.wz & (Z80Flags::x << 8));
+                                m_registers.af.y(m_registers.wz & (Z80Flags::y << 8));
+                                contendInternal(static_cast<uint16_t>(m_registers.hl + 1), 5);
+                            }
+                            m_remainingCycles += repeated * 21;
                         }
                         break;
                         // Rest is NOP
@@ -1324,7 +1464,7 @@ namespace epoch::zxspectrum
                         if (!m_registers.af.z())
                         {
                             m_registers.pc -= 2;
-                            m_remainingCycles += 5;
+                            contendInternal(static_cast<uint16_t>(m_registers.hl - 1), 5);
                         }
                         break;
                     case 0b111:
@@ -1334,7 +1474,7 @@ namespace epoch::zxspectrum
                         if (!m_registers.af.z())
                         {
                             m_registers.pc -= 2;
-                            m_remainingCycles += 5;
+                            contendInternal(static_cast<uint16_t>(m_registers.hl + 1), 5);
                         }
                         break;
                         // Rest is NOP
@@ -1361,7 +1501,7 @@ namespace epoch::zxspectrum
                         if (!m_registers.af.z())
                         {
                             m_registers.pc -= 2;
-                            m_remainingCycles += 5;
+                            contendInternal(m_registers.bc, 5);
                         }
                         break;
                     case 0b111:
@@ -1371,7 +1511,7 @@ namespace epoch::zxspectrum
                         if (!m_registers.af.z())
                         {
                             m_registers.pc -= 2;
-                            m_remainingCycles += 5;
+                            contendInternal(m_registers.bc, 5);
                         }
                         break;
                         // Rest is NOP
@@ -1402,19 +1542,54 @@ namespace epoch::zxspectrum
         return 0;
     }
 
-    void Z80Cpu::setHL(const uint16_t value)
+    void Z80Cpu::setHL(const uint16_t value) { hlRegister().word = value; }
+
+    inline Z80Registers::WordRegister& Z80Cpu::hlRegister()
     {
         switch (m_currentPrefix)
         {
-            case Z80OpcodePrefix::none:
-                m_registers.hl = value;
-                break;
             case Z80OpcodePrefix::ix:
-                m_registers.ix = value;
-                break;
+                return m_registers.ix;
             case Z80OpcodePrefix::iy:
-                m_registers.iy = value;
-                break;
+                return m_registers.iy;
+            default:
+                return m_registers.hl;
+        }
+    }
+
+    inline uint8_t& Z80Cpu::register8(const int index)
+    {
+        // H and L are replaced by the index register halves when a DD/FD prefix is active
+        switch (index)
+        {
+            case 4:
+                return hlRegister().high;
+            case 5:
+                return hlRegister().low;
+            default:
+                return register8Unprefixed(index);
+        }
+    }
+
+    inline uint8_t& Z80Cpu::register8Unprefixed(const int index)
+    {
+        assert(index != 0b110);
+        switch (index)
+        {
+            case 0:
+                return m_registers.bc.high;
+            case 1:
+                return m_registers.bc.low;
+            case 2:
+                return m_registers.de.high;
+            case 3:
+                return m_registers.de.low;
+            case 4:
+                return m_registers.hl.high;
+            case 5:
+                return m_registers.hl.low;
+            default:
+                return m_registers.af.high;
         }
     }
 
@@ -1427,13 +1602,13 @@ namespace epoch::zxspectrum
             case Z80OpcodePrefix::ix:
             {
                 const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
-                m_remainingCycles += 5;
+                contendInternal(m_registers.pc - 1, 5);
                 return busRead(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d));
             }
             case Z80OpcodePrefix::iy:
             {
                 const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
-                m_remainingCycles += 5;
+                contendInternal(m_registers.pc - 1, 5);
                 return busRead(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d));
             }
         }
@@ -1450,13 +1625,13 @@ namespace epoch::zxspectrum
             case Z80OpcodePrefix::ix:
             {
                 const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
-                m_remainingCycles += 5;
+                contendInternal(m_registers.pc - 1, 5);
                 return busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d), value);
             }
             case Z80OpcodePrefix::iy:
             {
                 const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
-                m_remainingCycles += 5;
+                contendInternal(m_registers.pc - 1, 5);
                 return busWrite(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d), value);
             }
         }
@@ -1681,11 +1856,71 @@ namespace epoch::zxspectrum
         const auto d = static_cast<int8_t>(busRead(m_registers.pc++));
         if (condition)
         {
-            m_remainingCycles += 5;
+            contendInternal(m_registers.pc - 1, 5);
             m_registers.wz = m_registers.pc += d;
+            if (d < 0) loopBranch();
         }
     }
 
+    void Z80Cpu::loopBranch()
+    {
+        // The state after a taken backward jump recurring with no writes, no contended accesses and the same IO
+        // results means the code in between is polling: it will run identically until something external changes
+        const auto clock = m_clockCounter + m_remainingCycles;
+        if (m_loopStableIterations >= 0 && !m_loopSideEffects && sameLoopState(m_registers, m_loopRegisters))
+        {
+            if (m_loopStableIterations > 0 && m_loopIoReadsCount == m_loopPreviousIoReadsCount &&
+                std::equal(m_loopIoReads.begin(), m_loopIoReads.begin() + m_loopIoReadsCount,
+                           m_loopPreviousIoReads.begin()))
+            {
+                const auto refresh = (m_registers.ir.low - m_loopRegisters.ir.low) & 0x7f;
+                fastForward(static_cast<int>(clock - m_loopClock), refresh, m_loopContended);
+            }
+            m_loopStableIterations++;
+        }
+        else
+        {
+            m_loopStableIterations = 0;
+        }
+        m_loopRegisters = m_registers;
+        m_loopClock = m_clockCounter + m_remainingCycles;
+        m_loopSideEffects = false;
+        m_loopContended = false;
+        m_loopPreviousIoReads = m_loopIoReads;
+        m_loopPreviousIoReadsCount = m_loopIoReadsCount;
+        m_loopIoReadsCount = 0;
+    }
+
+    void Z80Cpu::fastForward(const int iterationCycles, const int iterationRefresh, const bool contended)
+    {
+        // Repeats the last iteration as many times as possible before the next event the CPU could observe, with
+        // the interrupt check only happening at instruction boundaries the result is the same as executing them.
+        // Iterations touching contended memory can only be repeated while the delays are known to be zero.
+        // Breakpoints must see every iteration.
+        if (m_interruptRequested || m_breakpoints) return;
+        auto horizon = m_bus.cyclesToNextEvent();
+        if (contended) horizon = std::min(horizon, cyclesToContention());
+        const auto iterations = (static_cast<int>(horizon) - m_remainingCycles) / iterationCycles;
+        if (iterations <= 0) return;
+        m_remainingCycles += iterations * iterationCycles;
+        const auto r = m_registers.ir.low;
+        m_registers.ir.low = static_cast<uint8_t>(((r + iterations * iterationRefresh) & 0x7f) | (r & 0x80));
+    }
+
+    std::size_t Z80Cpu::cyclesToContention() const
+    {
+        const auto t = m_contention->frameTState;
+        if (t < m_contention->activeStart)
+        {
+            return m_contention->activeStart - t;
+        }
+        if (t >= m_contention->activeEnd)
+        {
+            return m_contention->frameLength - t + m_contention->activeStart;
+        }
+        return 0;
+    }
+
     void Z80Cpu::push16(const uint16_t value)
     {
         busWrite(--m_registers.sp, value >> 8);
@@ -1699,6 +1934,117 @@ namespace epoch::zxspectrum
         return static_cast<uint16_t>(high << 8) | low;
     }
 
+    int Z80Cpu::blockIterations(const int count, const bool contended) const
+    {
+        // Repetitions of a 21 T-states block instruction that can be executed at once before the current one without
+        // skipping an interrupt check that could succeed. The current repetition takes up to 13 more T-states.
+        constexpr int IterationCycles = 21;
+        constexpr int LastIterationCycles = 13;
+        if (count <= 0 || m_breakpoints) return 0;
+        auto horizon = std::numeric_limits<std::size_t>::max();
+        if (m_registers.iff1)
+        {
+            horizon = m_interruptRequested ? 0 : m_bus.cyclesToNextEvent();
+        }
+        if (contended)
+        {
+            horizon = std::min(horizon, cyclesToContention());
+        }
+        if (horizon == std::numeric_limits<std::size_t>::max()) return count;
+        const auto available = static_cast<int64_t>(horizon) - m_remainingCycles - LastIterationCycles;
+        return static_cast<int>(std::clamp<int64_t>(available / IterationCycles, 0, count));
+    }
+
+    int Z80Cpu::blockLoad(const int direction)
+    {
+        // All the repetitions but the last one, which is executed normally and sets flags and WZ
+        const auto hl = m_registers.hl.word;
+        const auto de = m_registers.de.word;
+        const auto inPage = [direction](const uint16_t address) {
+            return direction > 0 ? PageSize - (address & (PageSize - 1)) : (address & (PageSize - 1)) + 1;
+        };
+        auto count = static_cast<int>(m_registers.bc.word == 0 ? 0x10000 : m_registers.bc.word) - 1;
+        count = std::min({count, inPage(hl), inPage(de)});
+        if (count <= 0) return 0;
+        const auto* src = m_bus.readPage(hl >> 14);
+        auto* dst = m_bus.writePage(de >> 14);
+        if (src == nullptr || dst == nullptr) return 0;
+        const auto contended =
+            m_contention->pages[m_registers.pc >> 14] || m_contention->pages[hl >> 14] || m_contention->pages[de >> 14];
+        count = blockIterations(count, contended);
+        if (count == 0) return 0;
+
+        src += hl & (PageSize - 1);
+        dst += de & (PageSize - 1);
+        // Byte by byte when the destination is inside the part of the source still to be copied (LDIR fill idiom)
+        const auto distance = (reinterpret_cast<intptr_t>(dst) - reinterpret_cast<intptr_t>(src)) * direction;
+        if (distance > 0 && distance < count)
+        {
+            for (auto i = 0; i < count; i++, src += direction, dst += direction)
+            {
+                *dst = *src;
+            }
+        }
+        else if (direction > 0)
+        {
+            std::memmove(dst, src, count);
+        }
+        else
+        {
+            std::memmove(dst - count + 1, src - count + 1, count);
+        }
+
+        m_registers.hl.word = static_cast<uint16_t>(hl + direction * count);
+        m_registers.de.word = static_cast<uint16_t>(de + direction * count);
+        m_registers.bc.word = static_cast<uint16_t>(m_registers.bc.word - count);
+        m_registers.wz = m_registers.pc - 1;
+        const auto r = m_registers.ir.low;
+        m_registers.ir.low = static_cast<uint8_t>(((r + count * 2) & 0x7f) | (r & 0x80));
+        m_loopSideEffects = true;
+        return count;
+    }
+
+    int Z80Cpu::blockCompare(const int direction)
+    {
+        // All the repetitions not matching A but the last one, which is executed normally and sets flags and WZ
+        const auto hl = m_registers.hl.word;
+        auto count = static_cast<int>(m_registers.bc.word == 0 ? 0x10000 : m_registers.bc.word) - 1;
+        count = std::min(count, direction > 0 ? PageSize - (hl & (PageSize - 1))
+                                              : (hl & (PageSize - 1)) + 1);
+        if (count <= 0) return 0;
+        const auto* src = m_bus.readPage(hl >> 14);
+        if (src == nullptr) return 0;
+        count = blockIterations(count, m_contention->pages[m_registers.pc >> 14] || m_contention->pages[hl >> 14]);
+        if (count == 0) return 0;
+
+        src += hl & (PageSize - 1);
+        const auto a = m_registers.af.high;
+        if (direction > 0)
+        {
+            const auto* found = static_cast<const uint8_t*>(std::memchr(src, a, count));
+            if (found != nullptr) count = static_cast<int>(found - src);
+        }
+        else
+        {
+            for (auto i = 0; i < count; i++)
+            {
+                if (src[-i] == a)
+                {
+                    count = i;
+                    break;
+                }
+            }
+        }
+        if (count == 0) return 0;
+
+        m_registers.hl.word = static_cast<uint16_t>(hl + direction * count);
+        m_registers.bc.word = static_cast<uint16_t>(m_registers.bc.word - count);
+        m_registers.wz = m_registers.pc - 1;
+        const auto r = m_registers.ir.low;
+        m_registers.ir.low = static_cast<uint8_t>(((r + count * 2) & 0x7f) | (r & 0x80));
+        return count;
+    }
+
     void Z80Cpu::ldi()
     {
         const auto n = busRead(m_registers.hl);
@@ -1712,7 +2058,7 @@ namespace epoch::zxspectrum
         m_registers.af.x(an & (1 << 3));
         m_registers.af.n(false);
         m_registers.af.p(m_registers.bc);
-        m_remainingCycles += 2;
+        contendInternal(static_cast<uint16_t>(m_registers.de - 1), 2);
     }
 
     void Z80Cpu::ldd()
@@ -1728,7 +2074,7 @@ namespace epoch::zxspectrum
         m_registers.af.x(an & (1 << 3));
         m_registers.af.n(false);
         m_registers.af.p(m_registers.bc);
-        m_remainingCycles += 2;
+        contendInternal(static_cast<uint16_t>(m_registers.de + 1), 2);
     }
 
     void Z80Cpu::cpi()
@@ -1744,7 +2090,7 @@ namespace epoch::zxspectrum
         m_registers.bc = m_registers.bc - 1;
         m_registers.af.p(m_registers.bc);
         m_registers.af.c(c);
-        m_remainingCycles += 5;
+        contendInternal(static_cast<uint16_t>(m_registers.hl - 1), 5);
     }
 
     void Z80Cpu::cpd()
@@ -1760,12 +2106,12 @@ namespace epoch::zxspectrum
         m_registers.bc = m_registers.bc - 1;
         m_registers.af.p(m_registers.bc);
         m_registers.af.c(c);
-        m_remainingCycles += 5;
+        contendInternal(static_cast<uint16_t>(m_registers.hl + 1), 5);
     }
 
     void Z80Cpu::ini()
     {
-        m_remainingCycles++;
+        contendInternal(m_registers.ir.word, 1);
         const auto n = ioRead(m_registers.bc);  // use BC before decrementing B
         const auto b = --m_registers.bc.high;
         const auto c = m_registers.bc.low;
@@ -1784,7 +2130,7 @@ namespace epoch::zxspectrum
 
     void Z80Cpu::ind()
     {
-        m_remainingCycles++;
+        contendInternal(m_registers.ir.word, 1);
         const auto n = ioRead(m_registers.bc);  // use BC before decrementing B
         const auto b = --m_registers.bc.high;
         const auto c = m_registers.bc.low;
@@ -1803,7 +2149,7 @@ namespace epoch::zxspectrum
 
     void Z80Cpu::outi()
     {
-        m_remainingCycles++;
+        contendInternal(m_registers.ir.word, 1);
         const auto n = busRead(m_registers.hl);
         m_registers.hl = m_registers.hl + 1;
 
@@ -1822,7 +2168,7 @@ namespace epoch::zxspectrum
 
     void Z80Cpu::outd()
     {
-        m_remainingCycles++;
+        contendInternal(m_registers.ir.word, 1);
         const auto n = busRead(m_registers.hl);
         m_registers.hl = m_registers.hl - 1;
 
@@ -1846,20 +2192,27 @@ namespace epoch::zxspectrum
             case Z80OpcodePrefix::none:
                 if (z == 0b110)
                 {
-                    m_remainingCycles++;
                     // (HL)
-                    return busRead(m_registers.hl);
+                    const auto value = busRead(m_registers.hl);
+                    contendInternal(m_registers.hl, 1);
+                    return value;
                 }
                 else
                 {
-                    return *m_registersPointers[0][z];
+                    return register8Unprefixed(z);
                 }
             case Z80OpcodePrefix::ix:
-                m_remainingCycles++;
-                return busRead(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d));
+            {
+                const auto value = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.ix + d));
+                contendInternal(m_registers.wz, 1);
+                return value;
+            }
             case Z80OpcodePrefix::iy:
-                m_remainingCycles++;
-                return busRead(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d));
+            {
+                const auto value = busRead(m_registers.wz = static_cast<uint16_t>(m_registers.iy + d));
+                contendInternal(m_registers.wz, 1);
+                return value;
+            }
         }
         assert(false);
         return 0;
@@ -1886,7 +2239,7 @@ namespace epoch::zxspectrum
         }
         else
         {
-            *m_registersPointers[0][z] = value;
+            register8Unprefixed(z) = value;
             switch (m_currentPrefix)
             {
                 case Z80OpcodePrefix::none:
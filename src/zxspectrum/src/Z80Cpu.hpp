@@ -18,10 +18,20 @@
 #define SRC_EPOCH_ZXSPECTRUM_Z80CPU_HPP_
 
 #include "Z80Interface.hpp"
+#ifdef EPOCH_CPU_STATISTICS
+#include "Z80Statistics.hpp"
+#endif
 
 #include <array>
+#include <bit>
 #include <cstdint>
 
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define EPOCH_Z80_BIG_ENDIAN 1
+#else
+#define EPOCH_Z80_BIG_ENDIAN 0
+#endif
+
 namespace epoch::zxspectrum
 {
     struct Z80Flags
@@ -42,18 +52,30 @@ namespace epoch::zxspectrum
 
     struct Z80Registers
     {
+        // 16-bit register pair, addressable either as a whole or through its two bytes without shifts.
         struct WordRegister
         {
             WordRegister() = default;
-            WordRegister(const uint16_t v) : low{static_cast<uint8_t>(v & 0xff)}, high{static_cast<uint8_t>(v >> 8)} {}
-            uint8_t low{};
-            uint8_t high{};
-            [[nodiscard]] uint16_t value() const
+            WordRegister(const uint16_t v) : word{v} {}
+
+            union
             {
-                return static_cast<uint16_t>(low) | static_cast<uint16_t>(high << 8);
-            }
+                uint16_t word{};
+                struct
+                {
+#if EPOCH_Z80_BIG_ENDIAN
+                    uint8_t high;
+                    uint8_t low;
+#else
+                    uint8_t low;
+                    uint8_t high;
+#endif
+                };
+            };
 
-            operator uint16_t() const { return value(); }
+            [[nodiscard]] uint16_t value() const { return word; }
+
+            operator uint16_t() const { return word; }
         };
 
         struct WordFlagsRegister : WordRegister
@@ -116,6 +138,14 @@ namespace epoch::zxspectrum
         bool interruptJustEnabled{false};
     };
 
+    static_assert((std::endian::native == std::endian::big) == static_cast<bool>(EPOCH_Z80_BIG_ENDIAN),
+                  "Z80Registers byte layout does not match the host endianness");
+
+    class Z80Breakpoints;
+#ifdef EPOCH_TRACER
+    class Z80Tracer;
+#endif
+
     enum class Z80OpcodePrefix
     {
         none = 0,
@@ -139,6 +169,25 @@ namespace epoch::zxspectrum
         [[nodiscard]] const Z80Registers& registers() const { return m_registers; }
 
         [[nodiscard]] std::size_t clockCounter() const { return m_clockCounter; }
+        // Address of the instruction (or interrupt acceptance) the current T-state belongs to
+        [[nodiscard]] uint16_t instructionPc() const { return m_instructionPc; }
+
+        // Checks breakpoints before each instruction and on bus accesses, nullptr to disable the checks
+        void setBreakpoints(Z80Breakpoints* breakpoints) { m_breakpoints = breakpoints; }
+        [[nodiscard]] Z80Breakpoints* breakpoints() const { return m_breakpoints; }
+        // True when the last clock() did not run because a breakpoint was hit before the instruction at PC
+        [[nodiscard]] bool stopped() const { return m_stopped; }
+        [[nodiscard]] bool instructionBoundary() const { return m_remainingCycles == 0; }
+
+#ifdef EPOCH_CPU_STATISTICS
+        [[nodiscard]] Z80Statistics& statistics() { return m_statistics; }
+        [[nodiscard]] const Z80Statistics& statistics() const { return m_statistics; }
+#endif
+
+#ifdef EPOCH_TRACER
+        // Records every executed instruction into tracer, nullptr to stop tracing
+        void setTracer(Z80Tracer* tracer) { m_tracer = tracer; }
+#endif
 
     private:
         Z80Registers m_registers{};
@@ -146,15 +195,43 @@ namespace epoch::zxspectrum
         Z80OpcodePrefix m_currentPrefix{Z80OpcodePrefix::none};
         bool m_interruptRequested{};
         int m_remainingCycles{};
+        uint16_t m_instructionPc{};
         std::size_t m_clockCounter{};
 
         Z80Interface& m_bus;
+        const Z80Contention* m_contention;
+        Z80Breakpoints* m_breakpoints{};
+        bool m_stopped{};
+#ifdef EPOCH_TRACER
+        Z80Tracer* m_tracer{};
+#endif
+#ifdef EPOCH_CPU_STATISTICS
+        Z80Statistics m_statistics{};
+        Z80StatisticsTable m_statisticsTable{};
+#endif
 
-        std::array<std::array<uint8_t*, 8>, 3> m_registersPointers;
+        // Idle loop detection: CPU state after the last taken backward jump and what happened since then
+        static constexpr std::size_t MaxLoopIoReads = 4;
+        Z80Registers m_loopRegisters{};
+        std::size_t m_loopClock{};
+        int m_loopStableIterations{-1};  // -1 when not tracking
+        bool m_loopSideEffects{};
+        bool m_loopContended{};  // contended accesses that happened to have no delay
+        std::array<uint32_t, MaxLoopIoReads> m_loopIoReads{};
+        std::array<uint32_t, MaxLoopIoReads> m_loopPreviousIoReads{};
+        std::size_t m_loopIoReadsCount{};
+        std::size_t m_loopPreviousIoReadsCount{};
 
         void executeInstruction();
         void handleInterrupt();
 
+        void loopBranch();
+        void fastForward(int iterationCycles, int iterationRefresh, bool contended);
+        [[nodiscard]] std::size_t cyclesToContention() const;
+
+        void contend(uint16_t address);
+        void contendInternal(uint16_t address, int cycles);
+        void ioContend(uint16_t port);
         uint8_t fetchOpcode();
         uint8_t busRead(uint16_t address);
         void busWrite(uint16_t address, uint8_t value);
@@ -173,6 +250,9 @@ namespace epoch::zxspectrum
 
         [[nodiscard]] uint16_t getHL() const;
         void setHL(uint16_t value);
+        Z80Registers::WordRegister& hlRegister();
+        uint8_t& register8(int index);
+        uint8_t& register8Unprefixed(int index);
 
         uint8_t busReadHL();
         void busWriteHL(uint8_t value);
@@ -190,6 +270,9 @@ namespace epoch::zxspectrum
         void jr(bool condition);
         void push16(uint16_t value);
         uint16_t pop16();
+        int blockIterations(int count, bool contended) const;
+        int blockLoad(int direction);
+        int blockCompare(int direction);
         void ldi();
         void ldd();
         void cpi();
@@ -0,0 +1,561 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Z80Disassembler.hpp"
+
+#include "Z80Interface.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        constexpr const char* Registers8[] = {"B", "C", "D", "E", "H", "L", "(HL)", "A"};
+        constexpr const char* Registers16[] = {"BC", "DE", "HL", "SP"};
+        constexpr const char* Registers16Stack[] = {"BC", "DE", "HL", "AF"};
+        constexpr const char* Conditions[] = {"NZ", "Z", "NC", "C", "PO", "PE", "P", "M"};
+        constexpr const char* Alu[] = {"ADD A,", "ADC A,", "SUB ", "SBC A,", "AND ", "XOR ", "OR ", "CP "};
+        constexpr const char* Rotations[] = {"RLC", "RRC", "RL", "RR", "SLA", "SRA", "SLL", "SRL"};
+        constexpr const char* Accumulator[] = {"RLCA", "RRCA", "RLA", "RRA", "DAA", "CPL", "SCF", "CCF"};
+        constexpr const char* InterruptModes[] = {"0", "0", "1", "2", "0", "0", "1", "2"};
+        constexpr const char* EdMisc[] = {"LD I,A", "LD R,A", "LD A,I", "LD A,R", "RRD", "RLD", "NOP", "NOP"};
+        constexpr const char* Block[4][4] = {
+            {"LDI", "CPI", "INI", "OUTI"},
+            {"LDD", "CPD", "IND", "OUTD"},
+            {"LDIR", "CPIR", "INIR", "OTIR"},
+            {"LDDR", "CPDR", "INDR", "OTDR"},
+        };
+
+        // Decoder state for a single instruction: the bytes, the index prefix in use and the text produced so far
+        class Decoder final
+        {
+        public:
+            Decoder(const uint16_t address, const std::array<uint8_t, 4>& bytes) : m_address{address}, m_bytes{bytes}
+            {
+            }
+
+            Z80DisassemblyLine decode()
+            {
+                auto opcode = next();
+                if (opcode == 0xdd || opcode == 0xfd)
+                {
+                    m_index = opcode == 0xdd ? "IX" : "IY";
+                    opcode = m_bytes[1];
+                    if (opcode == 0xdd || opcode == 0xfd || opcode == 0xed)
+                    {
+                        // The prefix has no effect on the next instruction
+                        emit("NOP*");
+                        return result();
+                    }
+                    next();
+                }
+                if (opcode == 0xcb)
+                    decodeCb();
+                else if (opcode == 0xed)
+                    decodeEd();
+                else
+                    decodeMain(opcode);
+                return result();
+            }
+
+        private:
+            uint16_t m_address;
+            const std::array<uint8_t, 4>& m_bytes;
+            uint8_t m_length{};
+            const char* m_index{};
+            std::string m_text{};
+            int8_t m_displacement{};
+            bool m_hasDisplacement{};
+
+            uint8_t next() { return m_bytes[m_length++]; }
+
+            Z80DisassemblyLine result() const { return {m_address, m_length, m_text}; }
+
+            void emit(const char* text) { m_text += text; }
+
+            void emitByte()
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "$%02X", next());
+                m_text += buffer;
+            }
+
+            void emitWord()
+            {
+                const auto low = next();
+                const auto high = next();
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "$%04X", high << 8 | low);
+                m_text += buffer;
+            }
+
+            void emitRelative()
+            {
+                const auto offset = static_cast<int8_t>(next());
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "$%04X", static_cast<uint16_t>(m_address + m_length + offset));
+                m_text += buffer;
+            }
+
+            // (IX+d) for indexed instructions, the displacement is read on first use
+            void emitIndexed()
+            {
+                if (!m_hasDisplacement)
+                {
+                    m_displacement = static_cast<int8_t>(next());
+                    m_hasDisplacement = true;
+                }
+                char buffer[16];
+                std::snprintf(buffer, sizeof(buffer), "(%s%c$%02X)", m_index, m_displacement < 0 ? '-' : '+',
+                              std::abs(m_displacement));
+                m_text += buffer;
+            }
+
+            // 8 bit register operand. H and L become IXH/IXL unless the instruction also accesses (IX+d).
+            void emitRegister8(const int index, const bool indexHalves = true)
+            {
+                if (index == 6 && m_index)
+                {
+                    emitIndexed();
+                }
+                else if ((index == 4 || index == 5) && m_index && indexHalves)
+                {
+                    m_text += m_index;
+                    m_text += index == 4 ? "H" : "L";
+                }
+                else
+                {
+                    m_text += Registers8[index];
+                }
+            }
+
+            void emitRegister16(const int index, const char* const* names)
+            {
+                if (index == 2 && m_index)
+                    m_text += m_index;
+                else
+                    m_text += names[index];
+            }
+
+            void decodeMain(const uint8_t opcode)
+            {
+                const auto x = opcode >> 6;
+                const auto y = (opcode >> 3) & 7;
+                const auto z = opcode & 7;
+                const auto p = y >> 1;
+                const auto q = y & 1;
+                switch (x)
+                {
+                    case 0:
+                        decodeQuadrant0(y, z, p, q);
+                        break;
+                    case 1:
+                        if (y == 6 && z == 6)
+                        {
+                            emit("HALT");
+                        }
+                        else
+                        {
+                            // LD H,(IX+d) keeps H
+                            const auto memory = y == 6 || z == 6;
+                            emit("LD ");
+                            emitRegister8(y, !memory);
+                            emit(",");
+                            emitRegister8(z, !memory);
+                        }
+                        break;
+                    case 2:
+                        emit(Alu[y]);
+                        emitRegister8(z);
+                        break;
+                    default:
+                        decodeQuadrant3(y, z, p, q);
+                        break;
+                }
+            }
+
+            void decodeQuadrant0(const int y, const int z, const int p, const int q)
+            {
+                switch (z)
+                {
+                    case 0:
+                        if (y == 0)
+                        {
+                            emit("NOP");
+                        }
+                        else if (y == 1)
+                        {
+                            emit("EX AF,AF'");
+                        }
+                        else
+                        {
+                            emit(y == 2 ? "DJNZ " : "JR ");
+                            if (y >= 4)
+                            {
+                                emit(Conditions[y - 4]);
+                                emit(",");
+                            }
+                            emitRelative();
+                        }
+                        break;
+                    case 1:
+                        if (q == 0)
+                        {
+                            emit("LD ");
+                            emitRegister16(p, Registers16);
+                            emit(",");
+                            emitWord();
+                        }
+                        else
+                        {
+                            emit("ADD ");
+                            emitRegister16(2, Registers16);
+                            emit(",");
+                            emitRegister16(p, Registers16);
+                        }
+                        break;
+                    case 2:
+                    {
+                        if (p < 2)
+                        {
+                            const auto pointer = p == 0 ? "(BC)" : "(DE)";
+                            emit("LD ");
+                            emit(q == 0 ? pointer : "A");
+                            emit(",");
+                            emit(q == 0 ? "A" : pointer);
+                            break;
+                        }
+                        emit("LD ");
+                        if (q == 1)
+                        {
+                            if (p == 2)
+                                emitRegister16(2, Registers16);
+                            else
+                                emit("A");
+                            emit(",");
+                        }
+                        emit("(");
+                        emitWord();
+                        emit(")");
+                        if (q == 0)
+                        {
+                            emit(",");
+                            if (p == 2)
+                                emitRegister16(2, Registers16);
+                            else
+                                emit("A");
+                        }
+                        break;
+                    }
+                    case 3:
+                        emit(q == 0 ? "INC " : "DEC ");
+                        emitRegister16(p, Registers16);
+                        break;
+                    case 4:
+                    case 5:
+                        emit(z == 4 ? "INC " : "DEC ");
+                        emitRegister8(y);
+                        break;
+                    case 6:
+                        emit("LD ");
+                        emitRegister8(y);
+                        emit(",");
+                        emitByte();
+                        break;
+                    default:
+                        emit(Accumulator[y]);
+                        break;
+                }
+            }
+
+            void decodeQuadrant3(const int y, const int z, const int p, const int q)
+            {
+                switch (z)
+                {
+                    case 0:
+                        emit("RET ");
+                        emit(Conditions[y]);
+                        break;
+                    case 1:
+                        if (q == 0)
+                        {
+                            emit("POP ");
+                            emitRegister16(p, Registers16Stack);
+                        }
+                        else if (p == 0)
+                        {
+                            emit("RET");
+                        }
+                        else if (p == 1)
+                        {
+                            emit("EXX");
+                        }
+                        else if (p == 2)
+                        {
+                            emit("JP (");
+                            emitRegister16(2, Registers16);
+                            emit(")");
+                        }
+                        else
+                        {
+                            emit("LD SP,");
+                            emitRegister16(2, Registers16);
+                        }
+                        break;
+                    case 2:
+                    case 4:
+                        emit(z == 2 ? "JP " : "CALL ");
+                        emit(Conditions[y]);
+                        emit(",");
+                        emitWord();
+                        break;
+                    case 3:
+                        switch (y)
+                        {
+                            case 0:
+                                emit("JP ");
+                                emitWord();
+                                break;
+                            case 2:
+                                emit("OUT (");
+                                emitByte();
+                                emit("),A");
+                                break;
+                            case 3:
+                                emit("IN A,(");
+                                emitByte();
+                                emit(")");
+                                break;
+                            case 4:
+                                emit("EX (SP),");
+                                emitRegister16(2, Registers16);
+                                break;
+                            case 5:
+                                emit("EX DE,HL");
+                                break;
+                            case 6:
+                                emit("DI");
+                                break;
+                            default:
+                                emit("EI");
+                                break;
+                        }
+                        break;
+                    case 5:
+                        if (q == 0)
+                        {
+                            emit("PUSH ");
+                            emitRegister16(p, Registers16Stack);
+                        }
+                        else
+                        {
+                            emit("CALL ");
+                            emitWord();
+                        }
+                        break;
+                    case 6:
+                        emit(Alu[y]);
+                        emitByte();
+                        break;
+                    default:
+                    {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "RST $%02X", y * 8);
+                        emit(buffer);
+                        break;
+                    }
+                }
+            }
+
+            void decodeCb()
+            {
+                // DDCB/FDCB: the displacement comes before the opcode
+                if (m_index)
+                {
+                    m_displacement = static_cast<int8_t>(next());
+                    m_hasDisplacement = true;
+                }
+                const auto opcode = next();
+                const auto x = opcode >> 6;
+                const auto y = (opcode >> 3) & 7;
+                const auto z = opcode & 7;
+                if (x == 0)
+                {
+                    emit(Rotations[y]);
+                    emit(" ");
+                }
+                else
+                {
+                    emit(x == 1 ? "BIT " : x == 2 ? "RES " : "SET ");
+                    m_text += static_cast<char>('0' + y);
+                    emit(",");
+                }
+                if (m_index)
+                {
+                    emitIndexed();
+                    // Undocumented: the result is also copied to a register
+                    if (z != 6 && x != 1)
+                    {
+                        emit(",");
+                        emit(Registers8[z]);
+                    }
+                }
+                else
+                {
+                    emit(Registers8[z]);
+                }
+            }
+
+            void decodeEd()
+            {
+                const auto opcode = next();
+                const auto x = opcode >> 6;
+                const auto y = (opcode >> 3) & 7;
+                const auto z = opcode & 7;
+                const auto p = y >> 1;
+                const auto q = y & 1;
+                m_index = nullptr;
+                if (x == 2 && z <= 3 && y >= 4)
+                {
+                    emit(Block[y - 4][z]);
+                    return;
+                }
+                if (x != 1)
+                {
+                    emit("NOP*");
+                    return;
+                }
+                switch (z)
+                {
+                    case 0:
+                        emit("IN ");
+                        if (y != 6)
+                        {
+                            emit(Registers8[y]);
+                            emit(",");
+                        }
+                        emit("(C)");
+                        break;
+                    case 1:
+                        emit("OUT (C),");
+                        emit(y == 6 ? "0" : Registers8[y]);
+                        break;
+                    case 2:
+                        emit(q == 0 ? "SBC HL," : "ADC HL,");
+                        emit(Registers16[p]);
+                        break;
+                    case 3:
+                        emit("LD ");
+                        if (q == 0)
+                        {
+                            emit("(");
+                            emitWord();
+                            emit("),");
+                            emit(Registers16[p]);
+                        }
+                        else
+                        {
+                            emit(Registers16[p]);
+                            emit(",(");
+                            emitWord();
+                            emit(")");
+                        }
+                        break;
+                    case 4:
+                        emit("NEG");
+                        break;
+                    case 5:
+                        emit(y == 1 ? "RETI" : "RETN");
+                        break;
+                    case 6:
+                        emit("IM ");
+                        emit(InterruptModes[y]);
+                        break;
+                    default:
+                        emit(EdMisc[y]);
+                        break;
+                }
+            }
+        };
+    }  // namespace
+
+    Z80DisassemblyLine disassembleZ80(const uint16_t address, const std::array<uint8_t, 4>& bytes)
+    {
+        return Decoder{address, bytes}.decode();
+    }
+
+    bool Z80Disassembler::update(Z80Interface& bus)
+    {
+        constexpr std::size_t PageSize = 0x4000;
+        for (int page = 0; page < 4; ++page)
+        {
+            const auto base = static_cast<std::size_t>(page) * PageSize;
+            if (const auto source = bus.readPage(page))
+            {
+                std::memcpy(m_memory.data() + base, source, PageSize);
+            }
+            else
+            {
+                for (std::size_t i = 0; i < PageSize; ++i) m_memory[base + i] = bus.peek(static_cast<uint16_t>(base + i));
+            }
+        }
+
+        // A page is decoded again when its bytes changed, when the 3 bytes after it changed (instructions can cross
+        // into the next page), or when the previous page now ends at a different boundary
+        bool changed = false;
+        uint32_t start = 0;
+        for (std::size_t page = 0; page < PagesCount; ++page)
+        {
+            const auto base = static_cast<uint32_t>(page << 8);
+            const auto tail = std::min<uint32_t>(base + 0x100 + 3, 0x10000) - base;
+            if (m_valid && start == m_pageStart[page] &&
+                std::memcmp(m_memory.data() + base, m_previous.data() + base, tail) == 0)
+            {
+                start = m_pageEnd[page];
+                continue;
+            }
+            changed = true;
+            auto& lines = m_pages[page];
+            lines.clear();
+            m_pageStart[page] = start;
+            auto address = start;
+            while (address < base + 0x100 && address < 0x10000)
+            {
+                std::array<uint8_t, 4> bytes{};
+                for (std::size_t i = 0; i < bytes.size(); ++i) bytes[i] = m_memory[(address + i) & 0xffff];
+                lines.push_back(disassembleZ80(static_cast<uint16_t>(address), bytes));
+                address += lines.back().length;
+            }
+            m_pageEnd[page] = address;
+            start = address;
+        }
+        m_valid = true;
+        m_previous = m_memory;
+        return changed;
+    }
+
+    std::size_t Z80Disassembler::size() const
+    {
+        std::size_t result = 0;
+        for (const auto& lines : m_pages) result += lines.size();
+        return result;
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,68 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_Z80DISASSEMBLER_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_Z80DISASSEMBLER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    class Z80Interface;
+
+    struct Z80DisassemblyLine
+    {
+        uint16_t address;
+        uint8_t length;
+        std::string text;
+    };
+
+    // Decodes the instruction starting with bytes[0] (at most 4 bytes are used), e.g. "LD (IX+$05),$3C"
+    [[nodiscard]] Z80DisassemblyLine disassembleZ80(uint16_t address, const std::array<uint8_t, 4>& bytes);
+
+    // Disassembly listing of the whole address space, kept up to date with the memory content. Each update compares
+    // the memory with the previous snapshot and only decodes again the 256-byte pages that changed, plus the following
+    // ones until the instruction boundaries fall back in line with the previous listing.
+    class Z80Disassembler final
+    {
+    public:
+        Z80Disassembler() = default;
+
+    public:
+        static constexpr std::size_t PagesCount = 256;
+
+        // Reads the memory through the side effect free accessors, true if the listing changed
+        bool update(Z80Interface& bus);
+
+        // Instructions starting in the given 256-byte page, in address order
+        [[nodiscard]] const std::vector<Z80DisassemblyLine>& page(const std::size_t page) const { return m_pages[page]; }
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        std::array<uint8_t, 0x10000> m_memory{};
+        std::array<uint8_t, 0x10000> m_previous{};
+        bool m_valid{};
+        std::array<std::vector<Z80DisassemblyLine>, PagesCount> m_pages{};  // lines starting in each page
+        std::array<uint32_t, PagesCount> m_pageStart{};  // address of the first instruction starting in the page
+        std::array<uint32_t, PagesCount> m_pageEnd{};  // address following the last instruction of the page
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
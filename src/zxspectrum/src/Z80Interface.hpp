@@ -17,10 +17,28 @@
 #ifndef SRC_EPOCH_ZXSPECTRUM_Z80INTERFACE_HPP_
 #define SRC_EPOCH_ZXSPECTRUM_Z80INTERFACE_HPP_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace epoch::zxspectrum
 {
+    // Memory/IO contention state published by the bus and read by the CPU on every access.
+    // An access to a 16K page flagged in `pages` is delayed by delays[frameTState + offset] T-states, where offset is
+    // the position of the access inside the current instruction. `delays` must extend past the end of the frame by at
+    // least the length of the longest instruction.
+    struct Z80Contention
+    {
+        std::array<bool, 4> pages{};
+        bool io{};
+        const uint8_t* delays{};
+        std::size_t frameTState{};
+        // delays are all zero outside [activeStart, activeEnd) in each frame of frameLength T-states
+        std::size_t activeStart{};
+        std::size_t activeEnd{};
+        std::size_t frameLength{};
+    };
+
     class Z80Interface
     {
     public:
@@ -29,6 +47,27 @@ namespace epoch::zxspectrum
         virtual void write(uint16_t address, uint8_t value) = 0;
         virtual uint8_t ioRead(uint16_t port) = 0;
         virtual void ioWrite(uint16_t port, uint8_t value) = 0;
+
+        // Returns nullptr when the bus has no contention at all
+        [[nodiscard]] virtual const Z80Contention* contention() const { return nullptr; }
+
+        // T-states from the current one until the next event the CPU could observe (interrupt, input change...).
+        // The CPU uses it to fast-forward HALT and idle loops, 0 disables the look-ahead.
+        [[nodiscard]] virtual std::size_t cyclesToNextEvent() const { return 0; }
+
+        // Direct access to the memory mapped in a 16K page (0-3) for bulk transfers, nullptr when not available
+        // (e.g. ROM for writes). Reading or writing through these pointers must have no other side effect.
+        [[nodiscard]] virtual const uint8_t* readPage(int page) { return nullptr; }
+        [[nodiscard]] virtual uint8_t* writePage(int page) { return nullptr; }
+
+        // Side effect free read for debugging tools
+        [[nodiscard]] virtual uint8_t peek(const uint16_t address)
+        {
+            if (const auto page = readPage(address >> 14)) return page[address & 0x3fff];
+            return read(address);
+        }
+        // Machine specific memory paging state, recorded by the tracer
+        [[nodiscard]] virtual uint16_t paging() const { return 0; }
     };
 }  // namespace epoch::zxspectrum
 
@@ -0,0 +1,90 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Z80Statistics.hpp"
+
+#include <cstdio>
+#include <ostream>
+
+namespace epoch::zxspectrum
+{
+    Z80Statistics::Entry Z80Statistics::total() const
+    {
+        Entry result{};
+        for (const auto& table : m_entries)
+        {
+            for (const auto& entry : table)
+            {
+                result.executions += entry.executions;
+                result.cycles += entry.cycles;
+            }
+        }
+        return result;
+    }
+
+    std::string Z80Statistics::opcodeName(const Z80StatisticsTable table, const uint8_t opcode)
+    {
+        static constexpr const char* formats[] = {
+            "%02X", "CB %02X", "ED %02X", "DD %02X", "FD %02X", "DD CB d %02X", "FD CB d %02X",
+        };
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), formats[static_cast<std::size_t>(table)], opcode);
+        return buffer;
+    }
+
+    std::string_view Z80Statistics::tableName(const Z80StatisticsTable table)
+    {
+        static constexpr std::string_view names[] = {"none", "CB", "ED", "DD", "FD", "DDCB", "FDCB"};
+        return names[static_cast<std::size_t>(table)];
+    }
+
+    void Z80Statistics::writeCsv(std::ostream& os) const
+    {
+        os << "prefix,opcode,executions,cycles\n";
+        for (std::size_t t = 0; t < TablesCount; ++t)
+        {
+            for (std::size_t opcode = 0; opcode < 256; ++opcode)
+            {
+                const auto& entry = m_entries[t][opcode];
+                if (entry.executions == 0) continue;
+                os << tableName(static_cast<Z80StatisticsTable>(t)) << ',' << opcode << ',' << entry.executions << ','
+                   << entry.cycles << '\n';
+            }
+        }
+    }
+
+    void Z80Statistics::writeJson(std::ostream& os) const
+    {
+        os << "[\n";
+        bool first = true;
+        for (std::size_t t = 0; t < TablesCount; ++t)
+        {
+            for (std::size_t opcode = 0; opcode < 256; ++opcode)
+            {
+                const auto& entry = m_entries[t][opcode];
+                if (entry.executions == 0) continue;
+                const auto table = static_cast<Z80StatisticsTable>(t);
+                if (!first) os << ",\n";
+                first = false;
+                os << R"(  {"prefix": ")" << tableName(table) << R"(", "opcode": )" << opcode << R"(, "bytes": ")"
+                   << opcodeName(table, static_cast<uint8_t>(opcode)) << R"(", "executions": )" << entry.executions
+                   << R"(, "cycles": )" << entry.cycles << "}";
+            }
+        }
+        os << "\n]\n";
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,82 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_Z80STATISTICS_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_Z80STATISTICS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace epoch::zxspectrum
+{
+    enum class Z80StatisticsTable : uint8_t
+    {
+        none,
+        cb,
+        ed,
+        dd,
+        fd,
+        ddcb,
+        fdcb,
+        count,
+    };
+
+    // Executions and T-states per opcode, one table per prefix.
+    // Owned by a single CPU and updated with plain increments from its emulation thread only.
+    class Z80Statistics final
+    {
+    public:
+        struct Entry
+        {
+            uint64_t executions;
+            uint64_t cycles;
+        };
+
+        static constexpr auto TablesCount = static_cast<std::size_t>(Z80StatisticsTable::count);
+
+    public:
+        void count(const Z80StatisticsTable table, const uint8_t opcode, const int cycles)
+        {
+            auto& entry = m_entries[static_cast<std::size_t>(table)][opcode];
+            entry.executions++;
+            entry.cycles += static_cast<uint64_t>(cycles);
+        }
+        void reset() { m_entries = {}; }
+
+        [[nodiscard]] const Entry& entry(const Z80StatisticsTable table, const uint8_t opcode) const
+        {
+            return m_entries[static_cast<std::size_t>(table)][opcode];
+        }
+        [[nodiscard]] Entry total() const;
+
+        // Opcode bytes as they appear in memory, e.g. "ED B0", "DD CB d 46"
+        [[nodiscard]] static std::string opcodeName(Z80StatisticsTable table, uint8_t opcode);
+        [[nodiscard]] static std::string_view tableName(Z80StatisticsTable table);
+
+        // Only executed opcodes are written
+        void writeCsv(std::ostream& os) const;
+        void writeJson(std::ostream& os) const;
+
+    private:
+        std::array<std::array<Entry, 256>, TablesCount> m_entries{};
+    };
+}  // namespace epoch::zxspectrum
+
+#endif
@@ -0,0 +1,141 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Z80Tracer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        constexpr std::array<char, 4> TraceMagic{'E', 'P', 'T', 'R'};
+        constexpr uint32_t TraceVersion = 1;
+
+        struct TraceHeader
+        {
+            std::array<char, 4> magic;
+            uint32_t version;
+            uint32_t recordSize;
+            uint32_t littleEndian;
+            uint64_t count;
+        };
+    }  // namespace
+
+    Z80Tracer::Z80Tracer(const std::size_t capacity)
+        : m_records(std::bit_ceil(std::max<std::size_t>(capacity, 1))), m_mask{m_records.size() - 1}
+    {
+    }
+
+    void Z80Tracer::record(const Z80Registers& registers, const std::size_t clock, Z80Interface& bus)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        auto& r = m_records[head & m_mask];
+        r.clock = clock;
+        r.pc = registers.pc;
+        r.sp = registers.sp;
+        r.af = registers.af;
+        r.bc = registers.bc;
+        r.de = registers.de;
+        r.hl = registers.hl;
+        r.ix = registers.ix;
+        r.iy = registers.iy;
+        r.af2 = registers.af2;
+        r.bc2 = registers.bc2;
+        r.de2 = registers.de2;
+        r.hl2 = registers.hl2;
+        r.ir = registers.ir;
+        r.wz = registers.wz;
+        for (std::size_t i = 0; i < r.opcode.size(); ++i)
+        {
+            r.opcode[i] = bus.peek(static_cast<uint16_t>(registers.pc + i));
+        }
+        r.paging = bus.paging();
+        r.flags = static_cast<uint8_t>(registers.iff1 | registers.iff2 << 1 | (registers.interruptMode & 3) << 2);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    std::vector<Z80TraceRecord> Z80Tracer::snapshot() const
+    {
+        const auto head = m_head.load(std::memory_order_acquire);
+        const auto size = static_cast<uint64_t>(m_records.size());
+        const auto first = head > size ? head - size : 0;
+        std::vector<Z80TraceRecord> result;
+        result.reserve(head - first);
+        for (auto i = first; i < head; ++i)
+        {
+            result.push_back(m_records[i & m_mask]);
+        }
+        // Drop what the producer may have overwritten meanwhile (the slot being written included)
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto current = m_head.load(std::memory_order_relaxed);
+        const auto valid = current >= size ? current - size + 1 : 0;
+        if (valid > first)
+        {
+            result.erase(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(std::min(valid, head) - first));
+        }
+        return result;
+    }
+
+    void saveTrace(const std::filesystem::path& path, const std::vector<Z80TraceRecord>& records)
+    {
+        std::ofstream os{path, std::ios::binary};
+        if (!os) throw std::runtime_error("Cannot open trace file for writing");
+        const TraceHeader header{TraceMagic, TraceVersion, sizeof(Z80TraceRecord),
+                                 std::endian::native == std::endian::little, records.size()};
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(Z80TraceRecord)));
+        if (!os) throw std::runtime_error("Error writing trace file");
+    }
+
+    std::vector<Z80TraceRecord> loadTrace(const std::filesystem::path& path)
+    {
+        std::ifstream is{path, std::ios::binary};
+        if (!is) throw std::runtime_error("Cannot open trace file");
+        TraceHeader header{};
+        is.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!is || header.magic != TraceMagic) throw std::runtime_error("Invalid trace file");
+        if (header.version != TraceVersion || header.recordSize != sizeof(Z80TraceRecord) ||
+            static_cast<bool>(header.littleEndian) != (std::endian::native == std::endian::little))
+            throw std::runtime_error("Unsupported trace file format");
+        std::vector<Z80TraceRecord> records(header.count);
+        is.read(reinterpret_cast<char*>(records.data()),
+                static_cast<std::streamsize>(records.size() * sizeof(Z80TraceRecord)));
+        if (!is) throw std::runtime_error("Truncated trace file");
+        return records;
+    }
+
+    void formatTrace(std::ostream& os, const Z80TraceRecord& record)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line),
+                      "%12llu %04X  %02X %02X %02X %02X  AF=%04X BC=%04X DE=%04X HL=%04X IX=%04X IY=%04X SP=%04X "
+                      "AF'=%04X BC'=%04X DE'=%04X HL'=%04X IR=%04X WZ=%04X IM%d IFF=%d%d P=%04X",
+                      static_cast<unsigned long long>(record.clock), record.pc, record.opcode[0], record.opcode[1],
+                      record.opcode[2], record.opcode[3], record.af, record.bc, record.de, record.hl, record.ix,
+                      record.iy, record.sp, record.af2, record.bc2, record.de2, record.hl2, record.ir, record.wz,
+                      (record.flags >> 2) & 3, record.flags & 1, (record.flags >> 1) & 1, record.paging);
+        os << line << '\n';
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,84 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_Z80TRACER_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_Z80TRACER_HPP_
+
+#include "Z80Cpu.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    // CPU state captured right before an instruction is executed
+    struct Z80TraceRecord
+    {
+        uint64_t clock;
+        uint16_t pc, sp, af, bc, de, hl, ix, iy;
+        uint16_t af2, bc2, de2, hl2, ir, wz;
+        std::array<uint8_t, 4> opcode;
+        uint16_t paging;
+        uint8_t flags;  // bit 0 IFF1, bit 1 IFF2, bits 2-3 interrupt mode
+        uint8_t reserved0;
+        uint32_t reserved1;
+    };
+    static_assert(sizeof(Z80TraceRecord) == 48);
+
+    // Fixed capacity ring buffer of the last executed instructions.
+    // A single producer (the emulation thread) records, any other thread can take a snapshot at any time without
+    // locking: records overwritten while being copied are dropped from the snapshot.
+    class Z80Tracer final
+    {
+    public:
+        // capacity is rounded up to a power of two
+        explicit Z80Tracer(std::size_t capacity = 1 << 20);
+
+    public:
+        Z80Tracer(const Z80Tracer& other) = delete;
+        Z80Tracer(Z80Tracer&& other) noexcept = delete;
+        Z80Tracer& operator=(const Z80Tracer& other) = delete;
+        Z80Tracer& operator=(Z80Tracer&& other) noexcept = delete;
+
+    public:
+        void record(const Z80Registers& registers, std::size_t clock, Z80Interface& bus);
+
+        void clear() { m_head.store(0, std::memory_order_release); }
+
+        [[nodiscard]] std::size_t capacity() const { return m_records.size(); }
+        // Total number of records ever written, including the overwritten ones
+        [[nodiscard]] uint64_t recorded() const { return m_head.load(std::memory_order_acquire); }
+
+        // Records still in the buffer, oldest first
+        [[nodiscard]] std::vector<Z80TraceRecord> snapshot() const;
+
+    private:
+        std::vector<Z80TraceRecord> m_records;
+        std::size_t m_mask;
+        std::atomic<uint64_t> m_head{};
+    };
+
+    void saveTrace(const std::filesystem::path& path, const std::vector<Z80TraceRecord>& records);
+    std::vector<Z80TraceRecord> loadTrace(const std::filesystem::path& path);
+    void formatTrace(std::ostream& os, const Z80TraceRecord& record);
+}  // namespace epoch::zxspectrum
+
+#endif
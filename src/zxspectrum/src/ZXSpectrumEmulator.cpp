@@ -16,24 +16,51 @@
 
 #include "ZXSpectrumEmulator.hpp"
 
+#ifdef EPOCH_GDB_SERVER
+#include "GdbServer.hpp"
+#endif
+#include "GuestProfiler.hpp"
 #include "Io.hpp"
 #include "PulsesTape.hpp"
 #include "Roms.hpp"
 #include "Ula.hpp"
+#include "Z80Breakpoints.hpp"
 #include "Z80Cpu.hpp"
+#include "Z80Disassembler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <span>
 
 namespace epoch::zxspectrum
 {
-    ZXSpectrumEmulator::ZXSpectrumEmulator(std::unique_ptr<Ula> ula)
-        : Emulator{{Width,
-                    Height,
-                    TStatesPerFrame,
-                    FramesPerSecond,
-                    {
-                        {"Tapes", ".tap,.tzx", true, false},
-                        {"SNA Snapshots", ".sna", true, true},
-                        {"Z80 Snapshots", ".z80", true, false},
-                    }}},
+    namespace
+    {
+        template <typename Model>
+        class ModelEmulator final : public ZXSpectrumEmulator
+        {
+        public:
+            explicit ModelEmulator(const std::span<const uint8_t> rom)
+                : ZXSpectrumEmulator{{Width,
+                                      Height,
+                                      Model::TStatesPerFrame,
+                                      Model::FramesPerSecond,
+                                      {
+                                          {"Tapes", ".tap,.tzx", true, false},
+                                          {"SNA Snapshots", ".sna", true, true},
+                                          {"Z80 Snapshots", ".z80", true, false},
+                                      }},
+                                     std::make_unique<ModelUla<Model>>(rom)}
+            {
+            }
+
+        protected:
+            void doClock() override { clockMachine(static_cast<ModelUla<Model>&>(*ula())); }
+        };
+    }  // namespace
+
+    ZXSpectrumEmulator::ZXSpectrumEmulator(EmulatorInfo info, std::unique_ptr<Ula> ula)
+        : Emulator{std::move(info)},
           m_ula{std::move(ula)},
           m_cpu{std::make_unique<Z80Cpu>(*m_ula)},
           m_palette{
@@ -47,22 +74,22 @@ namespace epoch::zxspectrum
 
     std::unique_ptr<ZXSpectrumEmulator> ZXSpectrumEmulator::create48K()
     {
-        return std::make_unique<ZXSpectrumEmulator>(std::make_unique<Ula>(UlaType::zx48k, roms::Rom48K));
+        return std::make_unique<ModelEmulator<Model48K>>(roms::Rom48K);
     }
 
     std::unique_ptr<ZXSpectrumEmulator> ZXSpectrumEmulator::create128K()
     {
-        return std::make_unique<ZXSpectrumEmulator>(std::make_unique<Ula>(UlaType::zx128k, roms::Rom128K));
+        return std::make_unique<ModelEmulator<Model128K>>(roms::Rom128K);
     }
 
     std::unique_ptr<ZXSpectrumEmulator> ZXSpectrumEmulator::create128KPlus2()
     {
-        return std::make_unique<ZXSpectrumEmulator>(std::make_unique<Ula>(UlaType::zx128k, roms::Rom128KPlus2));
+        return std::make_unique<ModelEmulator<Model128K>>(roms::Rom128KPlus2);
     }
 
     std::unique_ptr<ZXSpectrumEmulator> ZXSpectrumEmulator::create128KPlus3()
     {
-        return std::make_unique<ZXSpectrumEmulator>(std::make_unique<Ula>(UlaType::zx128kplus3, roms::Rom128KPlus3));
+        return std::make_unique<ModelEmulator<Model128KPlus3>>(roms::Rom128KPlus3);
     }
 
     void ZXSpectrumEmulator::reset()
@@ -237,18 +264,206 @@ namespace epoch::zxspectrum
 
     Tape* ZXSpectrumEmulator::tape() { return m_tape.get(); }
 
-    void ZXSpectrumEmulator::doClock()
+    void ZXSpectrumEmulator::setGuestProfiling(const bool enabled)
+    {
+        if (enabled && !m_guestProfiler) m_guestProfiler = std::make_unique<GuestProfiler>();
+        m_guestProfiling = enabled;
+    }
+
+    EmulatorProfile ZXSpectrumEmulator::guestProfile() const
+    {
+        if (!m_guestProfiler) return {};
+        const auto& profiler = *m_guestProfiler;
+        const auto frames = static_cast<double>(std::max<uint64_t>(profiler.frames(), 1));
+        const auto toTStates = [&](const uint64_t samples)
+        { return static_cast<double>(samples) * profiler.samplePeriod() / frames; };
+        EmulatorProfile result{
+            .frames = profiler.frames(),
+            .busyTStates = toTStates(profiler.samples() - profiler.idleSamples()),
+            .idleTStates = toTStates(profiler.idleSamples()),
+            .frameLoad = profiler.frameLoad(),
+        };
+        for (const auto& routine : profiler.routines())
+        {
+            result.routines.push_back(
+                {routine.name, toTStates(routine.selfSamples), toTStates(routine.inclusiveSamples)});
+        }
+        return result;
+    }
+
+    void ZXSpectrumEmulator::resetGuestProfile()
+    {
+        if (m_guestProfiler) m_guestProfiler->reset();
+    }
+
+    void ZXSpectrumEmulator::loadSymbols(const std::string& path)
+    {
+        guestProfiler()->setSymbols(zxspectrum::loadSymbols(path));
+    }
+
+    GuestProfiler* ZXSpectrumEmulator::guestProfiler()
+    {
+        if (!m_guestProfiler) m_guestProfiler = std::make_unique<GuestProfiler>();
+        return m_guestProfiler.get();
+    }
+
+    void ZXSpectrumEmulator::resume()
+    {
+        // Leave the breakpoint the CPU is stopped at
+        if (m_breakpoints) m_breakpoints->skipNext();
+        Emulator::resume();
+    }
+
+    void ZXSpectrumEmulator::step()
+    {
+        if (!paused()) return;
+        if (m_breakpoints) m_breakpoints->skipNext();
+        do
+        {
+            doClock();
+        } while (!m_cpu->instructionBoundary());
+    }
+
+    void ZXSpectrumEmulator::stepOver()
+    {
+        if (!paused()) return;
+        const auto& registers = m_cpu->registers();
+        const auto opcode = m_ula->peek(registers.pc);
+        int length = 0;
+        if (opcode == 0xcd || (opcode & 0xc7) == 0xc4)
+        {
+            length = 3;  // CALL nn, CALL cc,nn
+        }
+        else if ((opcode & 0xc7) == 0xc7 || opcode == 0x76)
+        {
+            length = 1;  // RST p, HALT
+        }
+        else if (opcode == 0x10)
+        {
+            length = 2;  // DJNZ
+        }
+        else if (opcode == 0xed && (m_ula->peek(static_cast<uint16_t>(registers.pc + 1)) & 0xf4) == 0xb0)
+        {
+            length = 2;  // LDIR, CPIR, INIR, OTIR and their decrementing versions
+        }
+        if (length == 0)
+        {
+            step();
+            return;
+        }
+        // The stack pointer condition ignores the return address being reached by a recursive call
+        char condition[16];
+        std::snprintf(condition, sizeof(condition), "SP >= 0x%04X", registers.sp);
+        breakpoints()->add(Z80BreakpointType::execution, static_cast<uint16_t>(registers.pc + length), condition,
+                           true);
+        resume();
+    }
+
+    Z80Breakpoints* ZXSpectrumEmulator::breakpoints()
+    {
+        if (!m_breakpoints) m_breakpoints = std::make_unique<Z80Breakpoints>(*m_cpu);
+        return m_breakpoints.get();
+    }
+
+    uint8_t ZXSpectrumEmulator::peek(const uint16_t address) { return m_ula->peek(address); }
+
+    std::vector<EmulatorRegister> ZXSpectrumEmulator::debugRegisters() const
+    {
+        const auto& r = m_cpu->registers();
+        return {
+            {"AF", r.af, 16},  {"BC", r.bc, 16},   {"DE", r.de, 16},   {"HL", r.hl, 16},   {"IX", r.ix, 16},
+            {"IY", r.iy, 16},  {"SP", r.sp, 16},   {"PC", r.pc, 16},   {"AF'", r.af2, 16}, {"BC'", r.bc2, 16},
+            {"DE'", r.de2, 16}, {"HL'", r.hl2, 16}, {"IR", r.ir, 16},   {"WZ", r.wz, 16},   {"F", r.af.low, 8},
+            {"IM", r.interruptMode, 2}, {"IFF1", r.iff1, 1}, {"IFF2", r.iff2, 1},
+        };
+    }
+
+    uint16_t ZXSpectrumEmulator::programCounter() const { return m_cpu->registers().pc; }
+
+    uint16_t ZXSpectrumEmulator::stackPointer() const { return m_cpu->registers().sp; }
+
+    std::span<const EmulatorDisassemblyLine> ZXSpectrumEmulator::disassembly()
+    {
+        if (!m_disassembler) m_disassembler = std::make_unique<Z80Disassembler>();
+        if (m_disassembler->update(*m_ula))
+        {
+            m_disassembly.clear();
+            m_disassembly.reserve(m_disassembler->size());
+            for (std::size_t page = 0; page < Z80Disassembler::PagesCount; ++page)
+            {
+                for (const auto& line : m_disassembler->page(page))
+                {
+                    m_disassembly.push_back({line.address, line.length, line.text});
+                }
+            }
+        }
+        return m_disassembly;
+    }
+
+#ifdef EPOCH_GDB_SERVER
+    void ZXSpectrumEmulator::startGdbServer(const std::string& endpoint)
+    {
+        m_gdbServer = {};
+        m_gdbServer = std::make_unique<GdbServer>(*this, endpoint);
+        m_gdbServer->setWake(m_debuggerWake);
+    }
+
+    void ZXSpectrumEmulator::serviceDebugger()
     {
-        if (!m_ula->isCpuStalled())
+        if (m_gdbServer) m_gdbServer->service();
+    }
+
+    void ZXSpectrumEmulator::setDebuggerWake(std::function<void()> wake)
+    {
+        m_debuggerWake = std::move(wake);
+        if (m_gdbServer) m_gdbServer->setWake(m_debuggerWake);
+    }
+#endif
+
+#ifdef EPOCH_CPU_STATISTICS
+    std::vector<EmulatorCpuStatistic> ZXSpectrumEmulator::cpuStatistics() const
+    {
+        std::vector<EmulatorCpuStatistic> result;
+        const auto& statistics = m_cpu->statistics();
+        for (std::size_t t = 0; t < Z80Statistics::TablesCount; ++t)
         {
-            m_cpu->interruptRequest(m_ula->interruptRequested());
-            m_cpu->clock();
+            const auto table = static_cast<Z80StatisticsTable>(t);
+            for (int opcode = 0; opcode < 256; ++opcode)
+            {
+                const auto& entry = statistics.entry(table, static_cast<uint8_t>(opcode));
+                if (entry.executions == 0) continue;
+                result.push_back({Z80Statistics::opcodeName(table, static_cast<uint8_t>(opcode)), entry.executions,
+                                  entry.cycles});
+            }
         }
-        m_ula->clock();
-        m_ula->setAudioIn(m_audioIn > AudioInThreshold);
-        if (m_ula->frameReady())
+        return result;
+    }
+
+    void ZXSpectrumEmulator::resetCpuStatistics() { m_cpu->statistics().reset(); }
+#endif
+
+    template <typename ConcreteUla>
+    void ZXSpectrumEmulator::clockMachine(ConcreteUla& ula)
+    {
+        m_cpu->interruptRequest(ula.interruptRequested());
+        m_cpu->clock();
+        if (m_cpu->stopped()) [[unlikely]]
+        {
+            pause();
+            return;
+        }
+        if (m_guestProfiling) [[unlikely]]
+        {
+            m_guestProfiler->clock(*m_cpu, ula);
+        }
+        ula.clock();
+        ula.setAudioIn(m_audioIn > AudioInThreshold);
+        ula.setLookAhead(!m_tape || !m_tape->playing());
+        if (ula.frameReady())
         {
-            updateScreenBuffer();
+            m_screenBufferUpdated = false;
+            if (m_guestProfiling) m_guestProfiler->frame();
+            if (m_breakpoints) m_breakpoints->frame(ula.frameCounter());
         }
 
         if (m_tape && m_tape->playing())
@@ -267,6 +482,16 @@ namespace epoch::zxspectrum
         m_clockCounter++;
     }
 
+    std::span<const uint32_t> ZXSpectrumEmulator::screenBuffer()
+    {
+        if (!m_screenBufferUpdated) updateScreenBuffer();
+        return m_screenBuffer;
+    }
+
+    std::span<const uint8_t> ZXSpectrumEmulator::indexedScreenBuffer() { return m_ula->screenBuffer(); }
+
+    uint64_t ZXSpectrumEmulator::frameCounter() const { return m_ula->frameCounter(); }
+
     void ZXSpectrumEmulator::updateScreenBuffer()
     {
         const auto sourceBuffer = m_ula->screenBuffer();
@@ -274,5 +499,6 @@ namespace epoch::zxspectrum
         {
             m_screenBuffer[i] = m_palette[sourceBuffer[i]];
         }
+        m_screenBufferUpdated = true;
     }
 }  // namespace epoch::zxspectrum
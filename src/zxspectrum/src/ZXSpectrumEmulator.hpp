@@ -26,14 +26,24 @@
 
 namespace epoch::zxspectrum
 {
+#ifdef EPOCH_GDB_SERVER
+    class GdbServer;
+#endif
+    class GuestProfiler;
     class PulsesTape;
     class Ula;
+    class Z80Breakpoints;
     class Z80Cpu;
+    class Z80Disassembler;
 
-    class ZXSpectrumEmulator final : public Emulator
+    // Machine independent part of the emulator, every model is a subclass clocking its own ModelUla (see
+    // ZXSpectrumEmulator.cpp)
+    class ZXSpectrumEmulator : public Emulator
     {
+    protected:
+        ZXSpectrumEmulator(EmulatorInfo info, std::unique_ptr<Ula> ula);
+
     public:
-        explicit ZXSpectrumEmulator(std::unique_ptr<Ula> ula);
         ~ZXSpectrumEmulator() override;
 
     public:
@@ -54,7 +64,12 @@ namespace epoch::zxspectrum
         void load(const std::string& path) override;
         void save(const std::string& path) override;
 
-        [[nodiscard]] std::span<const uint32_t> screenBuffer() override { return m_screenBuffer; }
+        [[nodiscard]] std::span<const uint32_t> screenBuffer() override;
+        [[nodiscard]] std::span<const uint8_t> indexedScreenBuffer() override;
+        [[nodiscard]] std::span<const uint32_t> palette() const override { return m_palette; }
+        [[nodiscard]] uint64_t frameCounter() const override;
+        // Converts the last frame to RGBA, done by screenBuffer() when the frame changed since the last call
+        void updateScreenBuffer();
 
         [[nodiscard]] SoundSample audioOut() const override;
 
@@ -67,8 +82,42 @@ namespace epoch::zxspectrum
 
         Tape* tape() override;
 
+        void setGuestProfiling(bool enabled) override;
+        [[nodiscard]] bool guestProfiling() const override { return m_guestProfiling; }
+        [[nodiscard]] EmulatorProfile guestProfile() const override;
+        void resetGuestProfile() override;
+        void loadSymbols(const std::string& path) override;
+        // Created on first use
+        [[nodiscard]] GuestProfiler* guestProfiler();
+
+        void resume() override;
+        void step() override;
+        void stepOver() override;
+        // Created on first use
+        [[nodiscard]] Z80Breakpoints* breakpoints();
+
+        [[nodiscard]] uint8_t peek(uint16_t address) override;
+        [[nodiscard]] std::vector<EmulatorRegister> debugRegisters() const override;
+        [[nodiscard]] uint16_t programCounter() const override;
+        [[nodiscard]] uint16_t stackPointer() const override;
+        [[nodiscard]] std::span<const EmulatorDisassemblyLine> disassembly() override;
+
+#ifdef EPOCH_GDB_SERVER
+        // Listens for gdb on endpoint, see GdbServer. Throws std::runtime_error on failure.
+        void startGdbServer(const std::string& endpoint);
+        void serviceDebugger() override;
+        void setDebuggerWake(std::function<void()> wake) override;
+#endif
+
+#ifdef EPOCH_CPU_STATISTICS
+        [[nodiscard]] std::vector<EmulatorCpuStatistic> cpuStatistics() const override;
+        void resetCpuStatistics() override;
+#endif
+
     protected:
-        void doClock() override;
+        // One T-state of the whole machine, instantiated per model so that the Ula calls are not virtual
+        template <typename ConcreteUla>
+        void clockMachine(ConcreteUla& ula);
 
     private:
         const std::unique_ptr<Ula> m_ula;
@@ -77,11 +126,22 @@ namespace epoch::zxspectrum
 
         std::array<uint32_t, 16> m_palette;
 
+        // Expanded on demand from the last ULA frame
         std::array<uint32_t, static_cast<std::size_t>(Width* Height)> m_screenBuffer{};
+        bool m_screenBufferUpdated{};
 
         std::unique_ptr<PulsesTape> m_tape{};
 
-        void updateScreenBuffer();
+        std::unique_ptr<GuestProfiler> m_guestProfiler{};
+        bool m_guestProfiling{};
+
+        std::unique_ptr<Z80Breakpoints> m_breakpoints{};
+        std::unique_ptr<Z80Disassembler> m_disassembler{};
+        std::vector<EmulatorDisassemblyLine> m_disassembly{};
+#ifdef EPOCH_GDB_SERVER
+        std::unique_ptr<GdbServer> m_gdbServer{};
+        std::function<void()> m_debuggerWake{};
+#endif
     };
 }  // namespace epoch::zxspectrum
 
@@ -0,0 +1,116 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "../src/GuestProfiler.hpp"
+#include "../src/ZXSpectrumEmulator.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program
+                  << " [--model 48k|128k|plus2|plus3] [--frames N] [--period T] [--symbols FILE] [--output FILE]"
+                     " SNAPSHOT\n";
+    }
+
+    std::unique_ptr<epoch::zxspectrum::ZXSpectrumEmulator> createEmulator(const std::string_view model)
+    {
+        using epoch::zxspectrum::ZXSpectrumEmulator;
+        if (model == "48k") return ZXSpectrumEmulator::create48K();
+        if (model == "128k") return ZXSpectrumEmulator::create128K();
+        if (model == "plus2") return ZXSpectrumEmulator::create128KPlus2();
+        if (model == "plus3") return ZXSpectrumEmulator::create128KPlus3();
+        return nullptr;
+    }
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string_view model{"48k"};
+    unsigned long frames = 500;
+    unsigned long period = 64;
+    const char* symbols{};
+    const char* output{};
+    const char* snapshot{};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "--model" && i + 1 < argc)
+            model = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc)
+            frames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--period" && i + 1 < argc)
+            period = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--symbols" && i + 1 < argc)
+            symbols = argv[++i];
+        else if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else if (!snapshot && !arg.starts_with("--"))
+            snapshot = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    auto emulator = createEmulator(model);
+    if (!snapshot || !emulator || period == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        emulator->reset();
+        emulator->load(snapshot);
+        if (emulator->tape()) emulator->tape()->play();
+
+        const auto profiler = emulator->guestProfiler();
+        profiler->setSamplePeriod(static_cast<uint32_t>(period));
+        if (symbols) profiler->setSymbols(epoch::zxspectrum::loadSymbols(symbols));
+        emulator->setGuestProfiling(true);
+        for (unsigned long frame = 0; frame < frames; ++frame)
+        {
+            emulator->frame();
+        }
+
+        if (output)
+        {
+            std::ofstream os{output};
+            profiler->writeReport(os);
+        }
+        else
+        {
+            profiler->writeReport(std::cout);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "../src/ZXSpectrumEmulator.hpp"
+
+#include <epoch/core.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    void usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--model 48k|128k|plus2|plus3] [--frames N] [--load FILE] OUTPUT\n"
+                  << "Runs the machine without a frontend and records OUTPUT.epv and OUTPUT.wav\n";
+    }
+
+    std::unique_ptr<epoch::zxspectrum::ZXSpectrumEmulator> createEmulator(const std::string_view model)
+    {
+        using epoch::zxspectrum::ZXSpectrumEmulator;
+        if (model == "48k") return ZXSpectrumEmulator::create48K();
+        if (model == "128k") return ZXSpectrumEmulator::create128K();
+        if (model == "plus2") return ZXSpectrumEmulator::create128KPlus2();
+        if (model == "plus3") return ZXSpectrumEmulator::create128KPlus3();
+        return nullptr;
+    }
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string_view model{"48k"};
+    unsigned long frames = 500;
+    const char* load{};
+    const char* output{};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "--model" && i + 1 < argc)
+            model = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc)
+            frames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--load" && i + 1 < argc)
+            load = argv[++i];
+        else if (!output && !arg.starts_with("--"))
+            output = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    auto emulator = createEmulator(model);
+    if (!output || !emulator)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        emulator->reset();
+        if (load)
+        {
+            emulator->load(load);
+            if (emulator->tape()) emulator->tape()->play();
+        }
+
+        // generateNextAudioSample() runs the machine at 48kHz
+        epoch::RecorderStatistics statistics{};
+        {
+            epoch::Recorder recorder{output, emulator->info(), emulator->palette(), 48000};
+            std::vector<float> audio;
+            auto frameCounter = emulator->frameCounter();
+            for (unsigned long frame = 0; frame < frames; ++frame)
+            {
+                audio.clear();
+                while (emulator->frameCounter() == frameCounter)
+                {
+                    const auto sample = emulator->generateNextAudioSample();
+                    audio.push_back(sample.left);
+                    audio.push_back(sample.right);
+                }
+                frameCounter = emulator->frameCounter();
+                recorder.audio(audio);
+                recorder.frame(emulator->indexedScreenBuffer());
+                // Offline there is no deadline: the encoder catches up instead of frames being dropped
+                if (frame % (epoch::Recorder::PoolSize / 2) == 0) recorder.flush();
+            }
+            recorder.flush();
+            statistics = recorder.statistics();
+            if (recorder.failed()) throw std::runtime_error("Cannot write the recording");
+        }
+        std::cout << statistics.frames << " frames, " << statistics.dropped << " dropped, " << statistics.bytes
+                  << " bytes\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
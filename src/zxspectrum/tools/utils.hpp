@@ -19,11 +19,16 @@
 
 #include "../src/Z80Cpu.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
 #include <span>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 class RamZ80Interface : public epoch::zxspectrum::Z80Interface
@@ -49,6 +54,8 @@ public:
 
     uint8_t read(const uint16_t address) override { return m_ram[address]; }
     void write(const uint16_t address, const uint8_t value) override { m_ram[address] = value; }
+    const uint8_t* readPage(const int page) override { return m_ram.data() + page * 0x4000; }
+    uint8_t* writePage(const int page) override { return m_ram.data() + page * 0x4000; }
 
     uint8_t ioRead(const uint16_t port) override
     {
@@ -87,4 +94,39 @@ private:
     std::size_t m_nextIoOperation{};
 };
 
+// Calls work(index) for every index in [0, count) on a pool of jobs threads and done(index) on the calling thread, in
+// index order, as soon as that item and all the previous ones are completed
+template <typename Work, typename Done>
+void runOrdered(const std::size_t count, const unsigned jobs, Work work, Done done)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<bool> completed(count);
+    std::atomic<std::size_t> next{};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::clamp<std::size_t>(jobs, 1, std::max<std::size_t>(count, 1)); ++i)
+    {
+        workers.emplace_back([&] {
+            for (auto index = next++; index < count; index = next++)
+            {
+                work(index);
+                {
+                    std::lock_guard lock{mutex};
+                    completed[index] = true;
+                }
+                condition.notify_one();
+            }
+        });
+    }
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        {
+            std::unique_lock lock{mutex};
+            condition.wait(lock, [&] { return completed[index]; });
+        }
+        done(index);
+    }
+    for (auto& worker : workers) worker.join();
+}
+
 #endif
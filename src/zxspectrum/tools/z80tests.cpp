@@ -18,12 +18,29 @@
 
 #include <nlohmann/json.hpp>
 
+#include <array>
 #include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <set>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 std::set<std::filesystem::path> findJsons(const std::filesystem::path& path)
 {
@@ -39,46 +56,138 @@ std::set<std::filesystem::path> findJsons(const std::filesystem::path& path)
     return results;
 }
 
-struct TestInfo
+class MappedFile
 {
-    struct State
+public:
+    explicit MappedFile(const std::filesystem::path& path)
     {
-        uint16_t pc;
-        uint16_t sp;
-        uint8_t a;
-        uint8_t b;
-        uint8_t c;
-        uint8_t d;
-        uint8_t e;
-        uint8_t f;
-        uint8_t h;
-        uint8_t l;
-        uint8_t i;
-        uint8_t r;
-        bool ei;
-        uint16_t wz;
-        uint16_t ix;
-        uint16_t iy;
-        uint16_t af_;
-        uint16_t bc_;
-        uint16_t de_;
-        uint16_t hl_;
-        uint8_t im;
-        bool p;
-        bool q;
-        bool iff1;
-        bool iff2;
-        std::vector<std::pair<uint16_t, uint8_t>> ram;
-    };
+#ifdef _WIN32
+        const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path.string());
+        LARGE_INTEGER size{};
+        GetFileSizeEx(file, &size);
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        if (m_size > 0)
+        {
+            if (const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+            {
+                m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        const auto fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path.string());
+        struct stat st{};
+        fstat(fd, &st);
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size > 0)
+        {
+            const auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) m_data = static_cast<const uint8_t*>(data);
+        }
+        close(fd);
+#endif
+        if (m_size > 0 && !m_data) throw std::runtime_error("Cannot map " + path.string());
+    }
+    ~MappedFile()
+    {
+        if (!m_data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    }
 
-    std::string name;
-    State initial;
-    State final;
-    int cycles;
-    std::vector<RamZ80Interface::IoOperation> ports;
+public:
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) = delete;
+    MappedFile& operator=(MappedFile&& other) = delete;
+
+public:
+    [[nodiscard]] std::span<const uint8_t> data() const { return {m_data, m_size}; }
+
+private:
+    const uint8_t* m_data{};
+    std::size_t m_size{};
+};
+
+struct TestState
+{
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t e;
+    uint8_t f;
+    uint8_t h;
+    uint8_t l;
+    uint8_t i;
+    uint8_t r;
+    bool ei;
+    uint16_t wz;
+    uint16_t ix;
+    uint16_t iy;
+    uint16_t af_;
+    uint16_t bc_;
+    uint16_t de_;
+    uint16_t hl_;
+    uint8_t im;
+    bool p;
+    bool q;
+    bool iff1;
+    bool iff2;
+};
+
+struct RamEntry
+{
+    uint16_t address;
+    uint8_t value;
 };
 
-void from_json(const nlohmann::json& j, TestInfo::State& r)
+// Pre-parsed test suite, cached next to the json file and memory mapped by the following runs. The file is made of
+// the header followed by the arrays of tests, ram entries, io operations and names referenced by the tests.
+struct CacheHeader
+{
+    static constexpr std::array<char, 8> Magic{'E', 'Z', '8', '0', 'T', 'E', 'S', 'T'};
+    static constexpr uint32_t Version = 1;
+
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t testSize;
+    uint32_t testsCount;
+    uint32_t ramCount;
+    uint32_t portsCount;
+    uint32_t namesSize;
+};
+
+struct CachedTest
+{
+    TestState initial;
+    TestState final;
+    uint32_t cycles;
+    uint32_t initialRam;
+    uint32_t initialRamCount;
+    uint32_t finalRam;
+    uint32_t finalRamCount;
+    uint32_t ports;
+    uint32_t portsCount;
+    uint32_t name;
+    uint32_t nameSize;
+};
+
+static_assert(std::is_trivially_copyable_v<CachedTest> && std::is_trivially_copyable_v<RamEntry> &&
+              std::is_trivially_copyable_v<RamZ80Interface::IoOperation>);
+static_assert(sizeof(CacheHeader) % alignof(CachedTest) == 0 && sizeof(CachedTest) % alignof(RamEntry) == 0 &&
+              sizeof(RamEntry) % alignof(RamZ80Interface::IoOperation) == 0);
+
+void from_json(const nlohmann::json& j, TestState& r)
 {
     j.at("pc").get_to(r.pc);
     j.at("sp").get_to(r.sp);
@@ -105,113 +214,225 @@ void from_json(const nlohmann::json& j, TestInfo::State& r)
     r.q = j.at("q").get<int>();
     r.iff1 = j.at("iff1").get<int>();
     r.iff2 = j.at("iff2").get<int>();
-    for (const auto& it : j.at("ram"))
-    {
-        const auto addr = static_cast<uint16_t>(it[0].get<int>());
-        const auto value = static_cast<uint8_t>(it[1].get<int>());
-        r.ram.emplace_back(addr, value);
-    }
 }
 
-void from_json(const nlohmann::json& j, TestInfo& r)
+template <typename T>
+void writeArray(std::ostream& os, const std::vector<T>& values)
+{
+    os.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+void buildCache(const std::filesystem::path& jsonPath, const std::filesystem::path& cachePath)
 {
-    j.at("name").get_to(r.name);
-    j.at("initial").get_to(r.initial);
-    j.at("final").get_to(r.final);
-    r.cycles = static_cast<int>(j["cycles"].size());
-    if (j.contains("ports"))
+    std::ifstream fs(jsonPath);
+    const auto j = nlohmann::json::parse(fs);
+
+    std::vector<CachedTest> tests;
+    std::vector<RamEntry> ram;
+    std::vector<RamZ80Interface::IoOperation> ports;
+    std::string names;
+    const auto readRam = [&ram](const nlohmann::json& state, uint32_t& first, uint32_t& count) {
+        first = static_cast<uint32_t>(ram.size());
+        for (const auto& it : state.at("ram"))
+        {
+            ram.push_back({static_cast<uint16_t>(it[0].get<int>()), static_cast<uint8_t>(it[1].get<int>())});
+        }
+        count = static_cast<uint32_t>(ram.size()) - first;
+    };
+    for (const auto& it : j)
     {
-        for (const auto& it : j.at("ports"))
+        auto& test = tests.emplace_back();
+        it.at("initial").get_to(test.initial);
+        it.at("final").get_to(test.final);
+        readRam(it.at("initial"), test.initialRam, test.initialRamCount);
+        readRam(it.at("final"), test.finalRam, test.finalRamCount);
+        test.cycles = static_cast<uint32_t>(it.at("cycles").size());
+        test.ports = static_cast<uint32_t>(ports.size());
+        if (it.contains("ports"))
         {
-            const auto addr = static_cast<uint16_t>(it[0].get<int>());
-            const auto value = static_cast<uint8_t>(it[1].get<int>());
-            const auto direction = it[2].get<std::string>();
-            r.ports.emplace_back(addr, value, direction == "w");
+            for (const auto& port : it.at("ports"))
+            {
+                const auto addr = static_cast<uint16_t>(port[0].get<int>());
+                const auto value = static_cast<uint8_t>(port[1].get<int>());
+                const auto direction = port[2].get<std::string>();
+                ports.emplace_back(addr, value, direction == "w");
+            }
         }
+        test.portsCount = static_cast<uint32_t>(ports.size()) - test.ports;
+        const auto& name = it.at("name").get_ref<const std::string&>();
+        test.name = static_cast<uint32_t>(names.size());
+        test.nameSize = static_cast<uint32_t>(name.size());
+        names += name;
+    }
+
+    const CacheHeader header{CacheHeader::Magic,
+                             CacheHeader::Version,
+                             sizeof(CachedTest),
+                             static_cast<uint32_t>(tests.size()),
+                             static_cast<uint32_t>(ram.size()),
+                             static_cast<uint32_t>(ports.size()),
+                             static_cast<uint32_t>(names.size())};
+    // Written aside and renamed, so that an interrupted run never leaves a truncated cache behind
+    auto temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream os(temporaryPath, std::ios::binary);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(os, tests);
+        writeArray(os, ram);
+        writeArray(os, ports);
+        os.write(names.data(), static_cast<std::streamsize>(names.size()));
+        if (!os) throw std::runtime_error("Cannot write " + temporaryPath.string());
     }
+    std::filesystem::rename(temporaryPath, cachePath);
 }
 
-#define CHECK_VALUE(key, width, actual, expected)                                                                 \
-    if ((actual) != (expected))                                                                                   \
-    {                                                                                                             \
-        std::cout << "Test " << testInfo.name << " KO\t" << key << "\texpected: 0x" << std::hex                   \
-                  << std::setw((width) * 2) << std::setfill('0') << (int)(expected) << "\tactual: 0x" << std::hex \
-                  << std::setw((width) * 2) << std::setfill('0') << (int)(actual) << "\n";                        \
-        success = false;                                                                                          \
-    }                                                                                                             \
+class TestSuite
+{
+public:
+    explicit TestSuite(const std::filesystem::path& cachePath) : m_file{cachePath}
+    {
+        const auto data = m_file.data();
+        if (data.size() < sizeof(CacheHeader)) throw std::runtime_error("Invalid cache " + cachePath.string());
+        std::memcpy(&m_header, data.data(), sizeof(CacheHeader));
+        const auto expectedSize = sizeof(CacheHeader) + m_header.testsCount * sizeof(CachedTest) +
+                                  m_header.ramCount * sizeof(RamEntry) +
+                                  m_header.portsCount * sizeof(RamZ80Interface::IoOperation) + m_header.namesSize;
+        if (!valid(m_header) || data.size() != expectedSize)
+            throw std::runtime_error("Invalid cache " + cachePath.string());
+        auto p = data.data() + sizeof(CacheHeader);
+        m_tests = {reinterpret_cast<const CachedTest*>(p), m_header.testsCount};
+        p += m_tests.size_bytes();
+        m_ram = {reinterpret_cast<const RamEntry*>(p), m_header.ramCount};
+        p += m_ram.size_bytes();
+        m_ports = {reinterpret_cast<const RamZ80Interface::IoOperation*>(p), m_header.portsCount};
+        p += m_ports.size_bytes();
+        m_names = {reinterpret_cast<const char*>(p), m_header.namesSize};
+    }
+
+    // Returns whether the cache exists, is newer than the json file and has been written by this version
+    static bool upToDate(const std::filesystem::path& jsonPath, const std::filesystem::path& cachePath)
+    {
+        std::error_code ec;
+        const auto cacheTime = std::filesystem::last_write_time(cachePath, ec);
+        if (ec || cacheTime < std::filesystem::last_write_time(jsonPath)) return false;
+        CacheHeader header{};
+        std::ifstream is(cachePath, std::ios::binary);
+        return is.read(reinterpret_cast<char*>(&header), sizeof(header)) && valid(header);
+    }
+
+    [[nodiscard]] std::span<const CachedTest> tests() const { return m_tests; }
+    [[nodiscard]] std::span<const RamEntry> ram(const uint32_t first, const uint32_t count) const
+    {
+        return m_ram.subspan(first, count);
+    }
+    [[nodiscard]] std::span<const RamZ80Interface::IoOperation> ports(const CachedTest& test) const
+    {
+        return m_ports.subspan(test.ports, test.portsCount);
+    }
+    [[nodiscard]] std::string_view name(const CachedTest& test) const
+    {
+        return m_names.substr(test.name, test.nameSize);
+    }
+
+private:
+    static bool valid(const CacheHeader& header)
+    {
+        return header.magic == CacheHeader::Magic && header.version == CacheHeader::Version &&
+               header.testSize == sizeof(CachedTest);
+    }
+
+    MappedFile m_file;
+    CacheHeader m_header{};
+    std::span<const CachedTest> m_tests;
+    std::span<const RamEntry> m_ram;
+    std::span<const RamZ80Interface::IoOperation> m_ports;
+    std::string_view m_names;
+};
+
+#define CHECK_VALUE(key, width, actual, expected)                                                                    \
+    if ((actual) != (expected))                                                                                      \
+    {                                                                                                                \
+        os << "Test " << name << " KO\t" << key << "\texpected: 0x" << std::hex << std::setw((width) * 2)            \
+           << std::setfill('0') << (int)(expected) << "\tactual: 0x" << std::hex << std::setw((width) * 2)           \
+           << std::setfill('0') << (int)(actual) << "\n";                                                            \
+        success = false;                                                                                             \
+    }                                                                                                                \
     else
 
-bool executeTest(RamZ80Interface& interface, epoch::zxspectrum::Z80Cpu& cpu, const TestInfo& testInfo)
+bool executeTest(RamZ80Interface& interface, epoch::zxspectrum::Z80Cpu& cpu, const TestSuite& suite,
+                 const CachedTest& test, std::ostream& os)
 {
+    const auto name = suite.name(test);
     cpu.reset();
 
-    cpu.registers().pc = testInfo.initial.pc;
-    cpu.registers().sp = testInfo.initial.sp;
-    cpu.registers().af.high = testInfo.initial.a;
-    cpu.registers().af.low = testInfo.initial.f;
-    cpu.registers().bc.high = testInfo.initial.b;
-    cpu.registers().bc.low = testInfo.initial.c;
-    cpu.registers().de.high = testInfo.initial.d;
-    cpu.registers().de.low = testInfo.initial.e;
-    cpu.registers().hl.high = testInfo.initial.h;
-    cpu.registers().hl.low = testInfo.initial.l;
-    cpu.registers().ir.high = testInfo.initial.i;
-    cpu.registers().ir.low = testInfo.initial.r;
+    cpu.registers().pc = test.initial.pc;
+    cpu.registers().sp = test.initial.sp;
+    cpu.registers().af.high = test.initial.a;
+    cpu.registers().af.low = test.initial.f;
+    cpu.registers().bc.high = test.initial.b;
+    cpu.registers().bc.low = test.initial.c;
+    cpu.registers().de.high = test.initial.d;
+    cpu.registers().de.low = test.initial.e;
+    cpu.registers().hl.high = test.initial.h;
+    cpu.registers().hl.low = test.initial.l;
+    cpu.registers().ir.high = test.initial.i;
+    cpu.registers().ir.low = test.initial.r;
     // EI (?)
-    cpu.registers().wz = testInfo.initial.wz;
-    cpu.registers().ix = testInfo.initial.ix;
-    cpu.registers().iy = testInfo.initial.iy;
-    cpu.registers().af2 = testInfo.initial.af_;
-    cpu.registers().bc2 = testInfo.initial.bc_;
-    cpu.registers().de2 = testInfo.initial.de_;
-    cpu.registers().hl2 = testInfo.initial.hl_;
-    cpu.registers().interruptMode = testInfo.initial.im;
-    cpu.registers().iff1 = testInfo.initial.iff1;
-    cpu.registers().iff2 = testInfo.initial.iff2;
-    for (const auto& [address, value] : testInfo.initial.ram)
+    cpu.registers().wz = test.initial.wz;
+    cpu.registers().ix = test.initial.ix;
+    cpu.registers().iy = test.initial.iy;
+    cpu.registers().af2 = test.initial.af_;
+    cpu.registers().bc2 = test.initial.bc_;
+    cpu.registers().de2 = test.initial.de_;
+    cpu.registers().hl2 = test.initial.hl_;
+    cpu.registers().interruptMode = test.initial.im;
+    cpu.registers().iff1 = test.initial.iff1;
+    cpu.registers().iff2 = test.initial.iff2;
+    for (const auto& [address, value] : suite.ram(test.initialRam, test.initialRamCount))
     {
         interface.ram()[address] = value;
     }
-    interface.setIoOperations(testInfo.ports);
+    interface.setIoOperations(suite.ports(test));
     auto success = true;
 
     try
     {
-        for (auto i = 0; i < testInfo.cycles; i++)
+        for (uint32_t i = 0; i < test.cycles; i++)
         {
             cpu.clock();
         }
     }
     catch (std::runtime_error& err)
     {
-        std::cout << "Test " << testInfo.name << " KO\t" << err.what() << "\n";
+        os << "Test " << name << " KO\t" << err.what() << "\n";
         success = false;
     }
 
-    CHECK_VALUE("PC", 2, cpu.registers().pc, testInfo.final.pc);
-    CHECK_VALUE("SP", 2, cpu.registers().sp, testInfo.final.sp);
-    CHECK_VALUE("A", 1, cpu.registers().af.high, testInfo.final.a);
-    CHECK_VALUE("F", 1, cpu.registers().af.low, testInfo.final.f);
-    CHECK_VALUE("B", 1, cpu.registers().bc.high, testInfo.final.b);
-    CHECK_VALUE("C", 1, cpu.registers().bc.low, testInfo.final.c);
-    CHECK_VALUE("D", 1, cpu.registers().de.high, testInfo.final.d);
-    CHECK_VALUE("E", 1, cpu.registers().de.low, testInfo.final.e);
-    CHECK_VALUE("H", 1, cpu.registers().hl.high, testInfo.final.h);
-    CHECK_VALUE("L", 1, cpu.registers().hl.low, testInfo.final.l);
-    CHECK_VALUE("I", 1, cpu.registers().ir.high, testInfo.final.i);
-    CHECK_VALUE("R", 1, cpu.registers().ir.low, testInfo.final.r);
-    CHECK_VALUE("WZ", 2, cpu.registers().wz, testInfo.final.wz);
-    CHECK_VALUE("IX", 2, cpu.registers().ix, testInfo.final.ix);
-    CHECK_VALUE("IY", 2, cpu.registers().iy, testInfo.final.iy);
-    CHECK_VALUE("AF2", 2, cpu.registers().af2, testInfo.final.af_);
-    CHECK_VALUE("BC2", 2, cpu.registers().bc2, testInfo.final.bc_);
-    CHECK_VALUE("DE2", 2, cpu.registers().de2, testInfo.final.de_);
-    CHECK_VALUE("HL2", 2, cpu.registers().hl2, testInfo.final.hl_);
-    CHECK_VALUE("IM", 1, cpu.registers().interruptMode, testInfo.final.im);
-    CHECK_VALUE("IFF1", 1, cpu.registers().iff1, testInfo.final.iff1);
-    CHECK_VALUE("IFF2", 1, cpu.registers().iff2, testInfo.final.iff2);
-
-    for (const auto& [address, value] : testInfo.final.ram)
+    CHECK_VALUE("PC", 2, cpu.registers().pc, test.final.pc);
+    CHECK_VALUE("SP", 2, cpu.registers().sp, test.final.sp);
+    CHECK_VALUE("A", 1, cpu.registers().af.high, test.final.a);
+    CHECK_VALUE("F", 1, cpu.registers().af.low, test.final.f);
+    CHECK_VALUE("B", 1, cpu.registers().bc.high, test.final.b);
+    CHECK_VALUE("C", 1, cpu.registers().bc.low, test.final.c);
+    CHECK_VALUE("D", 1, cpu.registers().de.high, test.final.d);
+    CHECK_VALUE("E", 1, cpu.registers().de.low, test.final.e);
+    CHECK_VALUE("H", 1, cpu.registers().hl.high, test.final.h);
+    CHECK_VALUE("L", 1, cpu.registers().hl.low, test.final.l);
+    CHECK_VALUE("I", 1, cpu.registers().ir.high, test.final.i);
+    CHECK_VALUE("R", 1, cpu.registers().ir.low, test.final.r);
+    CHECK_VALUE("WZ", 2, cpu.registers().wz, test.final.wz);
+    CHECK_VALUE("IX", 2, cpu.registers().ix, test.final.ix);
+    CHECK_VALUE("IY", 2, cpu.registers().iy, test.final.iy);
+    CHECK_VALUE("AF2", 2, cpu.registers().af2, test.final.af_);
+    CHECK_VALUE("BC2", 2, cpu.registers().bc2, test.final.bc_);
+    CHECK_VALUE("DE2", 2, cpu.registers().de2, test.final.de_);
+    CHECK_VALUE("HL2", 2, cpu.registers().hl2, test.final.hl_);
+    CHECK_VALUE("IM", 1, cpu.registers().interruptMode, test.final.im);
+    CHECK_VALUE("IFF1", 1, cpu.registers().iff1, test.final.iff1);
+    CHECK_VALUE("IFF2", 1, cpu.registers().iff2, test.final.iff2);
+
+    for (const auto& [address, value] : suite.ram(test.finalRam, test.finalRamCount))
     {
         CHECK_VALUE("RAM[0x" << std::hex << std::setw(4) << std::setfill('0') << address << "]", 1,
                     interface.ram()[address], value);
@@ -220,50 +441,80 @@ bool executeTest(RamZ80Interface& interface, epoch::zxspectrum::Z80Cpu& cpu, con
     return success;
 }
 
-int executeTestSuite(RamZ80Interface& interface, epoch::zxspectrum::Z80Cpu& cpu,
-                     const std::filesystem::path& testSuitePath)
+struct TestSuiteResult
 {
-    std::ifstream fs(testSuitePath);
-    const auto j = nlohmann::json::parse(fs);
-    auto failed = 0;
-    for (const auto& it : j)
+    std::string output;
+    int failed{};
+};
+
+void executeTestSuite(const std::filesystem::path& testSuitePath, TestSuiteResult& result)
+{
+    std::ostringstream os;
+    try
     {
-        const auto testInfo = it.get<TestInfo>();
-        if (!executeTest(interface, cpu, testInfo))
+        auto cachePath = testSuitePath;
+        cachePath.replace_extension(".bin");
+        if (!TestSuite::upToDate(testSuitePath, cachePath)) buildCache(testSuitePath, cachePath);
+        const TestSuite suite{cachePath};
+
+        const auto interface = std::make_unique<RamZ80Interface>();
+        epoch::zxspectrum::Z80Cpu cpu{*interface};
+        for (const auto& test : suite.tests())
         {
-            failed++;
+            if (!executeTest(*interface, cpu, suite, test, os))
+            {
+                result.failed++;
+            }
         }
     }
-    return failed;
+    catch (const std::exception& err)
+    {
+        os << "Test suite " << testSuitePath.filename().string() << " KO\t" << err.what() << "\n";
+        result.failed++;
+    }
+    result.output = std::move(os).str();
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view{argv[i]} == "--jobs" && i + 1 < argc)
+        {
+            jobs = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--jobs <n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     const std::filesystem::path path = std::filesystem::weakly_canonical("z80/v1");
-    const auto files = findJsons(path);
-    if (files.empty())
+    const auto found = findJsons(path);
+    if (found.empty())
     {
         std::cerr << "No input files found in " << path << "\n";
         std::cout << "Please download Z80 json tests from "
                      "https://github.com/raddad772/jsmoo/tree/main/misc/tests/GeneratedTests/z80\n";
         return EXIT_FAILURE;
     }
-    std::cout << "Found " << files.size() << " files in " << path << std::endl;
-
-    RamZ80Interface interface;
-    epoch::zxspectrum::Z80Cpu cpu{interface};
+    std::cout << "Found " << found.size() << " files in " << path << std::endl;
+    const std::vector<std::filesystem::path> files{found.begin(), found.end()};
 
     const auto startTime = std::chrono::high_resolution_clock::now();
 
-    auto remaining = files.size();
+    // Every file runs in its own CPU, the first run also converts it into the binary cache
+    std::vector<TestSuiteResult> results(files.size());
     auto failed = 0;
-    for (const auto& testSuitePath : files)
-    {
-        remaining--;
-        // if (testSuitePath.filename().generic_string().starts_with("ed"))
-        // if (testSuitePath.filename().generic_string().starts_with("dd cb __ cb"))
-        failed += executeTestSuite(interface, cpu, testSuitePath);
-    }
+    runOrdered(
+        files.size(), jobs, [&](const std::size_t index) { executeTestSuite(files[index], results[index]); },
+        [&](const std::size_t index) {
+            std::cout << results[index].output;
+            failed += results[index].failed;
+            results[index].output = {};
+        });
 
     const auto stopTime = std::chrono::high_resolution_clock::now();
     const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stopTime - startTime);
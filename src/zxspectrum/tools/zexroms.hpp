@@ -0,0 +1,931 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_EPOCH_ZXSPECTRUM_TOOLS_ZEXROMS_HPP_
+#define SRC_EPOCH_ZXSPECTRUM_TOOLS_ZEXROMS_HPP_
+
+#include <cstdint>
+
+// Source: https://mdfs.net/Software/Z80/Exerciser/
+
+inline constexpr uint8_t zexdoc[] = {
+    0xc3, 0x13, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2a, 0x06, 0x00, 0xf9, 0x11, 0xda, 0x1d, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0x21, 0x3a, 0x01, 0x7e, 0x23, 0xb6, 0xca,
+    0x2f, 0x01, 0x2b, 0xcd, 0xe2, 0x1a, 0xc3, 0x22, 0x01, 0x11, 0xf9, 0x1d, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0xc3, 0x00,
+    0x00, 0xc2, 0x01, 0x22, 0x02, 0x82, 0x02, 0xe2, 0x02, 0x42, 0x03, 0xa2, 0x03, 0x02, 0x04, 0x62, 0x04, 0xc2, 0x04,
+    0x22, 0x05, 0x82, 0x05, 0xe2, 0x05, 0x42, 0x06, 0xa2, 0x06, 0x02, 0x07, 0x62, 0x07, 0xc2, 0x07, 0x22, 0x08, 0x82,
+    0x08, 0xe2, 0x08, 0x42, 0x09, 0xa2, 0x09, 0x02, 0x0a, 0x62, 0x0a, 0xc2, 0x0a, 0x22, 0x0b, 0x82, 0x0b, 0xe2, 0x0b,
+    0x42, 0x0c, 0xa2, 0x0c, 0x02, 0x0d, 0x62, 0x0d, 0xc2, 0x0d, 0x22, 0x0e, 0x82, 0x0e, 0xe2, 0x0e, 0x42, 0x0f, 0xa2,
+    0x0f, 0x02, 0x10, 0x62, 0x10, 0xc2, 0x10, 0x22, 0x11, 0x82, 0x11, 0xe2, 0x11, 0x42, 0x12, 0xa2, 0x12, 0x02, 0x13,
+    0x62, 0x13, 0xc2, 0x13, 0x22, 0x14, 0x82, 0x14, 0xe2, 0x14, 0x42, 0x15, 0xa2, 0x15, 0x02, 0x16, 0x62, 0x16, 0xc2,
+    0x16, 0x22, 0x17, 0x82, 0x17, 0xe2, 0x17, 0x42, 0x18, 0xa2, 0x18, 0x02, 0x19, 0x62, 0x19, 0xc2, 0x19, 0x22, 0x1a,
+    0x82, 0x1a, 0x00, 0x00, 0xc7, 0xed, 0x42, 0x00, 0x00, 0x2c, 0x83, 0x88, 0x4f, 0x2b, 0xf2, 0x39, 0xb3, 0x1f, 0x7e,
+    0x63, 0x15, 0xd3, 0x89, 0x5e, 0x46, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xf8, 0xb4, 0xea, 0xa9, 0x3c, 0x61, 0x64, 0x63, 0x2c, 0x73, 0x62,
+    0x63, 0x3e, 0x20, 0x68, 0x6c, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xc7, 0x09, 0x00, 0x00, 0x00, 0xa5, 0xc4, 0xc7, 0xc4, 0x26, 0xd2, 0x50, 0xa0, 0xea,
+    0x58, 0x66, 0x85, 0xc6, 0xde, 0xc9, 0x9b, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0x89, 0xfd, 0xb6, 0x35, 0x61, 0x64, 0x64, 0x20, 0x68, 0x6c,
+    0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xc7, 0xdd, 0x09, 0x00, 0x00, 0xac, 0xdd, 0x94, 0xc2, 0x5b, 0x63, 0xd3, 0x33,
+    0x76, 0x6a, 0x20, 0xfa, 0x94, 0x68, 0xf5, 0x36, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xc1, 0x33, 0x79, 0x0b, 0x61, 0x64, 0x64, 0x20, 0x69,
+    0x78, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x69, 0x78, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xc7, 0xfd, 0x09, 0x00, 0x00, 0xc2, 0xc7, 0x07, 0xf4, 0xc1, 0x51, 0x96,
+    0x3e, 0xf4, 0x0b, 0x0f, 0x51, 0x92, 0x1e, 0xea, 0x71, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xe8, 0x81, 0x7b, 0x9e, 0x61, 0x64, 0x64, 0x20,
+    0x69, 0x79, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x69, 0x79, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xc6, 0x00, 0x00, 0x00, 0x40, 0x91, 0x3c, 0x7e, 0x67, 0x7a,
+    0x6d, 0xdf, 0x61, 0x5b, 0x29, 0x0b, 0x10, 0x66, 0xb2, 0x85, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x48, 0x79, 0x93, 0x60, 0x61, 0x6c, 0x75,
+    0x6f, 0x70, 0x20, 0x61, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x80, 0x00, 0x00, 0x00, 0x3e, 0xc5, 0x3a, 0x57, 0x4d,
+    0x4c, 0x03, 0x01, 0x09, 0xe3, 0x66, 0xa6, 0xd0, 0x3b, 0xbb, 0xad, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0x00, 0x00, 0xfe, 0x43, 0xb0, 0x16, 0x61, 0x6c,
+    0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c,
+    0x28, 0x68, 0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x84, 0x00, 0x00, 0xf7, 0xd6, 0x6e, 0xc7,
+    0xcf, 0xac, 0x47, 0x28, 0xdd, 0x22, 0x35, 0xc0, 0xc5, 0x38, 0x4b, 0x23, 0x20, 0x39, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0x00, 0x00, 0xa4, 0x02, 0x6d, 0x5a, 0x61,
+    0x6c, 0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x3c, 0x69, 0x78, 0x68, 0x2c, 0x69, 0x78, 0x6c, 0x2c, 0x69, 0x79, 0x68,
+    0x2c, 0x69, 0x79, 0x6c, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x86, 0x01, 0x00, 0xb7, 0x90, 0x02,
+    0x01, 0x02, 0x01, 0xfd, 0x32, 0x6e, 0x40, 0xdc, 0xc1, 0x45, 0x6e, 0xfa, 0xe5, 0x20, 0x38, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xe8, 0x49, 0x67, 0x6e,
+    0x61, 0x6c, 0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0x53, 0xdd, 0xcb, 0x01, 0x46, 0x75, 0x20,
+    0x02, 0x01, 0x02, 0x01, 0xfc, 0x3c, 0x9a, 0xa7, 0x74, 0x3d, 0x51, 0x27, 0x14, 0xca, 0x20, 0x00, 0x00, 0x38, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa8, 0xee, 0x08,
+    0x67, 0x62, 0x69, 0x74, 0x20, 0x6e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0x53, 0xcb, 0x40, 0x00, 0x00, 0xf1,
+    0x3e, 0xfc, 0x9d, 0xcc, 0x7a, 0x03, 0x01, 0x61, 0xbe, 0x86, 0x7a, 0x50, 0x24, 0x98, 0x19, 0x00, 0x3f, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0x00, 0x00, 0x7b, 0x55,
+    0xe6, 0xc8, 0x62, 0x69, 0x74, 0x20, 0x6e, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c,
+    0x6c, 0x2c, 0x28, 0x68, 0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xed, 0xa9, 0x00, 0x00,
+    0xb6, 0xc7, 0xb4, 0x72, 0xf6, 0x18, 0x14, 0x01, 0xbd, 0x8d, 0x01, 0x00, 0xc0, 0x30, 0xa3, 0x94, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xa8,
+    0x7e, 0x6c, 0xfa, 0x63, 0x70, 0x64, 0x3c, 0x72, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xed, 0xa1, 0x00,
+    0x00, 0x48, 0x4d, 0x4a, 0xaf, 0x6b, 0x90, 0x03, 0x01, 0x71, 0x4e, 0x01, 0x00, 0x93, 0x6a, 0x7c, 0x90, 0x00, 0x10,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00,
+    0x06, 0xde, 0xb3, 0x56, 0x63, 0x70, 0x69, 0x3c, 0x72, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x27, 0x00,
+    0x00, 0x00, 0x41, 0x21, 0xfa, 0x09, 0x60, 0x1d, 0x59, 0xa5, 0x5b, 0x8d, 0x79, 0x90, 0x04, 0x8e, 0x9d, 0x29, 0x18,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x9b, 0x4b, 0xa6, 0x75, 0x3c, 0x64, 0x61, 0x61, 0x2c, 0x63, 0x70, 0x6c, 0x2c, 0x73, 0x63, 0x66, 0x2c, 0x63,
+    0x63, 0x66, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x3c,
+    0x00, 0x00, 0x00, 0xdf, 0x4a, 0xd8, 0xd5, 0x98, 0xe5, 0x2b, 0x8a, 0xb0, 0xa7, 0x1b, 0x43, 0x44, 0x5a, 0x30, 0xd0,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00,
+    0x00, 0x00, 0xd1, 0x88, 0x15, 0xa4, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x61, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7,
+    0x04, 0x00, 0x00, 0x00, 0x23, 0xd6, 0x2d, 0x43, 0x61, 0x7a, 0x80, 0x81, 0x86, 0x5a, 0x85, 0x1e, 0x86, 0x58, 0xbb,
+    0x9b, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7,
+    0x00, 0x00, 0x00, 0x5f, 0x68, 0x22, 0x64, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x62, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xd7, 0x03, 0x00, 0x00, 0x00, 0x97, 0xcd, 0xab, 0x44, 0xc9, 0x8d, 0xe3, 0xe3, 0xcc, 0x11, 0xa4, 0xe8, 0x02, 0x49,
+    0x4d, 0x2a, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xd7, 0x00, 0x00, 0x00, 0xd2, 0xae, 0x3b, 0xec, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x62,
+    0x63, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xd7, 0x0c, 0x00, 0x00, 0x00, 0x89, 0xd7, 0x35, 0x09, 0x5b, 0x05, 0x85, 0x9f, 0x27, 0x8b, 0x08, 0xd2, 0x95,
+    0x05, 0x60, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xd7, 0x00, 0x00, 0x00, 0xc2, 0x84, 0x55, 0x4c, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20,
+    0x63, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xd7, 0x14, 0x00, 0x00, 0x00, 0xea, 0xa0, 0xba, 0x5f, 0xfb, 0x65, 0x1c, 0x98, 0xcc, 0x38, 0xbc, 0xde,
+    0x43, 0x5c, 0xbd, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x45, 0x23, 0xde, 0x10, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e,
+    0x20, 0x64, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xd7, 0x13, 0x00, 0x00, 0x00, 0x2e, 0x34, 0x1d, 0x13, 0xc9, 0x28, 0xca, 0x0a, 0x67, 0x99, 0x2e,
+    0x3a, 0x92, 0xf6, 0x54, 0x9d, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xae, 0xc6, 0xd4, 0x2c, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63,
+    0x3e, 0x20, 0x64, 0x65, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x1c, 0x00, 0x00, 0x00, 0x2f, 0x60, 0x0d, 0x4c, 0x02, 0x24, 0xf5, 0xe2, 0xf4, 0xa0,
+    0x0a, 0xa1, 0x13, 0x32, 0x25, 0x59, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xe1, 0x75, 0xaf, 0xcc, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65,
+    0x63, 0x3e, 0x20, 0x65, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x24, 0x00, 0x00, 0x00, 0x06, 0x15, 0xeb, 0xf2, 0xdd, 0xe8, 0x2b, 0x26, 0xa6,
+    0x11, 0x1a, 0xbc, 0x17, 0x06, 0x18, 0x28, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x1c, 0xed, 0x84, 0x7d, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64,
+    0x65, 0x63, 0x3e, 0x20, 0x68, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x23, 0x00, 0x00, 0x00, 0xf4, 0xc3, 0xa5, 0x07, 0x6d, 0x1b, 0x04, 0x4f,
+    0xc2, 0xe2, 0x2a, 0x82, 0x57, 0xe0, 0xe1, 0xc3, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21,
+    0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xfc, 0x0d, 0x6d, 0x4a, 0x3c, 0x69, 0x6e, 0x63, 0x2c,
+    0x64, 0x65, 0x63, 0x3e, 0x20, 0x68, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x23, 0x00, 0x00, 0x3c, 0xbc, 0x9b, 0x0d, 0x81, 0xe0, 0xfd,
+    0xad, 0x7f, 0x9a, 0xe5, 0x96, 0x13, 0x85, 0xe2, 0x0b, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xa5, 0x4d, 0xbe, 0x31, 0x3c, 0x69, 0x6e, 0x63,
+    0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xfd, 0x23, 0x00, 0x00, 0x02, 0x94, 0x7a, 0x63, 0x82, 0x31,
+    0x5a, 0xc6, 0xe9, 0xb2, 0xb4, 0xab, 0x16, 0xf2, 0x05, 0x6d, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x50, 0x5d, 0x51, 0xa3, 0x3c, 0x69, 0x6e,
+    0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x2c, 0x00, 0x00, 0x00, 0x31, 0x80, 0x20, 0xa5, 0x56,
+    0x43, 0x09, 0xb4, 0xc1, 0xf4, 0xa2, 0xdf, 0xd1, 0x3c, 0xa2, 0x3e, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x56, 0xcd, 0x06, 0xf3, 0x3c, 0x69,
+    0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x34, 0x00, 0x00, 0x00, 0x56, 0xb8, 0x7c, 0x0c,
+    0x3e, 0xe5, 0x03, 0x01, 0x7e, 0x87, 0x58, 0xda, 0x15, 0x5c, 0x37, 0x1f, 0x01, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xb8, 0x3a, 0xdc, 0xef, 0x3c,
+    0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x28, 0x68, 0x6c, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x33, 0x00, 0x00, 0x00, 0x6f, 0x34, 0x82,
+    0xd4, 0x69, 0xd1, 0xb6, 0xde, 0x94, 0xa4, 0x76, 0xf4, 0x53, 0x02, 0x5b, 0x85, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x5d, 0xac, 0xd5, 0x27,
+    0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x73, 0x70, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x34, 0x01, 0x00, 0x6e, 0xfa,
+    0x02, 0x01, 0x02, 0x01, 0x28, 0x2c, 0x94, 0x88, 0x57, 0x50, 0x16, 0x33, 0x6f, 0x28, 0x20, 0x01, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x20, 0x58, 0x14,
+    0x70, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e,
+    0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x24, 0x00, 0x00, 0x38,
+    0xb8, 0x6c, 0x31, 0xd4, 0xc6, 0x01, 0x3e, 0x58, 0x83, 0xb4, 0x15, 0x81, 0xde, 0x59, 0x42, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x6f, 0x46,
+    0x36, 0x62, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x68, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x2c, 0x00, 0x00,
+    0x14, 0x4d, 0x60, 0x74, 0xd4, 0x76, 0xe7, 0x06, 0xa2, 0x32, 0x3c, 0x21, 0xd6, 0xd7, 0xa5, 0x99, 0x00, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x02,
+    0x7b, 0xef, 0x2c, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x6c, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x24, 0x00,
+    0x00, 0x36, 0x28, 0x6f, 0x9f, 0x16, 0x91, 0xb9, 0x61, 0xcb, 0x82, 0x19, 0xe2, 0x92, 0x73, 0x8c, 0xa9, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00,
+    0x2d, 0x96, 0x6c, 0xf3, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x68, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x2c,
+    0x00, 0x00, 0xc6, 0xd7, 0xd5, 0x62, 0x9e, 0xa0, 0x39, 0x70, 0x7e, 0x3e, 0x12, 0x9f, 0x90, 0xd9, 0x0f, 0x22, 0x00,
+    0x01, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00,
+    0x00, 0xfb, 0xcb, 0xba, 0x95, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x6c, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xed,
+    0x4b, 0x03, 0x01, 0xa8, 0xf9, 0x59, 0xf5, 0xa4, 0x93, 0xed, 0xf5, 0x96, 0x6f, 0x68, 0xd9, 0x86, 0xe6, 0xd8, 0x4b,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x4d, 0x45, 0xa9, 0xac, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x2c, 0x28, 0x6e,
+    0x6e, 0x6e, 0x6e, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7,
+    0x2a, 0x03, 0x01, 0x00, 0x63, 0x98, 0x30, 0x78, 0x77, 0x20, 0xfe, 0xb1, 0xfa, 0xb9, 0xb8, 0xab, 0x04, 0x06, 0x15,
+    0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x5f, 0x97, 0x24, 0x87, 0x6c, 0x64, 0x20, 0x68, 0x6c, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xd7, 0xed, 0x7b, 0x03, 0x01, 0xfc, 0x8d, 0xd7, 0x57, 0x61, 0x21, 0x18, 0xca, 0x85, 0xc1, 0xda, 0x27, 0x83, 0x1e,
+    0x60, 0xf4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x7a, 0xce, 0xa1, 0x1b, 0x6c, 0x64, 0x20, 0x73, 0x70, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e,
+    0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xd7, 0xdd, 0x2a, 0x03, 0x01, 0xd7, 0xde, 0xfa, 0xa6, 0x80, 0xf7, 0x4c, 0x24, 0xde, 0x87, 0xc2, 0xbc, 0x16,
+    0x63, 0x96, 0x4c, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x85, 0x8b, 0xf1, 0x6d, 0x6c, 0x64, 0x20, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e,
+    0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xd7, 0xed, 0x43, 0x03, 0x01, 0x98, 0x1f, 0x4d, 0x84, 0xac, 0xe8, 0xed, 0xc9, 0x5d, 0xc9, 0x61, 0x8f,
+    0x80, 0x3f, 0xbf, 0xc7, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x64, 0x1e, 0x87, 0x15, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29,
+    0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xd7, 0x22, 0x03, 0x01, 0x00, 0x03, 0xd0, 0x72, 0x77, 0x53, 0x7f, 0x72, 0x3f, 0xea, 0x64, 0x80,
+    0xe1, 0x10, 0x2d, 0xe9, 0x35, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa3, 0x60, 0x8b, 0x47, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e,
+    0x29, 0x2c, 0x68, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xed, 0x73, 0x03, 0x01, 0xdc, 0xc0, 0xd6, 0xd1, 0x5a, 0xed, 0x56, 0xf3, 0xda, 0xaf,
+    0xa7, 0x6c, 0x44, 0x9f, 0x0a, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x16, 0x58, 0x5f, 0xd7, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e,
+    0x6e, 0x29, 0x2c, 0x73, 0x70, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x22, 0x03, 0x01, 0xc3, 0x6c, 0x91, 0x0d, 0x00, 0x69, 0xf8, 0x8e, 0xd6,
+    0xe3, 0xf7, 0xc3, 0xc6, 0xd9, 0xdf, 0xc2, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xba, 0x10, 0x2a, 0x6b, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e,
+    0x6e, 0x6e, 0x29, 0x2c, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x01, 0x00, 0x00, 0x00, 0x1c, 0x5c, 0x46, 0x2d, 0xb9, 0x8e, 0x78, 0x60,
+    0xb1, 0x74, 0x0e, 0xb3, 0x46, 0xd1, 0xcc, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xde, 0x39, 0x19, 0x69, 0x6c, 0x64, 0x20, 0x3c, 0x62,
+    0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e, 0x2c, 0x6e, 0x6e, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x21, 0x00, 0x00, 0xe8, 0x87, 0x06, 0x20, 0x12, 0xbd, 0x9b,
+    0xb6, 0x53, 0x72, 0xe5, 0xa1, 0x51, 0x13, 0xbd, 0xf1, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x22, 0x7d, 0xd5, 0x25, 0x6c, 0x64, 0x20, 0x3c,
+    0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2c, 0x6e, 0x6e, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x0a, 0x00, 0x00, 0x00, 0xa8, 0xb3, 0x2a, 0x1d, 0x8e, 0x7f,
+    0xac, 0x42, 0x03, 0x01, 0x03, 0x01, 0xc6, 0xb1, 0x8e, 0xef, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0xb0, 0x81, 0x89, 0x35, 0x6c, 0x64, 0x20,
+    0x61, 0x2c, 0x3c, 0x28, 0x62, 0x63, 0x29, 0x2c, 0x28, 0x64, 0x65, 0x29, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x06, 0x00, 0x00, 0x00, 0x07, 0xc4, 0x9d, 0xf4, 0x3d,
+    0xd1, 0x39, 0x03, 0x89, 0xde, 0x55, 0x74, 0x53, 0xc0, 0x09, 0x55, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0xf1, 0xda, 0xb5, 0x56, 0x6c, 0x64,
+    0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c, 0x28, 0x68, 0x6c, 0x29, 0x2c,
+    0x61, 0x3e, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x36, 0x01, 0x00, 0x45, 0x1b, 0x02, 0x01,
+    0x02, 0x01, 0xc1, 0xd5, 0xc7, 0x61, 0xc4, 0xbd, 0xc0, 0x85, 0x16, 0xcd, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x26, 0xdb, 0x47, 0x7e, 0x6c,
+    0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x46, 0x01, 0x00, 0x16, 0xd0, 0x02,
+    0x01, 0x02, 0x01, 0x60, 0x42, 0x39, 0x7f, 0x04, 0x04, 0x97, 0x4a, 0x85, 0xd0, 0x20, 0x18, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xcc, 0x11, 0x06, 0xa8,
+    0x6c, 0x64, 0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x3e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69,
+    0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x66, 0x01, 0x00, 0xe0, 0x84,
+    0x02, 0x01, 0x02, 0x01, 0x52, 0x9c, 0x99, 0xa7, 0xb6, 0x49, 0x93, 0x00, 0xad, 0xee, 0x20, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfa, 0x2a, 0x4d,
+    0x03, 0x6c, 0x64, 0x20, 0x3c, 0x68, 0x2c, 0x6c, 0x3e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b,
+    0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x7e, 0x01, 0x00, 0xb6,
+    0xd8, 0x02, 0x01, 0x02, 0x01, 0x12, 0xc6, 0x07, 0xdf, 0xd0, 0x9c, 0x43, 0xa6, 0xe5, 0xa0, 0x20, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa5, 0xe9,
+    0xac, 0x64, 0x6c, 0x64, 0x20, 0x61, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x26, 0x00, 0x00,
+    0x53, 0x3c, 0x40, 0x46, 0x79, 0xe1, 0x11, 0x77, 0x07, 0xc1, 0xfa, 0x1a, 0x81, 0xad, 0x9b, 0x5d, 0x20, 0x08, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x24,
+    0xe8, 0x82, 0x8b, 0x6c, 0x64, 0x20, 0x3c, 0x69, 0x78, 0x68, 0x2c, 0x69, 0x78, 0x6c, 0x2c, 0x69, 0x79, 0x68, 0x2c,
+    0x69, 0x79, 0x6c, 0x3e, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x40, 0x00, 0x00,
+    0x00, 0xa4, 0x72, 0x24, 0xa0, 0xac, 0x61, 0x03, 0x01, 0xc7, 0x82, 0x8f, 0x71, 0x97, 0x8f, 0x8e, 0xef, 0x3f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00, 0x00,
+    0x74, 0x4b, 0x01, 0x18, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x68, 0x6c, 0x61, 0x3e, 0x2c, 0x3c, 0x62,
+    0x63, 0x64, 0x65, 0x68, 0x6c, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x40,
+    0x00, 0x00, 0xc5, 0xbc, 0x03, 0x01, 0x03, 0x01, 0x03, 0x01, 0xc2, 0x2f, 0xc0, 0x98, 0x83, 0x1f, 0xcd, 0x3b, 0x20,
+    0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00,
+    0x00, 0x47, 0x8b, 0xa3, 0x6b, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x78, 0x79, 0x61, 0x3e, 0x2c, 0x3c,
+    0x62, 0x63, 0x64, 0x65, 0x78, 0x79, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x32,
+    0x03, 0x01, 0x00, 0x68, 0xfd, 0xec, 0xf4, 0xa0, 0x44, 0x43, 0xb5, 0x53, 0x06, 0xba, 0xcd, 0xd2, 0x4f, 0xd8, 0x1f,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff,
+    0x00, 0x00, 0xc9, 0x26, 0x2d, 0xe5, 0x6c, 0x64, 0x20, 0x61, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x20, 0x2f,
+    0x20, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x2c, 0x61, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7,
+    0xed, 0xa8, 0x00, 0x00, 0x52, 0x98, 0xfa, 0x68, 0xa1, 0x66, 0x06, 0x01, 0x04, 0x01, 0x01, 0x00, 0xc1, 0x68, 0xb7,
+    0x20, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7,
+    0x00, 0x00, 0x00, 0x94, 0xf4, 0x27, 0x69, 0x6c, 0x64, 0x64, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x31, 0x29, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xd7, 0xed, 0xa8, 0x00, 0x00, 0x2e, 0xf1, 0x2a, 0xeb, 0xba, 0xd5, 0x06, 0x01, 0x04, 0x01, 0x02, 0x00, 0x47, 0xff,
+    0xe4, 0xfb, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xd7, 0x00, 0x00, 0x00, 0x5a, 0x90, 0x7e, 0xd4, 0x6c, 0x64, 0x64, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x32, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xd7, 0xed, 0xa0, 0x00, 0x00, 0x30, 0xfe, 0xcd, 0x03, 0x58, 0x60, 0x05, 0x01, 0x03, 0x01, 0x01, 0x00, 0x04,
+    0x60, 0x88, 0x26, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xd7, 0x00, 0x00, 0x00, 0x9a, 0xbd, 0xf6, 0xb5, 0x6c, 0x64, 0x69, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x31, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xd7, 0xed, 0xa0, 0x00, 0x00, 0xce, 0x4a, 0x6e, 0xc2, 0x88, 0xb1, 0x05, 0x01, 0x03, 0x01, 0x02, 0x00,
+    0x14, 0x2d, 0x9f, 0xa3, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xeb, 0x59, 0x89, 0x1b, 0x6c, 0x64, 0x69, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x32,
+    0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xd7, 0xed, 0x44, 0x00, 0x00, 0xa2, 0x38, 0x6b, 0x5f, 0x34, 0xd9, 0xe4, 0x57, 0xd6, 0xd2, 0x42,
+    0x46, 0x43, 0x5a, 0xcc, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6a, 0x3c, 0x3b, 0xbd, 0x6e, 0x65, 0x67, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xed, 0x67, 0x00, 0x00, 0xcb, 0x91, 0x8b, 0xc4, 0x62, 0xfa, 0x03, 0x01, 0x20, 0xe7,
+    0x79, 0xb4, 0x40, 0x06, 0xe2, 0x8a, 0x00, 0x08, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0x95, 0x5b, 0xa3, 0x26, 0x3c, 0x72, 0x72, 0x64, 0x2c, 0x72, 0x6c,
+    0x64, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x07, 0x00, 0x00, 0x00, 0x92, 0xcb, 0x43, 0x6d, 0x90, 0x0a, 0x84, 0xc2, 0x53,
+    0x0c, 0x0e, 0xf5, 0x91, 0xeb, 0xfc, 0x40, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x25, 0x13, 0x30, 0xae, 0x3c, 0x72, 0x6c, 0x63, 0x61, 0x2c,
+    0x72, 0x72, 0x63, 0x61, 0x2c, 0x72, 0x6c, 0x61, 0x2c, 0x72, 0x72, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0xcb, 0x01, 0x06, 0xaf, 0xdd, 0x02, 0x01, 0x02, 0x01, 0x3c, 0xff,
+    0xf6, 0xdb, 0xf4, 0x94, 0x82, 0x80, 0xd9, 0x61, 0x20, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x57, 0x00, 0x00, 0x00, 0x71, 0x3a, 0xcd, 0x81, 0x73, 0x68, 0x66, 0x2f, 0x72,
+    0x6f, 0x74, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xcb, 0x00, 0x00, 0x00, 0xeb, 0xcc, 0x4a, 0x5d, 0x07, 0xe0, 0x03,
+    0x01, 0x95, 0x13, 0xee, 0x30, 0x43, 0x78, 0xad, 0x3d, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x57, 0xff, 0x00, 0x00, 0xeb, 0x60, 0x4d, 0x58, 0x73, 0x68, 0x66, 0x2f,
+    0x72, 0x6f, 0x74, 0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c, 0x28, 0x68,
+    0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x24, 0xd7, 0xcb, 0x80, 0x00, 0x00, 0xd5, 0x2c, 0xab, 0x97, 0xff, 0x39,
+    0x03, 0x01, 0x4b, 0xd1, 0xb2, 0x6a, 0x53, 0x27, 0x38, 0xb5, 0x00, 0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00, 0x00, 0x8b, 0x57, 0xf0, 0x08, 0x3c, 0x73, 0x65,
+    0x74, 0x2c, 0x72, 0x65, 0x73, 0x3e, 0x20, 0x6e, 0x2c, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x68, 0x6c, 0x28, 0x68, 0x6c,
+    0x29, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0xcb, 0x01, 0x86, 0x44, 0xfb, 0x02, 0x01, 0x02,
+    0x01, 0x09, 0xba, 0xbe, 0x68, 0xd8, 0x32, 0x10, 0x5e, 0x67, 0xa8, 0x20, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xcc, 0x63, 0xf9, 0x8a, 0x3c, 0x73,
+    0x65, 0x74, 0x2c, 0x72, 0x65, 0x73, 0x3e, 0x20, 0x6e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b,
+    0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x70, 0x01, 0x00, 0x0d, 0x27, 0x02, 0x01,
+    0x02, 0x01, 0x3a, 0xb7, 0x7b, 0x88, 0xee, 0x99, 0x86, 0x70, 0x07, 0xca, 0x20, 0x03, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x04, 0x62, 0x6a, 0xbf, 0x6c,
+    0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c,
+    0x64, 0x2c, 0x65, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x74, 0x01, 0x00, 0x64, 0xb6, 0x02,
+    0x01, 0x02, 0x01, 0xac, 0xe8, 0xf5, 0xb5, 0xfe, 0xaa, 0x12, 0x10, 0x66, 0x95, 0x20, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6a, 0x1a, 0x88, 0x31,
+    0x6c, 0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x3c, 0x68, 0x2c, 0x6c,
+    0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0xdd, 0x77, 0x01, 0x00, 0xaf, 0x67,
+    0x02, 0x01, 0x02, 0x01, 0x13, 0x4f, 0x44, 0x06, 0xd7, 0xbc, 0x50, 0xac, 0xaf, 0x5f, 0x20, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0xcc, 0xbe, 0x5a,
+    0x96, 0x6c, 0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x61, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xd7, 0x02, 0x00, 0x00, 0x00, 0x3b,
+    0x0c, 0x92, 0xb5, 0xff, 0x6c, 0x9e, 0x95, 0x03, 0x01, 0x04, 0x01, 0xc1, 0x21, 0xe7, 0xbd, 0x18, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x7a, 0x4c,
+    0x11, 0x4f, 0x6c, 0x64, 0x20, 0x28, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x29, 0x2c, 0x61, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xe5, 0x7e, 0x23, 0x66, 0x6f,
+    0x7e, 0x32, 0x65, 0x1d, 0x23, 0xe5, 0x11, 0x14, 0x00, 0x19, 0x11, 0xda, 0x1c, 0xcd, 0x49, 0x1c, 0xe1, 0xe5, 0x11,
+    0x28, 0x00, 0x19, 0x11, 0x02, 0x1d, 0xcd, 0x49, 0x1c, 0x21, 0x02, 0x1d, 0x36, 0x01, 0xe1, 0xe5, 0x11, 0x42, 0x1d,
+    0x01, 0x04, 0x00, 0xed, 0xb0, 0x11, 0x03, 0x01, 0x01, 0x10, 0x00, 0xed, 0xb0, 0x11, 0x2c, 0x00, 0x19, 0xeb, 0x0e,
+    0x09, 0xcd, 0xce, 0x1d, 0xcd, 0x73, 0x1e, 0x3a, 0x42, 0x1d, 0xfe, 0x76, 0xca, 0x3e, 0x1b, 0xe6, 0xdf, 0xfe, 0xdd,
+    0xc2, 0x3b, 0x1b, 0x3a, 0x43, 0x1d, 0xfe, 0x76, 0xc4, 0x2a, 0x1d, 0xcd, 0x89, 0x1c, 0xc4, 0xad, 0x1c, 0xe1, 0xca,
+    0x7a, 0x1b, 0x11, 0x3c, 0x00, 0x19, 0xcd, 0x34, 0x1e, 0x11, 0x0a, 0x1e, 0xca, 0x71, 0x1b, 0x11, 0x11, 0x1e, 0x0e,
+    0x09, 0xcd, 0xce, 0x1d, 0xcd, 0x99, 0x1d, 0x11, 0x2c, 0x1e, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0x21, 0x87, 0x1e, 0xcd,
+    0x99, 0x1d, 0x11, 0x07, 0x1e, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0xe1, 0x23, 0x23, 0xc9, 0xe5, 0x3e, 0x01, 0x32, 0xf0,
+    0x1b, 0x32, 0x14, 0x1c, 0x21, 0xda, 0x1c, 0x22, 0xf1, 0x1b, 0x21, 0x02, 0x1d, 0x22, 0x15, 0x1c, 0x06, 0x04, 0xe1,
+    0xe5, 0x11, 0x42, 0x1d, 0xcd, 0xa4, 0x1b, 0x06, 0x10, 0x11, 0x03, 0x01, 0xcd, 0xa4, 0x1b, 0xc3, 0x27, 0x1b, 0xcd,
+    0xad, 0x1b, 0x23, 0x05, 0xc2, 0xa4, 0x1b, 0xc9, 0xc5, 0xd5, 0xe5, 0x4e, 0x11, 0x14, 0x00, 0x19, 0x7e, 0xfe, 0x00,
+    0xca, 0xce, 0x1b, 0x06, 0x08, 0x0f, 0xf5, 0x3e, 0x00, 0xdc, 0xf3, 0x1b, 0xa9, 0x0f, 0x4f, 0xf1, 0x05, 0xc2, 0xbd,
+    0x1b, 0x06, 0x08, 0x11, 0x14, 0x00, 0x19, 0x7e, 0xfe, 0x00, 0xca, 0xe9, 0x1b, 0x06, 0x08, 0x0f, 0xf5, 0x3e, 0x00,
+    0xdc, 0x17, 0x1c, 0xa9, 0x0f, 0x4f, 0xf1, 0x05, 0xc2, 0xda, 0x1b, 0xe1, 0xd1, 0x79, 0x12, 0x13, 0xc1, 0xc9, 0x00,
+    0x00, 0x00, 0xc5, 0xe5, 0x2a, 0xf1, 0x1b, 0x46, 0x21, 0xf0, 0x1b, 0x7e, 0x4f, 0x07, 0x77, 0xfe, 0x01, 0xc2, 0x0c,
+    0x1c, 0x2a, 0xf1, 0x1b, 0x23, 0x22, 0xf1, 0x1b, 0x78, 0xa1, 0xe1, 0xc1, 0xc8, 0x3e, 0x01, 0xc9, 0x00, 0x00, 0x00,
+    0xc5, 0xe5, 0x2a, 0x15, 0x1c, 0x46, 0x21, 0x14, 0x1c, 0x7e, 0x4f, 0x07, 0x77, 0xfe, 0x01, 0xc2, 0x30, 0x1c, 0x2a,
+    0x15, 0x1c, 0x23, 0x22, 0x15, 0x1c, 0x78, 0xa1, 0xe1, 0xc1, 0xc8, 0x3e, 0x01, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0x36,
+    0x00, 0x54, 0x5d, 0x13, 0x0b, 0xed, 0xb0, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0xd5, 0xeb, 0x01, 0x28, 0x00, 0xcd, 0x38,
+    0x1c, 0xeb, 0x06, 0x14, 0x0e, 0x01, 0x16, 0x00, 0x5e, 0x7b, 0xa1, 0xca, 0x5f, 0x1c, 0x14, 0x79, 0x07, 0x4f, 0xfe,
+    0x01, 0xc2, 0x59, 0x1c, 0x23, 0x05, 0xc2, 0x58, 0x1c, 0x7a, 0xe6, 0xf8, 0x0f, 0x0f, 0x0f, 0x6f, 0x26, 0x00, 0x7a,
+    0xe6, 0x07, 0x3c, 0x47, 0x3e, 0x80, 0x07, 0x05, 0xc2, 0x7c, 0x1c, 0xd1, 0x19, 0x11, 0x14, 0x00, 0x19, 0x77, 0xc9,
+    0xc5, 0xd5, 0xe5, 0x21, 0xda, 0x1c, 0x11, 0x14, 0x00, 0xeb, 0x19, 0xeb, 0x34, 0x7e, 0xfe, 0x00, 0xca, 0xa8, 0x1c,
+    0x47, 0x1a, 0xa0, 0xca, 0xa4, 0x1c, 0x36, 0x00, 0xc1, 0xd1, 0xe1, 0xc9, 0x23, 0x13, 0xc3, 0x95, 0x1c, 0xc5, 0xd5,
+    0xe5, 0x21, 0x02, 0x1d, 0x11, 0x14, 0x00, 0xeb, 0x19, 0xeb, 0x7e, 0xb7, 0xca, 0xd5, 0x1c, 0x47, 0x1a, 0xa0, 0xc2,
+    0xd1, 0x1c, 0x78, 0x07, 0xfe, 0x01, 0xc2, 0xcf, 0x1c, 0x36, 0x00, 0x23, 0x13, 0x77, 0xaf, 0xe1, 0xd1, 0xc1, 0xc9,
+    0x23, 0x13, 0xc3, 0xb9, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf5, 0xc5, 0xd5, 0xe5, 0xf3, 0xed, 0x73, 0x8d, 0x1d, 0x31,
+    0x05, 0x01, 0xfd, 0xe1, 0xdd, 0xe1, 0xe1, 0xd1, 0xc1, 0xf1, 0xed, 0x7b, 0x11, 0x01, 0x00, 0x00, 0x00, 0x00, 0xed,
+    0x73, 0x8b, 0x1d, 0x31, 0x8b, 0x1d, 0xf5, 0xc5, 0xd5, 0xe5, 0xdd, 0xe5, 0xfd, 0xe5, 0xed, 0x7b, 0x8d, 0x1d, 0xfb,
+    0x2a, 0x03, 0x01, 0x22, 0x7d, 0x1d, 0x21, 0x89, 0x1d, 0x7e, 0xe6, 0xd7, 0x77, 0x06, 0x10, 0x11, 0x7d, 0x1d, 0x21,
+    0x87, 0x1e, 0x1a, 0x13, 0xcd, 0x4b, 0x1e, 0x05, 0xc2, 0x6f, 0x1d, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0xcd, 0xab, 0x1d,
+    0x23, 0x05, 0xc2, 0x8f, 0x1d, 0xc9, 0xf5, 0xc5, 0xe5, 0x06, 0x04, 0x7e, 0xcd, 0xab, 0x1d, 0x23, 0x05, 0xc2, 0x9e,
+    0x1d, 0xe1, 0xc1, 0xf1, 0xc9, 0xf5, 0x0f, 0x0f, 0x0f, 0x0f, 0xcd, 0xb4, 0x1d, 0xf1, 0xf5, 0xc5, 0xd5, 0xe5, 0xe6,
+    0x0f, 0xfe, 0x0a, 0xda, 0xc1, 0x1d, 0xc6, 0x27, 0xc6, 0x30, 0x5f, 0x0e, 0x02, 0xcd, 0xce, 0x1d, 0xe1, 0xd1, 0xc1,
+    0xf1, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0xcd, 0x05, 0x00, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0x5a, 0x38, 0x30, 0x64, 0x6f,
+    0x63, 0x20, 0x69, 0x6e, 0x73, 0x74, 0x72, 0x75, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x65, 0x78, 0x65, 0x72, 0x63,
+    0x69, 0x73, 0x65, 0x72, 0x0a, 0x0d, 0x24, 0x54, 0x65, 0x73, 0x74, 0x73, 0x20, 0x63, 0x6f, 0x6d, 0x70, 0x6c, 0x65,
+    0x74, 0x65, 0x0a, 0x0d, 0x24, 0x20, 0x20, 0x4f, 0x4b, 0x0a, 0x0d, 0x24, 0x20, 0x20, 0x45, 0x52, 0x52, 0x4f, 0x52,
+    0x20, 0x2a, 0x2a, 0x2a, 0x2a, 0x20, 0x63, 0x72, 0x63, 0x20, 0x65, 0x78, 0x70, 0x65, 0x63, 0x74, 0x65, 0x64, 0x3a,
+    0x24, 0x20, 0x66, 0x6f, 0x75, 0x6e, 0x64, 0x3a, 0x24, 0xc5, 0xd5, 0xe5, 0x11, 0x87, 0x1e, 0x06, 0x04, 0x1a, 0xbe,
+    0xc2, 0x47, 0x1e, 0x23, 0x13, 0x05, 0xc2, 0x3c, 0x1e, 0xe1, 0xd1, 0xc1, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0xe5, 0x11,
+    0x03, 0x00, 0x19, 0xae, 0x6f, 0x26, 0x00, 0x29, 0x29, 0xeb, 0x21, 0x8b, 0x1e, 0x19, 0xeb, 0xe1, 0x01, 0x04, 0x00,
+    0x1a, 0xa8, 0x46, 0x77, 0x13, 0x23, 0x0d, 0xc2, 0x64, 0x1e, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0xf5, 0xc5, 0xe5, 0x21,
+    0x87, 0x1e, 0x3e, 0xff, 0x06, 0x04, 0x77, 0x23, 0x05, 0xc2, 0x7d, 0x1e, 0xe1, 0xc1, 0xf1, 0xc9, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x77, 0x07, 0x30, 0x96, 0xee, 0x0e, 0x61, 0x2c, 0x99, 0x09, 0x51, 0xba, 0x07, 0x6d,
+    0xc4, 0x19, 0x70, 0x6a, 0xf4, 0x8f, 0xe9, 0x63, 0xa5, 0x35, 0x9e, 0x64, 0x95, 0xa3, 0x0e, 0xdb, 0x88, 0x32, 0x79,
+    0xdc, 0xb8, 0xa4, 0xe0, 0xd5, 0xe9, 0x1e, 0x97, 0xd2, 0xd9, 0x88, 0x09, 0xb6, 0x4c, 0x2b, 0x7e, 0xb1, 0x7c, 0xbd,
+    0xe7, 0xb8, 0x2d, 0x07, 0x90, 0xbf, 0x1d, 0x91, 0x1d, 0xb7, 0x10, 0x64, 0x6a, 0xb0, 0x20, 0xf2, 0xf3, 0xb9, 0x71,
+    0x48, 0x84, 0xbe, 0x41, 0xde, 0x1a, 0xda, 0xd4, 0x7d, 0x6d, 0xdd, 0xe4, 0xeb, 0xf4, 0xd4, 0xb5, 0x51, 0x83, 0xd3,
+    0x85, 0xc7, 0x13, 0x6c, 0x98, 0x56, 0x64, 0x6b, 0xa8, 0xc0, 0xfd, 0x62, 0xf9, 0x7a, 0x8a, 0x65, 0xc9, 0xec, 0x14,
+    0x01, 0x5c, 0x4f, 0x63, 0x06, 0x6c, 0xd9, 0xfa, 0x0f, 0x3d, 0x63, 0x8d, 0x08, 0x0d, 0xf5, 0x3b, 0x6e, 0x20, 0xc8,
+    0x4c, 0x69, 0x10, 0x5e, 0xd5, 0x60, 0x41, 0xe4, 0xa2, 0x67, 0x71, 0x72, 0x3c, 0x03, 0xe4, 0xd1, 0x4b, 0x04, 0xd4,
+    0x47, 0xd2, 0x0d, 0x85, 0xfd, 0xa5, 0x0a, 0xb5, 0x6b, 0x35, 0xb5, 0xa8, 0xfa, 0x42, 0xb2, 0x98, 0x6c, 0xdb, 0xbb,
+    0xc9, 0xd6, 0xac, 0xbc, 0xf9, 0x40, 0x32, 0xd8, 0x6c, 0xe3, 0x45, 0xdf, 0x5c, 0x75, 0xdc, 0xd6, 0x0d, 0xcf, 0xab,
+    0xd1, 0x3d, 0x59, 0x26, 0xd9, 0x30, 0xac, 0x51, 0xde, 0x00, 0x3a, 0xc8, 0xd7, 0x51, 0x80, 0xbf, 0xd0, 0x61, 0x16,
+    0x21, 0xb4, 0xf4, 0xb5, 0x56, 0xb3, 0xc4, 0x23, 0xcf, 0xba, 0x95, 0x99, 0xb8, 0xbd, 0xa5, 0x0f, 0x28, 0x02, 0xb8,
+    0x9e, 0x5f, 0x05, 0x88, 0x08, 0xc6, 0x0c, 0xd9, 0xb2, 0xb1, 0x0b, 0xe9, 0x24, 0x2f, 0x6f, 0x7c, 0x87, 0x58, 0x68,
+    0x4c, 0x11, 0xc1, 0x61, 0x1d, 0xab, 0xb6, 0x66, 0x2d, 0x3d, 0x76, 0xdc, 0x41, 0x90, 0x01, 0xdb, 0x71, 0x06, 0x98,
+    0xd2, 0x20, 0xbc, 0xef, 0xd5, 0x10, 0x2a, 0x71, 0xb1, 0x85, 0x89, 0x06, 0xb6, 0xb5, 0x1f, 0x9f, 0xbf, 0xe4, 0xa5,
+    0xe8, 0xb8, 0xd4, 0x33, 0x78, 0x07, 0xc9, 0xa2, 0x0f, 0x00, 0xf9, 0x34, 0x96, 0x09, 0xa8, 0x8e, 0xe1, 0x0e, 0x98,
+    0x18, 0x7f, 0x6a, 0x0d, 0xbb, 0x08, 0x6d, 0x3d, 0x2d, 0x91, 0x64, 0x6c, 0x97, 0xe6, 0x63, 0x5c, 0x01, 0x6b, 0x6b,
+    0x51, 0xf4, 0x1c, 0x6c, 0x61, 0x62, 0x85, 0x65, 0x30, 0xd8, 0xf2, 0x62, 0x00, 0x4e, 0x6c, 0x06, 0x95, 0xed, 0x1b,
+    0x01, 0xa5, 0x7b, 0x82, 0x08, 0xf4, 0xc1, 0xf5, 0x0f, 0xc4, 0x57, 0x65, 0xb0, 0xd9, 0xc6, 0x12, 0xb7, 0xe9, 0x50,
+    0x8b, 0xbe, 0xb8, 0xea, 0xfc, 0xb9, 0x88, 0x7c, 0x62, 0xdd, 0x1d, 0xdf, 0x15, 0xda, 0x2d, 0x49, 0x8c, 0xd3, 0x7c,
+    0xf3, 0xfb, 0xd4, 0x4c, 0x65, 0x4d, 0xb2, 0x61, 0x58, 0x3a, 0xb5, 0x51, 0xce, 0xa3, 0xbc, 0x00, 0x74, 0xd4, 0xbb,
+    0x30, 0xe2, 0x4a, 0xdf, 0xa5, 0x41, 0x3d, 0xd8, 0x95, 0xd7, 0xa4, 0xd1, 0xc4, 0x6d, 0xd3, 0xd6, 0xf4, 0xfb, 0x43,
+    0x69, 0xe9, 0x6a, 0x34, 0x6e, 0xd9, 0xfc, 0xad, 0x67, 0x88, 0x46, 0xda, 0x60, 0xb8, 0xd0, 0x44, 0x04, 0x2d, 0x73,
+    0x33, 0x03, 0x1d, 0xe5, 0xaa, 0x0a, 0x4c, 0x5f, 0xdd, 0x0d, 0x7c, 0xc9, 0x50, 0x05, 0x71, 0x3c, 0x27, 0x02, 0x41,
+    0xaa, 0xbe, 0x0b, 0x10, 0x10, 0xc9, 0x0c, 0x20, 0x86, 0x57, 0x68, 0xb5, 0x25, 0x20, 0x6f, 0x85, 0xb3, 0xb9, 0x66,
+    0xd4, 0x09, 0xce, 0x61, 0xe4, 0x9f, 0x5e, 0xde, 0xf9, 0x0e, 0x29, 0xd9, 0xc9, 0x98, 0xb0, 0xd0, 0x98, 0x22, 0xc7,
+    0xd7, 0xa8, 0xb4, 0x59, 0xb3, 0x3d, 0x17, 0x2e, 0xb4, 0x0d, 0x81, 0xb7, 0xbd, 0x5c, 0x3b, 0xc0, 0xba, 0x6c, 0xad,
+    0xed, 0xb8, 0x83, 0x20, 0x9a, 0xbf, 0xb3, 0xb6, 0x03, 0xb6, 0xe2, 0x0c, 0x74, 0xb1, 0xd2, 0x9a, 0xea, 0xd5, 0x47,
+    0x39, 0x9d, 0xd2, 0x77, 0xaf, 0x04, 0xdb, 0x26, 0x15, 0x73, 0xdc, 0x16, 0x83, 0xe3, 0x63, 0x0b, 0x12, 0x94, 0x64,
+    0x3b, 0x84, 0x0d, 0x6d, 0x6a, 0x3e, 0x7a, 0x6a, 0x5a, 0xa8, 0xe4, 0x0e, 0xcf, 0x0b, 0x93, 0x09, 0xff, 0x9d, 0x0a,
+    0x00, 0xae, 0x27, 0x7d, 0x07, 0x9e, 0xb1, 0xf0, 0x0f, 0x93, 0x44, 0x87, 0x08, 0xa3, 0xd2, 0x1e, 0x01, 0xf2, 0x68,
+    0x69, 0x06, 0xc2, 0xfe, 0xf7, 0x62, 0x57, 0x5d, 0x80, 0x65, 0x67, 0xcb, 0x19, 0x6c, 0x36, 0x71, 0x6e, 0x6b, 0x06,
+    0xe7, 0xfe, 0xd4, 0x1b, 0x76, 0x89, 0xd3, 0x2b, 0xe0, 0x10, 0xda, 0x7a, 0x5a, 0x67, 0xdd, 0x4a, 0xcc, 0xf9, 0xb9,
+    0xdf, 0x6f, 0x8e, 0xbe, 0xef, 0xf9, 0x17, 0xb7, 0xbe, 0x43, 0x60, 0xb0, 0x8e, 0xd5, 0xd6, 0xd6, 0xa3, 0xe8, 0xa1,
+    0xd1, 0x93, 0x7e, 0x38, 0xd8, 0xc2, 0xc4, 0x4f, 0xdf, 0xf2, 0x52, 0xd1, 0xbb, 0x67, 0xf1, 0xa6, 0xbc, 0x57, 0x67,
+    0x3f, 0xb5, 0x06, 0xdd, 0x48, 0xb2, 0x36, 0x4b, 0xd8, 0x0d, 0x2b, 0xda, 0xaf, 0x0a, 0x1b, 0x4c, 0x36, 0x03, 0x4a,
+    0xf6, 0x41, 0x04, 0x7a, 0x60, 0xdf, 0x60, 0xef, 0xc3, 0xa8, 0x67, 0xdf, 0x55, 0x31, 0x6e, 0x8e, 0xef, 0x46, 0x69,
+    0xbe, 0x79, 0xcb, 0x61, 0xb3, 0x8c, 0xbc, 0x66, 0x83, 0x1a, 0x25, 0x6f, 0xd2, 0xa0, 0x52, 0x68, 0xe2, 0x36, 0xcc,
+    0x0c, 0x77, 0x95, 0xbb, 0x0b, 0x47, 0x03, 0x22, 0x02, 0x16, 0xb9, 0x55, 0x05, 0x26, 0x2f, 0xc5, 0xba, 0x3b, 0xbe,
+    0xb2, 0xbd, 0x0b, 0x28, 0x2b, 0xb4, 0x5a, 0x92, 0x5c, 0xb3, 0x6a, 0x04, 0xc2, 0xd7, 0xff, 0xa7, 0xb5, 0xd0, 0xcf,
+    0x31, 0x2c, 0xd9, 0x9e, 0x8b, 0x5b, 0xde, 0xae, 0x1d, 0x9b, 0x64, 0xc2, 0xb0, 0xec, 0x63, 0xf2, 0x26, 0x75, 0x6a,
+    0xa3, 0x9c, 0x02, 0x6d, 0x93, 0x0a, 0x9c, 0x09, 0x06, 0xa9, 0xeb, 0x0e, 0x36, 0x3f, 0x72, 0x07, 0x67, 0x85, 0x05,
+    0x00, 0x57, 0x13, 0x95, 0xbf, 0x4a, 0x82, 0xe2, 0xb8, 0x7a, 0x14, 0x7b, 0xb1, 0x2b, 0xae, 0x0c, 0xb6, 0x1b, 0x38,
+    0x92, 0xd2, 0x8e, 0x9b, 0xe5, 0xd5, 0xbe, 0x0d, 0x7c, 0xdc, 0xef, 0xb7, 0x0b, 0xdb, 0xdf, 0x21, 0x86, 0xd3, 0xd2,
+    0xd4, 0xf1, 0xd4, 0xe2, 0x42, 0x68, 0xdd, 0xb3, 0xf8, 0x1f, 0xda, 0x83, 0x6e, 0x81, 0xbe, 0x16, 0xcd, 0xf6, 0xb9,
+    0x26, 0x5b, 0x6f, 0xb0, 0x77, 0xe1, 0x18, 0xb7, 0x47, 0x77, 0x88, 0x08, 0x5a, 0xe6, 0xff, 0x0f, 0x6a, 0x70, 0x66,
+    0x06, 0x3b, 0xca, 0x11, 0x01, 0x0b, 0x5c, 0x8f, 0x65, 0x9e, 0xff, 0xf8, 0x62, 0xae, 0x69, 0x61, 0x6b, 0xff, 0xd3,
+    0x16, 0x6c, 0xcf, 0x45, 0xa0, 0x0a, 0xe2, 0x78, 0xd7, 0x0d, 0xd2, 0xee, 0x4e, 0x04, 0x83, 0x54, 0x39, 0x03, 0xb3,
+    0xc2, 0xa7, 0x67, 0x26, 0x61, 0xd0, 0x60, 0x16, 0xf7, 0x49, 0x69, 0x47, 0x4d, 0x3e, 0x6e, 0x77, 0xdb, 0xae, 0xd1,
+    0x6a, 0x4a, 0xd9, 0xd6, 0x5a, 0xdc, 0x40, 0xdf, 0x0b, 0x66, 0x37, 0xd8, 0x3b, 0xf0, 0xa9, 0xbc, 0xae, 0x53, 0xde,
+    0xbb, 0x9e, 0xc5, 0x47, 0xb2, 0xcf, 0x7f, 0x30, 0xb5, 0xff, 0xe9, 0xbd, 0xbd, 0xf2, 0x1c, 0xca, 0xba, 0xc2, 0x8a,
+    0x53, 0xb3, 0x93, 0x30, 0x24, 0xb4, 0xa3, 0xa6, 0xba, 0xd0, 0x36, 0x05, 0xcd, 0xd7, 0x06, 0x93, 0x54, 0xde, 0x57,
+    0x29, 0x23, 0xd9, 0x67, 0xbf, 0xb3, 0x66, 0x7a, 0x2e, 0xc4, 0x61, 0x4a, 0xb8, 0x5d, 0x68, 0x1b, 0x02, 0x2a, 0x6f,
+    0x2b, 0x94, 0xb4, 0x0b, 0xbe, 0x37, 0xc3, 0x0c, 0x8e, 0xa1, 0x5a, 0x05, 0xdf, 0x1b, 0x2d, 0x02, 0xef, 0x8d};
+inline constexpr uint8_t zexall[] = {
+    0xc3, 0x13, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2a, 0x06, 0x00, 0xf9, 0x11, 0xda, 0x1d, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0x21, 0x3a, 0x01, 0x7e, 0x23, 0xb6, 0xca,
+    0x2f, 0x01, 0x2b, 0xcd, 0xe2, 0x1a, 0xc3, 0x22, 0x01, 0x11, 0xf9, 0x1d, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0xc3, 0x00,
+    0x00, 0xc2, 0x01, 0x22, 0x02, 0x82, 0x02, 0xe2, 0x02, 0x42, 0x03, 0xa2, 0x03, 0x02, 0x04, 0x62, 0x04, 0xc2, 0x04,
+    0x22, 0x05, 0x82, 0x05, 0xe2, 0x05, 0x42, 0x06, 0xa2, 0x06, 0x02, 0x07, 0x62, 0x07, 0xc2, 0x07, 0x22, 0x08, 0x82,
+    0x08, 0xe2, 0x08, 0x42, 0x09, 0xa2, 0x09, 0x02, 0x0a, 0x62, 0x0a, 0xc2, 0x0a, 0x22, 0x0b, 0x82, 0x0b, 0xe2, 0x0b,
+    0x42, 0x0c, 0xa2, 0x0c, 0x02, 0x0d, 0x62, 0x0d, 0xc2, 0x0d, 0x22, 0x0e, 0x82, 0x0e, 0xe2, 0x0e, 0x42, 0x0f, 0xa2,
+    0x0f, 0x02, 0x10, 0x62, 0x10, 0xc2, 0x10, 0x22, 0x11, 0x82, 0x11, 0xe2, 0x11, 0x42, 0x12, 0xa2, 0x12, 0x02, 0x13,
+    0x62, 0x13, 0xc2, 0x13, 0x22, 0x14, 0x82, 0x14, 0xe2, 0x14, 0x42, 0x15, 0xa2, 0x15, 0x02, 0x16, 0x62, 0x16, 0xc2,
+    0x16, 0x22, 0x17, 0x82, 0x17, 0xe2, 0x17, 0x42, 0x18, 0xa2, 0x18, 0x02, 0x19, 0x62, 0x19, 0xc2, 0x19, 0x22, 0x1a,
+    0x82, 0x1a, 0x00, 0x00, 0xff, 0xed, 0x42, 0x00, 0x00, 0x2c, 0x83, 0x88, 0x4f, 0x2b, 0xf2, 0x39, 0xb3, 0x1f, 0x7e,
+    0x63, 0x15, 0xd3, 0x89, 0x5e, 0x46, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xd4, 0x8a, 0xd5, 0x19, 0x3c, 0x61, 0x64, 0x63, 0x2c, 0x73, 0x62,
+    0x63, 0x3e, 0x20, 0x68, 0x6c, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x09, 0x00, 0x00, 0x00, 0xa5, 0xc4, 0xc7, 0xc4, 0x26, 0xd2, 0x50, 0xa0, 0xea,
+    0x58, 0x66, 0x85, 0xc6, 0xde, 0xc9, 0x9b, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xd9, 0xa4, 0xca, 0x05, 0x61, 0x64, 0x64, 0x20, 0x68, 0x6c,
+    0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x09, 0x00, 0x00, 0xac, 0xdd, 0x94, 0xc2, 0x5b, 0x63, 0xd3, 0x33,
+    0x76, 0x6a, 0x20, 0xfa, 0x94, 0x68, 0xf5, 0x36, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0xb1, 0xdf, 0x8e, 0xc0, 0x61, 0x64, 0x64, 0x20, 0x69,
+    0x78, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x69, 0x78, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xfd, 0x09, 0x00, 0x00, 0xc2, 0xc7, 0x07, 0xf4, 0xc1, 0x51, 0x96,
+    0x3e, 0xf4, 0x0b, 0x0f, 0x51, 0x92, 0x1e, 0xea, 0x71, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0xff, 0xff, 0x39, 0xc8, 0x58, 0x9b, 0x61, 0x64, 0x64, 0x20,
+    0x69, 0x79, 0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x2c, 0x69, 0x79, 0x2c, 0x73, 0x70, 0x3e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xc6, 0x00, 0x00, 0x00, 0x40, 0x91, 0x3c, 0x7e, 0x67, 0x7a,
+    0x6d, 0xdf, 0x61, 0x5b, 0x29, 0x0b, 0x10, 0x66, 0xb2, 0x85, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x51, 0xc1, 0x9c, 0x2e, 0x61, 0x6c, 0x75,
+    0x6f, 0x70, 0x20, 0x61, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x80, 0x00, 0x00, 0x00, 0x3e, 0xc5, 0x3a, 0x57, 0x4d,
+    0x4c, 0x03, 0x01, 0x09, 0xe3, 0x66, 0xa6, 0xd0, 0x3b, 0xbb, 0xad, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0x00, 0x00, 0x06, 0xc7, 0xaa, 0x8e, 0x61, 0x6c,
+    0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c,
+    0x28, 0x68, 0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x84, 0x00, 0x00, 0xf7, 0xd6, 0x6e, 0xc7,
+    0xcf, 0xac, 0x47, 0x28, 0xdd, 0x22, 0x35, 0xc0, 0xc5, 0x38, 0x4b, 0x23, 0x20, 0x39, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0x00, 0x00, 0x00, 0xa8, 0x86, 0xcc, 0x44, 0x61,
+    0x6c, 0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x3c, 0x69, 0x78, 0x68, 0x2c, 0x69, 0x78, 0x6c, 0x2c, 0x69, 0x79, 0x68,
+    0x2c, 0x69, 0x79, 0x6c, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x86, 0x01, 0x00, 0xb7, 0x90, 0x02,
+    0x01, 0x02, 0x01, 0xfd, 0x32, 0x6e, 0x40, 0xdc, 0xc1, 0x45, 0x6e, 0xfa, 0xe5, 0x20, 0x38, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xd3, 0xf2, 0xd7, 0x4a,
+    0x61, 0x6c, 0x75, 0x6f, 0x70, 0x20, 0x61, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0xcb, 0x01, 0x46, 0x75, 0x20,
+    0x02, 0x01, 0x02, 0x01, 0xfc, 0x3c, 0x9a, 0xa7, 0x74, 0x3d, 0x51, 0x27, 0x14, 0xca, 0x20, 0x00, 0x00, 0x38, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x83, 0x53, 0x4e,
+    0xe1, 0x62, 0x69, 0x74, 0x20, 0x6e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xcb, 0x40, 0x00, 0x00, 0xf1,
+    0x3e, 0xfc, 0x9d, 0xcc, 0x7a, 0x03, 0x01, 0x61, 0xbe, 0x86, 0x7a, 0x50, 0x24, 0x98, 0x19, 0x00, 0x3f, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0x00, 0x00, 0x5e, 0x02,
+    0x0e, 0x98, 0x62, 0x69, 0x74, 0x20, 0x6e, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c,
+    0x6c, 0x2c, 0x28, 0x68, 0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xed, 0xa9, 0x00, 0x00,
+    0xb6, 0xc7, 0xb4, 0x72, 0xf6, 0x18, 0x14, 0x01, 0xbd, 0x8d, 0x01, 0x00, 0xc0, 0x30, 0xa3, 0x94, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x13,
+    0x4b, 0x62, 0x2d, 0x63, 0x70, 0x64, 0x3c, 0x72, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xed, 0xa1, 0x00,
+    0x00, 0x48, 0x4d, 0x4a, 0xaf, 0x6b, 0x90, 0x03, 0x01, 0x71, 0x4e, 0x01, 0x00, 0x93, 0x6a, 0x7c, 0x90, 0x00, 0x10,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00,
+    0x2d, 0xa4, 0x2d, 0x19, 0x63, 0x70, 0x69, 0x3c, 0x72, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x27, 0x00,
+    0x00, 0x00, 0x41, 0x21, 0xfa, 0x09, 0x60, 0x1d, 0x59, 0xa5, 0x5b, 0x8d, 0x79, 0x90, 0x04, 0x8e, 0x9d, 0x29, 0x18,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x6d, 0x2d, 0xd2, 0x13, 0x3c, 0x64, 0x61, 0x61, 0x2c, 0x63, 0x70, 0x6c, 0x2c, 0x73, 0x63, 0x66, 0x2c, 0x63,
+    0x63, 0x66, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x3c,
+    0x00, 0x00, 0x00, 0xdf, 0x4a, 0xd8, 0xd5, 0x98, 0xe5, 0x2b, 0x8a, 0xb0, 0xa7, 0x1b, 0x43, 0x44, 0x5a, 0x30, 0xd0,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00,
+    0x00, 0x00, 0x81, 0xfa, 0x81, 0x00, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x61, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff,
+    0x04, 0x00, 0x00, 0x00, 0x23, 0xd6, 0x2d, 0x43, 0x61, 0x7a, 0x80, 0x81, 0x86, 0x5a, 0x85, 0x1e, 0x86, 0x58, 0xbb,
+    0x9b, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7,
+    0x00, 0x00, 0x00, 0x77, 0xf3, 0x5a, 0x73, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x62, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xff, 0x03, 0x00, 0x00, 0x00, 0x97, 0xcd, 0xab, 0x44, 0xc9, 0x8d, 0xe3, 0xe3, 0xcc, 0x11, 0xa4, 0xe8, 0x02, 0x49,
+    0x4d, 0x2a, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xd7, 0x00, 0x00, 0x00, 0xd2, 0xae, 0x3b, 0xec, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x62,
+    0x63, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xff, 0x0c, 0x00, 0x00, 0x00, 0x89, 0xd7, 0x35, 0x09, 0x5b, 0x05, 0x85, 0x9f, 0x27, 0x8b, 0x08, 0xd2, 0x95,
+    0x05, 0x60, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xd7, 0x00, 0x00, 0x00, 0x1a, 0xf6, 0x12, 0xa7, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20,
+    0x63, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xff, 0x14, 0x00, 0x00, 0x00, 0xea, 0xa0, 0xba, 0x5f, 0xfb, 0x65, 0x1c, 0x98, 0xcc, 0x38, 0xbc, 0xde,
+    0x43, 0x5c, 0xbd, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xd1, 0x46, 0xbf, 0x51, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e,
+    0x20, 0x64, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xff, 0x13, 0x00, 0x00, 0x00, 0x2e, 0x34, 0x1d, 0x13, 0xc9, 0x28, 0xca, 0x0a, 0x67, 0x99, 0x2e,
+    0x3a, 0x92, 0xf6, 0x54, 0x9d, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xae, 0xc6, 0xd4, 0x2c, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63,
+    0x3e, 0x20, 0x64, 0x65, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x1c, 0x00, 0x00, 0x00, 0x2f, 0x60, 0x0d, 0x4c, 0x02, 0x24, 0xf5, 0xe2, 0xf4, 0xa0,
+    0x0a, 0xa1, 0x13, 0x32, 0x25, 0x59, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xca, 0x8c, 0x6a, 0xc2, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65,
+    0x63, 0x3e, 0x20, 0x65, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x24, 0x00, 0x00, 0x00, 0x06, 0x15, 0xeb, 0xf2, 0xdd, 0xe8, 0x2b, 0x26, 0xa6,
+    0x11, 0x1a, 0xbc, 0x17, 0x06, 0x18, 0x28, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x56, 0x0f, 0x95, 0x5e, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64,
+    0x65, 0x63, 0x3e, 0x20, 0x68, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x23, 0x00, 0x00, 0x00, 0xf4, 0xc3, 0xa5, 0x07, 0x6d, 0x1b, 0x04, 0x4f,
+    0xc2, 0xe2, 0x2a, 0x82, 0x57, 0xe0, 0xe1, 0xc3, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21,
+    0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xfc, 0x0d, 0x6d, 0x4a, 0x3c, 0x69, 0x6e, 0x63, 0x2c,
+    0x64, 0x65, 0x63, 0x3e, 0x20, 0x68, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x23, 0x00, 0x00, 0x3c, 0xbc, 0x9b, 0x0d, 0x81, 0xe0, 0xfd,
+    0xad, 0x7f, 0x9a, 0xe5, 0x96, 0x13, 0x85, 0xe2, 0x0b, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xa5, 0x4d, 0xbe, 0x31, 0x3c, 0x69, 0x6e, 0x63,
+    0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xfd, 0x23, 0x00, 0x00, 0x02, 0x94, 0x7a, 0x63, 0x82, 0x31,
+    0x5a, 0xc6, 0xe9, 0xb2, 0xb4, 0xab, 0x16, 0xf2, 0x05, 0x6d, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x50, 0x5d, 0x51, 0xa3, 0x3c, 0x69, 0x6e,
+    0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x2c, 0x00, 0x00, 0x00, 0x31, 0x80, 0x20, 0xa5, 0x56,
+    0x43, 0x09, 0xb4, 0xc1, 0xf4, 0xa2, 0xdf, 0xd1, 0x3c, 0xa2, 0x3e, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xa0, 0xa1, 0xb4, 0x9f, 0x3c, 0x69,
+    0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x34, 0x00, 0x00, 0x00, 0x56, 0xb8, 0x7c, 0x0c,
+    0x3e, 0xe5, 0x03, 0x01, 0x7e, 0x87, 0x58, 0xda, 0x15, 0x5c, 0x37, 0x1f, 0x01, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x28, 0x29, 0x5e, 0xce, 0x3c,
+    0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x28, 0x68, 0x6c, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x33, 0x00, 0x00, 0x00, 0x6f, 0x34, 0x82,
+    0xd4, 0x69, 0xd1, 0xb6, 0xde, 0x94, 0xa4, 0x76, 0xf4, 0x53, 0x02, 0x5b, 0x85, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x5d, 0xac, 0xd5, 0x27,
+    0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x73, 0x70, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x34, 0x01, 0x00, 0x6e, 0xfa,
+    0x02, 0x01, 0x02, 0x01, 0x28, 0x2c, 0x94, 0x88, 0x57, 0x50, 0x16, 0x33, 0x6f, 0x28, 0x20, 0x01, 0x00, 0x00, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x0b, 0x95, 0xa8,
+    0xea, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e,
+    0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x24, 0x00, 0x00, 0x38,
+    0xb8, 0x6c, 0x31, 0xd4, 0xc6, 0x01, 0x3e, 0x58, 0x83, 0xb4, 0x15, 0x81, 0xde, 0x59, 0x42, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x6f, 0x46,
+    0x36, 0x62, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x68, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x2c, 0x00, 0x00,
+    0x14, 0x4d, 0x60, 0x74, 0xd4, 0x76, 0xe7, 0x06, 0xa2, 0x32, 0x3c, 0x21, 0xd6, 0xd7, 0xa5, 0x99, 0x00, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x02,
+    0x7b, 0xef, 0x2c, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x78, 0x6c, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x24, 0x00,
+    0x00, 0x36, 0x28, 0x6f, 0x9f, 0x16, 0x91, 0xb9, 0x61, 0xcb, 0x82, 0x19, 0xe2, 0x92, 0x73, 0x8c, 0xa9, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00,
+    0x2d, 0x96, 0x6c, 0xf3, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x68, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x2c,
+    0x00, 0x00, 0xc6, 0xd7, 0xd5, 0x62, 0x9e, 0xa0, 0x39, 0x70, 0x7e, 0x3e, 0x12, 0x9f, 0x90, 0xd9, 0x0f, 0x22, 0x00,
+    0x01, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00,
+    0x00, 0x36, 0xc1, 0x1e, 0x75, 0x3c, 0x69, 0x6e, 0x63, 0x2c, 0x64, 0x65, 0x63, 0x3e, 0x20, 0x69, 0x79, 0x6c, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xed,
+    0x4b, 0x03, 0x01, 0xa8, 0xf9, 0x59, 0xf5, 0xa4, 0x93, 0xed, 0xf5, 0x96, 0x6f, 0x68, 0xd9, 0x86, 0xe6, 0xd8, 0x4b,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x4d, 0x45, 0xa9, 0xac, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x2c, 0x28, 0x6e,
+    0x6e, 0x6e, 0x6e, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff,
+    0x2a, 0x03, 0x01, 0x00, 0x63, 0x98, 0x30, 0x78, 0x77, 0x20, 0xfe, 0xb1, 0xfa, 0xb9, 0xb8, 0xab, 0x04, 0x06, 0x15,
+    0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x5f, 0x97, 0x24, 0x87, 0x6c, 0x64, 0x20, 0x68, 0x6c, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xff, 0xed, 0x7b, 0x03, 0x01, 0xfc, 0x8d, 0xd7, 0x57, 0x61, 0x21, 0x18, 0xca, 0x85, 0xc1, 0xda, 0x27, 0x83, 0x1e,
+    0x60, 0xf4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x7a, 0xce, 0xa1, 0x1b, 0x6c, 0x64, 0x20, 0x73, 0x70, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e,
+    0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xff, 0xdd, 0x2a, 0x03, 0x01, 0xd7, 0xde, 0xfa, 0xa6, 0x80, 0xf7, 0x4c, 0x24, 0xde, 0x87, 0xc2, 0xbc, 0x16,
+    0x63, 0x96, 0x4c, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x85, 0x8b, 0xf1, 0x6d, 0x6c, 0x64, 0x20, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e,
+    0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xff, 0xed, 0x43, 0x03, 0x01, 0x98, 0x1f, 0x4d, 0x84, 0xac, 0xe8, 0xed, 0xc9, 0x5d, 0xc9, 0x61, 0x8f,
+    0x80, 0x3f, 0xbf, 0xc7, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+    0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x64, 0x1e, 0x87, 0x15, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29,
+    0x2c, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xff, 0x22, 0x03, 0x01, 0x00, 0x03, 0xd0, 0x72, 0x77, 0x53, 0x7f, 0x72, 0x3f, 0xea, 0x64, 0x80,
+    0xe1, 0x10, 0x2d, 0xe9, 0x35, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa3, 0x60, 0x8b, 0x47, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e,
+    0x29, 0x2c, 0x68, 0x6c, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xed, 0x73, 0x03, 0x01, 0xdc, 0xc0, 0xd6, 0xd1, 0x5a, 0xed, 0x56, 0xf3, 0xda, 0xaf,
+    0xa7, 0x6c, 0x44, 0x9f, 0x0a, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x16, 0x58, 0x5f, 0xd7, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e,
+    0x6e, 0x29, 0x2c, 0x73, 0x70, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x22, 0x03, 0x01, 0xc3, 0x6c, 0x91, 0x0d, 0x00, 0x69, 0xf8, 0x8e, 0xd6,
+    0xe3, 0xf7, 0xc3, 0xc6, 0xd9, 0xdf, 0xc2, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xba, 0x10, 0x2a, 0x6b, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e,
+    0x6e, 0x6e, 0x29, 0x2c, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x01, 0x00, 0x00, 0x00, 0x1c, 0x5c, 0x46, 0x2d, 0xb9, 0x8e, 0x78, 0x60,
+    0xb1, 0x74, 0x0e, 0xb3, 0x46, 0xd1, 0xcc, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xde, 0x39, 0x19, 0x69, 0x6c, 0x64, 0x20, 0x3c, 0x62,
+    0x63, 0x2c, 0x64, 0x65, 0x2c, 0x68, 0x6c, 0x2c, 0x73, 0x70, 0x3e, 0x2c, 0x6e, 0x6e, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x21, 0x00, 0x00, 0xe8, 0x87, 0x06, 0x20, 0x12, 0xbd, 0x9b,
+    0xb6, 0x53, 0x72, 0xe5, 0xa1, 0x51, 0x13, 0xbd, 0xf1, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x22, 0x7d, 0xd5, 0x25, 0x6c, 0x64, 0x20, 0x3c,
+    0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2c, 0x6e, 0x6e, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x0a, 0x00, 0x00, 0x00, 0xa8, 0xb3, 0x2a, 0x1d, 0x8e, 0x7f,
+    0xac, 0x42, 0x03, 0x01, 0x03, 0x01, 0xc6, 0xb1, 0x8e, 0xef, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0xb0, 0x81, 0x89, 0x35, 0x6c, 0x64, 0x20,
+    0x61, 0x2c, 0x3c, 0x28, 0x62, 0x63, 0x29, 0x2c, 0x28, 0x64, 0x65, 0x29, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x06, 0x00, 0x00, 0x00, 0x07, 0xc4, 0x9d, 0xf4, 0x3d,
+    0xd1, 0x39, 0x03, 0x89, 0xde, 0x55, 0x74, 0x53, 0xc0, 0x09, 0x55, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0xf1, 0xda, 0xb5, 0x56, 0x6c, 0x64,
+    0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c, 0x28, 0x68, 0x6c, 0x29, 0x2c,
+    0x61, 0x3e, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x36, 0x01, 0x00, 0x45, 0x1b, 0x02, 0x01,
+    0x02, 0x01, 0xc1, 0xd5, 0xc7, 0x61, 0xc4, 0xbd, 0xc0, 0x85, 0x16, 0xcd, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x26, 0xdb, 0x47, 0x7e, 0x6c,
+    0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x46, 0x01, 0x00, 0x16, 0xd0, 0x02,
+    0x01, 0x02, 0x01, 0x60, 0x42, 0x39, 0x7f, 0x04, 0x04, 0x97, 0x4a, 0x85, 0xd0, 0x20, 0x18, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xcc, 0x11, 0x06, 0xa8,
+    0x6c, 0x64, 0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x3e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69,
+    0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x66, 0x01, 0x00, 0xe0, 0x84,
+    0x02, 0x01, 0x02, 0x01, 0x52, 0x9c, 0x99, 0xa7, 0xb6, 0x49, 0x93, 0x00, 0xad, 0xee, 0x20, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfa, 0x2a, 0x4d,
+    0x03, 0x6c, 0x64, 0x20, 0x3c, 0x68, 0x2c, 0x6c, 0x3e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b,
+    0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x7e, 0x01, 0x00, 0xb6,
+    0xd8, 0x02, 0x01, 0x02, 0x01, 0x12, 0xc6, 0x07, 0xdf, 0xd0, 0x9c, 0x43, 0xa6, 0xe5, 0xa0, 0x20, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa5, 0xe9,
+    0xac, 0x64, 0x6c, 0x64, 0x20, 0x61, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x26, 0x00, 0x00,
+    0x53, 0x3c, 0x40, 0x46, 0x79, 0xe1, 0x11, 0x77, 0x07, 0xc1, 0xfa, 0x1a, 0x81, 0xad, 0x9b, 0x5d, 0x20, 0x08, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x24,
+    0xe8, 0x82, 0x8b, 0x6c, 0x64, 0x20, 0x3c, 0x69, 0x78, 0x68, 0x2c, 0x69, 0x78, 0x6c, 0x2c, 0x69, 0x79, 0x68, 0x2c,
+    0x69, 0x79, 0x6c, 0x3e, 0x2c, 0x6e, 0x6e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x40, 0x00, 0x00,
+    0x00, 0xa4, 0x72, 0x24, 0xa0, 0xac, 0x61, 0x03, 0x01, 0xc7, 0x82, 0x8f, 0x71, 0x97, 0x8f, 0x8e, 0xef, 0x3f, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00, 0x00,
+    0x74, 0x4b, 0x01, 0x18, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x68, 0x6c, 0x61, 0x3e, 0x2c, 0x3c, 0x62,
+    0x63, 0x64, 0x65, 0x68, 0x6c, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x40,
+    0x00, 0x00, 0xc5, 0xbc, 0x03, 0x01, 0x03, 0x01, 0x03, 0x01, 0xc2, 0x2f, 0xc0, 0x98, 0x83, 0x1f, 0xcd, 0x3b, 0x20,
+    0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00,
+    0x00, 0x47, 0x8b, 0xa3, 0x6b, 0x6c, 0x64, 0x20, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x78, 0x79, 0x61, 0x3e, 0x2c, 0x3c,
+    0x62, 0x63, 0x64, 0x65, 0x78, 0x79, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x32,
+    0x03, 0x01, 0x00, 0x68, 0xfd, 0xec, 0xf4, 0xa0, 0x44, 0x43, 0xb5, 0x53, 0x06, 0xba, 0xcd, 0xd2, 0x4f, 0xd8, 0x1f,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0xff,
+    0x00, 0x00, 0xc9, 0x26, 0x2d, 0xe5, 0x6c, 0x64, 0x20, 0x61, 0x2c, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x20, 0x2f,
+    0x20, 0x6c, 0x64, 0x20, 0x28, 0x6e, 0x6e, 0x6e, 0x6e, 0x29, 0x2c, 0x61, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff,
+    0xed, 0xa8, 0x00, 0x00, 0x52, 0x98, 0xfa, 0x68, 0xa1, 0x66, 0x06, 0x01, 0x04, 0x01, 0x01, 0x00, 0xc1, 0x68, 0xb7,
+    0x20, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7,
+    0x00, 0x00, 0x00, 0x94, 0xf4, 0x27, 0x69, 0x6c, 0x64, 0x64, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x31, 0x29, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24,
+    0xff, 0xed, 0xa8, 0x00, 0x00, 0x2e, 0xf1, 0x2a, 0xeb, 0xba, 0xd5, 0x06, 0x01, 0x04, 0x01, 0x02, 0x00, 0x47, 0xff,
+    0xe4, 0xfb, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xd7, 0x00, 0x00, 0x00, 0x39, 0xdd, 0x3d, 0xe1, 0x6c, 0x64, 0x64, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x32, 0x29, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x24, 0xff, 0xed, 0xa0, 0x00, 0x00, 0x30, 0xfe, 0xcd, 0x03, 0x58, 0x60, 0x05, 0x01, 0x03, 0x01, 0x01, 0x00, 0x04,
+    0x60, 0x88, 0x26, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xd7, 0x00, 0x00, 0x00, 0xf7, 0x82, 0xb0, 0xd1, 0x6c, 0x64, 0x69, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x31, 0x29,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x24, 0xff, 0xed, 0xa0, 0x00, 0x00, 0xce, 0x4a, 0x6e, 0xc2, 0x88, 0xb1, 0x05, 0x01, 0x03, 0x01, 0x02, 0x00,
+    0x14, 0x2d, 0x9f, 0xa3, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xe9, 0xea, 0xd0, 0xae, 0x6c, 0x64, 0x69, 0x3c, 0x72, 0x3e, 0x20, 0x28, 0x32,
+    0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x24, 0xff, 0xed, 0x44, 0x00, 0x00, 0xa2, 0x38, 0x6b, 0x5f, 0x34, 0xd9, 0xe4, 0x57, 0xd6, 0xd2, 0x42,
+    0x46, 0x43, 0x5a, 0xcc, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd6, 0x38, 0xdd, 0x6a, 0x6e, 0x65, 0x67, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xed, 0x67, 0x00, 0x00, 0xcb, 0x91, 0x8b, 0xc4, 0x62, 0xfa, 0x03, 0x01, 0x20, 0xe7,
+    0x79, 0xb4, 0x40, 0x06, 0xe2, 0x8a, 0x00, 0x08, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xd7, 0xff, 0x00, 0x00, 0xff, 0x82, 0x3e, 0x77, 0x3c, 0x72, 0x72, 0x64, 0x2c, 0x72, 0x6c,
+    0x64, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x07, 0x00, 0x00, 0x00, 0x92, 0xcb, 0x43, 0x6d, 0x90, 0x0a, 0x84, 0xc2, 0x53,
+    0x0c, 0x0e, 0xf5, 0x91, 0xeb, 0xfc, 0x40, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0x9b, 0xa3, 0x80, 0x7c, 0x3c, 0x72, 0x6c, 0x63, 0x61, 0x2c,
+    0x72, 0x72, 0x63, 0x61, 0x2c, 0x72, 0x6c, 0x61, 0x2c, 0x72, 0x72, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0xcb, 0x01, 0x06, 0xaf, 0xdd, 0x02, 0x01, 0x02, 0x01, 0x3c, 0xff,
+    0xf6, 0xdb, 0xf4, 0x94, 0x82, 0x80, 0xd9, 0x61, 0x20, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x57, 0x00, 0x00, 0x00, 0x71, 0x00, 0x34, 0xcb, 0x73, 0x68, 0x66, 0x2f, 0x72,
+    0x6f, 0x74, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xcb, 0x00, 0x00, 0x00, 0xeb, 0xcc, 0x4a, 0x5d, 0x07, 0xe0, 0x03,
+    0x01, 0x95, 0x13, 0xee, 0x30, 0x43, 0x78, 0xad, 0x3d, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x57, 0xff, 0x00, 0x00, 0xa4, 0x25, 0x58, 0x33, 0x73, 0x68, 0x66, 0x2f,
+    0x72, 0x6f, 0x74, 0x20, 0x3c, 0x62, 0x2c, 0x63, 0x2c, 0x64, 0x2c, 0x65, 0x2c, 0x68, 0x2c, 0x6c, 0x2c, 0x28, 0x68,
+    0x6c, 0x29, 0x2c, 0x61, 0x3e, 0x2e, 0x2e, 0x24, 0xff, 0xcb, 0x80, 0x00, 0x00, 0xd5, 0x2c, 0xab, 0x97, 0xff, 0x39,
+    0x03, 0x01, 0x4b, 0xd1, 0xb2, 0x6a, 0x53, 0x27, 0x38, 0xb5, 0x00, 0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd7, 0xff, 0x00, 0x00, 0x8b, 0x57, 0xf0, 0x08, 0x3c, 0x73, 0x65,
+    0x74, 0x2c, 0x72, 0x65, 0x73, 0x3e, 0x20, 0x6e, 0x2c, 0x3c, 0x62, 0x63, 0x64, 0x65, 0x68, 0x6c, 0x28, 0x68, 0x6c,
+    0x29, 0x61, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0xcb, 0x01, 0x86, 0x44, 0xfb, 0x02, 0x01, 0x02,
+    0x01, 0x09, 0xba, 0xbe, 0x68, 0xd8, 0x32, 0x10, 0x5e, 0x67, 0xa8, 0x20, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd7, 0x00, 0x00, 0x00, 0xcc, 0x63, 0xf9, 0x8a, 0x3c, 0x73,
+    0x65, 0x74, 0x2c, 0x72, 0x65, 0x73, 0x3e, 0x20, 0x6e, 0x2c, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b,
+    0x31, 0x29, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x70, 0x01, 0x00, 0x0d, 0x27, 0x02, 0x01,
+    0x02, 0x01, 0x3a, 0xb7, 0x7b, 0x88, 0xee, 0x99, 0x86, 0x70, 0x07, 0xca, 0x20, 0x03, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x04, 0x62, 0x6a, 0xbf, 0x6c,
+    0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x3c, 0x62, 0x2c, 0x63, 0x2c,
+    0x64, 0x2c, 0x65, 0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x74, 0x01, 0x00, 0x64, 0xb6, 0x02,
+    0x01, 0x02, 0x01, 0xac, 0xe8, 0xf5, 0xb5, 0xfe, 0xaa, 0x12, 0x10, 0x66, 0x95, 0x20, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6a, 0x1a, 0x88, 0x31,
+    0x6c, 0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x3c, 0x68, 0x2c, 0x6c,
+    0x3e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0xdd, 0x77, 0x01, 0x00, 0xaf, 0x67,
+    0x02, 0x01, 0x02, 0x01, 0x13, 0x4f, 0x44, 0x06, 0xd7, 0xbc, 0x50, 0xac, 0xaf, 0x5f, 0x20, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0xcc, 0xbe, 0x5a,
+    0x96, 0x6c, 0x64, 0x20, 0x28, 0x3c, 0x69, 0x78, 0x2c, 0x69, 0x79, 0x3e, 0x2b, 0x31, 0x29, 0x2c, 0x61, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xff, 0x02, 0x00, 0x00, 0x00, 0x3b,
+    0x0c, 0x92, 0xb5, 0xff, 0x6c, 0x9e, 0x95, 0x03, 0x01, 0x04, 0x01, 0xc1, 0x21, 0xe7, 0xbd, 0x18, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x7a, 0x4c,
+    0x11, 0x4f, 0x6c, 0x64, 0x20, 0x28, 0x3c, 0x62, 0x63, 0x2c, 0x64, 0x65, 0x3e, 0x29, 0x2c, 0x61, 0x2e, 0x2e, 0x2e,
+    0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x24, 0xe5, 0x7e, 0x23, 0x66, 0x6f,
+    0x7e, 0x32, 0x65, 0x1d, 0x23, 0xe5, 0x11, 0x14, 0x00, 0x19, 0x11, 0xda, 0x1c, 0xcd, 0x49, 0x1c, 0xe1, 0xe5, 0x11,
+    0x28, 0x00, 0x19, 0x11, 0x02, 0x1d, 0xcd, 0x49, 0x1c, 0x21, 0x02, 0x1d, 0x36, 0x01, 0xe1, 0xe5, 0x11, 0x42, 0x1d,
+    0x01, 0x04, 0x00, 0xed, 0xb0, 0x11, 0x03, 0x01, 0x01, 0x10, 0x00, 0xed, 0xb0, 0x11, 0x2c, 0x00, 0x19, 0xeb, 0x0e,
+    0x09, 0xcd, 0xce, 0x1d, 0xcd, 0x73, 0x1e, 0x3a, 0x42, 0x1d, 0xfe, 0x76, 0xca, 0x3e, 0x1b, 0xe6, 0xdf, 0xfe, 0xdd,
+    0xc2, 0x3b, 0x1b, 0x3a, 0x43, 0x1d, 0xfe, 0x76, 0xc4, 0x2a, 0x1d, 0xcd, 0x89, 0x1c, 0xc4, 0xad, 0x1c, 0xe1, 0xca,
+    0x7a, 0x1b, 0x11, 0x3c, 0x00, 0x19, 0xcd, 0x34, 0x1e, 0x11, 0x0a, 0x1e, 0xca, 0x71, 0x1b, 0x11, 0x11, 0x1e, 0x0e,
+    0x09, 0xcd, 0xce, 0x1d, 0xcd, 0x99, 0x1d, 0x11, 0x2c, 0x1e, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0x21, 0x87, 0x1e, 0xcd,
+    0x99, 0x1d, 0x11, 0x07, 0x1e, 0x0e, 0x09, 0xcd, 0xce, 0x1d, 0xe1, 0x23, 0x23, 0xc9, 0xe5, 0x3e, 0x01, 0x32, 0xf0,
+    0x1b, 0x32, 0x14, 0x1c, 0x21, 0xda, 0x1c, 0x22, 0xf1, 0x1b, 0x21, 0x02, 0x1d, 0x22, 0x15, 0x1c, 0x06, 0x04, 0xe1,
+    0xe5, 0x11, 0x42, 0x1d, 0xcd, 0xa4, 0x1b, 0x06, 0x10, 0x11, 0x03, 0x01, 0xcd, 0xa4, 0x1b, 0xc3, 0x27, 0x1b, 0xcd,
+    0xad, 0x1b, 0x23, 0x05, 0xc2, 0xa4, 0x1b, 0xc9, 0xc5, 0xd5, 0xe5, 0x4e, 0x11, 0x14, 0x00, 0x19, 0x7e, 0xfe, 0x00,
+    0xca, 0xce, 0x1b, 0x06, 0x08, 0x0f, 0xf5, 0x3e, 0x00, 0xdc, 0xf3, 0x1b, 0xa9, 0x0f, 0x4f, 0xf1, 0x05, 0xc2, 0xbd,
+    0x1b, 0x06, 0x08, 0x11, 0x14, 0x00, 0x19, 0x7e, 0xfe, 0x00, 0xca, 0xe9, 0x1b, 0x06, 0x08, 0x0f, 0xf5, 0x3e, 0x00,
+    0xdc, 0x17, 0x1c, 0xa9, 0x0f, 0x4f, 0xf1, 0x05, 0xc2, 0xda, 0x1b, 0xe1, 0xd1, 0x79, 0x12, 0x13, 0xc1, 0xc9, 0x00,
+    0x00, 0x00, 0xc5, 0xe5, 0x2a, 0xf1, 0x1b, 0x46, 0x21, 0xf0, 0x1b, 0x7e, 0x4f, 0x07, 0x77, 0xfe, 0x01, 0xc2, 0x0c,
+    0x1c, 0x2a, 0xf1, 0x1b, 0x23, 0x22, 0xf1, 0x1b, 0x78, 0xa1, 0xe1, 0xc1, 0xc8, 0x3e, 0x01, 0xc9, 0x00, 0x00, 0x00,
+    0xc5, 0xe5, 0x2a, 0x15, 0x1c, 0x46, 0x21, 0x14, 0x1c, 0x7e, 0x4f, 0x07, 0x77, 0xfe, 0x01, 0xc2, 0x30, 0x1c, 0x2a,
+    0x15, 0x1c, 0x23, 0x22, 0x15, 0x1c, 0x78, 0xa1, 0xe1, 0xc1, 0xc8, 0x3e, 0x01, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0x36,
+    0x00, 0x54, 0x5d, 0x13, 0x0b, 0xed, 0xb0, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0xd5, 0xeb, 0x01, 0x28, 0x00, 0xcd, 0x38,
+    0x1c, 0xeb, 0x06, 0x14, 0x0e, 0x01, 0x16, 0x00, 0x5e, 0x7b, 0xa1, 0xca, 0x5f, 0x1c, 0x14, 0x79, 0x07, 0x4f, 0xfe,
+    0x01, 0xc2, 0x59, 0x1c, 0x23, 0x05, 0xc2, 0x58, 0x1c, 0x7a, 0xe6, 0xf8, 0x0f, 0x0f, 0x0f, 0x6f, 0x26, 0x00, 0x7a,
+    0xe6, 0x07, 0x3c, 0x47, 0x3e, 0x80, 0x07, 0x05, 0xc2, 0x7c, 0x1c, 0xd1, 0x19, 0x11, 0x14, 0x00, 0x19, 0x77, 0xc9,
+    0xc5, 0xd5, 0xe5, 0x21, 0xda, 0x1c, 0x11, 0x14, 0x00, 0xeb, 0x19, 0xeb, 0x34, 0x7e, 0xfe, 0x00, 0xca, 0xa8, 0x1c,
+    0x47, 0x1a, 0xa0, 0xca, 0xa4, 0x1c, 0x36, 0x00, 0xc1, 0xd1, 0xe1, 0xc9, 0x23, 0x13, 0xc3, 0x95, 0x1c, 0xc5, 0xd5,
+    0xe5, 0x21, 0x02, 0x1d, 0x11, 0x14, 0x00, 0xeb, 0x19, 0xeb, 0x7e, 0xb7, 0xca, 0xd5, 0x1c, 0x47, 0x1a, 0xa0, 0xc2,
+    0xd1, 0x1c, 0x78, 0x07, 0xfe, 0x01, 0xc2, 0xcf, 0x1c, 0x36, 0x00, 0x23, 0x13, 0x77, 0xaf, 0xe1, 0xd1, 0xc1, 0xc9,
+    0x23, 0x13, 0xc3, 0xb9, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf5, 0xc5, 0xd5, 0xe5, 0xf3, 0xed, 0x73, 0x8d, 0x1d, 0x31,
+    0x05, 0x01, 0xfd, 0xe1, 0xdd, 0xe1, 0xe1, 0xd1, 0xc1, 0xf1, 0xed, 0x7b, 0x11, 0x01, 0x00, 0x00, 0x00, 0x00, 0xed,
+    0x73, 0x8b, 0x1d, 0x31, 0x8b, 0x1d, 0xf5, 0xc5, 0xd5, 0xe5, 0xdd, 0xe5, 0xfd, 0xe5, 0xed, 0x7b, 0x8d, 0x1d, 0xfb,
+    0x2a, 0x03, 0x01, 0x22, 0x7d, 0x1d, 0x21, 0x89, 0x1d, 0x7e, 0xe6, 0xd7, 0x77, 0x06, 0x10, 0x11, 0x7d, 0x1d, 0x21,
+    0x87, 0x1e, 0x1a, 0x13, 0xcd, 0x4b, 0x1e, 0x05, 0xc2, 0x6f, 0x1d, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0xcd, 0xab, 0x1d,
+    0x23, 0x05, 0xc2, 0x8f, 0x1d, 0xc9, 0xf5, 0xc5, 0xe5, 0x06, 0x04, 0x7e, 0xcd, 0xab, 0x1d, 0x23, 0x05, 0xc2, 0x9e,
+    0x1d, 0xe1, 0xc1, 0xf1, 0xc9, 0xf5, 0x0f, 0x0f, 0x0f, 0x0f, 0xcd, 0xb4, 0x1d, 0xf1, 0xf5, 0xc5, 0xd5, 0xe5, 0xe6,
+    0x0f, 0xfe, 0x0a, 0xda, 0xc1, 0x1d, 0xc6, 0x27, 0xc6, 0x30, 0x5f, 0x0e, 0x02, 0xcd, 0xce, 0x1d, 0xe1, 0xd1, 0xc1,
+    0xf1, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0xcd, 0x05, 0x00, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0x5a, 0x38, 0x30, 0x61, 0x6c,
+    0x6c, 0x20, 0x69, 0x6e, 0x73, 0x74, 0x72, 0x75, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x65, 0x78, 0x65, 0x72, 0x63,
+    0x69, 0x73, 0x65, 0x72, 0x0a, 0x0d, 0x24, 0x54, 0x65, 0x73, 0x74, 0x73, 0x20, 0x63, 0x6f, 0x6d, 0x70, 0x6c, 0x65,
+    0x74, 0x65, 0x0a, 0x0d, 0x24, 0x20, 0x20, 0x4f, 0x4b, 0x0a, 0x0d, 0x24, 0x20, 0x20, 0x45, 0x52, 0x52, 0x4f, 0x52,
+    0x20, 0x2a, 0x2a, 0x2a, 0x2a, 0x20, 0x63, 0x72, 0x63, 0x20, 0x65, 0x78, 0x70, 0x65, 0x63, 0x74, 0x65, 0x64, 0x3a,
+    0x24, 0x20, 0x66, 0x6f, 0x75, 0x6e, 0x64, 0x3a, 0x24, 0xc5, 0xd5, 0xe5, 0x11, 0x87, 0x1e, 0x06, 0x04, 0x1a, 0xbe,
+    0xc2, 0x47, 0x1e, 0x23, 0x13, 0x05, 0xc2, 0x3c, 0x1e, 0xe1, 0xd1, 0xc1, 0xc9, 0xf5, 0xc5, 0xd5, 0xe5, 0xe5, 0x11,
+    0x03, 0x00, 0x19, 0xae, 0x6f, 0x26, 0x00, 0x29, 0x29, 0xeb, 0x21, 0x8b, 0x1e, 0x19, 0xeb, 0xe1, 0x01, 0x04, 0x00,
+    0x1a, 0xa8, 0x46, 0x77, 0x13, 0x23, 0x0d, 0xc2, 0x64, 0x1e, 0xe1, 0xd1, 0xc1, 0xf1, 0xc9, 0xf5, 0xc5, 0xe5, 0x21,
+    0x87, 0x1e, 0x3e, 0xff, 0x06, 0x04, 0x77, 0x23, 0x05, 0xc2, 0x7d, 0x1e, 0xe1, 0xc1, 0xf1, 0xc9, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x77, 0x07, 0x30, 0x96, 0xee, 0x0e, 0x61, 0x2c, 0x99, 0x09, 0x51, 0xba, 0x07, 0x6d,
+    0xc4, 0x19, 0x70, 0x6a, 0xf4, 0x8f, 0xe9, 0x63, 0xa5, 0x35, 0x9e, 0x64, 0x95, 0xa3, 0x0e, 0xdb, 0x88, 0x32, 0x79,
+    0xdc, 0xb8, 0xa4, 0xe0, 0xd5, 0xe9, 0x1e, 0x97, 0xd2, 0xd9, 0x88, 0x09, 0xb6, 0x4c, 0x2b, 0x7e, 0xb1, 0x7c, 0xbd,
+    0xe7, 0xb8, 0x2d, 0x07, 0x90, 0xbf, 0x1d, 0x91, 0x1d, 0xb7, 0x10, 0x64, 0x6a, 0xb0, 0x20, 0xf2, 0xf3, 0xb9, 0x71,
+    0x48, 0x84, 0xbe, 0x41, 0xde, 0x1a, 0xda, 0xd4, 0x7d, 0x6d, 0xdd, 0xe4, 0xeb, 0xf4, 0xd4, 0xb5, 0x51, 0x83, 0xd3,
+    0x85, 0xc7, 0x13, 0x6c, 0x98, 0x56, 0x64, 0x6b, 0xa8, 0xc0, 0xfd, 0x62, 0xf9, 0x7a, 0x8a, 0x65, 0xc9, 0xec, 0x14,
+    0x01, 0x5c, 0x4f, 0x63, 0x06, 0x6c, 0xd9, 0xfa, 0x0f, 0x3d, 0x63, 0x8d, 0x08, 0x0d, 0xf5, 0x3b, 0x6e, 0x20, 0xc8,
+    0x4c, 0x69, 0x10, 0x5e, 0xd5, 0x60, 0x41, 0xe4, 0xa2, 0x67, 0x71, 0x72, 0x3c, 0x03, 0xe4, 0xd1, 0x4b, 0x04, 0xd4,
+    0x47, 0xd2, 0x0d, 0x85, 0xfd, 0xa5, 0x0a, 0xb5, 0x6b, 0x35, 0xb5, 0xa8, 0xfa, 0x42, 0xb2, 0x98, 0x6c, 0xdb, 0xbb,
+    0xc9, 0xd6, 0xac, 0xbc, 0xf9, 0x40, 0x32, 0xd8, 0x6c, 0xe3, 0x45, 0xdf, 0x5c, 0x75, 0xdc, 0xd6, 0x0d, 0xcf, 0xab,
+    0xd1, 0x3d, 0x59, 0x26, 0xd9, 0x30, 0xac, 0x51, 0xde, 0x00, 0x3a, 0xc8, 0xd7, 0x51, 0x80, 0xbf, 0xd0, 0x61, 0x16,
+    0x21, 0xb4, 0xf4, 0xb5, 0x56, 0xb3, 0xc4, 0x23, 0xcf, 0xba, 0x95, 0x99, 0xb8, 0xbd, 0xa5, 0x0f, 0x28, 0x02, 0xb8,
+    0x9e, 0x5f, 0x05, 0x88, 0x08, 0xc6, 0x0c, 0xd9, 0xb2, 0xb1, 0x0b, 0xe9, 0x24, 0x2f, 0x6f, 0x7c, 0x87, 0x58, 0x68,
+    0x4c, 0x11, 0xc1, 0x61, 0x1d, 0xab, 0xb6, 0x66, 0x2d, 0x3d, 0x76, 0xdc, 0x41, 0x90, 0x01, 0xdb, 0x71, 0x06, 0x98,
+    0xd2, 0x20, 0xbc, 0xef, 0xd5, 0x10, 0x2a, 0x71, 0xb1, 0x85, 0x89, 0x06, 0xb6, 0xb5, 0x1f, 0x9f, 0xbf, 0xe4, 0xa5,
+    0xe8, 0xb8, 0xd4, 0x33, 0x78, 0x07, 0xc9, 0xa2, 0x0f, 0x00, 0xf9, 0x34, 0x96, 0x09, 0xa8, 0x8e, 0xe1, 0x0e, 0x98,
+    0x18, 0x7f, 0x6a, 0x0d, 0xbb, 0x08, 0x6d, 0x3d, 0x2d, 0x91, 0x64, 0x6c, 0x97, 0xe6, 0x63, 0x5c, 0x01, 0x6b, 0x6b,
+    0x51, 0xf4, 0x1c, 0x6c, 0x61, 0x62, 0x85, 0x65, 0x30, 0xd8, 0xf2, 0x62, 0x00, 0x4e, 0x6c, 0x06, 0x95, 0xed, 0x1b,
+    0x01, 0xa5, 0x7b, 0x82, 0x08, 0xf4, 0xc1, 0xf5, 0x0f, 0xc4, 0x57, 0x65, 0xb0, 0xd9, 0xc6, 0x12, 0xb7, 0xe9, 0x50,
+    0x8b, 0xbe, 0xb8, 0xea, 0xfc, 0xb9, 0x88, 0x7c, 0x62, 0xdd, 0x1d, 0xdf, 0x15, 0xda, 0x2d, 0x49, 0x8c, 0xd3, 0x7c,
+    0xf3, 0xfb, 0xd4, 0x4c, 0x65, 0x4d, 0xb2, 0x61, 0x58, 0x3a, 0xb5, 0x51, 0xce, 0xa3, 0xbc, 0x00, 0x74, 0xd4, 0xbb,
+    0x30, 0xe2, 0x4a, 0xdf, 0xa5, 0x41, 0x3d, 0xd8, 0x95, 0xd7, 0xa4, 0xd1, 0xc4, 0x6d, 0xd3, 0xd6, 0xf4, 0xfb, 0x43,
+    0x69, 0xe9, 0x6a, 0x34, 0x6e, 0xd9, 0xfc, 0xad, 0x67, 0x88, 0x46, 0xda, 0x60, 0xb8, 0xd0, 0x44, 0x04, 0x2d, 0x73,
+    0x33, 0x03, 0x1d, 0xe5, 0xaa, 0x0a, 0x4c, 0x5f, 0xdd, 0x0d, 0x7c, 0xc9, 0x50, 0x05, 0x71, 0x3c, 0x27, 0x02, 0x41,
+    0xaa, 0xbe, 0x0b, 0x10, 0x10, 0xc9, 0x0c, 0x20, 0x86, 0x57, 0x68, 0xb5, 0x25, 0x20, 0x6f, 0x85, 0xb3, 0xb9, 0x66,
+    0xd4, 0x09, 0xce, 0x61, 0xe4, 0x9f, 0x5e, 0xde, 0xf9, 0x0e, 0x29, 0xd9, 0xc9, 0x98, 0xb0, 0xd0, 0x98, 0x22, 0xc7,
+    0xd7, 0xa8, 0xb4, 0x59, 0xb3, 0x3d, 0x17, 0x2e, 0xb4, 0x0d, 0x81, 0xb7, 0xbd, 0x5c, 0x3b, 0xc0, 0xba, 0x6c, 0xad,
+    0xed, 0xb8, 0x83, 0x20, 0x9a, 0xbf, 0xb3, 0xb6, 0x03, 0xb6, 0xe2, 0x0c, 0x74, 0xb1, 0xd2, 0x9a, 0xea, 0xd5, 0x47,
+    0x39, 0x9d, 0xd2, 0x77, 0xaf, 0x04, 0xdb, 0x26, 0x15, 0x73, 0xdc, 0x16, 0x83, 0xe3, 0x63, 0x0b, 0x12, 0x94, 0x64,
+    0x3b, 0x84, 0x0d, 0x6d, 0x6a, 0x3e, 0x7a, 0x6a, 0x5a, 0xa8, 0xe4, 0x0e, 0xcf, 0x0b, 0x93, 0x09, 0xff, 0x9d, 0x0a,
+    0x00, 0xae, 0x27, 0x7d, 0x07, 0x9e, 0xb1, 0xf0, 0x0f, 0x93, 0x44, 0x87, 0x08, 0xa3, 0xd2, 0x1e, 0x01, 0xf2, 0x68,
+    0x69, 0x06, 0xc2, 0xfe, 0xf7, 0x62, 0x57, 0x5d, 0x80, 0x65, 0x67, 0xcb, 0x19, 0x6c, 0x36, 0x71, 0x6e, 0x6b, 0x06,
+    0xe7, 0xfe, 0xd4, 0x1b, 0x76, 0x89, 0xd3, 0x2b, 0xe0, 0x10, 0xda, 0x7a, 0x5a, 0x67, 0xdd, 0x4a, 0xcc, 0xf9, 0xb9,
+    0xdf, 0x6f, 0x8e, 0xbe, 0xef, 0xf9, 0x17, 0xb7, 0xbe, 0x43, 0x60, 0xb0, 0x8e, 0xd5, 0xd6, 0xd6, 0xa3, 0xe8, 0xa1,
+    0xd1, 0x93, 0x7e, 0x38, 0xd8, 0xc2, 0xc4, 0x4f, 0xdf, 0xf2, 0x52, 0xd1, 0xbb, 0x67, 0xf1, 0xa6, 0xbc, 0x57, 0x67,
+    0x3f, 0xb5, 0x06, 0xdd, 0x48, 0xb2, 0x36, 0x4b, 0xd8, 0x0d, 0x2b, 0xda, 0xaf, 0x0a, 0x1b, 0x4c, 0x36, 0x03, 0x4a,
+    0xf6, 0x41, 0x04, 0x7a, 0x60, 0xdf, 0x60, 0xef, 0xc3, 0xa8, 0x67, 0xdf, 0x55, 0x31, 0x6e, 0x8e, 0xef, 0x46, 0x69,
+    0xbe, 0x79, 0xcb, 0x61, 0xb3, 0x8c, 0xbc, 0x66, 0x83, 0x1a, 0x25, 0x6f, 0xd2, 0xa0, 0x52, 0x68, 0xe2, 0x36, 0xcc,
+    0x0c, 0x77, 0x95, 0xbb, 0x0b, 0x47, 0x03, 0x22, 0x02, 0x16, 0xb9, 0x55, 0x05, 0x26, 0x2f, 0xc5, 0xba, 0x3b, 0xbe,
+    0xb2, 0xbd, 0x0b, 0x28, 0x2b, 0xb4, 0x5a, 0x92, 0x5c, 0xb3, 0x6a, 0x04, 0xc2, 0xd7, 0xff, 0xa7, 0xb5, 0xd0, 0xcf,
+    0x31, 0x2c, 0xd9, 0x9e, 0x8b, 0x5b, 0xde, 0xae, 0x1d, 0x9b, 0x64, 0xc2, 0xb0, 0xec, 0x63, 0xf2, 0x26, 0x75, 0x6a,
+    0xa3, 0x9c, 0x02, 0x6d, 0x93, 0x0a, 0x9c, 0x09, 0x06, 0xa9, 0xeb, 0x0e, 0x36, 0x3f, 0x72, 0x07, 0x67, 0x85, 0x05,
+    0x00, 0x57, 0x13, 0x95, 0xbf, 0x4a, 0x82, 0xe2, 0xb8, 0x7a, 0x14, 0x7b, 0xb1, 0x2b, 0xae, 0x0c, 0xb6, 0x1b, 0x38,
+    0x92, 0xd2, 0x8e, 0x9b, 0xe5, 0xd5, 0xbe, 0x0d, 0x7c, 0xdc, 0xef, 0xb7, 0x0b, 0xdb, 0xdf, 0x21, 0x86, 0xd3, 0xd2,
+    0xd4, 0xf1, 0xd4, 0xe2, 0x42, 0x68, 0xdd, 0xb3, 0xf8, 0x1f, 0xda, 0x83, 0x6e, 0x81, 0xbe, 0x16, 0xcd, 0xf6, 0xb9,
+    0x26, 0x5b, 0x6f, 0xb0, 0x77, 0xe1, 0x18, 0xb7, 0x47, 0x77, 0x88, 0x08, 0x5a, 0xe6, 0xff, 0x0f, 0x6a, 0x70, 0x66,
+    0x06, 0x3b, 0xca, 0x11, 0x01, 0x0b, 0x5c, 0x8f, 0x65, 0x9e, 0xff, 0xf8, 0x62, 0xae, 0x69, 0x61, 0x6b, 0xff, 0xd3,
+    0x16, 0x6c, 0xcf, 0x45, 0xa0, 0x0a, 0xe2, 0x78, 0xd7, 0x0d, 0xd2, 0xee, 0x4e, 0x04, 0x83, 0x54, 0x39, 0x03, 0xb3,
+    0xc2, 0xa7, 0x67, 0x26, 0x61, 0xd0, 0x60, 0x16, 0xf7, 0x49, 0x69, 0x47, 0x4d, 0x3e, 0x6e, 0x77, 0xdb, 0xae, 0xd1,
+    0x6a, 0x4a, 0xd9, 0xd6, 0x5a, 0xdc, 0x40, 0xdf, 0x0b, 0x66, 0x37, 0xd8, 0x3b, 0xf0, 0xa9, 0xbc, 0xae, 0x53, 0xde,
+    0xbb, 0x9e, 0xc5, 0x47, 0xb2, 0xcf, 0x7f, 0x30, 0xb5, 0xff, 0xe9, 0xbd, 0xbd, 0xf2, 0x1c, 0xca, 0xba, 0xc2, 0x8a,
+    0x53, 0xb3, 0x93, 0x30, 0x24, 0xb4, 0xa3, 0xa6, 0xba, 0xd0, 0x36, 0x05, 0xcd, 0xd7, 0x06, 0x93, 0x54, 0xde, 0x57,
+    0x29, 0x23, 0xd9, 0x67, 0xbf, 0xb3, 0x66, 0x7a, 0x2e, 0xc4, 0x61, 0x4a, 0xb8, 0x5d, 0x68, 0x1b, 0x02, 0x2a, 0x6f,
+    0x2b, 0x94, 0xb4, 0x0b, 0xbe, 0x37, 0xc3, 0x0c, 0x8e, 0xa1, 0x5a, 0x05, 0xdf, 0x1b, 0x2d, 0x02, 0xef, 0x8d};
+
+#endif
@@ -0,0 +1,162 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <epoch/core.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace epoch
+{
+    namespace
+    {
+        constexpr unsigned Width = 64;
+        constexpr unsigned Height = 48;
+        constexpr std::size_t FrameSamples = 960;
+
+        const EmulatorInfo Info{Width, Height, 69888, 50.0, {}};
+        const std::vector<uint32_t> Palette{0xff000000, 0xff0000ff, 0xff00ff00, 0xffff0000};
+
+        // A static background with a marker that changes every frame
+        std::vector<uint8_t> screen(const int frame)
+        {
+            std::vector<uint8_t> indices(Width * Height);
+            for (unsigned i = 0; i < indices.size(); ++i) indices[i] = static_cast<uint8_t>((i / Width + i) % 3);
+            indices[static_cast<std::size_t>(frame) % indices.size()] = 3;
+            return indices;
+        }
+
+        class Recording
+        {
+        public:
+            explicit Recording(const std::string& name) : path{std::filesystem::temp_directory_path() / name} {}
+            ~Recording()
+            {
+                std::filesystem::remove(video());
+                std::filesystem::remove(wav());
+            }
+
+            [[nodiscard]] std::filesystem::path video() const { return path.string() + ".epv"; }
+            [[nodiscard]] std::filesystem::path wav() const { return path.string() + ".wav"; }
+
+            // Writes frame with the audio that precedes it
+            void frame(Recorder& recorder, const int frame)
+            {
+                const std::vector<float> audio(FrameSamples * 2, 0.25f);
+                recorder.audio(audio);
+                screens.push_back(screen(frame));
+                recorder.frame(screens.back());
+            }
+
+            // All the frames in the video file
+            [[nodiscard]] std::vector<std::vector<uint8_t>> read() const
+            {
+                RecordingReader reader{video()};
+                EXPECT_EQ(reader.width(), Width);
+                EXPECT_EQ(reader.height(), Height);
+                EXPECT_EQ(reader.palette(), Palette);
+                std::vector<std::vector<uint8_t>> frames;
+                std::vector<uint8_t> indices;
+                while (reader.next(indices)) frames.push_back(indices);
+                return frames;
+            }
+
+            const std::filesystem::path path;
+            std::vector<std::vector<uint8_t>> screens{};
+        };
+    }  // namespace
+
+    TEST(Recorder, RoundTrip)
+    {
+        constexpr int Frames = 300;
+        Recording recording{"epoch_recorder_round_trip"};
+        {
+            Recorder recorder{recording.path, Info, Palette, 48000};
+            for (int i = 0; i < Frames; i++)
+            {
+                // Offline: let the encoder catch up before the pool can run out
+                if (i % (Recorder::PoolSize / 2) == 0) recorder.flush();
+                recording.frame(recorder, i);
+            }
+            recorder.flush();
+            const auto statistics = recorder.statistics();
+            EXPECT_EQ(statistics.frames, static_cast<uint64_t>(Frames));
+            EXPECT_EQ(statistics.dropped, 0u);
+            EXPECT_EQ(statistics.queueDepth, 0u);
+        }
+
+        EXPECT_EQ(recording.read(), recording.screens);
+        // Deltas of a mostly static screen: far smaller than the raw indices
+        EXPECT_LT(std::filesystem::file_size(recording.video()), Frames * Width * Height / 20);
+        EXPECT_EQ(std::filesystem::file_size(recording.wav()), 44 + Frames * FrameSamples * 2 * sizeof(int16_t));
+    }
+
+    TEST(Recorder, DroppedFramesRepeatTheFrameThatGetsTheBuffer)
+    {
+        Recording recording{"epoch_recorder_dropped"};
+        {
+            Recorder recorder{recording.path, Info, Palette, 48000};
+            recorder.setEncoderPaused(true);
+            // One buffer is always being filled: the others are queued, then the pool is exhausted
+            constexpr int Queued = Recorder::PoolSize - 1;
+            for (int i = 0; i < Queued; i++) recording.frame(recorder, i);
+            EXPECT_EQ(recorder.statistics().queueDepth, static_cast<std::size_t>(Queued));
+            for (int i = Queued; i < Queued + 3; i++) recording.frame(recorder, i);
+            EXPECT_EQ(recorder.statistics().dropped, 3u);
+
+            recorder.flush();
+            recording.frame(recorder, Queued + 3);
+            recording.frame(recorder, Queued + 4);
+        }
+
+        const auto frames = recording.read();
+        ASSERT_EQ(frames.size(), recording.screens.size());
+        const auto& screens = recording.screens;
+        for (std::size_t i = 0; i < Recorder::PoolSize - 1; i++) EXPECT_EQ(frames[i], screens[i]) << "frame " << i;
+        // The three dropped frames and the one that found a free buffer are all that last frame
+        for (std::size_t i = Recorder::PoolSize - 1; i < Recorder::PoolSize + 3; i++)
+        {
+            EXPECT_EQ(frames[i], screens[Recorder::PoolSize + 2]) << "frame " << i;
+        }
+        EXPECT_EQ(frames.back(), screens.back());
+        // Audio is never dropped
+        EXPECT_EQ(std::filesystem::file_size(recording.wav()),
+                  44 + screens.size() * FrameSamples * 2 * sizeof(int16_t));
+    }
+
+    TEST(Recorder, DroppedFramesAtTheEnd)
+    {
+        Recording recording{"epoch_recorder_dropped_end"};
+        {
+            Recorder recorder{recording.path, Info, Palette, 48000};
+            recorder.setEncoderPaused(true);
+            for (std::size_t i = 0; i < Recorder::PoolSize + 1; i++) recording.frame(recorder, static_cast<int>(i));
+            EXPECT_EQ(recorder.statistics().dropped, 2u);
+            // Closing drains the queue even with the encoder paused
+        }
+
+        const auto frames = recording.read();
+        ASSERT_EQ(frames.size(), recording.screens.size());
+        EXPECT_EQ(frames[Recorder::PoolSize - 2], recording.screens[Recorder::PoolSize - 2]);
+        EXPECT_EQ(frames[Recorder::PoolSize - 1], recording.screens.back());
+        EXPECT_EQ(frames[Recorder::PoolSize], recording.screens.back());
+    }
+}  // namespace epoch
@@ -0,0 +1,97 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/frontend/src/ConfigurableShader.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace epoch::frontend
+{
+    namespace
+    {
+        std::vector<ShaderPass> parse(const std::string_view preset)
+        {
+            return parseShaderPreset(preset, [](const std::string& name) { return "source of " + name; });
+        }
+    }  // namespace
+
+    TEST(ShaderPreset, TwoPasses)
+    {
+        const auto passes = parse(R"(# Comments and quotes are ignored
+shaders = 2
+
+shader0 = "first.glsl"
+scale_type0 = absolute
+scale0 = 320
+filter_linear0 = true
+
+shader1 = second.glsl  # last pass
+)");
+        ASSERT_EQ(passes.size(), 2u);
+        EXPECT_EQ(passes[0].source, "source of first.glsl");
+        EXPECT_EQ(passes[0].scaleType, ShaderPassScale::absolute);
+        EXPECT_FLOAT_EQ(passes[0].scale, 320.f);
+        EXPECT_TRUE(passes[0].filterLinear);
+        EXPECT_EQ(passes[1].source, "source of second.glsl");
+        EXPECT_EQ(passes[1].scaleType, ShaderPassScale::viewport);
+        EXPECT_FLOAT_EQ(passes[1].scale, 1.f);
+        EXPECT_FALSE(passes[1].filterLinear);
+    }
+
+    TEST(ShaderPreset, IntermediatePassesDefaultToSourceScale)
+    {
+        const auto passes = parse("shaders = 3\nshader0 = a\nshader1 = b\nscale1 = 2.5\nshader2 = c\n");
+        ASSERT_EQ(passes.size(), 3u);
+        EXPECT_EQ(passes[0].scaleType, ShaderPassScale::source);
+        EXPECT_EQ(passes[1].scaleType, ShaderPassScale::source);
+        EXPECT_FLOAT_EQ(passes[1].scale, 2.5f);
+        EXPECT_EQ(passes[2].scaleType, ShaderPassScale::viewport);
+    }
+
+    TEST(ShaderPreset, MissingPass)
+    {
+        EXPECT_THROW((void)parse("shaders = 2\nshader0 = a\n"), std::runtime_error);
+        EXPECT_THROW((void)parse("shaders = 2\nshader0 = a\nshader2 = c\n"), std::runtime_error);
+        EXPECT_THROW((void)parse("shader0 = a\n"), std::runtime_error);
+    }
+
+    TEST(ShaderPreset, BadPassCount)
+    {
+        for (const auto* count : {"0", "-1", "two", "2x", ""})
+        {
+            EXPECT_THROW((void)parse(std::string{"shaders = "} + count + "\nshader0 = a\nshader1 = b\n"),
+                         std::runtime_error)
+                << count;
+        }
+    }
+
+    TEST(ShaderPreset, BadScale)
+    {
+        for (const auto* scale : {"0", "-2", "big", "2x", "nan", "inf", ""})
+        {
+            EXPECT_THROW((void)parse(std::string{"shaders = 1\nshader0 = a\nscale0 = "} + scale + "\n"),
+                         std::runtime_error)
+                << scale;
+        }
+        EXPECT_THROW((void)parse("shaders = 1\nshader0 = a\nscale_type0 = stretch\n"), std::runtime_error);
+    }
+}  // namespace epoch::frontend
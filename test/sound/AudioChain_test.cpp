@@ -0,0 +1,163 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <epoch/sound.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace epoch::sound
+{
+    namespace
+    {
+        std::vector<SoundSample> sine(const float frequency, const float sampleRate, const std::size_t count,
+                                      const float offset = 0.f)
+        {
+            std::vector<SoundSample> samples(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const auto value = std::sin(2.f * std::numbers::pi_v<float> * frequency * static_cast<float>(i) /
+                                            sampleRate);
+                samples[i] = {offset + value, offset - value};
+            }
+            return samples;
+        }
+
+        // Peak of the left channel after the first skip samples, past any filter transient
+        float peak(const std::vector<SoundSample>& samples, const std::size_t skip)
+        {
+            float result = 0;
+            for (std::size_t i = skip; i < samples.size(); ++i) result = std::max(result, std::abs(samples[i].left));
+            return result;
+        }
+    }  // namespace
+
+    TEST(AudioChain, DcBlockerRemovesOffset)
+    {
+        DcBlocker blocker{48000.f};
+        std::vector<SoundSample> block(48000, SoundSample{0.8f});
+        blocker.process(block);
+        EXPECT_NEAR(block.back().left, 0.f, 1e-3f);
+        EXPECT_NEAR(block.back().right, 0.f, 1e-3f);
+    }
+
+    TEST(AudioChain, LowPassAttenuatesAboveCutoff)
+    {
+        LowPassFilter pass{48000.f, 8000.f};
+        auto low = sine(1000.f, 48000.f, 4800);
+        pass.process(low);
+        EXPECT_NEAR(peak(low, 480), 1.f, 0.02f);
+
+        LowPassFilter stop{48000.f, 8000.f};
+        auto high = sine(20000.f, 48000.f, 4800);
+        stop.process(high);
+        EXPECT_LT(peak(high, 480), 0.1f);
+    }
+
+    TEST(AudioChain, StereoWidener)
+    {
+        std::vector<SoundSample> block(7, SoundSample{0.5f, 0.1f});
+        StereoWidener{0.f}.process(block);
+        for (const auto& sample : block)
+        {
+            EXPECT_FLOAT_EQ(sample.left, 0.3f);
+            EXPECT_FLOAT_EQ(sample.right, 0.3f);
+        }
+        StereoWidener{2.f}.process(block = std::vector<SoundSample>(7, SoundSample{0.5f, 0.1f}));
+        for (const auto& sample : block)
+        {
+            EXPECT_FLOAT_EQ(sample.left, 0.7f);
+            EXPECT_FLOAT_EQ(sample.right, -0.1f);
+        }
+    }
+
+    TEST(AudioChain, ResamplerProducesRequestedSamples)
+    {
+        for (const auto outputRate : {44100., 48000., 96000.})
+        {
+            Resampler resampler{48000., outputRate};
+            std::vector<SoundSample> output;
+            for (const std::size_t count : {512u, 1u, 300u, 0u, 441u})
+            {
+                const auto input = resampler.inputFor(count);
+                std::vector<SoundSample> block(input);
+                output.clear();
+                resampler.process(block, output);
+                EXPECT_GE(output.size(), count) << outputRate;
+                EXPECT_LE(output.size(), count + 1) << outputRate;
+            }
+        }
+    }
+
+    TEST(AudioChain, ResamplerKeepsTones)
+    {
+        Resampler resampler{48000., 44100.};
+        const auto input = sine(1000.f, 48000.f, 48000);
+        std::vector<SoundSample> output;
+        for (std::size_t i = 0; i < input.size(); i += 480)
+        {
+            resampler.process(std::span{input}.subspan(i, 480), output);
+        }
+        EXPECT_NEAR(static_cast<double>(output.size()), 44100., Resampler::Taps);
+        EXPECT_NEAR(peak(output, Resampler::Taps), 1.f, 0.01f);
+
+        // Compare to the ideal tone at the output rate, the resampler does not shift the phase
+        float error = 0;
+        for (std::size_t i = Resampler::Taps; i < output.size(); ++i)
+        {
+            const auto time = static_cast<float>(i) / 44100.f;
+            const auto expected = std::sin(2.f * std::numbers::pi_v<float> * 1000.f * time);
+            error = std::max({error, std::abs(output[i].left - expected), std::abs(output[i].right + expected)});
+        }
+        EXPECT_LT(error, 0.01f);
+    }
+
+    TEST(AudioChain, ResamplerRemovesAliases)
+    {
+        // 23kHz fits at 48kHz but folds back to 21.1kHz at 44.1kHz
+        Resampler resampler{48000., 44100.};
+        const auto input = sine(23000.f, 48000.f, 4800);
+        std::vector<SoundSample> output;
+        resampler.process(input, output);
+        EXPECT_LT(peak(output, Resampler::Taps), 0.05f);
+    }
+
+    TEST(AudioChain, StagesAndTimes)
+    {
+        AudioChain chain{48000., 48000.};
+        chain.emplace<DcBlocker>(48000.f);
+        auto& lowPass = chain.emplace<LowPassFilter>(48000.f, 8000.f);
+        EXPECT_EQ(chain.stageNames(), (std::vector<std::string>{"DC blocker", "Low-pass", "Resampler"}));
+        EXPECT_EQ(chain.stageTimes().size(), 3u);
+
+        lowPass.setEnabled(false);
+        auto block = sine(20000.f, 48000.f, 480);
+        const auto original = block;
+        chain.filter(block);
+        // Only the DC blocker ran, barely touching a 20kHz tone
+        EXPECT_NEAR(peak(block, 0), peak(original, 0), 0.01f);
+        EXPECT_EQ(chain.stageTimes()[1], 0.f);
+
+        std::vector<SoundSample> output;
+        chain.resample(block, output);
+        ASSERT_EQ(output.size(), block.size());
+        EXPECT_EQ(output.front().left, block.front().left);
+    }
+}  // namespace epoch::sound
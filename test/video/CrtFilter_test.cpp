@@ -0,0 +1,229 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <epoch/video.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace epoch::video
+{
+    namespace
+    {
+        constexpr unsigned Width = 64;
+        constexpr unsigned Height = 48;
+
+        const std::vector<uint32_t> Palette = {0xff000000, 0xffd90000, 0xff0000d9, 0xffd900d9,
+                                               0xff00d900, 0xffd9d900, 0xff00d9d9, 0xffd9d9d9};
+
+        std::vector<uint8_t> makeScreen()
+        {
+            // Blocks of color like attribute cells, with some single pixel detail
+            std::mt19937 random{1};
+            std::vector<uint8_t> screen(Width * Height);
+            for (unsigned y = 0; y < Height; ++y)
+            {
+                for (unsigned x = 0; x < Width; ++x)
+                {
+                    screen[y * Width + x] = static_cast<uint8_t>(((x / 8) + (y / 8) * 3) % 8);
+                    if (random() % 7 == 0) screen[y * Width + x] = 7;
+                }
+            }
+            return screen;
+        }
+
+        // Straight transliteration of the crt-easymode fragment shader, for one output pixel
+        uint32_t referencePixel(const std::vector<uint8_t>& screen, const CrtParameters& p, const unsigned outputWidth,
+                                const unsigned outputHeight, const unsigned x, const unsigned y)
+        {
+            constexpr auto pi = std::numbers::pi;
+            struct Color
+            {
+                double r, g, b;
+            };
+            const auto tex = [&](int sx, int sy)
+            {
+                sx = std::clamp(sx, 0, static_cast<int>(Width) - 1);
+                sy = std::clamp(sy, 0, static_cast<int>(Height) - 1);
+                const auto c = Palette[screen[sy * Width + sx]];
+                const auto channel = [&](const int shift)
+                {
+                    const auto v = ((c >> shift) & 0xff) / 255.;
+                    return v * (1. + (v - 1.) * p.dilation);
+                };
+                return Color{channel(0), channel(8), channel(16)};
+            };
+            const auto curve = [](const double d, const double sharp)
+            {
+                const auto step = d >= 0.5 ? 1. : 0.;
+                const auto sign = d < 0.5 ? 1. : (d > 0.5 ? -1. : 0.);
+                return d + (0.5 - std::sqrt(0.25 - (d - step) * (d - step)) * sign - d) * sharp;
+            };
+
+            const auto u = (x + 0.5) / outputWidth, v = (y + 0.5) / outputHeight;
+            const auto pixX = u * Width - 0.5, pixY = v * Height - 0.5;
+            const auto tx = static_cast<int>(std::floor(pixX)), ty = static_cast<int>(std::floor(pixY));
+            const auto distX = pixX - tx, distY = pixY - ty;
+
+            const auto curveX = curve(distX, p.sharpnessH * p.sharpnessH);
+            double coeffs[4] = {1 + curveX, curveX, 1 - curveX, 2 - curveX};
+            double sum = 0;
+            for (auto& c : coeffs)
+            {
+                c = std::max(std::abs(c * pi), 1e-5);
+                c = 2 * std::sin(c) * std::sin(c * 0.5) / (c * c);
+                sum += c;
+            }
+            const auto row = [&](const int sy)
+            {
+                Color taps[4];
+                for (int k = 0; k < 4; ++k) taps[k] = tex(tx - 1 + k, sy);
+                const auto filter = [&](double Color::*channel)
+                {
+                    double value = 0;
+                    for (int k = 0; k < 4; ++k) value += taps[k].*channel * coeffs[k] / sum;
+                    return std::clamp(value, std::min(taps[1].*channel, taps[2].*channel),
+                                      std::max(taps[1].*channel, taps[2].*channel));
+                };
+                return Color{filter(&Color::r), filter(&Color::g), filter(&Color::b)};
+            };
+            const auto col1 = row(ty), col2 = row(ty + 1);
+            const auto mixY = curve(distY, p.sharpnessV);
+            const auto gamma = p.gammaInput / (p.dilation + 1.);
+            Color col{std::pow(col1.r + (col2.r - col1.r) * mixY, gamma),
+                      std::pow(col1.g + (col2.g - col1.g) * mixY, gamma),
+                      std::pow(col1.b + (col2.b - col1.b) * mixY, gamma)};
+
+            const auto luma = 0.2126 * col.r + 0.7152 * col.g + 0.0722 * col.b;
+            const auto bright = (std::max({col.r, col.g, col.b}) + luma) * 0.5;
+            const auto scanBright = std::clamp<double>(bright, p.scanlineBrightMin, p.scanlineBrightMax);
+            const auto scanBeam =
+                std::clamp<double>(bright * p.scanlineBeamWidthMax, p.scanlineBeamWidthMin, p.scanlineBeamWidthMax);
+            auto scanWeight = 1. - std::pow(std::cos(v * 2. * pi * Height) * 0.5 + 0.5, scanBeam) * p.scanlineStrength;
+            if (Height >= p.scanlineCutoff) scanWeight = 1.;
+
+            const auto mask = 1. - p.maskStrength;
+            const auto modX = std::floor((x + 0.5) / p.maskSize);
+            const auto modY = std::floor((y + 0.5) / (p.maskDotHeight * p.maskSize));
+            const auto dot =
+                static_cast<int>(std::fmod((modX + std::fmod(modY, 2.) * p.maskStagger) / p.maskDotWidth, 3.));
+            const Color maskWeight = dot == 0   ? Color{1, mask, mask}
+                                     : dot == 1 ? Color{mask, 1, mask}
+                                                : Color{mask, mask, 1};
+
+            const auto factor = scanWeight + (1. - scanWeight) * scanBright;
+            const auto out = [&](const double value, const double weight)
+            {
+                const auto c = std::pow(value * factor * weight, 1. / p.gammaOutput) * p.brightBoost;
+                return static_cast<uint32_t>(std::lround(std::clamp(c, 0., 1.) * 255.));
+            };
+            return out(col.r, maskWeight.r) | out(col.g, maskWeight.g) << 8 | out(col.b, maskWeight.b) << 16 |
+                   0xff000000;
+        }
+
+        int maxDifference(const uint32_t a, const uint32_t b)
+        {
+            int difference = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                difference = std::max(difference, std::abs(static_cast<int>((a >> shift) & 0xff) -
+                                                           static_cast<int>((b >> shift) & 0xff)));
+            }
+            return difference;
+        }
+    }  // namespace
+
+    TEST(CrtFilter, MatchesShader)
+    {
+        const auto screen = makeScreen();
+        CrtParameters parameters{};
+        ASSERT_TRUE(parameters.set("MASK_STAGGER", 3.f));
+        ASSERT_TRUE(parameters.set("MASK_DOT_WIDTH", 2.f));
+        ASSERT_TRUE(parameters.set("SCANLINE_BEAM_WIDTH_MIN", 1.f));
+        ASSERT_FALSE(parameters.set("NOT_A_PARAMETER", 1.f));
+
+        for (const auto& p : {CrtParameters{}, parameters})
+        {
+            for (const auto scale : {2u, 3u})
+            {
+                CrtFilter filter{Width, Height, Width * scale, Height * scale};
+                filter.setParameters(p);
+                std::vector<uint32_t> output(Width * scale * Height * scale);
+                filter.render(screen, Palette, output, 3);
+
+                int worst = 0;
+                for (unsigned y = 0; y < Height * scale; ++y)
+                {
+                    for (unsigned x = 0; x < Width * scale; ++x)
+                    {
+                        const auto expected = referencePixel(screen, p, Width * scale, Height * scale, x, y);
+                        worst = std::max(worst, maxDifference(output[y * Width * scale + x], expected));
+                    }
+                }
+                EXPECT_LE(worst, 3) << "scale " << scale;
+            }
+        }
+    }
+
+    TEST(CrtFilter, ThreadsDoNotChangeTheResult)
+    {
+        const auto screen = makeScreen();
+        CrtParameters parameters{};
+        parameters.curvature = 1.f;
+        parameters.bloom = 0.3f;
+        CrtFilter filter{Width, Height, Width * 2, Height * 2};
+        filter.setParameters(parameters);
+        std::vector<uint32_t> single(Width * 2 * Height * 2), multi(single.size());
+        filter.render(screen, Palette, single, 1);
+        filter.render(screen, Palette, multi, 4);
+        EXPECT_EQ(single, multi);
+    }
+
+    TEST(CrtFilter, CurvatureBlanksTheCorners)
+    {
+        const std::vector<uint8_t> screen(Width * Height, 7);
+        CrtParameters parameters{};
+        parameters.curvature = 1.f;
+        CrtFilter filter{Width, Height, Width * 2, Height * 2};
+        filter.setParameters(parameters);
+        std::vector<uint32_t> output(Width * 2 * Height * 2);
+        filter.render(screen, Palette, output);
+        EXPECT_EQ(output.front(), 0xff000000);
+        EXPECT_EQ(output.back(), 0xff000000);
+        EXPECT_NE(output[Height * Width * 2 + Width], 0xff000000);
+    }
+
+    TEST(CrtFilter, BloomBrightensScanlineGaps)
+    {
+        const std::vector<uint8_t> screen(Width * Height, 7);
+        CrtFilter filter{Width, Height, Width * 3, Height * 3};
+        std::vector<uint32_t> plain(Width * 3 * Height * 3), glowing(plain.size());
+        filter.render(screen, Palette, plain);
+        CrtParameters parameters{};
+        parameters.bloom = 0.5f;
+        filter.setParameters(parameters);
+        filter.render(screen, Palette, glowing);
+        // Close to the boundary between two source rows, where the scanlines are darkest
+        const auto gap = (Height / 2 * 3) * Width * 3 + Width;
+        EXPECT_GT(glowing[gap] & 0xff, plain[gap] & 0xff);
+    }
+}  // namespace epoch::video
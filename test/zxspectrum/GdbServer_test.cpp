@@ -0,0 +1,240 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/GdbStub.hpp"
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "../../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+
+#include <memory>
+#include <string>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        // A 48K machine stopped by a freshly attached debugger
+        class AttachedStub
+        {
+        public:
+            AttachedStub() : emulator{ZXSpectrumEmulator::create48K()}, stub{*emulator}
+            {
+                emulator->reset();
+                stub.attach();
+            }
+
+            std::string handle(const std::string& packet)
+            {
+                const auto reply = stub.handle(packet);
+                EXPECT_TRUE(reply.has_value()) << packet;
+                return reply.value_or("");
+            }
+
+            // Runs frames until the machine stops by itself, false if it did not within maxFrames
+            bool runUntilStopped(const int maxFrames = 10)
+            {
+                for (int i = 0; i < maxFrames; i++)
+                {
+                    emulator->frame();
+                    if (stub.stopped()) return true;
+                }
+                return false;
+            }
+
+            std::unique_ptr<ZXSpectrumEmulator> emulator;
+            GdbStub stub;
+        };
+
+        // "NOP ; NOP ; LD (9000h),A ; JR $" at 8000h, with PC on its first instruction
+        void loadProgram(AttachedStub& sut)
+        {
+            ASSERT_EQ(sut.handle("M8000,7:000032009018fe"), "OK");
+            ASSERT_EQ(sut.handle("P5=0080"), "OK");
+        }
+    }  // namespace
+
+    TEST(GdbServer, AttachStopsTheMachine)
+    {
+        AttachedStub sut;
+        EXPECT_TRUE(sut.emulator->paused());
+        EXPECT_TRUE(sut.stub.halted());
+        EXPECT_EQ(sut.handle("?"), "S02");
+        EXPECT_FALSE(sut.stub.stopped());
+    }
+
+    TEST(GdbServer, ReadWriteAllRegisters)
+    {
+        AttachedStub sut;
+        // AF BC DE HL SP PC IX IY AF' BC' DE' HL' IR, little endian
+        const std::string registers = "3412785634127856ff7f008001200220cdabcdabcdabcdab0a3f";
+        EXPECT_EQ(sut.handle("G" + registers), "OK");
+        EXPECT_EQ(sut.handle("g"), registers);
+        const auto& r = sut.emulator->cpu()->registers();
+        EXPECT_EQ(r.af, 0x1234);
+        EXPECT_EQ(r.hl, 0x5678);
+        EXPECT_EQ(r.sp, 0x7fff);
+        EXPECT_EQ(r.pc, 0x8000);
+        EXPECT_EQ(r.iy, 0x2002);
+        EXPECT_EQ(r.ir, 0x3f0a);
+    }
+
+    TEST(GdbServer, WriteRegistersRejectsMalformedValues)
+    {
+        AttachedStub sut;
+        const auto before = sut.handle("g");
+        // Invalid hex digit in BC, then a register cut in half
+        EXPECT_EQ(sut.handle("G3412zz56"), "E00");
+        EXPECT_EQ(sut.handle("G341278"), "E00");
+        EXPECT_EQ(sut.handle("G" + before + "0000"), "E00");
+        EXPECT_EQ(sut.handle("g"), before);
+    }
+
+    TEST(GdbServer, ReadWriteSingleRegister)
+    {
+        AttachedStub sut;
+        EXPECT_EQ(sut.handle("P3=3412"), "OK");
+        EXPECT_EQ(sut.emulator->cpu()->registers().hl, 0x1234);
+        EXPECT_EQ(sut.handle("p3"), "3412");
+        EXPECT_EQ(sut.handle("pc"), sut.handle("g").substr(12 * 4, 4));
+        EXPECT_EQ(sut.handle("pd"), "E00");
+        EXPECT_EQ(sut.handle("Pd=0000"), "E00");
+        EXPECT_EQ(sut.handle("P3=34z2"), "E00");
+        EXPECT_EQ(sut.handle("P3"), "E00");
+        EXPECT_EQ(sut.emulator->cpu()->registers().hl, 0x1234);
+    }
+
+    TEST(GdbServer, ReadWriteMemory)
+    {
+        AttachedStub sut;
+        EXPECT_EQ(sut.handle("M8000,3:aaBBcc"), "OK");
+        EXPECT_EQ(sut.handle("m8000,3"), "aabbcc");
+        EXPECT_EQ(sut.handle("m7fff,5"), "00aabbcc00");
+        // Length does not match the data
+        EXPECT_EQ(sut.handle("M8000,2:01"), "E00");
+        EXPECT_EQ(sut.handle("m8000,1"), "aa");
+    }
+
+    TEST(GdbServer, WriteMemoryToRomFails)
+    {
+        AttachedStub sut;
+        const auto rom = sut.handle("m3ffe,4");
+        EXPECT_EQ(sut.handle("M0000,1:ff"), "E01");
+        // Partly in ROM: nothing is written
+        EXPECT_EQ(sut.handle("M3ffe,4:01020304"), "E01");
+        EXPECT_EQ(sut.handle("m3ffe,4"), rom);
+        EXPECT_EQ(sut.handle("m0000,1"), "f3");  // DI
+    }
+
+    TEST(GdbServer, BreakpointAndContinue)
+    {
+        AttachedStub sut;
+        loadProgram(sut);
+        EXPECT_EQ(sut.handle("Z0,8002,1"), "OK");
+        EXPECT_FALSE(sut.stub.handle("c").has_value());
+        EXPECT_FALSE(sut.emulator->paused());
+        EXPECT_FALSE(sut.stub.halted());
+        ASSERT_TRUE(sut.runUntilStopped());
+        EXPECT_EQ(sut.handle("?"), "S05");
+        EXPECT_EQ(sut.handle("p5"), "0280");
+
+        // Removed, the machine runs into the JR $ loop without stopping
+        EXPECT_EQ(sut.handle("z0,8002,1"), "OK");
+        EXPECT_FALSE(sut.stub.handle("c").has_value());
+        EXPECT_FALSE(sut.runUntilStopped(2));
+    }
+
+    TEST(GdbServer, ContinueFromAddress)
+    {
+        AttachedStub sut;
+        loadProgram(sut);
+        EXPECT_EQ(sut.handle("Z1,8005,1"), "OK");
+        EXPECT_FALSE(sut.stub.handle("c8002").has_value());
+        ASSERT_TRUE(sut.runUntilStopped());
+        EXPECT_EQ(sut.handle("p5"), "0580");
+    }
+
+    TEST(GdbServer, WriteWatchpoint)
+    {
+        AttachedStub sut;
+        loadProgram(sut);
+        EXPECT_EQ(sut.handle("Z2,9000,1"), "OK");
+        EXPECT_FALSE(sut.stub.handle("c").has_value());
+        ASSERT_TRUE(sut.runUntilStopped());
+        EXPECT_EQ(sut.handle("?"), "T05watch:9000;");
+        EXPECT_EQ(sut.handle("z2,9000,1"), "OK");
+    }
+
+    TEST(GdbServer, UnsupportedBreakpointType)
+    {
+        AttachedStub sut;
+        EXPECT_EQ(sut.handle("Z9,8000,1"), "");
+        EXPECT_EQ(sut.handle("z9,8000,1"), "");
+    }
+
+    TEST(GdbServer, Step)
+    {
+        AttachedStub sut;
+        loadProgram(sut);
+        EXPECT_EQ(sut.handle("s"), "S05");
+        EXPECT_EQ(sut.handle("p5"), "0180");
+        EXPECT_EQ(sut.handle("s8002"), "S05");
+        EXPECT_EQ(sut.handle("p5"), "0580");
+        EXPECT_TRUE(sut.emulator->paused());
+    }
+
+    TEST(GdbServer, MalformedPackets)
+    {
+        AttachedStub sut;
+        const auto registers = sut.handle("g");
+        EXPECT_EQ(sut.handle("m8000"), "E00");
+        EXPECT_EQ(sut.handle("mzz,1"), "E00");
+        EXPECT_EQ(sut.handle("m8000,1x"), "E00");
+        EXPECT_EQ(sut.handle("M8000,1"), "E00");
+        EXPECT_EQ(sut.handle("Z0"), "E00");
+        EXPECT_EQ(sut.handle("Z08000,1"), "E00");
+        EXPECT_EQ(sut.handle("Z0,8000"), "E00");
+        EXPECT_EQ(sut.handle("sxyz"), "E00");
+        EXPECT_EQ(sut.handle("cxyz"), "E00");
+        EXPECT_TRUE(sut.emulator->paused());
+        // Unknown packets get the empty reply
+        EXPECT_EQ(sut.handle("X8000,0:"), "");
+        EXPECT_EQ(sut.handle(""), "");
+        EXPECT_EQ(sut.handle("g"), registers);
+    }
+
+    TEST(GdbServer, KillClosesTheConnection)
+    {
+        AttachedStub sut;
+        EXPECT_EQ(sut.handle("Z0,8000,1"), "OK");
+        EXPECT_FALSE(sut.stub.handle("k").has_value());
+        EXPECT_TRUE(sut.stub.closing());
+        // Detached, the machine runs again
+        EXPECT_FALSE(sut.emulator->paused());
+        EXPECT_FALSE(sut.stub.halted());
+        sut.stub.attach();
+        EXPECT_FALSE(sut.stub.closing());
+    }
+
+    TEST(GdbServer, DetachResumes)
+    {
+        AttachedStub sut;
+        EXPECT_EQ(sut.handle("D"), "OK");
+        EXPECT_FALSE(sut.emulator->paused());
+        EXPECT_FALSE(sut.stub.closing());
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,72 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/GuestProfiler.hpp"
+#include "../../src/zxspectrum/src/Models.hpp"
+#include "../../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+
+#include <numeric>
+#include <sstream>
+
+namespace epoch::zxspectrum
+{
+    TEST(GuestProfiler, ParseSymbols)
+    {
+        std::istringstream is{
+            "MAIN_LOOP EQU 12A2H\n"           // pasmo
+            "key_input: EQU 0x000010A8\n"     // sjasmplus
+            "print = $0010 ; comment\n"       // z88dk map
+            "02BF KEYBOARD\n"                 // address label
+            "mask_int 0038\n"                 // label address
+            "value equ 100\n"                 // decimal
+            "; only a comment\n"
+            "not a symbol line\n"};
+        const auto symbols = parseSymbols(is);
+        ASSERT_EQ(symbols.size(), 6);
+        EXPECT_EQ(symbols.at(0x12a2), "MAIN_LOOP");
+        EXPECT_EQ(symbols.at(0x10a8), "key_input");
+        EXPECT_EQ(symbols.at(0x0010), "print");
+        EXPECT_EQ(symbols.at(0x02bf), "KEYBOARD");
+        EXPECT_EQ(symbols.at(0x0038), "mask_int");
+        EXPECT_EQ(symbols.at(100), "value");
+    }
+
+    TEST(GuestProfiler, SamplesEveryPeriod)
+    {
+        const auto emulator = ZXSpectrumEmulator::create48K();
+        emulator->reset();
+        emulator->guestProfiler()->setSamplePeriod(16);
+        emulator->setGuestProfiling(true);
+        for (int i = 0; i < 10; i++) emulator->frame();
+
+        const auto profiler = emulator->guestProfiler();
+        EXPECT_EQ(profiler->frames(), 10);
+        EXPECT_EQ(profiler->samples(), 10 * Model48K::TStatesPerFrame / 16);
+        const auto routines = profiler->routines();
+        ASSERT_FALSE(routines.empty());
+        EXPECT_EQ(std::accumulate(routines.begin(), routines.end(), uint64_t{0},
+                                  [](const uint64_t sum, const GuestProfiler::Routine& routine)
+                                  { return sum + routine.selfSamples; }),
+                  profiler->samples());
+        for (const auto& routine : routines)
+        {
+            EXPECT_GE(routine.inclusiveSamples, routine.selfSamples);
+        }
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,102 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/IoBus.hpp"
+#include "../../src/zxspectrum/src/Roms.hpp"
+#include "../../src/zxspectrum/src/Ula.hpp"
+
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        class TestDevice final : public IoDevice
+        {
+        public:
+            explicit TestDevice(const uint8_t value) : m_value{value} {}
+
+            uint8_t ioRead(uint16_t port) override { return m_value; }
+            void ioWrite(const uint16_t port, const uint8_t value) override { writes.emplace_back(port, value); }
+
+            std::vector<std::pair<uint16_t, uint8_t>> writes;
+
+        private:
+            uint8_t m_value;
+        };
+    }  // namespace
+
+    TEST(IoBus, Decoding)
+    {
+        TestDevice first{0x11}, second{0x22};
+        IoBus bus;
+        EXPECT_EQ(bus.read(0x1234), 0xff);
+        bus.write(0x1234, 0x00);
+
+        bus.attach(&first, {0x00ff, 0x001f}, {0x0001, 0x0000});
+        bus.attach(&second, {0x0001, 0x0001}, {0x0003, 0x0000});
+        EXPECT_EQ(bus.read(0x001f), 0x11);  // Both decode it, the first attached wins
+        EXPECT_EQ(bus.read(0x0103), 0x22);
+        EXPECT_EQ(bus.read(0x0002), 0xff);
+
+        bus.write(0x00fc, 0x01);  // Both
+        bus.write(0x00fe, 0x02);  // First only
+        bus.write(0x00ff, 0x03);  // None
+        EXPECT_EQ(first.writes, (std::vector<std::pair<uint16_t, uint8_t>>{{0x00fc, 0x01}, {0x00fe, 0x02}}));
+        EXPECT_EQ(second.writes, (std::vector<std::pair<uint16_t, uint8_t>>{{0x00fc, 0x01}}));
+    }
+
+    TEST(IoBus, UlaPorts)
+    {
+        ModelUla<Model128K> ula{roms::Rom128K};
+        EXPECT_EQ(ula.ioRead(0xfefe), 0b10111111);  // No key pressed
+        ula.setKeyState(0, 0, true);
+        EXPECT_EQ(ula.ioRead(0xfefe), 0b10111110);
+        EXPECT_EQ(ula.ioRead(0x7ffe), 0b10111111);
+        ula.setKempstonState(0, true);
+        EXPECT_EQ(ula.ioRead(0x001f), 0x01);
+
+        ula.ioWrite(0x00fe, 0x03);
+        EXPECT_EQ(ula.border(), 0x03);
+
+        ula.ioWrite(0x7ffd, 0x07);
+        EXPECT_EQ(ula.pageBank(3), 7);
+        EXPECT_EQ(ula.ioRead(0x7ffd), 0x07);
+
+        ula.ioWrite(0xfffd, 0x08);  // AY register 8
+        ula.ioWrite(0xbffd, 0x0c);
+        EXPECT_EQ(ula.ioRead(0xfffd), 0x0c);
+    }
+
+    TEST(IoBus, UlaAttach)
+    {
+        ModelUla<Model48K> ula{roms::Rom48K};
+        EXPECT_EQ(ula.ioRead(0xff3b), 0xff);
+
+        TestDevice device{0x5a};
+        ula.ioBus().attach(&device, {0x00ff, 0x003b}, {0x00ff, 0x003b});
+        EXPECT_EQ(ula.ioRead(0xff3b), 0x5a);
+        ula.ioWrite(0xbf3b, 0x40);
+        EXPECT_EQ(device.writes, (std::vector<std::pair<uint16_t, uint8_t>>{{0xbf3b, 0x40}}));
+
+        // Built-in ports are unchanged
+        ula.ioWrite(0x00fe, 0x05);
+        EXPECT_EQ(ula.border(), 0x05);
+        EXPECT_EQ(device.writes.size(), 1);
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,138 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/Z80Breakpoints.hpp"
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "../../src/zxspectrum/src/ZXSpectrumEmulator.hpp"
+#include "TestZ80Interface.hpp"
+
+#include <stdexcept>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        // Clocks the CPU until it stops on a breakpoint, false if it did not within maxClocks
+        bool runUntilStopped(Z80Cpu& cpu, const int maxClocks = 1000)
+        {
+            for (int i = 0; i < maxClocks; i++)
+            {
+                cpu.clock();
+                if (cpu.stopped()) return true;
+            }
+            return false;
+        }
+    }  // namespace
+
+    TEST(Z80Breakpoints, Condition)
+    {
+        Z80Registers registers{};
+        registers.af = 0x10ff;
+        registers.hl = 0x8001;
+        registers.sp = 0xfff0;
+        registers.bc2 = 0x1234;
+        registers.iff1 = true;
+
+        EXPECT_EQ(Z80Condition{"a"}.evaluate(registers), 0x10);
+        EXPECT_EQ(Z80Condition{"A == 0x10 && (HL > $8000 || iff2)"}.evaluate(registers), 1);
+        EXPECT_EQ(Z80Condition{"h == 80h & l == 1"}.evaluate(registers), 1);
+        EXPECT_EQ(Z80Condition{"1 + 2 == 3 && 2 - 3 == -1"}.evaluate(registers), 1);
+        EXPECT_EQ(Z80Condition{"sp >= #fff0 && !(sp > 65520)"}.evaluate(registers), 1);
+        EXPECT_EQ(Z80Condition{"BC' ^ 0x1234 | iff1"}.evaluate(registers), 1);
+        EXPECT_EQ(Z80Condition{"~f & 0xff"}.evaluate(registers), 0);
+        EXPECT_TRUE(Z80Condition{" "}.empty());
+
+        EXPECT_THROW(Z80Condition{"a =="}, std::invalid_argument);
+        EXPECT_THROW(Z80Condition{"(a == 1"}, std::invalid_argument);
+        EXPECT_THROW(Z80Condition{"q == 1"}, std::invalid_argument);
+        EXPECT_THROW(Z80Condition{"a = 1"}, std::invalid_argument);
+    }
+
+    TEST(Z80Breakpoints, Execution)
+    {
+        // LD A,1; loop: INC A; INC A; JR loop
+        constexpr uint8_t program[] = {0x3e, 0x01, 0x3c, 0x3c, 0x18, 0xfc};
+        TestZ80Interface bus{program};
+        Z80Cpu cpu{bus};
+        Z80Breakpoints breakpoints{cpu};
+        EXPECT_EQ(cpu.breakpoints(), nullptr);
+
+        const auto id = breakpoints.add(Z80BreakpointType::execution, 0x0003, "a == 6");
+        EXPECT_EQ(cpu.breakpoints(), &breakpoints);
+        ASSERT_TRUE(runUntilStopped(cpu));
+        EXPECT_EQ(cpu.registers().pc, 0x0003);
+        EXPECT_EQ(cpu.registers().af.high, 6);
+        EXPECT_EQ(breakpoints.lastHit().reason, Z80Breakpoints::Reason::breakpoint);
+        EXPECT_EQ(breakpoints.lastHit().id, id);
+        EXPECT_EQ(breakpoints.list().front().hits, 1);
+
+        // Stopped again at the same place without skipping the breakpoint
+        cpu.clock();
+        EXPECT_TRUE(cpu.stopped());
+        breakpoints.skipNext();
+        cpu.clock();
+        EXPECT_FALSE(cpu.stopped());
+
+        breakpoints.remove(id);
+        EXPECT_TRUE(breakpoints.empty());
+        EXPECT_EQ(cpu.breakpoints(), nullptr);
+    }
+
+    TEST(Z80Breakpoints, WriteAndTemporary)
+    {
+        // LD HL,0x8000; loop: LD (HL),A; INC HL; JR loop
+        constexpr uint8_t program[] = {0x21, 0x00, 0x80, 0x77, 0x23, 0x18, 0xfc};
+        TestZ80Interface bus{program};
+        Z80Cpu cpu{bus};
+        Z80Breakpoints breakpoints{cpu};
+
+        breakpoints.add(Z80BreakpointType::write, 0x8002, {}, true);
+        ASSERT_TRUE(runUntilStopped(cpu));
+        // Stops after the writing instruction
+        EXPECT_EQ(cpu.registers().pc, 0x0004);
+        EXPECT_EQ(cpu.registers().hl, 0x8002);
+        EXPECT_EQ(breakpoints.lastHit().address, 0x8002);
+        EXPECT_TRUE(breakpoints.empty());
+        EXPECT_FALSE(runUntilStopped(cpu));
+    }
+
+    TEST(Z80Breakpoints, Emulator)
+    {
+        const auto emulator = ZXSpectrumEmulator::create48K();
+        emulator->reset();
+        emulator->breakpoints()->add(Z80BreakpointType::execution, 0x0038);
+        // The ROM enables the interrupts once the memory test is over
+        for (int i = 0; i < 200 && !emulator->paused(); i++) emulator->frame();
+        ASSERT_TRUE(emulator->paused());
+        EXPECT_EQ(emulator->cpu()->registers().pc, 0x0038);
+
+        // A paused emulator does not execute, stepping runs a single instruction
+        const auto clockCounter = emulator->cpu()->clockCounter();
+        emulator->frame();
+        EXPECT_EQ(emulator->cpu()->clockCounter(), clockCounter);
+        emulator->step();
+        EXPECT_EQ(emulator->cpu()->registers().pc, 0x0039);
+        EXPECT_TRUE(emulator->paused());
+
+        emulator->breakpoints()->clear();
+        emulator->resume();
+        emulator->frame();
+        EXPECT_FALSE(emulator->paused());
+    }
+}  // namespace epoch::zxspectrum
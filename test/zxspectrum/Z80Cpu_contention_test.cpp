@@ -0,0 +1,135 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "TestZ80Interface.hpp"
+
+namespace epoch::zxspectrum
+{
+    class ContendedTestZ80Interface : public TestZ80Interface
+    {
+    public:
+        ContendedTestZ80Interface(const std::span<const uint8_t> initRam = {}) : TestZ80Interface{initRam}
+        {
+            // Page 1 contended, 6-5-4-3-2-1-0-0 pattern starting at T-state 100
+            for (auto t = 0; t < 64; t++)
+            {
+                m_delays[100 + t] = std::array<uint8_t, 8>{6, 5, 4, 3, 2, 1, 0, 0}[t & 0x07];
+            }
+            m_contention.pages = {false, true, false, false};
+            m_contention.io = true;
+            m_contention.delays = m_delays.data();
+        }
+
+        [[nodiscard]] const Z80Contention* contention() const override { return &m_contention; }
+
+        void setFrameTState(const std::size_t tState) { m_contention.frameTState = tState; }
+
+    private:
+        std::array<uint8_t, 512> m_delays{};
+        Z80Contention m_contention{};
+    };
+
+    TEST(Z80Cpu_contention, UncontendedPage) {
+        ContendedTestZ80Interface bus{ std::initializer_list<uint8_t>{ 0x3a, 0x00, 0x80 } }; // LD A,(0x8000)
+        Z80Cpu sut{ bus };
+        bus.setFrameTState(100);
+        sut.step();
+        EXPECT_EQ(sut.clockCounter(), 13);
+    }
+
+    TEST(Z80Cpu_contention, ContendedRead) {
+        ContendedTestZ80Interface bus{ std::initializer_list<uint8_t>{ 0x3a, 0x00, 0x40 } }; // LD A,(0x4000)
+        Z80Cpu sut{ bus };
+        bus.setFrameTState(100);
+        sut.step();
+        // Opcode fetch and operands are uncontended, the read at offset 10 waits 4 T-states
+        EXPECT_EQ(sut.clockCounter(), 13 + 4);
+    }
+
+    TEST(Z80Cpu_contention, ContendedOpcodeFetch) {
+        ContendedTestZ80Interface bus{ std::initializer_list<uint8_t>{ 0xc3, 0x00, 0x40 } }; // JP 0x4000
+        Z80Cpu sut{ bus };
+        sut.step();
+        EXPECT_EQ(sut.clockCounter(), 10);
+        bus.setFrameTState(101);
+        sut.step(); // NOP at 0x4000
+        EXPECT_EQ(sut.clockCounter(), 10 + 4 + 5);
+        bus.setFrameTState(106);
+        sut.step(); // NOP at 0x4001, no delay at this T-state
+        EXPECT_EQ(sut.clockCounter(), 10 + 4 + 5 + 4);
+        bus.setFrameTState(0);
+        sut.step(); // NOP at 0x4002, outside the contended window
+        EXPECT_EQ(sut.clockCounter(), 10 + 4 + 5 + 4 + 4);
+    }
+
+    TEST(Z80Cpu_contention, UlaPortWrite) {
+        ContendedTestZ80Interface bus{ std::initializer_list<uint8_t>{ 0xd3, 0xfe } }; // OUT (0xfe),A
+        Z80Cpu sut{ bus };
+        sut.registers().af = 0x0000;
+        bus.setFrameTState(100 - 7);
+        sut.step();
+        // N:1 C:3, the I/O cycle starts at offset 7 and is contended from offset 8 (delay 5)
+        EXPECT_EQ(sut.clockCounter(), 11 + 5);
+    }
+
+    TEST(Z80Cpu_contention, IncHLInternalCycle) {
+        ContendedTestZ80Interface bus{ std::initializer_list<uint8_t>{ 0x34 } }; // INC (HL)
+        Z80Cpu sut{ bus };
+        sut.registers().hl = 0x4000;
+        bus.setFrameTState(100 - 4);
+        sut.step();
+        // hl:3 at offset 4 (delay 6), hl:1 at offset 13 (delay 5), hl:3 at offset 19 (no delay)
+        EXPECT_EQ(sut.clockCounter(), 11 + 6 + 5);
+        EXPECT_EQ(bus.ram(0x4000), 0x01);
+    }
+
+    TEST(Z80Cpu_contention, IndexedDisplacementAndInternalCycles) {
+        ContendedTestZ80Interface bus{};
+        const uint8_t program[] = { 0xdd, 0x7e, 0x00 }; // LD A,(IX+0)
+        std::memcpy(bus.ram().data() + 0x4000, program, sizeof(program));
+        bus.ram()[0x8000] = 0x5a;
+        Z80Cpu sut{ bus };
+        sut.registers().pc = 0x4000;
+        sut.registers().ix = 0x8000;
+        bus.setFrameTState(100);
+        sut.step();
+        // pc:4 (6), pc+1:4 (4), pc+2:3 (4), pc+2:1 x5 (5, 0, 6, 0, 6), ix+d:3 uncontended
+        EXPECT_EQ(sut.clockCounter(), 19 + 6 + 4 + 4 + 5 + 6 + 6);
+        EXPECT_EQ(sut.registers().af.high, 0x5a);
+    }
+
+    TEST(Z80Cpu_contention, IndexedBitDisplacementAndOpcodeRead) {
+        ContendedTestZ80Interface bus{};
+        const uint8_t program[] = { 0xdd, 0xcb, 0x00, 0x46 }; // BIT 0,(IX+0)
+        std::memcpy(bus.ram().data() + 0x4000, program, sizeof(program));
+        Z80Cpu sut{ bus };
+        sut.registers().pc = 0x4000;
+        sut.registers().ix = 0x8000;
+        const auto r = sut.registers().ir.low;
+        bus.setFrameTState(100);
+        sut.step();
+        // pc:4 (6), pc+1:4 (4), pc+2:3 (4), pc+3:3 (5), pc+3:1 x2 (5, 0), ix+d:3 and ix+d:1 uncontended
+        EXPECT_EQ(sut.clockCounter(), 20 + 6 + 4 + 4 + 5 + 5);
+        EXPECT_EQ(sut.registers().pc, 0x4004);
+        // Only the two opcode fetches refresh memory
+        EXPECT_EQ(sut.registers().ir.low & 0x7f, (r + 2) & 0x7f);
+    }
+}
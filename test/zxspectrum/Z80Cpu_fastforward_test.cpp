@@ -0,0 +1,181 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "TestZ80Interface.hpp"
+
+namespace epoch::zxspectrum
+{
+    // Raises the interrupt for 32 T-states every InterruptPeriod. When fastForward is enabled, reports it as the next
+    // event and gives direct page access for bulk block instructions.
+    class PeriodicTestZ80Interface : public TestZ80Interface
+    {
+    public:
+        static constexpr std::size_t InterruptPeriod = 1000;
+
+        PeriodicTestZ80Interface(const std::span<const uint8_t> initRam, const bool fastForward)
+            : TestZ80Interface{initRam}, m_fastForward{fastForward}
+        {
+        }
+
+        void attach(const Z80Cpu* cpu) { m_cpu = cpu; }
+
+        [[nodiscard]] std::size_t cyclesToNextEvent() const override
+        {
+            return m_fastForward ? InterruptPeriod - m_cpu->clockCounter() % InterruptPeriod : 0;
+        }
+
+        [[nodiscard]] const uint8_t* readPage(const int page) override { return writePage(page); }
+        [[nodiscard]] uint8_t* writePage(const int page) override
+        {
+            return m_fastForward ? ram().data() + page * 0x4000 : nullptr;
+        }
+
+        void clock(Z80Cpu& cpu) const
+        {
+            cpu.interruptRequest(cpu.clockCounter() % InterruptPeriod < 32);
+            cpu.clock();
+        }
+
+    private:
+        bool m_fastForward;
+        const Z80Cpu* m_cpu{};
+    };
+
+    TEST(Z80Cpu_fastforward, HaltUntilInterrupt) {
+        const std::initializer_list<uint8_t> program{ 0x76 }; // HALT
+        PeriodicTestZ80Interface bus{ program, true };
+        Z80Cpu sut{ bus };
+        bus.attach(&sut);
+        sut.registers().ir = 0x0080;
+        sut.step();
+        // All the 4 T-states repetitions until the interrupt are executed at once
+        EXPECT_EQ(sut.clockCounter(), 1000);
+        EXPECT_EQ(sut.registers().pc, 0);
+        EXPECT_EQ(sut.registers().ir, 0x0080 | (250 & 0x7f));
+    }
+
+    TEST(Z80Cpu_fastforward, PollingLoopMatchesExecution) {
+        std::array<uint8_t, 0x40> program{
+            0xed, 0x56,             // IM 1
+            0xfb,                   // EI
+            0xdb, 0xfe,             // loop: IN A,(0xfe)
+            0xe6, 0x1f,             // AND 0x1f
+            0xfe, 0x1f,             // CP 0x1f
+            0x20, 0xf8,             // JR NZ, loop
+        };
+        program[0x38] = 0x04;       // INC B
+        program[0x39] = 0xfb;       // EI
+        program[0x3a] = 0xc9;       // RET
+
+        PeriodicTestZ80Interface fastBus{ program, true };
+        Z80Cpu fast{ fastBus };
+        fastBus.attach(&fast);
+        PeriodicTestZ80Interface referenceBus{ program, false };
+        Z80Cpu reference{ referenceBus };
+        referenceBus.attach(&reference);
+        fast.registers().sp = reference.registers().sp = 0x8000;
+
+        for (auto t = 0; t < 5000; t++)
+        {
+            fastBus.clock(fast);
+            referenceBus.clock(reference);
+            if (t % PeriodicTestZ80Interface::InterruptPeriod == 20)
+            {
+                // Both inside the interrupt handler: same instruction boundaries, same state
+                EXPECT_EQ(fast.registers().pc, reference.registers().pc);
+                EXPECT_EQ(fast.registers().bc, reference.registers().bc);
+                EXPECT_EQ(fast.registers().af, reference.registers().af);
+                EXPECT_EQ(fast.registers().ir, reference.registers().ir);
+                EXPECT_EQ(fast.registers().sp, reference.registers().sp);
+            }
+        }
+        EXPECT_EQ(fast.registers().bc, reference.registers().bc);
+        EXPECT_EQ(fast.clockCounter(), reference.clockCounter());
+    }
+
+    TEST(Z80Cpu_fastforward, BlockInstructionsMatchExecution) {
+        std::array<uint8_t, 0x80> program{
+            0xc3, 0x40, 0x00,       // JP 0x0040
+        };
+        const std::initializer_list<uint8_t> handler{
+            0x08,                   // EX AF, AF'
+            0x3c,                   // INC A
+            0x08,                   // EX AF, AF'
+            0xfb,                   // EI
+            0xc9,                   // RET
+        };
+        const std::initializer_list<uint8_t> main{
+            0xed, 0x56,             // IM 1
+            0xfb,                   // EI
+            0x21, 0x00, 0x00,       // LD HL, 0x0000
+            0x11, 0xf0, 0x3f,       // LD DE, 0x3ff0
+            0x01, 0x00, 0x20,       // LD BC, 0x2000
+            0xed, 0xb0,             // LDIR (crossing a page boundary)
+            0x21, 0x00, 0x80,       // LD HL, 0x8000
+            0x36, 0xaa,             // LD (HL), 0xaa
+            0x11, 0x01, 0x80,       // LD DE, 0x8001
+            0x01, 0xff, 0x0f,       // LD BC, 0x0fff
+            0xed, 0xb0,             // LDIR (fill)
+            0x21, 0xff, 0x5f,       // LD HL, 0x5fff
+            0x11, 0xff, 0x9f,       // LD DE, 0x9fff
+            0x01, 0x00, 0x30,       // LD BC, 0x3000
+            0xed, 0xb8,             // LDDR
+            0x21, 0x00, 0x40,       // LD HL, 0x4000
+            0x3e, 0xc9,             // LD A, 0xc9
+            0x01, 0x00, 0x00,       // LD BC, 0x0000
+            0xed, 0xb1,             // CPIR (finds the copy of the handler RET at 0x402c)
+            0x3e, 0xaa,             // LD A, 0xaa
+            0x01, 0x00, 0x10,       // LD BC, 0x1000
+            0xed, 0xb9,             // CPDR (no match, crossing a page boundary)
+            0x18, 0xfe,             // JR $
+        };
+        std::copy(handler.begin(), handler.end(), program.begin() + 0x38);
+        std::copy(main.begin(), main.end(), program.begin() + 0x40);
+
+        PeriodicTestZ80Interface fastBus{ program, true };
+        Z80Cpu fast{ fastBus };
+        fastBus.attach(&fast);
+        PeriodicTestZ80Interface referenceBus{ program, false };
+        Z80Cpu reference{ referenceBus };
+        referenceBus.attach(&reference);
+        fast.registers().sp = reference.registers().sp = 0xfff0;
+
+        for (auto t = 0; t < 1000000; t++)
+        {
+            fastBus.clock(fast);
+            referenceBus.clock(reference);
+            if (t % PeriodicTestZ80Interface::InterruptPeriod == 20)
+            {
+                // Both inside the interrupt handler: same instruction boundaries, same state
+                ASSERT_EQ(fast.registers().pc, reference.registers().pc);
+                ASSERT_EQ(fast.registers().ir, reference.registers().ir);
+                ASSERT_EQ(fast.registers().af2, reference.registers().af2);
+            }
+        }
+        EXPECT_EQ(fast.registers().pc, 0x40 + main.size() - 2);
+        EXPECT_EQ(fast.clockCounter(), reference.clockCounter());
+        EXPECT_EQ(fast.registers().af, reference.registers().af);
+        EXPECT_EQ(fast.registers().bc, reference.registers().bc);
+        EXPECT_EQ(fast.registers().de, reference.registers().de);
+        EXPECT_EQ(fast.registers().hl, reference.registers().hl);
+        EXPECT_EQ(fast.registers().wz, reference.registers().wz);
+        EXPECT_EQ(fast.registers().ir, reference.registers().ir);
+        EXPECT_TRUE(std::equal(fastBus.ram().begin(), fastBus.ram().end(), referenceBus.ram().begin()));
+    }
+}
@@ -0,0 +1,75 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/Z80Disassembler.hpp"
+#include "TestZ80Interface.hpp"
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        std::string disassemble(const std::array<uint8_t, 4>& bytes, const uint8_t expectedLength)
+        {
+            const auto line = disassembleZ80(0x8000, bytes);
+            EXPECT_EQ(line.length, expectedLength) << line.text;
+            return line.text;
+        }
+    }  // namespace
+
+    TEST(Z80Disassembler, Instructions)
+    {
+        EXPECT_EQ(disassemble({0x00}, 1), "NOP");
+        EXPECT_EQ(disassemble({0x21, 0x34, 0x12}, 3), "LD HL,$1234");
+        EXPECT_EQ(disassemble({0x18, 0xfe}, 2), "JR $8000");
+        EXPECT_EQ(disassemble({0x10, 0x10}, 2), "DJNZ $8012");
+        EXPECT_EQ(disassemble({0x76}, 1), "HALT");
+        EXPECT_EQ(disassemble({0x7e}, 1), "LD A,(HL)");
+        EXPECT_EQ(disassemble({0xcd, 0x00, 0x40}, 3), "CALL $4000");
+        EXPECT_EQ(disassemble({0xff}, 1), "RST $38");
+        EXPECT_EQ(disassemble({0xcb, 0x7e}, 2), "BIT 7,(HL)");
+        EXPECT_EQ(disassemble({0xed, 0xb0}, 2), "LDIR");
+        EXPECT_EQ(disassemble({0xed, 0x43, 0x00, 0x5c}, 4), "LD ($5C00),BC");
+        EXPECT_EQ(disassemble({0xed, 0x56}, 2), "IM 1");
+        EXPECT_EQ(disassemble({0xdd, 0x21, 0x00, 0x80}, 4), "LD IX,$8000");
+        EXPECT_EQ(disassemble({0xdd, 0x66, 0xfb}, 3), "LD H,(IX-$05)");
+        EXPECT_EQ(disassemble({0xfd, 0x36, 0x05, 0x3c}, 4), "LD (IY+$05),$3C");
+        EXPECT_EQ(disassemble({0xdd, 0x7c}, 2), "LD A,IXH");
+        EXPECT_EQ(disassemble({0xfd, 0xe9}, 2), "JP (IY)");
+        EXPECT_EQ(disassemble({0xdd, 0xcb, 0x02, 0xc6}, 4), "SET 0,(IX+$02)");
+        EXPECT_EQ(disassemble({0xfd, 0xcb, 0x01, 0x46}, 4), "BIT 0,(IY+$01)");
+        EXPECT_EQ(disassemble({0xdd, 0xdd}, 1), "NOP*");
+    }
+
+    TEST(Z80Disassembler, UpdatesChangedPages)
+    {
+        TestZ80Interface bus;
+        Z80Disassembler disassembler;
+        EXPECT_TRUE(disassembler.update(bus));
+        EXPECT_EQ(disassembler.size(), 0x10000);
+        EXPECT_FALSE(disassembler.update(bus));
+
+        // LD BC,$0000 at $80FF merges three NOPs and moves the boundaries of the next page
+        bus.write(0x80ff, 0x01);
+        EXPECT_TRUE(disassembler.update(bus));
+        EXPECT_EQ(disassembler.size(), 0x10000 - 2);
+        EXPECT_EQ(disassembler.page(0x80).back().text, "LD BC,$0000");
+        EXPECT_EQ(disassembler.page(0x81).front().address, 0x8102);
+        EXPECT_EQ(disassembler.page(0x82).front().address, 0x8200);
+    }
+}  // namespace epoch::zxspectrum
@@ -0,0 +1,60 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "TestZ80Interface.hpp"
+
+#ifdef EPOCH_CPU_STATISTICS
+namespace epoch::zxspectrum
+{
+    TEST(Z80Statistics, PrefixesChargedToPrefixedInstruction)
+    {
+        // NOP ; LD IX,1234h ; ADD IY,BC ; DD DD LD IX,0 ; BIT 0,(IY+0) ; BIT 0,(IX+0)
+        TestZ80Interface bus{std::initializer_list<uint8_t>{0x00, 0xdd, 0x21, 0x34, 0x12, 0xfd, 0x09, 0xdd, 0xdd, 0x21,
+                                                            0x00, 0x00, 0xfd, 0xcb, 0x00, 0x46, 0xdd, 0xcb, 0x00, 0x46}};
+        Z80Cpu sut{bus};
+        for (int i = 0; i < 6; ++i) sut.step();
+        const auto& statistics = sut.statistics();
+
+        // The bare prefixes never show up as instructions of their own
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::none, 0xdd).executions, 0u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::none, 0xfd).executions, 0u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::none, 0x00).executions, 1u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::none, 0x00).cycles, 4u);
+
+        // LD IX,nn is 14 T-states with the prefix, a repeated prefix adds its 4 T-states to the same entry
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::dd, 0x21).executions, 2u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::dd, 0x21).cycles, 14u + 18u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::fd, 0x09).executions, 1u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::fd, 0x09).cycles, 15u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::fdcb, 0x46).executions, 1u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::fdcb, 0x46).cycles, 20u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::ddcb, 0x46).executions, 1u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::ddcb, 0x46).cycles, 20u);
+        EXPECT_EQ(statistics.entry(Z80StatisticsTable::cb, 0x46).executions, 0u);
+
+        EXPECT_EQ(statistics.total().cycles, sut.clockCounter());
+        EXPECT_EQ(statistics.total().executions, 6u);
+    }
+}  // namespace epoch::zxspectrum
+#else
+TEST(Z80Statistics, PrefixesChargedToPrefixedInstruction)
+{
+    GTEST_SKIP() << "Built without EPOCH_ENABLE_CPU_STATISTICS";
+}
+#endif
@@ -0,0 +1,174 @@
+/* This file is part of Epoch, Copyright (C) 2024 Andrea Ghidini.
+ *
+ * Epoch is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Epoch is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Epoch.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "../../src/zxspectrum/src/Z80Cpu.hpp"
+#include "../../src/zxspectrum/src/Z80Tracer.hpp"
+#include "TestZ80Interface.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace epoch::zxspectrum
+{
+    namespace
+    {
+        class PagedTestZ80Interface : public TestZ80Interface
+        {
+        public:
+            using TestZ80Interface::TestZ80Interface;
+
+            [[nodiscard]] uint16_t paging() const override { return 0x0017; }
+        };
+
+        // Record number n has clock n, PC n and SP ~n: a record mixing two writes shows up as inconsistent
+        void recordNumbered(Z80Tracer& tracer, Z80Interface& bus, const uint64_t n)
+        {
+            Z80Registers registers{};
+            registers.pc = static_cast<uint16_t>(n);
+            registers.sp = static_cast<uint16_t>(~n);
+            tracer.record(registers, n, bus);
+        }
+
+        bool sameRecord(const Z80TraceRecord& a, const Z80TraceRecord& b)
+        {
+            return std::memcmp(&a, &b, sizeof(Z80TraceRecord)) == 0;
+        }
+    }  // namespace
+
+    TEST(Z80Tracer, CapacityIsAPowerOfTwo)
+    {
+        EXPECT_EQ(Z80Tracer{5}.capacity(), 8u);
+        EXPECT_EQ(Z80Tracer{8}.capacity(), 8u);
+        EXPECT_EQ(Z80Tracer{0}.capacity(), 1u);
+    }
+
+    TEST(Z80Tracer, WrapAround)
+    {
+        TestZ80Interface bus{};
+        Z80Tracer sut{4};
+        for (uint64_t n = 0; n < 3; n++) recordNumbered(sut, bus, n);
+        auto records = sut.snapshot();
+        ASSERT_EQ(records.size(), 3u);
+        EXPECT_EQ(records.front().clock, 0u);
+
+        for (uint64_t n = 3; n < 10; n++) recordNumbered(sut, bus, n);
+        EXPECT_EQ(sut.recorded(), 10u);
+        // Oldest first; the oldest slot is also the next one to be written, so it is never part of a snapshot
+        records = sut.snapshot();
+        ASSERT_EQ(records.size(), sut.capacity() - 1);
+        for (std::size_t i = 0; i < records.size(); i++)
+        {
+            EXPECT_EQ(records[i].clock, 7 + i);
+            EXPECT_EQ(records[i].pc, 7 + i);
+        }
+
+        sut.clear();
+        EXPECT_TRUE(sut.snapshot().empty());
+    }
+
+    TEST(Z80Tracer, SnapshotDropsOverwrittenRecords)
+    {
+        // The producer keeps wrapping around a small buffer while snapshots are taken: every record in a snapshot
+        // must be whole and the sequence must have no gap
+        TestZ80Interface bus{};
+        Z80Tracer sut{64};
+        std::atomic<bool> stop{};
+        std::thread producer{[&] {
+            for (uint64_t n = 0; !stop.load(std::memory_order_relaxed); n++) recordNumbered(sut, bus, n);
+        }};
+        const auto check = [](const std::vector<Z80TraceRecord>& records) {
+            for (std::size_t j = 0; j < records.size(); j++)
+            {
+                ASSERT_EQ(records[j].pc, static_cast<uint16_t>(records[j].clock));
+                ASSERT_EQ(records[j].sp, static_cast<uint16_t>(~records[j].clock));
+                if (j > 0) ASSERT_EQ(records[j].clock, records[j - 1].clock + 1);
+            }
+        };
+        while (sut.recorded() < 4 * sut.capacity()) std::this_thread::yield();
+        // A producer lapping the buffer during the copy may leave nothing valid, so only consistency is checked here
+        for (int i = 0; i < 2000; i++)
+        {
+            const auto records = sut.snapshot();
+            ASSERT_LT(records.size(), sut.capacity());
+            check(records);
+        }
+        stop = true;
+        producer.join();
+
+        const auto records = sut.snapshot();
+        ASSERT_EQ(records.size(), sut.capacity() - 1);
+        check(records);
+        EXPECT_EQ(records.back().clock, sut.recorded() - 1);
+    }
+
+    TEST(Z80Tracer, SaveLoadRoundTrip)
+    {
+        const auto path = std::filesystem::temp_directory_path() / "epoch_tracer_test.trace";
+        TestZ80Interface bus{std::initializer_list<uint8_t>{0xdd, 0x21, 0x34, 0x12}};
+        Z80Tracer sut{16};
+        for (uint64_t n = 0; n < 10; n++) recordNumbered(sut, bus, n * 3);
+        const auto records = sut.snapshot();
+        saveTrace(path, records);
+
+        const auto loaded = loadTrace(path);
+        ASSERT_EQ(loaded.size(), records.size());
+        for (std::size_t i = 0; i < loaded.size(); i++) EXPECT_TRUE(sameRecord(loaded[i], records[i])) << i;
+
+        // A file cut in the middle of a record
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        EXPECT_THROW((void)loadTrace(path), std::runtime_error);
+        {
+            std::ofstream os{path, std::ios::binary};
+            os << "not a trace file at all";
+        }
+        EXPECT_THROW((void)loadTrace(path), std::runtime_error);
+        std::filesystem::remove(path);
+    }
+
+    TEST(Z80Tracer, FormatInstructionSequence)
+    {
+        // LD A,12h ; LD BC,3456h ; INC A
+        PagedTestZ80Interface bus{std::initializer_list<uint8_t>{0x3e, 0x12, 0x01, 0x56, 0x34, 0x3c}};
+        Z80Cpu cpu{bus};
+        cpu.registers().interruptMode = 1;
+        cpu.registers().iff1 = cpu.registers().iff2 = true;
+        Z80Tracer sut{16};
+        for (int i = 0; i < 3; i++)
+        {
+            sut.record(cpu.registers(), cpu.clockCounter(), bus);
+            cpu.step();
+        }
+
+        std::ostringstream os;
+        for (const auto& record : sut.snapshot()) formatTrace(os, record);
+        EXPECT_EQ(os.str(),
+                  "           0 0000  3E 12 01 56  AF=FFFF BC=FFFF DE=FFFF HL=FFFF IX=FFFF IY=FFFF SP=FFFF "
+                  "AF'=FFFF BC'=FFFF DE'=FFFF HL'=FFFF IR=0000 WZ=0000 IM1 IFF=11 P=0017\n"
+                  "           7 0002  01 56 34 3C  AF=12FF BC=FFFF DE=FFFF HL=FFFF IX=FFFF IY=FFFF SP=FFFF "
+                  "AF'=FFFF BC'=FFFF DE'=FFFF HL'=FFFF IR=0001 WZ=0000 IM1 IFF=11 P=0017\n"
+                  "          17 0005  3C 00 00 00  AF=12FF BC=3456 DE=FFFF HL=FFFF IX=FFFF IY=FFFF SP=FFFF "
+                  "AF'=FFFF BC'=FFFF DE'=FFFF HL'=FFFF IR=0002 WZ=0000 IM1 IFF=11 P=0017\n");
+    }
+}  // namespace epoch::zxspectrum